@@ -7,7 +7,8 @@ namespace winsetup::abstractions {
     class IExecutor {
     public:
         virtual ~IExecutor() = default;
-        virtual void Post(std::function<void()> task) = 0;
+        // Returns false when the task was not queued; it will never run.
+        virtual bool Post(std::function<void()> task) = 0;
     };
 
 } // namespace winsetup::abstractions
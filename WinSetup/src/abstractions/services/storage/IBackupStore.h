@@ -0,0 +1,59 @@
+// src/abstractions/services/storage/IBackupStore.h
+#pragma once
+#include "domain/primitives/Expected.h"
+#include <string>
+#include <cstdint>
+
+namespace winsetup::abstractions {
+
+    struct BackupStoreStats {
+        uint64_t files = 0;
+        uint64_t directories = 0;
+        uint64_t skippedFiles = 0;
+        uint64_t bytesRead = 0;
+        uint64_t bytesWritten = 0;
+        uint64_t chunks = 0;
+        uint64_t duplicateChunks = 0;
+        uint64_t mismatchedFiles = 0;   // Verify only
+    };
+
+    // A backup location that keeps file contents as deduplicated chunks.
+    // Each backup is stored under a name as a tree that references those
+    // chunks; restoring rebuilds the tree from the shared chunk data.
+    class IBackupStore {
+    public:
+        // Folder on the data volume that holds the store.
+        static constexpr wchar_t kStoreDirectoryName[] = L"WinSetupBackup";
+
+        virtual ~IBackupStore() = default;
+
+        [[nodiscard]] virtual domain::Expected<BackupStoreStats> Backup(
+            const std::wstring& storeDir,
+            const std::wstring& name,
+            const std::wstring& sourceDir
+        ) = 0;
+
+        [[nodiscard]] virtual domain::Expected<BackupStoreStats> Restore(
+            const std::wstring& storeDir,
+            const std::wstring& name,
+            const std::wstring& targetDir
+        ) = 0;
+
+        // Re-reads a restored tree and compares every file with the size and
+        // content hash recorded at backup. Missing or differing files are
+        // logged and counted in mismatchedFiles rather than failing the call.
+        [[nodiscard]] virtual domain::Expected<BackupStoreStats> Verify(
+            const std::wstring& storeDir,
+            const std::wstring& name,
+            const std::wstring& targetDir
+        ) = 0;
+
+        [[nodiscard]] virtual bool HasBackup(
+            const std::wstring& storeDir,
+            const std::wstring& name
+        ) const = 0;
+
+        virtual void Cancel() noexcept = 0;
+    };
+
+}
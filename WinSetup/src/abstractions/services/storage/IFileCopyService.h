@@ -1,8 +1,10 @@
 // src/abstractions/services/storage/IFileCopyService.h
 #pragma once
 #include "domain/primitives/Expected.h"
+#include <algorithm>
 #include <functional>
 #include <string>
+#include <vector>
 #include <cstdint>
 
 namespace winsetup::abstractions {
@@ -13,14 +15,102 @@ namespace winsetup::abstractions {
         uint32_t     totalFiles = 0;
         uint32_t     copiedFiles = 0;
         uint32_t     percentComplete = 0;
+        bool         totalsFinal = true;  // false while the source is still being enumerated
+        uint32_t     activeWorkers = 0;
+        uint32_t     bufferSizeKB = 0;
         std::wstring currentFile;
     };
 
+    // What a failed file does to the rest of the run. Skip records it and
+    // lets the run succeed; Fail records it, keeps copying and fails the
+    // run at the end; Abort records it and stops the run at once.
+    enum class FileCopyErrorAction : uint8_t {
+        Retry,
+        Skip,
+        Fail,
+        Abort
+    };
+
+    struct FileCopyErrorRule {
+        uint32_t            errorCode = 0;
+        FileCopyErrorAction action = FileCopyErrorAction::Fail;
+    };
+
+    struct FileCopyErrorPolicy {
+        // Sharing and lock violations (32, 33) are usually another process
+        // holding the file briefly, so they are retried by default.
+        std::vector<FileCopyErrorRule> rules = {
+            { 32, FileCopyErrorAction::Retry },
+            { 33, FileCopyErrorAction::Retry }
+        };
+        FileCopyErrorAction defaultAction = FileCopyErrorAction::Fail;
+
+        // A retried file waits initialBackoffMs, doubling per attempt up to
+        // maxBackoffMs, and takes exhaustedAction after maxAttempts tries.
+        FileCopyErrorAction exhaustedAction = FileCopyErrorAction::Fail;
+        uint32_t            maxAttempts = 4;
+        uint32_t            initialBackoffMs = 250;
+        uint32_t            maxBackoffMs = 4000;
+
+        [[nodiscard]] FileCopyErrorAction ActionFor(uint32_t errorCode) const noexcept {
+            for (const auto& rule : rules)
+                if (rule.errorCode == errorCode) return rule.action;
+            return defaultAction;
+        }
+
+        // The action once any retries are used up.
+        [[nodiscard]] FileCopyErrorAction FinalActionFor(uint32_t errorCode) const noexcept {
+            const FileCopyErrorAction action = ActionFor(errorCode);
+            if (action != FileCopyErrorAction::Retry) return action;
+            return exhaustedAction == FileCopyErrorAction::Retry ? FileCopyErrorAction::Fail : exhaustedAction;
+        }
+
+        [[nodiscard]] uint32_t BackoffMs(uint32_t attempts) const noexcept {
+            const uint64_t backoff = static_cast<uint64_t>(initialBackoffMs)
+                << (std::min)(attempts > 0 ? attempts - 1 : 0u, 16u);
+            return static_cast<uint32_t>((std::min)(backoff, static_cast<uint64_t>(maxBackoffMs)));
+        }
+    };
+
+    struct FileCopyFailure {
+        std::wstring        srcPath;
+        std::wstring        dstPath;
+        uint32_t            errorCode = 0;
+        std::wstring        message;
+        uint32_t            attempts = 0;
+        FileCopyErrorAction action = FileCopyErrorAction::Fail;  // never Retry
+    };
+
+    // Outcome of the last CopyFile or CopyDirectory beyond its return value.
+    struct FileCopyReport {
+        std::vector<FileCopyFailure> failures;
+        uint32_t                     retriedFiles = 0;
+        uint32_t                     recoveredFiles = 0;  // succeeded on a retry
+    };
+
     struct FileCopyOptions {
         bool     overwrite = false;
         bool     recursive = true;
         uint32_t threadCount = 0;
         uint32_t bufferSizeKB = 256;
+
+        // Let CopyDirectory tune the number of active workers and the buffer
+        // size from measured throughput, starting small. threadCount and the
+        // buffer limits stay the upper bounds; bufferSizeKB is only the
+        // starting point. Settings found for a source/destination volume
+        // pair seed the next copy between them.
+        bool     adaptiveConcurrency = true;
+
+        // Hash data as it is copied, then re-read the destination and
+        // compare. The content hash is kept in the resume manifest if set.
+        bool     verify = false;
+
+        // Append-only manifest of completed files and committed chunks.
+        // When set, a re-run skips files already recorded with the same
+        // size and mtime and resumes large files from their last chunk.
+        std::wstring resumeManifestPath;
+
+        FileCopyErrorPolicy errorPolicy;
     };
 
     using FileCopyProgressCallback = std::function<void(const FileCopyProgress&)>;
@@ -48,6 +138,8 @@ namespace winsetup::abstractions {
         [[nodiscard]] virtual bool IsCancelled() const noexcept = 0;
 
         [[nodiscard]] virtual FileCopyProgress GetLastProgress() const noexcept = 0;
+
+        [[nodiscard]] virtual FileCopyReport GetLastReport() const = 0;
     };
 
 }
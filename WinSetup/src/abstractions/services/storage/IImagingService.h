@@ -37,6 +37,7 @@ namespace winsetup::abstractions {
         uint64_t completedBytes;
         uint64_t totalBytes;
         uint32_t percentComplete;
+        uint64_t bytesPerSecond;
         std::wstring currentFile;
     };
 
@@ -53,6 +54,17 @@ namespace winsetup::abstractions {
             ProgressCallback progressCallback = nullptr
         ) = 0;
 
+        // Reads the source front to back exactly once, overlapping the reads
+        // with decompressing and writing the image. sourcePath is a pipable
+        // WIM, the first part of a split WIM (name.swm, name2.swm, ...), or
+        // a pipe carrying a pipable WIM.
+        [[nodiscard]] virtual domain::Expected<void> ApplyImageStreamed(
+            const std::wstring& sourcePath,
+            uint32_t imageIndex,
+            const std::wstring& targetPath,
+            ProgressCallback progressCallback = nullptr
+        ) = 0;
+
         [[nodiscard]] virtual domain::Expected<void> CaptureImage(
             const std::wstring& sourcePath,
             const std::wstring& wimPath,
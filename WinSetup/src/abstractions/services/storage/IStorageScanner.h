@@ -1 +1,80 @@
 ﻿// src\abstractions\services\storage\IStorageScanner.h
+#pragma once
+
+#include <domain/primitives/Expected.h>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace winsetup::abstractions {
+
+    struct StorageUsage {
+        uint64_t totalSize = 0;
+        uint64_t fileCount = 0;
+    };
+
+    struct StorageScanProgress {
+        std::wstring volumeGuid;
+        uint64_t     recordsScanned = 0;
+        uint64_t     estimatedTotalRecords = 0;
+        double       estimatedRemainingMs = 0.0;
+        uint32_t     percentComplete = 0;
+    };
+
+    // Volumes on different disks are scanned concurrently, so the callback
+    // may be invoked from several threads at once.
+    using StorageScanProgressCallback = std::function<void(const StorageScanProgress&)>;
+
+    // Immutable file index of one volume. Paths are volume-relative and
+    // matched case-insensitively; every method is safe to call concurrently.
+    // An incomplete index (scan hit its deadline or was cancelled) holds a
+    // consistent subset, so only its positive answers are authoritative.
+    class IStorageIndexSnapshot {
+    public:
+        virtual ~IStorageIndexSnapshot() = default;
+
+        [[nodiscard]] virtual const std::wstring& GetVolumeGuid() const noexcept = 0;
+        [[nodiscard]] virtual size_t GetEntryCount() const noexcept = 0;
+        [[nodiscard]] virtual bool IsComplete() const noexcept = 0;
+
+        [[nodiscard]] virtual bool Exists(const std::wstring& relativePath) const noexcept = 0;
+        [[nodiscard]] virtual bool IsFile(const std::wstring& relativePath) const noexcept = 0;
+        [[nodiscard]] virtual bool IsDirectory(const std::wstring& relativePath) const noexcept = 0;
+
+        [[nodiscard]] virtual std::optional<StorageUsage> GetUsage(
+            const std::wstring& relativePath
+        ) const = 0;
+
+        [[nodiscard]] virtual domain::Expected<std::vector<std::wstring>> FindPaths(
+            const std::wstring& pattern
+        ) const = 0;
+    };
+
+    // Owns one index per volume GUID. ScanVolumes blocks until every volume
+    // has been indexed or has failed, and returns how many succeeded.
+    class IStorageScanner {
+    public:
+        virtual ~IStorageScanner() = default;
+
+        [[nodiscard]] virtual domain::Expected<size_t> ScanVolumes(
+            const std::vector<std::wstring>& volumeGuids
+        ) = 0;
+
+        [[nodiscard]] virtual std::shared_ptr<const IStorageIndexSnapshot> GetSnapshot(
+            const std::wstring& volumeGuid
+        ) const = 0;
+
+        virtual void Invalidate(const std::wstring& volumeGuid) = 0;
+
+        // Stops in-flight scans at their next buffer boundary; they publish
+        // what they have read as incomplete snapshots.
+        virtual void CancelScans() noexcept = 0;
+
+        // Applies to scans started after the call.
+        virtual void SetProgressCallback(StorageScanProgressCallback callback) = 0;
+    };
+
+}
@@ -8,44 +8,362 @@
 #include <adapters/platform/win32/core/Win32HandleFactory.h>
 #include <algorithm>
 #include <chrono>
+#include <cstring>
+#include <cwchar>
+#include <optional>
 #include <thread>
 #include <Windows.h>
 #include <psapi.h>
+#include <fcntl.h>
+#include <io.h>
 
 #undef min
 #undef max
 
 namespace winsetup::adapters {
 
+    namespace {
+        domain::Error WimlibError(const std::wstring& message, int code) {
+            const wimlib_tchar* text = wimlib_get_error_string(static_cast<enum wimlib_error_code>(code));
+            return domain::Error{
+                message + L": " + (text ? text : L"unknown wimlib error"),
+                static_cast<uint32_t>(code),
+                domain::ErrorCategory::Imaging
+            };
+        }
+
+        struct WimDeleter {
+            void operator()(WIMStruct* wim) const noexcept { wimlib_free(wim); }
+        };
+
+        using UniqueWim = std::unique_ptr<WIMStruct, WimDeleter>;
+
+        enum wimlib_compression_type ToWimlibCompression(abstractions::CompressionType compression) {
+            switch (compression) {
+            case abstractions::CompressionType::None:   return WIMLIB_COMPRESSION_TYPE_NONE;
+            case abstractions::CompressionType::XPRESS: return WIMLIB_COMPRESSION_TYPE_XPRESS;
+            case abstractions::CompressionType::LZMS:   return WIMLIB_COMPRESSION_TYPE_LZMS;
+            case abstractions::CompressionType::LZX:
+            default:                                    return WIMLIB_COMPRESSION_TYPE_LZX;
+            }
+        }
+
+        // wimlib levels run from about 10 to 100+ with 50 as its default;
+        // the OptimizationLevel values are on a different scale.
+        unsigned int ToWimlibLevel(OptimizationLevel level) {
+            switch (level) {
+            case OptimizationLevel::Fast:  return 20;
+            case OptimizationLevel::Best:  return 80;
+            case OptimizationLevel::Ultra: return 100;
+            case OptimizationLevel::Normal:
+            default:                       return 50;
+            }
+        }
+
+        // Chunk sizes each format accepts for non-solid resources.
+        uint32_t FitChunkSize(int compressionType, uint32_t chunkSize) {
+            uint32_t minSize = 1u << 15;
+            uint32_t maxSize = 1u << 21;
+            if (compressionType == WIMLIB_COMPRESSION_TYPE_XPRESS) {
+                minSize = 1u << 12;
+                maxSize = 1u << 16;
+            }
+            else if (compressionType == WIMLIB_COMPRESSION_TYPE_LZMS) {
+                maxSize = 1u << 30;
+            }
+            return std::clamp(chunkSize, minSize, maxSize);
+        }
+
+        // One write thread holds a compressor plus a chunk in and a chunk
+        // out; 0 when wimlib rejects the type/size pair.
+        uint64_t WriterThreadMemory(int compressionType, uint32_t chunkSize) {
+            const uint64_t compressor = wimlib_get_compressor_needed_memory(
+                static_cast<enum wimlib_compression_type>(compressionType), chunkSize, 0);
+            return compressor == 0 ? 0 : compressor + 2ULL * chunkSize;
+        }
+
+        // Uncompressed size of every image, from the XML data wimlib keeps
+        // up to date as images are added.
+        uint64_t ImageTotalBytes(WIMStruct* wim) {
+            wimlib_wim_info info{};
+            if (wimlib_get_wim_info(wim, &info) != 0) {
+                return 0;
+            }
+
+            uint64_t total = 0;
+            for (uint32_t image = 1; image <= info.image_count; ++image) {
+                const wimlib_tchar* bytes = wimlib_get_image_property(wim, static_cast<int>(image), L"TOTALBYTES");
+                if (bytes) {
+                    total += std::wcstoull(bytes, nullptr, 10);
+                }
+            }
+            return total;
+        }
+
+        std::optional<uint64_t> QueryFileSize(const std::wstring& path) {
+            WIN32_FILE_ATTRIBUTE_DATA data{};
+            if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data)) {
+                return std::nullopt;
+            }
+            return (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+        }
+
+        // DISM and wimlib both name split parts name.swm, name2.swm, ...;
+        // the list stops at the first number that does not exist.
+        std::vector<std::wstring> SplitWimParts(const std::wstring& firstPart) {
+            std::vector<std::wstring> parts{ firstPart };
+            const size_t dot = firstPart.find_last_of(L'.');
+            if (dot == std::wstring::npos || _wcsicmp(firstPart.c_str() + dot, L".swm") != 0) {
+                return parts;
+            }
+
+            const std::wstring stem = firstPart.substr(0, dot);
+            for (uint32_t number = 2; ; ++number) {
+                std::wstring part = stem + std::to_wstring(number) + L".swm";
+                if (!QueryFileSize(part)) {
+                    break;
+                }
+                parts.push_back(std::move(part));
+            }
+            return parts;
+        }
+
+        HANDLE OpenSequential(const std::wstring& path) {
+            return CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        }
+
+        // One ReadFile; 0 at end of file, and when the writer of a pipe
+        // has closed its end.
+        domain::Expected<uint32_t> ReadSome(HANDLE source, std::byte* buffer, uint32_t size) {
+            DWORD read = 0;
+            if (!ReadFile(source, buffer, size, &read, nullptr)) {
+                const DWORD error = GetLastError();
+                if (error == ERROR_BROKEN_PIPE || error == ERROR_HANDLE_EOF) {
+                    return 0u;
+                }
+                return domain::Error{ L"Failed to read image source", error, domain::ErrorCategory::IO };
+            }
+            return static_cast<uint32_t>(read);
+        }
+
+        // Copies every part into the pipe wimlib reads from, starting with
+        // the bytes already sitting in the buffer. A reader that has gone
+        // away is not an error here; wimlib reports why it stopped.
+        domain::Expected<void> PumpParts(
+            HANDLE first,
+            uint32_t buffered,
+            const std::vector<std::wstring>& parts,
+            HANDLE sink,
+            std::byte* buffer,
+            uint32_t bufferSize)
+        {
+            platform::UniqueHandle next;
+            HANDLE source = first;
+            size_t part = 0;
+            uint32_t pending = buffered;
+
+            for (;;) {
+                for (uint32_t offset = 0; offset < pending; ) {
+                    DWORD written = 0;
+                    if (!WriteFile(sink, buffer + offset, pending - offset, &written, nullptr)) {
+                        const DWORD error = GetLastError();
+                        if (error == ERROR_NO_DATA || error == ERROR_BROKEN_PIPE) {
+                            return domain::Expected<void>();
+                        }
+                        return domain::Error{ L"Failed to feed image data to wimlib", error, domain::ErrorCategory::IO };
+                    }
+                    offset += written;
+                }
+
+                auto read = ReadSome(source, buffer, bufferSize);
+                if (!read.HasValue()) {
+                    return domain::Error{
+                        L"Failed to read " + parts[part],
+                        read.GetError().GetCode(),
+                        domain::ErrorCategory::IO
+                    };
+                }
+
+                pending = read.Value();
+                if (pending != 0) {
+                    continue;
+                }
+
+                if (++part == parts.size()) {
+                    return domain::Expected<void>();
+                }
+
+                next = platform::Win32HandleFactory::MakeHandle(OpenSequential(parts[part]));
+                if (!next) {
+                    return domain::Error{ L"Failed to open " + parts[part], GetLastError(), domain::ErrorCategory::IO };
+                }
+                source = platform::Win32HandleFactory::ToWin32Handle(next);
+            }
+        }
+
+        // libwim-15.dll is a MinGW build with its own C runtime, so a
+        // descriptor made by ours would mean nothing to it. The one handed
+        // to wimlib_extract_image_from_pipe comes from whichever CRT the
+        // DLL imports; a statically linked wimlib shares ours.
+        struct WimlibCrt {
+            int (__cdecl* openOsHandle)(intptr_t, int) = &_open_osfhandle;
+            int (__cdecl* close)(int) = &_close;
+        };
+
+        WimlibCrt ResolveWimlibCrt() {
+            WimlibCrt crt;
+            const auto* base = reinterpret_cast<const BYTE*>(GetModuleHandleW(L"libwim-15.dll"));
+            if (!base) {
+                return crt;
+            }
+
+            const auto* dos = reinterpret_cast<const IMAGE_DOS_HEADER*>(base);
+            const auto* nt = reinterpret_cast<const IMAGE_NT_HEADERS*>(base + dos->e_lfanew);
+            const IMAGE_DATA_DIRECTORY& imports = nt->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT];
+            if (imports.VirtualAddress == 0) {
+                return crt;
+            }
+
+            HMODULE runtime = nullptr;
+            for (auto* entry = reinterpret_cast<const IMAGE_IMPORT_DESCRIPTOR*>(base + imports.VirtualAddress);
+                entry->Name != 0 && !runtime; ++entry) {
+                const char* name = reinterpret_cast<const char*>(base + entry->Name);
+                if (_stricmp(name, "msvcrt.dll") == 0) {
+                    runtime = GetModuleHandleW(L"msvcrt.dll");
+                }
+                else if (_stricmp(name, "ucrtbase.dll") == 0 || _strnicmp(name, "api-ms-win-crt-", 15) == 0) {
+                    runtime = GetModuleHandleW(L"ucrtbase.dll");
+                }
+            }
+            if (!runtime) {
+                return crt;
+            }
+
+            auto openFd = reinterpret_cast<int (__cdecl*)(intptr_t, int)>(GetProcAddress(runtime, "_open_osfhandle"));
+            auto closeFd = reinterpret_cast<int (__cdecl*)(int)>(GetProcAddress(runtime, "_close"));
+            if (openFd && closeFd) {
+                crt.openOsHandle = openFd;
+                crt.close = closeFd;
+            }
+            return crt;
+        }
+
+        // Turns wimlib extraction and write messages into ImageProgress,
+        // after handing each message to the raw callback set with
+        // SetProgressCallback and to the optimizer's live stats.
+        struct ImageProgressBridge {
+            abstractions::ProgressCallback        callback;
+            wimlib_progress_func_t                chained = nullptr;
+            void*                                 chainedContext = nullptr;
+            WimlibOptimizer*                      owner = nullptr;
+            void (WimlibOptimizer::*observe)(uint32_t, const void*) = nullptr;
+            std::chrono::steady_clock::time_point start;
+            uint64_t                              totalBytes = 0;
+            uint64_t                              completedBytes = 0;
+        };
+
+        enum wimlib_progress_status ForwardProgress(
+            ImageProgressBridge* bridge,
+            enum wimlib_progress_msg msg,
+            union wimlib_progress_info* info)
+        {
+            if (bridge->chained) {
+                const auto status = bridge->chained(msg, info, bridge->chainedContext);
+                if (status != WIMLIB_PROGRESS_STATUS_CONTINUE) {
+                    return status;
+                }
+            }
+
+            if (bridge->owner) {
+                (bridge->owner->*bridge->observe)(static_cast<uint32_t>(msg), info);
+            }
+
+            const wimlib_tchar* currentFile = nullptr;
+            switch (msg) {
+            case WIMLIB_PROGRESS_MSG_EXTRACT_IMAGE_BEGIN:
+            case WIMLIB_PROGRESS_MSG_EXTRACT_STREAMS:
+            case WIMLIB_PROGRESS_MSG_EXTRACT_IMAGE_END:
+                bridge->totalBytes = info->extract.total_bytes;
+                bridge->completedBytes = info->extract.completed_bytes;
+                currentFile = info->extract.target;
+                break;
+            case WIMLIB_PROGRESS_MSG_WRITE_STREAMS:
+                bridge->totalBytes = info->write_streams.total_bytes;
+                bridge->completedBytes = info->write_streams.completed_bytes;
+                break;
+            default:
+                return WIMLIB_PROGRESS_STATUS_CONTINUE;
+            }
+
+            if (!bridge->callback) {
+                return WIMLIB_PROGRESS_STATUS_CONTINUE;
+            }
+
+            const double seconds = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - bridge->start).count();
+
+            abstractions::ImageProgress progress{};
+            progress.completedBytes = bridge->completedBytes;
+            progress.totalBytes = bridge->totalBytes;
+            progress.percentComplete = bridge->totalBytes != 0
+                ? static_cast<uint32_t>(bridge->completedBytes * 100 / bridge->totalBytes)
+                : 0;
+            progress.bytesPerSecond = seconds > 0.0
+                ? static_cast<uint64_t>(bridge->completedBytes / seconds)
+                : 0;
+            if (currentFile) {
+                progress.currentFile = currentFile;
+            }
+
+            bridge->callback(progress);
+            return WIMLIB_PROGRESS_STATUS_CONTINUE;
+        }
+
+        enum wimlib_progress_status ImageProgressThunk(
+            enum wimlib_progress_msg msg,
+            union wimlib_progress_info* info,
+            void* context)
+        {
+            // Nothing may unwind through wimlib's C frames.
+            try {
+                return ForwardProgress(static_cast<ImageProgressBridge*>(context), msg, info);
+            }
+            catch (...) {
+                return WIMLIB_PROGRESS_STATUS_ABORT;
+            }
+        }
+    }
+
     WimlibOptimizer::WimlibOptimizer()
         : mConfig()
         , mLastStats()
-        , mMemoryPool(nullptr)
-        , mMemoryPoolSize(0)
+        , mStatsMutex()
+        , mStatsCallback()
+        , mStatsIntervalMs(DEFAULT_STATS_INTERVAL_MS)
+        , mWriteThreads(0)
         , mProgressCallback(nullptr)
         , mProgressContext(nullptr)
         , mInitialized(false)
         , mPeakMemory(0)
-        , mJobObject()
     {
     }
 
     WimlibOptimizer::WimlibOptimizer(const WimlibOptimizerConfig& config)
         : mConfig(config)
         , mLastStats()
-        , mMemoryPool(nullptr)
-        , mMemoryPoolSize(0)
+        , mStatsMutex()
+        , mStatsCallback()
+        , mStatsIntervalMs(DEFAULT_STATS_INTERVAL_MS)
+        , mWriteThreads(0)
         , mProgressCallback(nullptr)
         , mProgressContext(nullptr)
         , mInitialized(false)
         , mPeakMemory(0)
-        , mJobObject()
     {
     }
 
-    WimlibOptimizer::~WimlibOptimizer() {
-        ReleaseMemoryPool();
-    }
+    WimlibOptimizer::~WimlibOptimizer() = default;
 
     domain::Expected<void> WimlibOptimizer::Initialize() {
         if (mInitialized.load()) {
@@ -60,52 +378,215 @@ namespace winsetup::adapters {
             mConfig.memoryLimitMB = CalculateOptimalMemoryLimit();
         }
 
-        auto memResult = AllocateMemoryPool();
-        if (!memResult.HasValue()) {
-            return memResult;
-        }
+        mWriteThreads = mConfig.maxThreads;
 
         auto threadResult = ConfigureThreadPool();
         if (!threadResult.HasValue()) {
             return threadResult;
         }
 
-        HANDLE hJob = CreateJobObjectW(nullptr, nullptr);
-        if (hJob) {
-            mJobObject = platform::Win32HandleFactory::MakeHandle(hJob);
+        mInitialized.store(true);
+        return domain::Expected<void>();
+    }
+
+    domain::Expected<void> WimlibOptimizer::ApplyImage(
+        const std::wstring& wimPath,
+        uint32_t imageIndex,
+        const std::wstring& targetPath,
+        abstractions::ProgressCallback progressCallback)
+    {
+        BeginStats();
+        return ExtractFromParts({ wimPath }, imageIndex, targetPath, std::move(progressCallback));
+    }
 
-            JOBOBJECT_EXTENDED_LIMIT_INFORMATION jobInfo{};
-            jobInfo.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_JOB_MEMORY;
-            jobInfo.JobMemoryLimit = mConfig.memoryLimitMB * 1024 * 1024;
+    domain::Expected<void> WimlibOptimizer::ApplyImageStreamed(
+        const std::wstring& sourcePath,
+        uint32_t imageIndex,
+        const std::wstring& targetPath,
+        abstractions::ProgressCallback progressCallback)
+    {
+        BeginStats();
 
-            SetInformationJobObject(
-                platform::Win32HandleFactory::ToWin32Handle(mJobObject),
-                JobObjectExtendedLimitInformation,
-                &jobInfo,
-                sizeof(jobInfo)
-            );
+        if (!mInitialized.load()) {
+            auto initResult = Initialize();
+            if (!initResult.HasValue()) {
+                return initResult;
+            }
+        }
 
-            AssignProcessToJobObject(
-                platform::Win32HandleFactory::ToWin32Handle(mJobObject),
-                GetCurrentProcess()
-            );
+        const auto parts = SplitWimParts(sourcePath);
+        auto source = platform::Win32HandleFactory::MakeHandle(OpenSequential(parts.front()));
+        if (!source) {
+            return domain::Error{ L"Failed to open " + parts.front(), GetLastError(), domain::ErrorCategory::IO };
+        }
+        HANDLE sourceHandle = platform::Win32HandleFactory::ToWin32Handle(source);
+
+        // Outlives the pump thread, which is joined before returning.
+        const auto readAhead = std::make_unique_for_overwrite<std::byte[]>(READ_AHEAD_BLOCK_SIZE);
+        std::byte* buffer = readAhead.get();
+
+        // The header decides the route, and a pipe cannot be rewound, so
+        // the bytes read here are the first ones fed to wimlib.
+        static constexpr char PIPABLE_MAGIC[8] = { 'W', 'L', 'P', 'W', 'M', 0, 0, 0 };
+        uint32_t buffered = 0;
+        while (buffered < sizeof(PIPABLE_MAGIC)) {
+            auto read = ReadSome(sourceHandle, buffer + buffered, READ_AHEAD_BLOCK_SIZE - buffered);
+            if (!read.HasValue()) {
+                return read.GetError();
+            }
+            if (read.Value() == 0) {
+                break;
+            }
+            buffered += read.Value();
+        }
+
+        if (buffered < sizeof(PIPABLE_MAGIC) || std::memcmp(buffer, PIPABLE_MAGIC, sizeof(PIPABLE_MAGIC)) != 0) {
+            // A regular WIM has its blob table at the end, so it needs a
+            // seekable file. wimlib still reads the blobs of a split WIM
+            // part after part in file order.
+            if (GetFileType(sourceHandle) != FILE_TYPE_DISK) {
+                return domain::Error{
+                    sourcePath + L" is not a pipable WIM and cannot be applied from a stream",
+                    static_cast<uint32_t>(WIMLIB_ERR_NOT_PIPABLE),
+                    domain::ErrorCategory::Validation
+                };
+            }
+            source.Reset();
+            return ExtractFromParts(parts, imageIndex, targetPath, std::move(progressCallback));
+        }
+
+        HANDLE pipeRead = nullptr;
+        HANDLE pipeWrite = nullptr;
+        if (!CreatePipe(&pipeRead, &pipeWrite, nullptr, PIPE_BUFFER_SIZE)) {
+            return domain::Error{ L"Failed to create the image pipe", GetLastError(), domain::ErrorCategory::System };
+        }
+        auto sink = platform::Win32HandleFactory::MakeHandle(pipeWrite);
+
+        const WimlibCrt crt = ResolveWimlibCrt();
+        const int fd = crt.openOsHandle(reinterpret_cast<intptr_t>(pipeRead), _O_RDONLY | _O_BINARY);
+        if (fd == -1) {
+            CloseHandle(pipeRead);
+            return domain::Error{
+                L"Failed to hand the image pipe to wimlib",
+                ERROR_INVALID_HANDLE,
+                domain::ErrorCategory::System
+            };
+        }
+
+        // Reading the source runs on its own thread, ahead of wimlib by up
+        // to the pipe buffer, while wimlib decompresses and writes files.
+        std::optional<domain::Error> pumpError;
+        std::thread pump([&]() {
+            auto pumped = PumpParts(sourceHandle, buffered, parts, pipeWrite, buffer, READ_AHEAD_BLOCK_SIZE);
+            if (!pumped.HasValue()) {
+                pumpError = pumped.GetError();
+            }
+            sink.Reset();
+        });
+
+        ImageProgressBridge bridge;
+        bridge.callback = std::move(progressCallback);
+        bridge.chained = reinterpret_cast<wimlib_progress_func_t>(mProgressCallback);
+        bridge.chainedContext = mProgressContext;
+        bridge.owner = this;
+        bridge.observe = &WimlibOptimizer::UpdateStats;
+        bridge.start = std::chrono::steady_clock::now();
+
+        const std::wstring image = std::to_wstring(imageIndex);
+        const int ret = wimlib_extract_image_from_pipe_with_progress(
+            fd, image.c_str(), targetPath.c_str(), 0, &ImageProgressThunk, &bridge);
+
+        // Closing the read end fails the pump's next write if wimlib
+        // stopped before the end of the stream.
+        crt.close(fd);
+        pump.join();
+
+        FinishStats();
+
+        // A failed read truncates the stream, which is what wimlib then
+        // complains about; the read error is the useful one.
+        if (pumpError) {
+            return *pumpError;
+        }
+
+        if (ret != 0) {
+            return WimlibError(L"Failed to apply image " + image + L" of " + sourcePath
+                + L" to " + targetPath, ret);
         }
 
-        mInitialized.store(true);
         return domain::Expected<void>();
     }
 
-    domain::Expected<void> WimlibOptimizer::ApplyImage(
-        const std::wstring& wimPath,
+    domain::Expected<void> WimlibOptimizer::ExtractFromParts(
+        const std::vector<std::wstring>& parts,
         uint32_t imageIndex,
         const std::wstring& targetPath,
         abstractions::ProgressCallback progressCallback)
     {
-        return domain::Error{
-            L"ApplyImage not implemented yet",
-            0,
-            domain::ErrorCategory::Imaging
-        };
+        const std::wstring& wimPath = parts.front();
+
+        WIMStruct* rawWim = nullptr;
+        int ret = wimlib_open_wim(wimPath.c_str(), 0, &rawWim);
+        if (ret != 0) {
+            return WimlibError(L"Failed to open " + wimPath, ret);
+        }
+        UniqueWim wim(rawWim);
+
+        // Only the first part of a split WIM holds the metadata; the others
+        // are referenced for their file data.
+        if (parts.size() > 1) {
+            std::vector<const wimlib_tchar*> others;
+            for (size_t part = 1; part < parts.size(); ++part) {
+                others.push_back(parts[part].c_str());
+            }
+            ret = wimlib_reference_resource_files(
+                wim.get(), others.data(), static_cast<unsigned>(others.size()), 0, 0);
+            if (ret != 0) {
+                return WimlibError(L"Failed to open the split parts of " + wimPath, ret);
+            }
+        }
+
+        wimlib_wim_info info{};
+        ret = wimlib_get_wim_info(wim.get(), &info);
+        if (ret != 0) {
+            return WimlibError(L"Failed to read WIM header of " + wimPath, ret);
+        }
+
+        if (imageIndex == 0 || imageIndex > info.image_count) {
+            return domain::Error{
+                L"Image " + std::to_wstring(imageIndex) + L" not found in " + wimPath
+                    + L" (" + std::to_wstring(info.image_count) + L" images)",
+                static_cast<uint32_t>(WIMLIB_ERR_INVALID_IMAGE),
+                domain::ErrorCategory::Validation
+            };
+        }
+
+        auto extractResult = OptimizeExtract(wim.get());
+        if (!extractResult.HasValue()) {
+            return extractResult;
+        }
+
+        ImageProgressBridge bridge;
+        bridge.callback = std::move(progressCallback);
+        bridge.chained = reinterpret_cast<wimlib_progress_func_t>(mProgressCallback);
+        bridge.chainedContext = mProgressContext;
+        bridge.owner = this;
+        bridge.observe = &WimlibOptimizer::UpdateStats;
+        bridge.start = std::chrono::steady_clock::now();
+        wimlib_register_progress_function(wim.get(), &ImageProgressThunk, &bridge);
+
+        // A full-image extraction, so wimlib can fix up absolute reparse
+        // points and apply the root directory's metadata.
+        ret = wimlib_extract_image(wim.get(), static_cast<int>(imageIndex), targetPath.c_str(), 0);
+
+        FinishStats();
+
+        if (ret != 0) {
+            return WimlibError(L"Failed to apply image " + std::to_wstring(imageIndex)
+                + L" of " + wimPath + L" to " + targetPath, ret);
+        }
+
+        return domain::Expected<void>();
     }
 
     domain::Expected<void> WimlibOptimizer::CaptureImage(
@@ -116,11 +597,98 @@ namespace winsetup::adapters {
         abstractions::CompressionType compression,
         abstractions::ProgressCallback progressCallback)
     {
-        return domain::Error{
-            L"CaptureImage not implemented yet",
-            0,
-            domain::ErrorCategory::Imaging
-        };
+        BeginStats();
+
+        const auto compressionType = ToWimlibCompression(compression);
+        const auto existingSize = QueryFileSize(wimPath);
+
+        // A capture replaces whatever is at wimPath unless appending was
+        // asked for; an appended image shares data with the ones already
+        // there, so it is stored once.
+        const bool append = mConfig.appendToExisting && existingSize.has_value();
+
+        WIMStruct* rawWim = nullptr;
+        int ret = append
+            ? wimlib_open_wim(wimPath.c_str(), WIMLIB_OPEN_FLAG_WRITE_ACCESS, &rawWim)
+            : wimlib_create_new_wim(compressionType, &rawWim);
+        if (ret != 0) {
+            return WimlibError(append ? L"Failed to open " + wimPath : L"Failed to create WIM", ret);
+        }
+        UniqueWim wim(rawWim);
+
+        wimlib_wim_info info{};
+        ret = wimlib_get_wim_info(wim.get(), &info);
+        if (ret != 0) {
+            return WimlibError(L"Failed to read WIM header of " + wimPath, ret);
+        }
+
+        // Registered before the scan so its file count reaches the stats.
+        ImageProgressBridge bridge;
+        bridge.callback = std::move(progressCallback);
+        bridge.chained = reinterpret_cast<wimlib_progress_func_t>(mProgressCallback);
+        bridge.chainedContext = mProgressContext;
+        bridge.owner = this;
+        bridge.observe = &WimlibOptimizer::UpdateStats;
+        bridge.start = std::chrono::steady_clock::now();
+        wimlib_register_progress_function(wim.get(), &ImageProgressThunk, &bridge);
+
+        if (append && wimlib_image_name_in_use(wim.get(), imageName.c_str())) {
+            return WimlibError(L"Image name \"" + imageName + L"\" is already used in " + wimPath,
+                WIMLIB_ERR_IMAGE_NAME_COLLISION);
+        }
+
+        ret = wimlib_add_image(wim.get(), sourcePath.c_str(), imageName.c_str(), nullptr, WIMLIB_ADD_FLAG_WINCONFIG);
+        if (ret != 0) {
+            return WimlibError(L"Failed to scan " + sourcePath, ret);
+        }
+
+        const int image = static_cast<int>(info.image_count) + 1;
+        if (!imageDescription.empty()) {
+            ret = wimlib_set_image_property(wim.get(), image, L"DESCRIPTION", imageDescription.c_str());
+            if (ret != 0) {
+                return WimlibError(L"Failed to set image description", ret);
+            }
+        }
+
+        auto captureResult = OptimizeCapture(wim.get(), compressionType);
+        if (!captureResult.HasValue()) {
+            return captureResult;
+        }
+
+        // OptimizeCapture registers the raw callback on its own; the bridge
+        // already forwards to it.
+        wimlib_register_progress_function(wim.get(), &ImageProgressThunk, &bridge);
+
+        // An in-place append cannot change the compression type recorded in
+        // the header, so a different one means rewriting the file.
+        int writeFlags = mConfig.enableSolidCompression ? WIMLIB_WRITE_FLAG_SOLID : 0;
+        if (append && info.compression_type != compressionType) {
+            writeFlags |= WIMLIB_WRITE_FLAG_REBUILD;
+        }
+
+        ret = append
+            ? wimlib_overwrite(wim.get(), writeFlags, mWriteThreads)
+            : wimlib_write(wim.get(), wimPath.c_str(), WIMLIB_ALL_IMAGES, writeFlags, mWriteThreads);
+
+        FinishStats();
+
+        if (ret != 0) {
+            return WimlibError(L"Failed to write " + wimPath, ret);
+        }
+
+        // The file on disk also counts the XML data and lookup table, which
+        // the live figure from wimlib leaves out.
+        if (const auto finalSize = QueryFileSize(wimPath)) {
+            const uint64_t before = (append && !(writeFlags & WIMLIB_WRITE_FLAG_REBUILD)) ? existingSize.value_or(0) : 0;
+            std::lock_guard<std::mutex> lock(mStatsMutex);
+            mLastStats.compressedBytes = *finalSize > before ? *finalSize - before : 0;
+            if (mLastStats.processedBytes != 0) {
+                mLastStats.compressionRatio =
+                    static_cast<double>(mLastStats.compressedBytes) / mLastStats.processedBytes;
+            }
+        }
+
+        return domain::Expected<void>();
     }
 
     domain::Expected<std::vector<abstractions::ImageInfo>> WimlibOptimizer::GetImageInfo(
@@ -137,11 +705,42 @@ namespace winsetup::adapters {
         const std::wstring& wimPath,
         abstractions::CompressionType compression)
     {
-        return domain::Error{
-            L"OptimizeImage not implemented yet",
-            0,
-            domain::ErrorCategory::Imaging
-        };
+        BeginStats();
+
+        WIMStruct* rawWim = nullptr;
+        int ret = wimlib_open_wim(wimPath.c_str(), WIMLIB_OPEN_FLAG_WRITE_ACCESS, &rawWim);
+        if (ret != 0) {
+            return WimlibError(L"Failed to open " + wimPath, ret);
+        }
+        UniqueWim wim(rawWim);
+
+        auto captureResult = OptimizeCapture(wim.get(), ToWimlibCompression(compression));
+        if (!captureResult.HasValue()) {
+            return captureResult;
+        }
+
+        // Rebuilding drops data no image references any more; recompressing
+        // applies the new settings to data that is already compressed.
+        int writeFlags = WIMLIB_WRITE_FLAG_REBUILD | WIMLIB_WRITE_FLAG_RECOMPRESS;
+        if (mConfig.enableSolidCompression) {
+            writeFlags |= WIMLIB_WRITE_FLAG_SOLID;
+        }
+
+        ImageProgressBridge bridge;
+        bridge.chained = reinterpret_cast<wimlib_progress_func_t>(mProgressCallback);
+        bridge.chainedContext = mProgressContext;
+        bridge.owner = this;
+        bridge.observe = &WimlibOptimizer::UpdateStats;
+        bridge.start = std::chrono::steady_clock::now();
+        wimlib_register_progress_function(wim.get(), &ImageProgressThunk, &bridge);
+
+        ret = wimlib_overwrite(wim.get(), writeFlags, mWriteThreads);
+        FinishStats();
+        if (ret != 0) {
+            return WimlibError(L"Failed to rewrite " + wimPath, ret);
+        }
+
+        return domain::Expected<void>();
     }
 
     void WimlibOptimizer::SetCompressionLevel(uint32_t level) {
@@ -172,10 +771,6 @@ namespace winsetup::adapters {
             }
         }
 
-        auto startTime = std::chrono::high_resolution_clock::now();
-
-        mLastStats = WimlibOperationStats{};
-
         auto compResult = ApplyCompressionSettings(wim, compressionType);
         if (!compResult.HasValue()) {
             return compResult;
@@ -186,13 +781,6 @@ namespace winsetup::adapters {
             wimlib_register_progress_function(wim, callback, mProgressContext);
         }
 
-        auto endTime = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-            endTime - startTime
-        );
-        mLastStats.elapsedSeconds = duration.count() / 1000.0;
-        mLastStats.peakMemoryMB = mPeakMemory.load() / (1024 * 1024);
-
         return domain::Expected<void>();
     }
 
@@ -204,28 +792,19 @@ namespace winsetup::adapters {
             }
         }
 
-        auto startTime = std::chrono::high_resolution_clock::now();
-
-        auto extResult = ApplyExtractionSettings(wim);
-        if (!extResult.HasValue()) {
-            return extResult;
-        }
-
         if (mProgressCallback) {
             auto callback = reinterpret_cast<wimlib_progress_func_t>(mProgressCallback);
             wimlib_register_progress_function(wim, callback, mProgressContext);
         }
 
-        auto endTime = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-            endTime - startTime
-        );
-        mLastStats.elapsedSeconds = duration.count() / 1000.0;
-        mLastStats.peakMemoryMB = mPeakMemory.load() / (1024 * 1024);
-
         return domain::Expected<void>();
     }
 
+    void WimlibOptimizer::SetStatsCallback(StatsCallback callback, uint32_t intervalMs) {
+        mStatsCallback = std::move(callback);
+        mStatsIntervalMs = intervalMs;
+    }
+
     void WimlibOptimizer::SetProgressCallback(void* callback, void* context) {
         mProgressCallback = callback;
         mProgressContext = context;
@@ -325,44 +904,11 @@ namespace winsetup::adapters {
         return chunkSizeKB;
     }
 
-    domain::Expected<void> WimlibOptimizer::AllocateMemoryPool() {
-        if (mMemoryPool) {
-            ReleaseMemoryPool();
-        }
-
-        mMemoryPoolSize = mConfig.memoryLimitMB * 1024 * 1024;
-
-        mMemoryPool = VirtualAlloc(
-            nullptr,
-            mMemoryPoolSize,
-            MEM_RESERVE | MEM_COMMIT,
-            PAGE_READWRITE
-        );
-
-        if (!mMemoryPool) {
-            return domain::Error{
-                L"Failed to allocate memory pool",
-                GetLastError(),
-                domain::ErrorCategory::System
-            };
-        }
-
-        return domain::Expected<void>();
-    }
-
-    void WimlibOptimizer::ReleaseMemoryPool() {
-        if (mMemoryPool) {
-            VirtualFree(mMemoryPool, 0, MEM_RELEASE);
-            mMemoryPool = nullptr;
-            mMemoryPoolSize = 0;
-        }
-    }
-
     domain::Expected<void> WimlibOptimizer::ConfigureThreadPool() {
-        wimlib_set_default_compression_level(
-            static_cast<int>(WIMLIB_COMPRESSION_TYPE_LZX),
-            static_cast<uint32_t>(mConfig.level)
-        );
+        const int ret = wimlib_set_default_compression_level(-1, ToWimlibLevel(mConfig.level));
+        if (ret != 0) {
+            return WimlibError(L"Failed to set compression level", ret);
+        }
 
         return domain::Expected<void>();
     }
@@ -384,27 +930,171 @@ namespace winsetup::adapters {
             };
         }
 
-        uint32_t chunkSize = mConfig.chunkSizeKB * 1024;
-        ret = wimlib_set_output_chunk_size(wim, chunkSize);
+        uint32_t chunkSize = 0;
+        if (compressionType != WIMLIB_COMPRESSION_TYPE_NONE) {
+            chunkSize = FitChunkSize(
+                compressionType, CalculateOptimalChunkSize(ImageTotalBytes(wim)) * 1024);
+            ret = wimlib_set_output_chunk_size(wim, chunkSize);
+            if (ret != 0) {
+                return domain::Error{
+                    L"Failed to set chunk size",
+                    static_cast<uint32_t>(ret),
+                    domain::ErrorCategory::Imaging
+                };
+            }
+        }
+
+        if (!mConfig.enableSolidCompression) {
+            mWriteThreads = BudgetWriteThreads(compressionType, chunkSize);
+            return domain::Expected<void>();
+        }
+
+        ret = wimlib_set_output_pack_compression_type(wim, WIMLIB_COMPRESSION_TYPE_LZMS);
         if (ret != 0) {
             return domain::Error{
-                L"Failed to set chunk size",
+                L"Failed to set solid compression type",
                 static_cast<uint32_t>(ret),
                 domain::ErrorCategory::Imaging
             };
         }
 
+        // Solid blocks keep wimlib's 64 MiB chunks unless a single LZMS
+        // compressor at that size would already exceed the memory limit.
+        const uint64_t budget = mConfig.memoryLimitMB * 1024 * 1024;
+        uint32_t solidChunkSize = DEFAULT_SOLID_CHUNK_SIZE;
+        while (solidChunkSize > MIN_SOLID_CHUNK_SIZE &&
+            WriterThreadMemory(WIMLIB_COMPRESSION_TYPE_LZMS, solidChunkSize) > budget) {
+            solidChunkSize /= 2;
+        }
+
+        if (solidChunkSize != DEFAULT_SOLID_CHUNK_SIZE) {
+            ret = wimlib_set_output_pack_chunk_size(wim, solidChunkSize);
+            if (ret != 0) {
+                return domain::Error{
+                    L"Failed to set solid chunk size",
+                    static_cast<uint32_t>(ret),
+                    domain::ErrorCategory::Imaging
+                };
+            }
+        }
+
+        mWriteThreads = BudgetWriteThreads(WIMLIB_COMPRESSION_TYPE_LZMS, solidChunkSize);
         return domain::Expected<void>();
     }
 
-    domain::Expected<void> WimlibOptimizer::ApplyExtractionSettings(
-        WIMStruct* wim
-    ) {
-        return domain::Expected<void>();
+    // The memory limit is enforced through the thread count handed to
+    // wimlib_write, since each compression thread owns its compressor.
+    uint32_t WimlibOptimizer::BudgetWriteThreads(int compressionType, uint32_t chunkSize) const {
+        const uint32_t maxThreads = (std::max)(mConfig.maxThreads, 1u);
+        if (compressionType == WIMLIB_COMPRESSION_TYPE_NONE) {
+            return maxThreads;
+        }
+
+        const uint64_t perThread = WriterThreadMemory(compressionType, chunkSize);
+        if (perThread == 0) {
+            return maxThreads;
+        }
+
+        const uint64_t budget = mConfig.memoryLimitMB * 1024 * 1024;
+        return static_cast<uint32_t>(std::clamp<uint64_t>(budget / perThread, 1, maxThreads));
+    }
+
+    void WimlibOptimizer::BeginStats() {
+        const auto now = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> lock(mStatsMutex);
+            mLastStats = WimlibOperationStats{};
+        }
+        mPeakMemory.store(GetCurrentMemoryUsage());
+        mStatsStart = now;
+        mLastSnapshot = now;
+        mLastMemorySample = now;
+    }
+
+    void WimlibOptimizer::UpdateStats(uint32_t message, const void* info) {
+        const auto* progress = static_cast<const union wimlib_progress_info*>(info);
+        const auto now = std::chrono::steady_clock::now();
+
+        if (now - mLastMemorySample >= std::chrono::milliseconds(MEMORY_SAMPLE_INTERVAL_MS)) {
+            mLastMemorySample = now;
+            SampleMemory();
+        }
+
+        WimlibOperationStats snapshot;
+        {
+            std::lock_guard<std::mutex> lock(mStatsMutex);
+            switch (message) {
+            case WIMLIB_PROGRESS_MSG_SCAN_END:
+                mLastStats.totalFiles = progress->scan.num_nondirs_scanned;
+                break;
+            case WIMLIB_PROGRESS_MSG_EXTRACT_IMAGE_BEGIN:
+            case WIMLIB_PROGRESS_MSG_EXTRACT_STREAMS:
+            case WIMLIB_PROGRESS_MSG_EXTRACT_IMAGE_END:
+                mLastStats.totalBytes = progress->extract.total_bytes;
+                mLastStats.processedBytes = progress->extract.completed_bytes;
+                mLastStats.totalFiles = progress->extract.total_streams;
+                mLastStats.processedFiles = progress->extract.completed_streams;
+                break;
+            case WIMLIB_PROGRESS_MSG_WRITE_STREAMS:
+                mLastStats.totalBytes = progress->write_streams.total_bytes;
+                mLastStats.processedBytes = progress->write_streams.completed_bytes;
+                mLastStats.compressedBytes = progress->write_streams.completed_compressed_bytes;
+                mLastStats.totalFiles = progress->write_streams.total_streams;
+                mLastStats.processedFiles = progress->write_streams.completed_streams;
+                break;
+            default:
+                return;
+            }
+
+            RefreshRates(now);
+
+            const bool done = mLastStats.totalBytes != 0 && mLastStats.processedBytes == mLastStats.totalBytes;
+            if (!mStatsCallback ||
+                (!done && now - mLastSnapshot < std::chrono::milliseconds(mStatsIntervalMs))) {
+                return;
+            }
+            mLastSnapshot = now;
+            snapshot = mLastStats;
+        }
+
+        mStatsCallback(snapshot);
+    }
+
+    void WimlibOptimizer::FinishStats() {
+        SampleMemory();
+
+        std::lock_guard<std::mutex> lock(mStatsMutex);
+        RefreshRates(std::chrono::steady_clock::now());
+        mLastStats.remainingSeconds = 0.0;
+    }
+
+    // Called with mStatsMutex held.
+    void WimlibOptimizer::RefreshRates(std::chrono::steady_clock::time_point now) {
+        const double seconds = std::chrono::duration<double>(now - mStatsStart).count();
+        mLastStats.elapsedSeconds = seconds;
+        if (seconds > 0.0) {
+            mLastStats.bytesPerSecond = mLastStats.processedBytes / seconds;
+            mLastStats.filesPerSecond = mLastStats.processedFiles / seconds;
+        }
+
+        mLastStats.remainingSeconds = mLastStats.bytesPerSecond > 0.0 && mLastStats.totalBytes > mLastStats.processedBytes
+            ? (mLastStats.totalBytes - mLastStats.processedBytes) / mLastStats.bytesPerSecond
+            : 0.0;
+
+        // completed_compressed_bytes is 0 before wimlib 1.13.4 and while
+        // extracting, which leaves the ratio unknown rather than wrong.
+        if (mLastStats.processedBytes != 0 && mLastStats.compressedBytes != 0) {
+            mLastStats.compressionRatio =
+                static_cast<double>(mLastStats.compressedBytes) / mLastStats.processedBytes;
+        }
+
+        mLastStats.peakMemoryMB = mPeakMemory.load() / (1024 * 1024);
     }
 
-    void WimlibOptimizer::UpdateStats(const void* info) {
-        uint64_t currentMemory = GetCurrentMemoryUsage();
+    // Working set is polled rather than tracked, so short spikes between
+    // samples can be missed.
+    void WimlibOptimizer::SampleMemory() {
+        const uint64_t currentMemory = GetCurrentMemoryUsage();
 
         uint64_t expected = mPeakMemory.load();
         while (currentMemory > expected &&
@@ -3,10 +3,14 @@
 
 #include <abstractions/services/storage/IImagingService.h>
 #include <domain/primitives/Expected.h>
-#include <adapters/platform/win32/memory/UniqueHandle.h>
 #include <cstdint>
 #include <memory>
 #include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
 
 struct WIMStruct;
 
@@ -25,7 +29,9 @@ namespace winsetup::adapters {
         uint64_t memoryLimitMB;
         uint32_t chunkSizeKB;
         bool enableSolidCompression;
-        bool enableDeduplication;
+        // Add captured images to a WIM already at the target path instead
+        // of replacing it.
+        bool appendToExisting;
 
         WimlibOptimizerConfig()
             : level(OptimizationLevel::Normal)
@@ -33,30 +39,45 @@ namespace winsetup::adapters {
             , memoryLimitMB(2048)
             , chunkSizeKB(32)
             , enableSolidCompression(false)
-            , enableDeduplication(true)
+            , appendToExisting(false)
         {
         }
     };
 
+    // Filled live from wimlib's progress messages while an operation runs.
+    // File counts are wimlib's stream counts, which track files closely but
+    // not exactly (hard links, named streams, empty files).
     struct WimlibOperationStats {
         uint64_t totalBytes;
+        uint64_t processedBytes;
         uint64_t compressedBytes;
+        uint64_t totalFiles;
         uint64_t processedFiles;
         double compressionRatio;
+        double bytesPerSecond;
+        double filesPerSecond;
+        double remainingSeconds;
         double elapsedSeconds;
         uint64_t peakMemoryMB;
 
         WimlibOperationStats()
             : totalBytes(0)
+            , processedBytes(0)
             , compressedBytes(0)
+            , totalFiles(0)
             , processedFiles(0)
             , compressionRatio(0.0)
+            , bytesPerSecond(0.0)
+            , filesPerSecond(0.0)
+            , remainingSeconds(0.0)
             , elapsedSeconds(0.0)
             , peakMemoryMB(0)
         {
         }
     };
 
+    using StatsCallback = std::function<void(const WimlibOperationStats&)>;
+
     class WimlibOptimizer : public abstractions::IImagingService {
     public:
         WimlibOptimizer();
@@ -75,6 +96,13 @@ namespace winsetup::adapters {
             abstractions::ProgressCallback progressCallback = nullptr
         ) override;
 
+        [[nodiscard]] domain::Expected<void> ApplyImageStreamed(
+            const std::wstring& sourcePath,
+            uint32_t imageIndex,
+            const std::wstring& targetPath,
+            abstractions::ProgressCallback progressCallback = nullptr
+        ) override;
+
         [[nodiscard]] domain::Expected<void> CaptureImage(
             const std::wstring& sourcePath,
             const std::wstring& wimPath,
@@ -111,10 +139,17 @@ namespace winsetup::adapters {
             WIMStruct* wim
         );
 
-        [[nodiscard]] const WimlibOperationStats& GetLastStats() const noexcept {
+        // Safe to call from another thread while an operation is running.
+        [[nodiscard]] WimlibOperationStats GetLastStats() const {
+            std::lock_guard<std::mutex> lock(mStatsMutex);
             return mLastStats;
         }
 
+        // Receives a snapshot at most every intervalMs, and once more when
+        // all data has been processed. Runs on the thread doing the work;
+        // throwing aborts the operation.
+        void SetStatsCallback(StatsCallback callback, uint32_t intervalMs = DEFAULT_STATS_INTERVAL_MS);
+
         void SetProgressCallback(void* callback, void* context);
 
         [[nodiscard]] uint32_t CalculateOptimalThreadCount() const;
@@ -122,19 +157,32 @@ namespace winsetup::adapters {
         [[nodiscard]] uint32_t CalculateOptimalChunkSize(uint64_t estimatedSizeBytes) const;
 
     private:
-        [[nodiscard]] domain::Expected<void> AllocateMemoryPool();
-        void ReleaseMemoryPool();
+        [[nodiscard]] domain::Expected<void> ExtractFromParts(
+            const std::vector<std::wstring>& parts,
+            uint32_t imageIndex,
+            const std::wstring& targetPath,
+            abstractions::ProgressCallback progressCallback
+        );
         [[nodiscard]] domain::Expected<void> ConfigureThreadPool();
         [[nodiscard]] domain::Expected<void> ApplyCompressionSettings(WIMStruct* wim, int compressionType);
-        [[nodiscard]] domain::Expected<void> ApplyExtractionSettings(WIMStruct* wim);
-        void UpdateStats(const void* info);
+        [[nodiscard]] uint32_t BudgetWriteThreads(int compressionType, uint32_t chunkSize) const;
+        void BeginStats();
+        void UpdateStats(uint32_t message, const void* info);
+        void FinishStats();
+        void RefreshRates(std::chrono::steady_clock::time_point now);
+        void SampleMemory();
         [[nodiscard]] uint64_t GetCurrentMemoryUsage() const;
 
         WimlibOptimizerConfig mConfig;
         WimlibOperationStats mLastStats;
+        mutable std::mutex mStatsMutex;
+        StatsCallback mStatsCallback;
+        uint32_t mStatsIntervalMs;
+        std::chrono::steady_clock::time_point mStatsStart;
+        std::chrono::steady_clock::time_point mLastSnapshot;
+        std::chrono::steady_clock::time_point mLastMemorySample;
 
-        void* mMemoryPool;
-        size_t mMemoryPoolSize;
+        uint32_t mWriteThreads;
 
         void* mProgressCallback;
         void* mProgressContext;
@@ -142,12 +190,16 @@ namespace winsetup::adapters {
         std::atomic<bool> mInitialized;
         std::atomic<uint64_t> mPeakMemory;
 
-        platform::UniqueHandle mJobObject;
-
         static constexpr uint32_t MIN_CHUNK_SIZE_KB = 32;
         static constexpr uint32_t MAX_CHUNK_SIZE_KB = 32768;
         static constexpr uint64_t MIN_MEMORY_MB = 256;
         static constexpr uint64_t MAX_MEMORY_MB = 16384;
+        static constexpr uint32_t DEFAULT_SOLID_CHUNK_SIZE = 64u * 1024 * 1024;
+        static constexpr uint32_t MIN_SOLID_CHUNK_SIZE = 4u * 1024 * 1024;
+        static constexpr uint32_t DEFAULT_STATS_INTERVAL_MS = 500;
+        static constexpr uint32_t MEMORY_SAMPLE_INTERVAL_MS = 100;
+        static constexpr uint32_t READ_AHEAD_BLOCK_SIZE = 4u * 1024 * 1024;
+        static constexpr uint32_t PIPE_BUFFER_SIZE = 8u * 1024 * 1024;
     };
 
     class WimlibOptimizerBuilder {
@@ -179,8 +231,8 @@ namespace winsetup::adapters {
             return *this;
         }
 
-        WimlibOptimizerBuilder& WithDeduplication(bool enable) {
-            mConfig.enableDeduplication = enable;
+        WimlibOptimizerBuilder& WithAppendToExisting(bool enable) {
+            mConfig.appendToExisting = enable;
             return *this;
         }
 
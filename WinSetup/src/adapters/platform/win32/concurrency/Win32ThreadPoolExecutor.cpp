@@ -41,12 +41,17 @@ namespace winsetup::adapters::platform {
         }
     }
 
-    void Win32ThreadPoolExecutor::Post(std::function<void()> task) {
+    bool Win32ThreadPoolExecutor::Post(std::function<void()> task) {
+        if (!mIOCP || mThreads.empty() || mShutdown.load())
+            return false;
+
         auto* raw = new std::function<void()>(std::move(task));
         if (!PostQueuedCompletionStatus(mIOCP, 0, kTaskKey,
             reinterpret_cast<LPOVERLAPPED>(raw))) {
             delete raw;
+            return false;
         }
+        return true;
     }
 
     DWORD WINAPI Win32ThreadPoolExecutor::WorkerThreadProc(LPVOID lpParam) {
@@ -16,7 +16,7 @@ namespace winsetup::adapters::platform {
         Win32ThreadPoolExecutor(const Win32ThreadPoolExecutor&) = delete;
         Win32ThreadPoolExecutor& operator=(const Win32ThreadPoolExecutor&) = delete;
 
-        void Post(std::function<void()> task) override;
+        bool Post(std::function<void()> task) override;
 
     private:
         static DWORD WINAPI WorkerThreadProc(LPVOID lpParam);
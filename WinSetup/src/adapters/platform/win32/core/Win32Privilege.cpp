@@ -0,0 +1,26 @@
+// src/adapters/platform/win32/core/Win32Privilege.cpp
+#include "Win32Privilege.h"
+#include "Win32HandleFactory.h"
+#include <Windows.h>
+
+namespace winsetup::adapters::platform {
+
+    bool Win32Privilege::Enable(const wchar_t* privilegeName) noexcept {
+        HANDLE rawToken = nullptr;
+        if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &rawToken))
+            return false;
+        auto token = Win32HandleFactory::MakeHandle(rawToken);
+
+        TOKEN_PRIVILEGES privileges{};
+        privileges.PrivilegeCount = 1;
+        privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+        if (!LookupPrivilegeValueW(nullptr, privilegeName, &privileges.Privileges[0].Luid))
+            return false;
+
+        // Succeeds with ERROR_NOT_ALL_ASSIGNED when the token lacks it.
+        if (!AdjustTokenPrivileges(Win32HandleFactory::ToWin32Handle(token), FALSE, &privileges, 0, nullptr, nullptr))
+            return false;
+        return GetLastError() == ERROR_SUCCESS;
+    }
+
+}
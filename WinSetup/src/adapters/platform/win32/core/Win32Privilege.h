@@ -0,0 +1,16 @@
+// src/adapters/platform/win32/core/Win32Privilege.h
+#pragma once
+
+namespace winsetup::adapters::platform {
+
+    class Win32Privilege {
+    public:
+        Win32Privilege() = delete;
+
+        // Enables a privilege (SE_BACKUP_NAME, ...) on the process token.
+        // Returns false when the token does not hold it, e.g. when the
+        // process is not elevated. Stays enabled for the process lifetime.
+        [[nodiscard]] static bool Enable(const wchar_t* privilegeName) noexcept;
+    };
+
+}
@@ -0,0 +1,61 @@
+﻿#pragma once
+
+#include <domain/primitives/Expected.h>
+#include <cstdint>
+
+namespace winsetup::adapters::platform {
+
+    enum class AsyncFileOperation : uint8_t {
+        Read,
+        Write
+    };
+
+    struct AsyncFileCompletion {
+        uint32_t           slot = 0;
+        AsyncFileOperation operation = AsyncFileOperation::Read;
+        uint32_t           bytesTransferred = 0;
+        uint32_t           errorCode = 0;
+    };
+
+    // A source/destination file pair driven by positional, asynchronous
+    // reads and writes. Each slot has at most one request in flight, and
+    // completions may arrive in any order. Reads that run into end of file
+    // complete successfully with a short byte count. Offsets, lengths and
+    // buffers passed here must be multiples of GetAlignment().
+    class IAsyncFileChannel {
+    public:
+        virtual ~IAsyncFileChannel() = default;
+
+        [[nodiscard]] virtual uint32_t GetAlignment() const noexcept = 0;
+
+        [[nodiscard]] virtual domain::Expected<void> SubmitRead(
+            uint32_t slot,
+            uint64_t offset,
+            void* buffer,
+            uint32_t length
+        ) = 0;
+
+        [[nodiscard]] virtual domain::Expected<void> SubmitWrite(
+            uint32_t slot,
+            uint64_t offset,
+            const void* buffer,
+            uint32_t length
+        ) = 0;
+
+        // Blocks until one submitted request finishes.
+        [[nodiscard]] virtual domain::Expected<AsyncFileCompletion> WaitForCompletion() = 0;
+
+        // True when the destination's valid data length trails the writes.
+        // Writes must then be issued in offset order, or the file system
+        // zero-fills every gap synchronously before the write can start.
+        [[nodiscard]] virtual bool RequiresOrderedWrites() const noexcept = 0;
+
+        // Trims the destination to its real length after an aligned tail write.
+        [[nodiscard]] virtual domain::Expected<void> SetDestinationLength(uint64_t length) = 0;
+
+        // Asks outstanding requests to finish early. They still complete
+        // through WaitForCompletion().
+        virtual void CancelPending() noexcept = 0;
+    };
+
+}
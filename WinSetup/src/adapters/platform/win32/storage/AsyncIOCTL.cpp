@@ -34,15 +34,10 @@ namespace winsetup::adapters::platform {
         DWORD              outputBufferSize,
         AsyncIOCTLCallback callback
     ) {
-        if (mPendingOperations.load() >= mMaxConcurrentOps)
-            return domain::Error{ L"Too many concurrent operations",
-                ERROR_TOO_MANY_CMDS, domain::ErrorCategory::System };
-
         auto op = std::make_shared<AsyncOperation>();
-        op->id = mNextOperationId.fetch_add(1);
         op->hDevice = hDevice;
         op->ioControlCode = ioControlCode;
-        op->callback = callback;
+        op->callback = std::move(callback);
 
         if (inputBuffer && inputBufferSize > 0) {
             op->inputBuffer.resize(inputBufferSize);
@@ -51,6 +46,52 @@ namespace winsetup::adapters::platform {
         if (outputBufferSize > 0)
             op->outputBuffer.resize(outputBufferSize);
 
+        return Submit(std::move(op));
+    }
+
+    domain::Expected<uint32_t> AsyncIOCTL::SendAsync(
+        HANDLE             hDevice,
+        DWORD              ioControlCode,
+        const void* inputBuffer,
+        DWORD              inputBufferSize,
+        std::span<BYTE>    outputBuffer,
+        AsyncIOCTLCallback callback
+    ) {
+        auto op = std::make_shared<AsyncOperation>();
+        op->hDevice = hDevice;
+        op->ioControlCode = ioControlCode;
+        op->callback = std::move(callback);
+        op->externalOutput = outputBuffer.data();
+        op->externalOutputSize = static_cast<DWORD>(outputBuffer.size());
+
+        if (inputBuffer && inputBufferSize > 0) {
+            op->inputBuffer.resize(inputBufferSize);
+            std::memcpy(op->inputBuffer.data(), inputBuffer, inputBufferSize);
+        }
+
+        return Submit(std::move(op));
+    }
+
+    domain::Expected<void> AsyncIOCTL::AssociateDevice(HANDLE hDevice) {
+        std::lock_guard<std::mutex> lock(mOperationsMutex);
+        if (mAssociatedDevices.contains(hDevice))
+            return domain::Expected<void>();
+
+        if (!CreateIoCompletionPort(hDevice, mIOCP, kOperationKey, 0))
+            return domain::Error{ L"Failed to associate device with IOCP",
+                GetLastError(), domain::ErrorCategory::System };
+
+        mAssociatedDevices.insert(hDevice);
+        return domain::Expected<void>();
+    }
+
+    domain::Expected<uint32_t> AsyncIOCTL::Submit(std::shared_ptr<AsyncOperation> op) {
+        if (mPendingOperations.load() >= mMaxConcurrentOps)
+            return domain::Error{ L"Too many concurrent operations",
+                ERROR_TOO_MANY_CMDS, domain::ErrorCategory::System };
+
+        op->id = mNextOperationId.fetch_add(1);
+
         HANDLE hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
         if (!hEvent)
             return domain::Error{ L"Failed to create event",
@@ -59,9 +100,9 @@ namespace winsetup::adapters::platform {
         op->hEvent = Win32HandleFactory::MakeHandle(hEvent);
         ZeroMemory(&op->overlapped, sizeof(OVERLAPPED));
 
-        if (!CreateIoCompletionPort(hDevice, mIOCP, kOperationKey, 0))
-            return domain::Error{ L"Failed to associate device with IOCP",
-                GetLastError(), domain::ErrorCategory::System };
+        auto associateResult = AssociateDevice(op->hDevice);
+        if (!associateResult.HasValue())
+            return associateResult.GetError();
 
         const uint32_t returnId = op->id;
 
@@ -71,14 +112,21 @@ namespace winsetup::adapters::platform {
         }
         mPendingOperations.fetch_add(1);
 
+        BYTE* output = op->externalOutput
+            ? op->externalOutput
+            : (op->outputBuffer.empty() ? nullptr : op->outputBuffer.data());
+        DWORD outputSize = op->externalOutput
+            ? op->externalOutputSize
+            : static_cast<DWORD>(op->outputBuffer.size());
+
         DWORD bytesReturned = 0;
         BOOL result = DeviceIoControl(
             op->hDevice,
             op->ioControlCode,
             op->inputBuffer.empty() ? nullptr : op->inputBuffer.data(),
             static_cast<DWORD>(op->inputBuffer.size()),
-            op->outputBuffer.empty() ? nullptr : op->outputBuffer.data(),
-            static_cast<DWORD>(op->outputBuffer.size()),
+            output,
+            outputSize,
             &bytesReturned,
             &op->overlapped
         );
@@ -126,10 +174,12 @@ namespace winsetup::adapters::platform {
             std::shared_ptr<AsyncOperation> op;
             {
                 std::lock_guard<std::mutex> lock(mOperationsMutex);
-                const AsyncOperation* raw = reinterpret_cast<const AsyncOperation*>(pOverlapped);
-                auto it = mOperations.find(raw->id);
-                if (it != mOperations.end())
-                    op = it->second;
+                for (const auto& [id, candidate] : mOperations) {
+                    if (candidate && &candidate->overlapped == pOverlapped) {
+                        op = candidate;
+                        break;
+                    }
+                }
             }
 
             if (!op)
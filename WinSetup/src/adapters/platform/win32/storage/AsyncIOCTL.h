@@ -3,10 +3,13 @@
 #include <adapters/platform/win32/memory/UniqueHandle.h>
 #include <Windows.h>
 #include <atomic>
+#include <cstring>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <span>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace winsetup::adapters::platform {
@@ -48,6 +51,15 @@ namespace winsetup::adapters::platform {
             AsyncIOCTLCallback callback
         );
 
+        [[nodiscard]] domain::Expected<uint32_t> SendAsync(
+            HANDLE             hDevice,
+            DWORD              ioControlCode,
+            const void* inputBuffer,
+            DWORD              inputBufferSize,
+            std::span<BYTE>    outputBuffer,
+            AsyncIOCTLCallback callback
+        );
+
         [[nodiscard]] domain::Expected<AsyncIOCTLResult> Wait(
             uint32_t operationId,
             DWORD    timeoutMs = INFINITE
@@ -72,6 +84,8 @@ namespace winsetup::adapters::platform {
             DWORD                        ioControlCode = 0;
             std::vector<BYTE>            inputBuffer;
             std::vector<BYTE>            outputBuffer;
+            BYTE*                        externalOutput = nullptr;
+            DWORD                        externalOutputSize = 0;
             OVERLAPPED                   overlapped{};
             UniqueHandle                 hEvent;
             AsyncIOCTLCallback           callback;
@@ -82,6 +96,8 @@ namespace winsetup::adapters::platform {
             AsyncOperation() = default;
         };
 
+        [[nodiscard]] domain::Expected<uint32_t> Submit(std::shared_ptr<AsyncOperation> op);
+        [[nodiscard]] domain::Expected<void> AssociateDevice(HANDLE hDevice);
         void CompletionLoop();
         void NotifyCompletion(std::shared_ptr<AsyncOperation> op);
         [[nodiscard]] std::shared_ptr<AsyncOperation> FindOperation(uint32_t operationId);
@@ -94,6 +110,7 @@ namespace winsetup::adapters::platform {
         size_t                                                          mMaxConcurrentOps{ kMaxConcurrentOperations };
         std::unordered_map<uint32_t, std::shared_ptr<AsyncOperation>>  mOperations;
         mutable std::mutex                                              mOperationsMutex;
+        std::unordered_set<HANDLE>                                      mAssociatedDevices;
         std::atomic<bool>                                               mShutdown{ false };
 
         static constexpr size_t    kMaxConcurrentOperations = 32;
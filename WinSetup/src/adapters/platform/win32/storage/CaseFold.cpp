@@ -0,0 +1,133 @@
+﻿#include "CaseFold.h"
+#include <cstring>
+#include <cwctype>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define WINSETUP_CASEFOLD_SSE2 1
+#endif
+
+namespace winsetup::adapters::platform {
+
+    namespace {
+        constexpr size_t   BLOCK_CHARS = 8;
+        constexpr uint64_t MIX_PRIME_1 = 0x87C37B91114253D5ULL;
+        constexpr uint64_t MIX_PRIME_2 = 0x4CF5AD432745937FULL;
+        constexpr uint64_t FINAL_PRIME = 0xC4CEB9FE1A85EC53ULL;
+
+        struct FoldedBlock {
+            uint64_t low;
+            uint64_t high;
+        };
+
+        inline uint64_t MixBlock(uint64_t hash, const FoldedBlock& block) noexcept {
+            hash = (hash ^ block.low) * MIX_PRIME_1;
+            hash ^= hash >> 32;
+            hash = (hash ^ block.high) * MIX_PRIME_2;
+            hash ^= hash >> 29;
+            return hash;
+        }
+
+        inline FoldedBlock FoldScalar(const wchar_t* chars, size_t count) noexcept {
+            uint16_t lanes[BLOCK_CHARS] = {};
+            for (size_t i = 0; i < count; ++i)
+                lanes[i] = static_cast<uint16_t>(CaseFold::FoldChar(chars[i]));
+
+            FoldedBlock block;
+            std::memcpy(&block, lanes, sizeof(block));
+            return block;
+        }
+
+#if defined(WINSETUP_CASEFOLD_SSE2)
+        static_assert(sizeof(FoldedBlock) == sizeof(__m128i));
+
+        inline bool IsAsciiBlock(__m128i chars) noexcept {
+            const __m128i high = _mm_and_si128(chars, _mm_set1_epi16(static_cast<short>(0xFF80)));
+            return _mm_movemask_epi8(_mm_cmpeq_epi16(high, _mm_setzero_si128())) == 0xFFFF;
+        }
+
+        inline __m128i FoldAsciiBlock(__m128i chars) noexcept {
+            const __m128i aboveA = _mm_cmpgt_epi16(chars, _mm_set1_epi16(L'A' - 1));
+            const __m128i belowZ = _mm_cmplt_epi16(chars, _mm_set1_epi16(L'Z' + 1));
+            const __m128i upper = _mm_and_si128(aboveA, belowZ);
+            return _mm_add_epi16(chars, _mm_and_si128(upper, _mm_set1_epi16(0x20)));
+        }
+
+        inline FoldedBlock FoldBlock(const wchar_t* chars) noexcept {
+            if constexpr (sizeof(wchar_t) == sizeof(uint16_t)) {
+                const __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(chars));
+                if (IsAsciiBlock(raw)) {
+                    FoldedBlock block;
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(&block), FoldAsciiBlock(raw));
+                    return block;
+                }
+            }
+            return FoldScalar(chars, BLOCK_CHARS);
+        }
+
+        inline bool EqualsBlock(const wchar_t* a, const wchar_t* b) noexcept {
+            if constexpr (sizeof(wchar_t) == sizeof(uint16_t)) {
+                const __m128i rawA = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+                const __m128i rawB = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+                if (IsAsciiBlock(_mm_or_si128(rawA, rawB))) {
+                    const __m128i equal = _mm_cmpeq_epi16(FoldAsciiBlock(rawA), FoldAsciiBlock(rawB));
+                    return _mm_movemask_epi8(equal) == 0xFFFF;
+                }
+            }
+            for (size_t i = 0; i < BLOCK_CHARS; ++i) {
+                if (CaseFold::FoldChar(a[i]) != CaseFold::FoldChar(b[i])) return false;
+            }
+            return true;
+        }
+#else
+        inline FoldedBlock FoldBlock(const wchar_t* chars) noexcept {
+            return FoldScalar(chars, BLOCK_CHARS);
+        }
+
+        inline bool EqualsBlock(const wchar_t* a, const wchar_t* b) noexcept {
+            for (size_t i = 0; i < BLOCK_CHARS; ++i) {
+                if (CaseFold::FoldChar(a[i]) != CaseFold::FoldChar(b[i])) return false;
+            }
+            return true;
+        }
+#endif
+    }
+
+    wchar_t CaseFold::FoldChar(wchar_t c) noexcept {
+        if (c < 0x80)
+            return (c >= L'A' && c <= L'Z') ? static_cast<wchar_t>(c + 0x20) : c;
+        return static_cast<wchar_t>(std::towlower(c));
+    }
+
+    uint64_t CaseFold::Hash(std::wstring_view text, uint64_t seed) noexcept {
+        uint64_t hash = seed ^ (static_cast<uint64_t>(text.size()) * FINAL_PRIME);
+
+        const wchar_t* cursor = text.data();
+        size_t remaining = text.size();
+        for (; remaining >= BLOCK_CHARS; cursor += BLOCK_CHARS, remaining -= BLOCK_CHARS)
+            hash = MixBlock(hash, FoldBlock(cursor));
+
+        if (remaining > 0)
+            hash = MixBlock(hash, FoldScalar(cursor, remaining));
+
+        hash ^= hash >> 33;
+        hash *= FINAL_PRIME;
+        hash ^= hash >> 29;
+        return hash;
+    }
+
+    bool CaseFold::Equals(std::wstring_view a, std::wstring_view b) noexcept {
+        if (a.size() != b.size()) return false;
+
+        size_t offset = 0;
+        for (; offset + BLOCK_CHARS <= a.size(); offset += BLOCK_CHARS) {
+            if (!EqualsBlock(a.data() + offset, b.data() + offset)) return false;
+        }
+
+        for (; offset < a.size(); ++offset) {
+            if (FoldChar(a[offset]) != FoldChar(b[offset])) return false;
+        }
+        return true;
+    }
+
+}
@@ -0,0 +1,36 @@
+﻿#pragma once
+
+#include <string_view>
+#include <cstdint>
+
+namespace winsetup::adapters::platform {
+
+    // Case-insensitive hashing and comparison of UTF-16 names without
+    // building lowercase copies. Blocks of ASCII are folded eight characters
+    // at a time with SSE2; any block holding a non-ASCII character falls back
+    // to towlower, and both paths produce identical hashes.
+    class CaseFold {
+    public:
+        CaseFold() = delete;
+
+        static constexpr uint64_t HASH_SEED = 0x9E3779B97F4A7C15ULL;
+
+        [[nodiscard]] static wchar_t FoldChar(wchar_t c) noexcept;
+
+        [[nodiscard]] static uint64_t Hash(std::wstring_view text, uint64_t seed = HASH_SEED) noexcept;
+
+        [[nodiscard]] static bool Equals(std::wstring_view a, std::wstring_view b) noexcept;
+
+        [[nodiscard]] static bool EndsWith(std::wstring_view text, std::wstring_view suffix) noexcept {
+            return suffix.size() <= text.size() &&
+                Equals(text.substr(text.size() - suffix.size()), suffix);
+        }
+
+        // Chains a path component's hash onto its parent directory's hash.
+        [[nodiscard]] static uint64_t CombinePath(uint64_t parentHash, uint64_t componentHash) noexcept {
+            uint64_t hash = (parentHash ^ componentHash) * 0xFF51AFD7ED558CCDULL;
+            return hash ^ (hash >> 32) ^ (parentHash << 7);
+        }
+    };
+
+}
@@ -0,0 +1,66 @@
+﻿#include "ContentChunker.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+
+namespace winsetup::adapters::platform {
+
+    namespace {
+        constexpr uint64_t GEAR_SEED = 0x5EEDC0DEC0FFEE11ULL;
+
+        constexpr std::array<uint64_t, 256> MakeGearTable() noexcept {
+            std::array<uint64_t, 256> table{};
+            uint64_t state = GEAR_SEED;
+            for (auto& entry : table) {
+                state += 0x9E3779B97F4A7C15ULL;
+                uint64_t z = state;
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+                entry = z ^ (z >> 31);
+            }
+            return table;
+        }
+
+        constexpr std::array<uint64_t, 256> GEAR = MakeGearTable();
+
+        // The top bits of the gear hash depend on the most bytes, so the
+        // masks test those.
+        constexpr uint64_t TopBitsMask(uint32_t bits) noexcept {
+            return bits == 0 ? 0 : ~0ULL << (64 - bits);
+        }
+    }
+
+    ContentChunker::ContentChunker(const ContentChunkerPolicy& policy) noexcept
+        : mMinSize((std::max)(policy.minSize, 64u))
+        , mAverageSize((std::max)(std::bit_ceil(policy.averageSize), mMinSize))
+        , mMaxSize((std::max)(policy.maxSize, mAverageSize))
+    {
+        const uint32_t bits = static_cast<uint32_t>(std::countr_zero(mAverageSize));
+        mMaskStrict = TopBitsMask((std::min)(bits + 2, 63u));
+        mMaskLoose = TopBitsMask(bits > 2 ? bits - 2 : 1);
+    }
+
+    size_t ContentChunker::FindCut(const uint8_t* data, size_t length, bool final) const noexcept {
+        if (length <= mMinSize)
+            return final ? length : 0;
+
+        const size_t limit = (std::min)(length, static_cast<size_t>(mMaxSize));
+        const size_t normal = (std::min)(limit, static_cast<size_t>(mAverageSize));
+
+        uint64_t hash = 0;
+        size_t i = mMinSize;
+        for (; i < normal; ++i) {
+            hash = (hash << 1) + GEAR[data[i]];
+            if ((hash & mMaskStrict) == 0) return i + 1;
+        }
+        for (; i < limit; ++i) {
+            hash = (hash << 1) + GEAR[data[i]];
+            if ((hash & mMaskLoose) == 0) return i + 1;
+        }
+
+        if (limit == mMaxSize || final)
+            return limit;
+        return 0;
+    }
+
+}
@@ -0,0 +1,40 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace winsetup::adapters::platform {
+
+    struct ContentChunkerPolicy {
+        uint32_t minSize = 64 * 1024;
+        uint32_t averageSize = 256 * 1024;
+        uint32_t maxSize = 1024 * 1024;
+    };
+
+    // Content-defined chunking with a gear rolling hash (FastCDC). A cut
+    // depends only on the bytes just before it, so the same data produces
+    // the same chunks wherever it sits in a file, and an insertion moves
+    // one boundary instead of all that follow. Below the average size the
+    // cut condition is stricter and above it looser, which keeps chunk
+    // sizes close to the average. Nothing here depends on the Windows
+    // headers.
+    class ContentChunker {
+    public:
+        explicit ContentChunker(const ContentChunkerPolicy& policy = {}) noexcept;
+
+        // Length of the chunk that starts at data, or 0 when more input is
+        // needed to place the cut. Callers that pass at least GetMaxSize()
+        // bytes, or set final, always get a cut.
+        [[nodiscard]] size_t FindCut(const uint8_t* data, size_t length, bool final) const noexcept;
+
+        [[nodiscard]] uint32_t GetMaxSize() const noexcept { return mMaxSize; }
+
+    private:
+        uint32_t mMinSize;
+        uint32_t mAverageSize;
+        uint32_t mMaxSize;
+        uint64_t mMaskStrict;
+        uint64_t mMaskLoose;
+    };
+
+}
@@ -0,0 +1,89 @@
+﻿#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace winsetup::adapters::platform {
+
+    // Bounded hand-off between the directory walk and the copy workers.
+    // Workers share the front batch until it runs dry and then retire it,
+    // which frees a slot for the producer; a full queue blocks the walk so
+    // enumeration never runs far ahead of the copy. Close() releases both
+    // sides, whether the walk finished or a worker saw cancellation.
+    // Nothing here depends on the Windows headers.
+    template <typename Batch>
+    class CopyBatchQueue {
+    public:
+        explicit CopyBatchQueue(size_t capacity)
+            : mCapacity(capacity > 0 ? capacity : 1)
+        {
+        }
+
+        CopyBatchQueue(const CopyBatchQueue&) = delete;
+        CopyBatchQueue& operator=(const CopyBatchQueue&) = delete;
+
+        // Returns false once the queue is closed; the batch is dropped.
+        [[nodiscard]] bool Push(std::shared_ptr<Batch> batch) {
+            std::unique_lock lock(mMutex);
+            mNotFull.wait(lock, [this] { return mClosed || mBatches.size() < mCapacity; });
+            if (mClosed)
+                return false;
+            mBatches.push_back(std::move(batch));
+            mNotEmpty.notify_all();
+            return true;
+        }
+
+        // Blocks until a batch is available. Returns null when the queue is
+        // closed and drained.
+        [[nodiscard]] std::shared_ptr<Batch> Acquire() {
+            std::unique_lock lock(mMutex);
+            mNotEmpty.wait(lock, [this] { return mClosed || !mBatches.empty(); });
+            return mBatches.empty() ? nullptr : mBatches.front();
+        }
+
+        // Called by every worker that finds the batch exhausted; only the
+        // first call for a given batch removes it.
+        void Retire(const Batch* batch) {
+            std::lock_guard lock(mMutex);
+            if (!mBatches.empty() && mBatches.front().get() == batch) {
+                mBatches.pop_front();
+                mNotFull.notify_all();
+            }
+        }
+
+        // Batches queued and not yet retired; the front one may already be
+        // fully handed out.
+        [[nodiscard]] size_t GetPendingCount() {
+            std::lock_guard lock(mMutex);
+            return mBatches.size();
+        }
+
+        void Close() {
+            std::lock_guard lock(mMutex);
+            mClosed = true;
+            mNotEmpty.notify_all();
+            mNotFull.notify_all();
+        }
+
+        // Drops queued batches so workers stop after their current item.
+        void Abort() {
+            std::lock_guard lock(mMutex);
+            mClosed = true;
+            mBatches.clear();
+            mNotEmpty.notify_all();
+            mNotFull.notify_all();
+        }
+
+    private:
+        const size_t                       mCapacity;
+        std::mutex                         mMutex;
+        std::condition_variable            mNotEmpty;
+        std::condition_variable            mNotFull;
+        std::deque<std::shared_ptr<Batch>> mBatches;
+        bool                               mClosed = false;
+    };
+
+}
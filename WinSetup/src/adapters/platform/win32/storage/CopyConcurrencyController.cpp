@@ -0,0 +1,162 @@
+﻿#include "CopyConcurrencyController.h"
+#include <algorithm>
+
+namespace winsetup::adapters::platform {
+
+    namespace {
+        CopyConcurrencySettings Clamp(CopyConcurrencySettings settings, const CopyConcurrencyLimits& limits) noexcept {
+            settings.workers = std::clamp(settings.workers, 1u, (std::max)(limits.maxWorkers, 1u));
+            settings.bufferSizeKB = std::clamp(settings.bufferSizeKB,
+                limits.minBufferSizeKB, (std::max)(limits.maxBufferSizeKB, limits.minBufferSizeKB));
+            return settings;
+        }
+    }
+
+    CopyConcurrencyController::CopyConcurrencyController(
+        const CopyConcurrencySettings& start,
+        const CopyConcurrencyLimits& limits
+    )
+        : mLimits(limits)
+        , mCurrent(Clamp(start, limits))
+        , mBest(mCurrent)
+        , mActiveWorkers(mCurrent.workers)
+        , mBufferSizeKB(mCurrent.bufferSizeKB)
+    {
+    }
+
+    bool CopyConcurrencyController::Observe(uint64_t bytes, uint32_t files, double seconds) {
+        if (seconds <= 0.0) return false;
+        const double score = (static_cast<double>(bytes)
+            + static_cast<double>(files) * static_cast<double>(mLimits.perFileCostBytes)) / seconds;
+        if (score <= 0.0) return false;
+
+        std::lock_guard lock(mMutex);
+        if (mWarmup) {
+            mWarmup = false;
+            return false;
+        }
+
+        if (mPhase == Phase::Settled) {
+            if (score >= mBestScore * RESEARCH_THRESHOLD) {
+                mBestScore = 0.75 * mBestScore + 0.25 * score;
+                return false;
+            }
+            // The workload changed under us, e.g. from large files to a
+            // directory of small ones; search again from here, trying fewer
+            // workers first since that is the cheaper mistake.
+            mPhase = Phase::Workers;
+            mDirection = -1;
+            mBest = mCurrent;
+            mBestScore = score;
+            mHaveBaseline = true;
+            mImprovedInPhase = false;
+            mTriedReverse = false;
+            return Step();
+        }
+
+        if (!mHaveBaseline) {
+            mHaveBaseline = true;
+            mBestScore = score;
+            return Step();
+        }
+
+        if (score > mBestScore * IMPROVEMENT) {
+            mBest = mCurrent;
+            mBestScore = score;
+            mImprovedInPhase = true;
+            return Step();
+        }
+
+        mCurrent = mBest;
+        if (!mImprovedInPhase && !mTriedReverse) {
+            mTriedReverse = true;
+            mDirection = -mDirection;
+            return Step();
+        }
+        return NextPhase();
+    }
+
+    CopyConcurrencySettings CopyConcurrencyController::GetBestSettings() const {
+        std::lock_guard lock(mMutex);
+        return mBest;
+    }
+
+    bool CopyConcurrencyController::IsSettled() const {
+        std::lock_guard lock(mMutex);
+        return mPhase == Phase::Settled;
+    }
+
+    bool CopyConcurrencyController::WaitForTurn(uint32_t slot) {
+        if (slot < GetActiveWorkers()) return true;
+
+        std::unique_lock lock(mGateMutex);
+        mGate.wait(lock, [this, slot] { return mReleased || slot < GetActiveWorkers(); });
+        return slot < GetActiveWorkers();
+    }
+
+    void CopyConcurrencyController::Release() {
+        {
+            std::lock_guard lock(mGateMutex);
+            mReleased = true;
+        }
+        mGate.notify_all();
+    }
+
+    CopyConcurrencySettings CopyConcurrencyController::Move(
+        const CopyConcurrencySettings& from,
+        int direction
+    ) const noexcept {
+        CopyConcurrencySettings next = from;
+        if (mPhase == Phase::Workers)
+            next.workers = direction > 0 ? from.workers * 2 : from.workers / 2;
+        else
+            next.bufferSizeKB = direction > 0 ? from.bufferSizeKB * 2 : from.bufferSizeKB / 2;
+        return Clamp(next, mLimits);
+    }
+
+    // Tries the next setting in the current direction from the best one,
+    // or turns around or moves to the next phase when there is none.
+    bool CopyConcurrencyController::Step() {
+        const CopyConcurrencySettings next = Move(mBest, mDirection);
+        if (next != mBest)
+            return Apply(next);
+
+        mCurrent = mBest;
+        if (!mImprovedInPhase && !mTriedReverse) {
+            mTriedReverse = true;
+            mDirection = -mDirection;
+            const CopyConcurrencySettings reverse = Move(mBest, mDirection);
+            if (reverse != mBest)
+                return Apply(reverse);
+        }
+        return NextPhase();
+    }
+
+    bool CopyConcurrencyController::NextPhase() {
+        mImprovedInPhase = false;
+        mTriedReverse = false;
+        mDirection = 1;
+        if (mPhase == Phase::Workers) {
+            mPhase = Phase::Buffer;
+            return Step();
+        }
+        mPhase = Phase::Settled;
+        return Apply(mBest);
+    }
+
+    bool CopyConcurrencyController::Apply(const CopyConcurrencySettings& settings) {
+        const bool changed = !(settings == CopyConcurrencySettings{
+            mActiveWorkers.load(std::memory_order_relaxed),
+            mBufferSizeKB.load(std::memory_order_relaxed) });
+        mCurrent = settings;
+        mWarmup = changed;
+        mBufferSizeKB.store(settings.bufferSizeKB, std::memory_order_relaxed);
+        {
+            std::lock_guard lock(mGateMutex);
+            mActiveWorkers.store(settings.workers, std::memory_order_relaxed);
+        }
+        mGate.notify_all();
+        return changed;
+    }
+
+}
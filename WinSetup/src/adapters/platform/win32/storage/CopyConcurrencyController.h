@@ -0,0 +1,101 @@
+﻿#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace winsetup::adapters::platform {
+
+    struct CopyConcurrencySettings {
+        uint32_t workers = 2;
+        uint32_t bufferSizeKB = 256;
+
+        [[nodiscard]] bool operator==(const CopyConcurrencySettings&) const noexcept = default;
+    };
+
+    struct CopyConcurrencyLimits {
+        uint32_t maxWorkers = 16;
+        uint32_t minBufferSizeKB = 64;
+        uint32_t maxBufferSizeKB = 4096;
+        uint64_t perFileCostBytes = 64 * 1024;
+    };
+
+    // Hill-climbs the number of active copy workers and then the buffer
+    // size from measured throughput. Each trial is held for one interval to
+    // settle and scored on the next; a step is kept only if it beats the
+    // best score by IMPROVEMENT, otherwise the controller goes back to the
+    // best settings, tries the other direction once, and moves on. Once
+    // settled it keeps watching, and searches again from where it stands
+    // when throughput falls below RESEARCH_THRESHOLD of what it settled
+    // at. A score counts files as well as bytes, since with many small
+    // files the per-file cost dominates, and because the worker count is
+    // fixed for an interval it also reflects per-item latency.
+    //
+    // Workers above the active count park in WaitForTurn() until the count
+    // grows or Release() is called. Nothing here depends on the Windows
+    // headers.
+    class CopyConcurrencyController {
+    public:
+        CopyConcurrencyController(const CopyConcurrencySettings& start, const CopyConcurrencyLimits& limits);
+
+        CopyConcurrencyController(const CopyConcurrencyController&) = delete;
+        CopyConcurrencyController& operator=(const CopyConcurrencyController&) = delete;
+
+        // Feeds one interval's progress; returns true when the settings
+        // changed. Intervals in which the workers were starved for work
+        // should not be fed, as they say nothing about the settings.
+        bool Observe(uint64_t bytes, uint32_t files, double seconds);
+
+        [[nodiscard]] uint32_t GetActiveWorkers() const noexcept {
+            return mActiveWorkers.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] uint32_t GetBufferSizeKB() const noexcept {
+            return mBufferSizeKB.load(std::memory_order_relaxed);
+        }
+
+        // Best settings found so far; a later copy between the same devices
+        // can start from them.
+        [[nodiscard]] CopyConcurrencySettings GetBestSettings() const;
+
+        [[nodiscard]] bool IsSettled() const;
+
+        // Blocks a worker whose slot is above the active count. Returns
+        // false once released while still above it; the worker should exit.
+        [[nodiscard]] bool WaitForTurn(uint32_t slot);
+
+        void Release();
+
+        static constexpr double IMPROVEMENT = 1.08;
+        static constexpr double RESEARCH_THRESHOLD = 0.7;
+
+    private:
+        enum class Phase { Workers, Buffer, Settled };
+
+        [[nodiscard]] CopyConcurrencySettings Move(const CopyConcurrencySettings& from, int direction) const noexcept;
+
+        bool Step();
+        bool NextPhase();
+        bool Apply(const CopyConcurrencySettings& settings);
+
+        CopyConcurrencyLimits   mLimits;
+        mutable std::mutex      mMutex;
+        Phase                   mPhase = Phase::Workers;
+        int                     mDirection = 1;
+        bool                    mHaveBaseline = false;
+        bool                    mImprovedInPhase = false;
+        bool                    mTriedReverse = false;
+        bool                    mWarmup = false;
+        double                  mBestScore = 0.0;
+        CopyConcurrencySettings mCurrent;
+        CopyConcurrencySettings mBest;
+
+        std::atomic<uint32_t>   mActiveWorkers;
+        std::atomic<uint32_t>   mBufferSizeKB;
+        std::mutex              mGateMutex;
+        std::condition_variable mGate;
+        bool                    mReleased = false;
+    };
+
+}
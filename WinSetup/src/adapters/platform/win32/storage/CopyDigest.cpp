@@ -0,0 +1,181 @@
+﻿#include "CopyDigest.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace winsetup::adapters::platform {
+
+    namespace {
+        constexpr uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+        constexpr uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+        constexpr uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+        constexpr uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+        constexpr uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+        inline uint64_t Read64(const uint8_t* p) noexcept {
+            uint64_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        inline uint32_t Read32(const uint8_t* p) noexcept {
+            uint32_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        inline uint64_t Round(uint64_t acc, uint64_t input) noexcept {
+            acc += input * PRIME64_2;
+            acc = std::rotl(acc, 31);
+            return acc * PRIME64_1;
+        }
+
+        inline uint64_t MergeRound(uint64_t acc, uint64_t lane) noexcept {
+            acc ^= Round(0, lane);
+            return acc * PRIME64_1 + PRIME64_4;
+        }
+
+        inline void ConsumeStripe(uint64_t* lanes, const uint8_t* p) noexcept {
+            lanes[0] = Round(lanes[0], Read64(p));
+            lanes[1] = Round(lanes[1], Read64(p + 8));
+            lanes[2] = Round(lanes[2], Read64(p + 16));
+            lanes[3] = Round(lanes[3], Read64(p + 24));
+        }
+    }
+
+    Xxh64::Xxh64(uint64_t seed) noexcept
+        : mLanes{ seed + PRIME64_1 + PRIME64_2, seed + PRIME64_2, seed, seed - PRIME64_1 }
+        , mSeed(seed)
+    {
+    }
+
+    void Xxh64::Update(const void* data, size_t length) noexcept {
+        const auto* p = static_cast<const uint8_t*>(data);
+        const uint8_t* const end = p + length;
+        mTotalLength += length;
+
+        if (mStripeLength > 0) {
+            const size_t take = (std::min)(length, sizeof(mStripe) - mStripeLength);
+            std::memcpy(mStripe + mStripeLength, p, take);
+            mStripeLength += static_cast<uint32_t>(take);
+            p += take;
+            if (mStripeLength < sizeof(mStripe)) return;
+            ConsumeStripe(mLanes, mStripe);
+            mStripeLength = 0;
+        }
+
+        for (; end - p >= 32; p += 32)
+            ConsumeStripe(mLanes, p);
+
+        if (p < end) {
+            std::memcpy(mStripe, p, static_cast<size_t>(end - p));
+            mStripeLength = static_cast<uint32_t>(end - p);
+        }
+    }
+
+    uint64_t Xxh64::Digest() const noexcept {
+        uint64_t hash;
+        if (mTotalLength >= 32) {
+            hash = std::rotl(mLanes[0], 1) + std::rotl(mLanes[1], 7)
+                + std::rotl(mLanes[2], 12) + std::rotl(mLanes[3], 18);
+            for (uint64_t lane : mLanes)
+                hash = MergeRound(hash, lane);
+        }
+        else {
+            hash = mSeed + PRIME64_5;
+        }
+        hash += mTotalLength;
+
+        const uint8_t* p = mStripe;
+        const uint8_t* const end = mStripe + mStripeLength;
+        for (; end - p >= 8; p += 8) {
+            hash ^= Round(0, Read64(p));
+            hash = std::rotl(hash, 27) * PRIME64_1 + PRIME64_4;
+        }
+        if (end - p >= 4) {
+            hash ^= static_cast<uint64_t>(Read32(p)) * PRIME64_1;
+            hash = std::rotl(hash, 23) * PRIME64_2 + PRIME64_3;
+            p += 4;
+        }
+        for (; p < end; ++p) {
+            hash ^= *p * PRIME64_5;
+            hash = std::rotl(hash, 11) * PRIME64_1;
+        }
+
+        hash ^= hash >> 33;
+        hash *= PRIME64_2;
+        hash ^= hash >> 29;
+        hash *= PRIME64_3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+    uint64_t Xxh64::Hash(const void* data, size_t length, uint64_t seed) noexcept {
+        Xxh64 state(seed);
+        state.Update(data, length);
+        return state.Digest();
+    }
+
+    CopyDigest::CopyDigest(uint64_t fileSize)
+        : mFileSize(fileSize)
+        , mBlockHashes(static_cast<size_t>((fileSize + BLOCK_SIZE - 1) / BLOCK_SIZE))
+    {
+    }
+
+    uint32_t CopyDigest::BlockLength(uint64_t block) const noexcept {
+        const uint64_t begin = block * BLOCK_SIZE;
+        return static_cast<uint32_t>((std::min)(static_cast<uint64_t>(BLOCK_SIZE), mFileSize - begin));
+    }
+
+    // Whole blocks, the common case for the copy ring, are hashed outside
+    // the lock; only pieces of a block go through the partial table.
+    void CopyDigest::Update(uint64_t offset, const void* data, size_t length) {
+        const auto* p = static_cast<const uint8_t*>(data);
+        length = static_cast<size_t>((std::min)(static_cast<uint64_t>(length),
+            offset < mFileSize ? mFileSize - offset : 0));
+
+        while (length > 0) {
+            const uint64_t block = offset / BLOCK_SIZE;
+            const uint32_t within = static_cast<uint32_t>(offset % BLOCK_SIZE);
+            const uint32_t blockLength = BlockLength(block);
+            const uint32_t take = static_cast<uint32_t>(
+                (std::min)(static_cast<uint64_t>(blockLength - within), static_cast<uint64_t>(length)));
+
+            if (within == 0 && take == blockLength) {
+                StoreBlock(block, Xxh64::Hash(p, take, block));
+            }
+            else {
+                std::lock_guard lock(mMutex);
+                auto [it, inserted] = mPartial.try_emplace(block, PartialBlock{ Xxh64(block), 0 });
+                it->second.state.Update(p, take);
+                it->second.filled += take;
+                if (it->second.filled >= blockLength) {
+                    mBlockHashes[static_cast<size_t>(block)] = it->second.state.Digest();
+                    ++mBlocksDone;
+                    mPartial.erase(it);
+                }
+            }
+
+            p += take;
+            offset += take;
+            length -= take;
+        }
+    }
+
+    void CopyDigest::StoreBlock(uint64_t block, uint64_t hash) {
+        std::lock_guard lock(mMutex);
+        mBlockHashes[static_cast<size_t>(block)] = hash;
+        ++mBlocksDone;
+    }
+
+    bool CopyDigest::IsComplete() const {
+        std::lock_guard lock(mMutex);
+        return mBlocksDone == mBlockHashes.size();
+    }
+
+    uint64_t CopyDigest::Finish() const {
+        std::lock_guard lock(mMutex);
+        return Xxh64::Hash(mBlockHashes.data(), mBlockHashes.size() * sizeof(uint64_t), mFileSize);
+    }
+
+}
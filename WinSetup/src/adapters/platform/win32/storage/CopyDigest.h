@@ -0,0 +1,70 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace winsetup::adapters::platform {
+
+    // Streaming XXH64. Four independent lanes per 32-byte stripe keep the
+    // multipliers busy, so one core hashes well ahead of any disk.
+    class Xxh64 {
+    public:
+        explicit Xxh64(uint64_t seed = 0) noexcept;
+
+        void Update(const void* data, size_t length) noexcept;
+
+        [[nodiscard]] uint64_t Digest() const noexcept;
+
+        [[nodiscard]] static uint64_t Hash(const void* data, size_t length, uint64_t seed = 0) noexcept;
+
+    private:
+        uint64_t mLanes[4];
+        uint64_t mSeed;
+        uint64_t mTotalLength = 0;
+        uint8_t  mStripe[32] = {};
+        uint32_t mStripeLength = 0;
+    };
+
+    // Content hash of a copied file that does not depend on the order its
+    // blocks are seen in. The file is cut into BLOCK_SIZE blocks, each block
+    // is hashed with XXH64 seeded by its index, and the digest is the XXH64
+    // of the block hashes seeded by the file size. Blocks may arrive in any
+    // order and from several threads; bytes within one block must arrive in
+    // order. Nothing here depends on the Windows headers.
+    class CopyDigest {
+    public:
+        static constexpr uint32_t BLOCK_SIZE = 1024 * 1024;
+
+        explicit CopyDigest(uint64_t fileSize);
+
+        CopyDigest(const CopyDigest&) = delete;
+        CopyDigest& operator=(const CopyDigest&) = delete;
+
+        void Update(uint64_t offset, const void* data, size_t length);
+
+        [[nodiscard]] bool IsComplete() const;
+
+        // Only meaningful once IsComplete().
+        [[nodiscard]] uint64_t Finish() const;
+
+    private:
+        struct PartialBlock {
+            Xxh64    state;
+            uint32_t filled = 0;
+        };
+
+        [[nodiscard]] uint32_t BlockLength(uint64_t block) const noexcept;
+
+        void StoreBlock(uint64_t block, uint64_t hash);
+
+        const uint64_t                             mFileSize;
+        mutable std::mutex                         mMutex;
+        std::vector<uint64_t>                      mBlockHashes;
+        std::unordered_map<uint64_t, PartialBlock> mPartial;
+        uint64_t                                   mBlocksDone = 0;
+    };
+
+}
@@ -0,0 +1,236 @@
+﻿#include "CopyManifest.h"
+#include <adapters/platform/win32/core/Win32HandleFactory.h>
+#include <adapters/platform/win32/storage/CaseFold.h>
+#include <Windows.h>
+#include <cstddef>
+#include <fstream>
+#include <type_traits>
+
+namespace winsetup::adapters::platform {
+
+    namespace {
+        constexpr uint32_t FNV32_OFFSET_BASIS = 2166136261u;
+        constexpr uint32_t FNV32_PRIME = 16777619u;
+    }
+
+    CopyManifest::CopyManifest(std::wstring manifestPath)
+        : mPath(std::move(manifestPath))
+    {
+    }
+
+    CopyManifest::~CopyManifest() {
+        if (mFile && mUnflushed > 0)
+            FlushFileBuffers(Win32HandleFactory::ToWin32Handle(mFile));
+    }
+
+    domain::Expected<std::unique_ptr<CopyManifest>> CopyManifest::Open(
+        const std::wstring& manifestPath
+    ) {
+        std::unique_ptr<CopyManifest> manifest(new CopyManifest(manifestPath));
+        manifest->Load();
+
+        auto compacted = manifest->Compact();
+        if (!compacted.HasValue())
+            return compacted.GetError();
+
+        manifest->mFile = Win32HandleFactory::MakeHandle(
+            CreateFileW(manifestPath.c_str(),
+                FILE_APPEND_DATA,
+                FILE_SHARE_READ,
+                nullptr,
+                OPEN_EXISTING,
+                FILE_ATTRIBUTE_NORMAL,
+                nullptr));
+        if (!manifest->mFile) {
+            return domain::Error{
+                L"Failed to open copy manifest: " + manifestPath,
+                GetLastError(),
+                domain::ErrorCategory::IO
+            };
+        }
+        manifest->mLastFlush = std::chrono::steady_clock::now();
+        return manifest;
+    }
+
+    uint64_t CopyManifest::HashPath(std::wstring_view path) noexcept {
+        return CaseFold::Hash(path);
+    }
+
+    uint32_t CopyManifest::Checksum(const Record& record) noexcept {
+        static_assert(std::is_trivially_copyable_v<Record> && sizeof(Record) == 48);
+
+        const auto* bytes = reinterpret_cast<const uint8_t*>(&record);
+        uint32_t hash = FNV32_OFFSET_BASIS;
+        for (size_t i = 0; i < offsetof(Record, checksum); ++i) {
+            hash ^= bytes[i];
+            hash *= FNV32_PRIME;
+        }
+        return hash;
+    }
+
+    // Reads up to the first record that is short or fails its checksum;
+    // anything after it was never committed. A missing or foreign file
+    // simply starts an empty manifest.
+    void CopyManifest::Load() {
+        std::ifstream in(mPath, std::ios::binary);
+        if (!in.is_open()) return;
+
+        uint32_t header[2] = {};
+        if (!in.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+            header[0] != kMagic || header[1] != kVersion)
+            return;
+
+        Record record{};
+        while (in.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+            if (record.checksum != Checksum(record)) break;
+
+            CopyManifestEntry& entry = mEntries[record.pathHash];
+            entry.fileSize = record.fileSize;
+            entry.lastWriteTime = record.lastWriteTime;
+            entry.committedBytes = record.committedBytes;
+            entry.contentHash = record.contentHash;
+            entry.complete = (record.flags & kFlagComplete) != 0;
+            entry.hasContentHash = (record.flags & kFlagContentHash) != 0;
+        }
+    }
+
+    domain::Expected<void> CopyManifest::Compact() {
+        const std::wstring tempPath = mPath + L".tmp";
+
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) {
+                return domain::Error{
+                    L"Failed to create copy manifest: " + tempPath,
+                    ERROR_CANNOT_MAKE,
+                    domain::ErrorCategory::IO
+                };
+            }
+
+            const uint32_t header[2] = { kMagic, kVersion };
+            out.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+            for (const auto& [pathHash, entry] : mEntries) {
+                Record record{};
+                record.pathHash = pathHash;
+                record.fileSize = entry.fileSize;
+                record.lastWriteTime = entry.lastWriteTime;
+                record.committedBytes = entry.committedBytes;
+                record.contentHash = entry.contentHash;
+                record.flags = (entry.complete ? kFlagComplete : 0)
+                    | (entry.hasContentHash ? kFlagContentHash : 0);
+                record.checksum = Checksum(record);
+                out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+            }
+
+            if (!out.good()) {
+                return domain::Error{
+                    L"Failed to write copy manifest: " + tempPath,
+                    ERROR_WRITE_FAULT,
+                    domain::ErrorCategory::IO
+                };
+            }
+        }
+
+        if (!MoveFileExW(tempPath.c_str(), mPath.c_str(),
+            MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+            DWORD error = GetLastError();
+            DeleteFileW(tempPath.c_str());
+            return domain::Error{
+                L"Failed to commit copy manifest: " + mPath,
+                error,
+                domain::ErrorCategory::IO
+            };
+        }
+
+        return domain::Expected<void>();
+    }
+
+    std::optional<CopyManifestEntry> CopyManifest::Find(
+        uint64_t pathHash,
+        uint64_t fileSize,
+        uint64_t lastWriteTime
+    ) const {
+        std::lock_guard lock(mMutex);
+        const auto it = mEntries.find(pathHash);
+        if (it == mEntries.end() ||
+            it->second.fileSize != fileSize ||
+            it->second.lastWriteTime != lastWriteTime)
+            return std::nullopt;
+        return it->second;
+    }
+
+    domain::Expected<void> CopyManifest::RecordProgress(
+        uint64_t pathHash,
+        uint64_t fileSize,
+        uint64_t lastWriteTime,
+        uint64_t committedBytes
+    ) {
+        Record record{};
+        record.pathHash = pathHash;
+        record.fileSize = fileSize;
+        record.lastWriteTime = lastWriteTime;
+        record.committedBytes = committedBytes;
+        return Append(record);
+    }
+
+    domain::Expected<void> CopyManifest::RecordComplete(
+        uint64_t pathHash,
+        uint64_t fileSize,
+        uint64_t lastWriteTime,
+        std::optional<uint64_t> contentHash
+    ) {
+        Record record{};
+        record.pathHash = pathHash;
+        record.fileSize = fileSize;
+        record.lastWriteTime = lastWriteTime;
+        record.committedBytes = fileSize;
+        record.contentHash = contentHash.value_or(0);
+        record.flags = kFlagComplete | (contentHash.has_value() ? kFlagContentHash : 0);
+        return Append(record);
+    }
+
+    size_t CopyManifest::GetEntryCount() const {
+        std::lock_guard lock(mMutex);
+        return mEntries.size();
+    }
+
+    domain::Expected<void> CopyManifest::Append(const Record& record) {
+        Record sealed = record;
+        sealed.checksum = Checksum(sealed);
+
+        std::lock_guard lock(mMutex);
+        const HANDLE hFile = Win32HandleFactory::ToWin32Handle(mFile);
+        DWORD written = 0;
+        if (!WriteFile(hFile, &sealed, sizeof(sealed), &written, nullptr) || written != sizeof(sealed)) {
+            return domain::Error{
+                L"Failed to append to copy manifest: " + mPath,
+                written == 0 ? GetLastError() : ERROR_WRITE_FAULT,
+                domain::ErrorCategory::IO
+            };
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        if (++mUnflushed >= kFlushRecords || now - mLastFlush >= kFlushInterval) {
+            if (!FlushFileBuffers(hFile)) {
+                return domain::Error{
+                    L"Failed to flush copy manifest: " + mPath,
+                    GetLastError(),
+                    domain::ErrorCategory::IO
+                };
+            }
+            mUnflushed = 0;
+            mLastFlush = now;
+        }
+
+        CopyManifestEntry& entry = mEntries[record.pathHash];
+        entry.fileSize = record.fileSize;
+        entry.lastWriteTime = record.lastWriteTime;
+        entry.committedBytes = record.committedBytes;
+        entry.contentHash = record.contentHash;
+        entry.complete = (record.flags & kFlagComplete) != 0;
+        entry.hasContentHash = (record.flags & kFlagContentHash) != 0;
+        return domain::Expected<void>();
+    }
+
+}
@@ -0,0 +1,108 @@
+﻿#pragma once
+
+#include <domain/primitives/Expected.h>
+#include <adapters/platform/win32/memory/UniqueHandle.h>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace winsetup::adapters::platform {
+
+    struct CopyManifestEntry {
+        uint64_t fileSize = 0;
+        uint64_t lastWriteTime = 0;
+        uint64_t committedBytes = 0;
+        uint64_t contentHash = 0;
+        bool     complete = false;
+        bool     hasContentHash = false;
+    };
+
+    // Append-only record of what a resumable copy has finished. Each record
+    // is fixed-size and checksummed, keyed by the case-folded destination
+    // path hash, and the last record for a path wins. A torn record at the
+    // tail is dropped on Open, which also compacts the file to one record
+    // per path. Records are written straight to the file handle and made
+    // durable with FlushFileBuffers once per kFlushRecords records or
+    // kFlushInterval, whichever comes first, and on destruction; a crash
+    // loses at most that window, which only costs re-copying. Safe to call
+    // from several copy workers at once.
+    class CopyManifest {
+    public:
+        [[nodiscard]] static domain::Expected<std::unique_ptr<CopyManifest>> Open(
+            const std::wstring& manifestPath
+        );
+
+        ~CopyManifest();
+
+        CopyManifest(const CopyManifest&) = delete;
+        CopyManifest& operator=(const CopyManifest&) = delete;
+
+        [[nodiscard]] static uint64_t HashPath(std::wstring_view path) noexcept;
+
+        // The entry only if the source still has the recorded size and
+        // last write time; a changed source has to be copied again.
+        [[nodiscard]] std::optional<CopyManifestEntry> Find(
+            uint64_t pathHash,
+            uint64_t fileSize,
+            uint64_t lastWriteTime
+        ) const;
+
+        // Everything before committedBytes is on disk in the destination.
+        [[nodiscard]] domain::Expected<void> RecordProgress(
+            uint64_t pathHash,
+            uint64_t fileSize,
+            uint64_t lastWriteTime,
+            uint64_t committedBytes
+        );
+
+        [[nodiscard]] domain::Expected<void> RecordComplete(
+            uint64_t pathHash,
+            uint64_t fileSize,
+            uint64_t lastWriteTime,
+            std::optional<uint64_t> contentHash = std::nullopt
+        );
+
+        [[nodiscard]] size_t GetEntryCount() const;
+
+    private:
+        struct Record {
+            uint64_t pathHash;
+            uint64_t fileSize;
+            uint64_t lastWriteTime;
+            uint64_t committedBytes;
+            uint64_t contentHash;
+            uint32_t flags;
+            uint32_t checksum;
+        };
+
+        static constexpr uint32_t kMagic = 0x464D5043;
+        static constexpr uint32_t kVersion = 1;
+        static constexpr uint32_t kFlagComplete = 0x1;
+        static constexpr uint32_t kFlagContentHash = 0x2;
+        static constexpr uint32_t kFlushRecords = 64;
+        static constexpr std::chrono::milliseconds kFlushInterval{ 500 };
+
+        explicit CopyManifest(std::wstring manifestPath);
+
+        [[nodiscard]] static uint32_t Checksum(const Record& record) noexcept;
+
+        void Load();
+
+        [[nodiscard]] domain::Expected<void> Compact();
+
+        [[nodiscard]] domain::Expected<void> Append(const Record& record);
+
+        std::wstring                                    mPath;
+        mutable std::mutex                              mMutex;
+        std::unordered_map<uint64_t, CopyManifestEntry> mEntries;
+        UniqueHandle                                    mFile;
+        uint32_t                                        mUnflushed = 0;
+        std::chrono::steady_clock::time_point           mLastFlush;
+    };
+
+}
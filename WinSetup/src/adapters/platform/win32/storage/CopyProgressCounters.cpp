@@ -0,0 +1,47 @@
+﻿#include "CopyProgressCounters.h"
+#include <algorithm>
+
+namespace winsetup::adapters::platform {
+
+    CopyProgressCounters::CopyProgressCounters(uint32_t slotCount)
+        : mSlots(std::make_unique<Slot[]>((std::max)(slotCount, 1u)))
+        , mSlotCount((std::max)(slotCount, 1u))
+    {
+    }
+
+    void CopyProgressCounters::Add(uint32_t slot, uint64_t bytes, uint32_t files) noexcept {
+        // A single writer per slot, so a plain load and store is enough and
+        // avoids a locked instruction.
+        Slot& own = mSlots[slot % mSlotCount];
+        own.bytes.store(own.bytes.load(std::memory_order_relaxed) + bytes, std::memory_order_relaxed);
+        own.files.store(own.files.load(std::memory_order_relaxed) + files, std::memory_order_relaxed);
+    }
+
+    void CopyProgressCounters::OfferCurrentFile(const std::wstring& path) {
+        if (!mFileWanted.load(std::memory_order_relaxed)) return;
+        if (!mFileWanted.exchange(false, std::memory_order_acquire)) return;
+
+        std::lock_guard lock(mFileMutex);
+        mCurrentFile = path;
+    }
+
+    CopyProgressCounters::Totals CopyProgressCounters::Sum() const noexcept {
+        Totals totals;
+        for (uint32_t i = 0; i < mSlotCount; ++i) {
+            totals.bytes += mSlots[i].bytes.load(std::memory_order_relaxed);
+            totals.files += mSlots[i].files.load(std::memory_order_relaxed);
+        }
+        return totals;
+    }
+
+    std::wstring CopyProgressCounters::TakeCurrentFile() {
+        std::wstring current;
+        {
+            std::lock_guard lock(mFileMutex);
+            current = mCurrentFile;
+        }
+        mFileWanted.store(true, std::memory_order_release);
+        return current;
+    }
+
+}
@@ -0,0 +1,57 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace winsetup::adapters::platform {
+
+    // Progress counters for a pool of copy workers. Each worker adds to its
+    // own cache line, so completing a file never touches a line another
+    // worker writes, and a sampler sums the lines at its own pace. The name
+    // of the file being copied is only handed over when the sampler has
+    // asked for one since its last snapshot. Nothing here depends on the
+    // Windows headers.
+    class CopyProgressCounters {
+    public:
+        struct Totals {
+            uint64_t bytes = 0;
+            uint32_t files = 0;
+        };
+
+        explicit CopyProgressCounters(uint32_t slotCount);
+
+        CopyProgressCounters(const CopyProgressCounters&) = delete;
+        CopyProgressCounters& operator=(const CopyProgressCounters&) = delete;
+
+        // Only the worker that owns the slot may add to it.
+        void Add(uint32_t slot, uint64_t bytes, uint32_t files) noexcept;
+
+        // Cheap unless the sampler is waiting for a name.
+        void OfferCurrentFile(const std::wstring& path);
+
+        [[nodiscard]] Totals Sum() const noexcept;
+
+        // Returns the latest offered name and asks the workers for a new one.
+        [[nodiscard]] std::wstring TakeCurrentFile();
+
+        [[nodiscard]] uint32_t GetSlotCount() const noexcept { return mSlotCount; }
+
+        static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    private:
+        struct alignas(CACHE_LINE_SIZE) Slot {
+            std::atomic<uint64_t> bytes{ 0 };
+            std::atomic<uint32_t> files{ 0 };
+        };
+
+        std::unique_ptr<Slot[]> mSlots;
+        uint32_t                mSlotCount;
+        std::atomic<bool>       mFileWanted{ true };
+        std::mutex              mFileMutex;
+        std::wstring            mCurrentFile;
+    };
+
+}
@@ -0,0 +1,58 @@
+﻿#include "CopySchedule.h"
+#include <algorithm>
+
+namespace winsetup::adapters::platform {
+
+    CopySchedule CopyScheduler::Build(
+        std::span<const uint64_t> sizesDescending,
+        uint32_t workerCount,
+        const CopySchedulePolicy& policy,
+        std::span<const uint8_t> keepWhole
+    ) {
+        CopySchedule schedule;
+        const uint32_t fileCount = static_cast<uint32_t>(sizesDescending.size());
+        workerCount = (std::max)(workerCount, 1u);
+
+        uint32_t index = 0;
+        for (; index < fileCount && sizesDescending[index] > policy.smallFileMaxBytes; ++index) {
+            const uint64_t size = sizesDescending[index];
+
+            const bool splittable = keepWhole.empty() || !keepWhole[index];
+            if (workerCount > 1 && policy.splitChunkSize != 0 && size >= policy.splitMinFileSize && splittable) {
+                const uint32_t splitIndex = static_cast<uint32_t>(schedule.rangesPerSplit.size());
+                uint32_t ranges = 0;
+                for (uint64_t offset = 0; offset < size; offset += policy.splitChunkSize) {
+                    const uint64_t length = (std::min)(policy.splitChunkSize, size - offset);
+                    schedule.items.push_back({ index, 1, offset, length, splitIndex, length });
+                    ++ranges;
+                }
+                schedule.rangesPerSplit.push_back(ranges);
+                continue;
+            }
+
+            schedule.items.push_back({ index, 1, 0, 0, 0, size + policy.perFileCostBytes });
+        }
+
+        const uint32_t smallCount = fileCount - index;
+        if (smallCount > 0) {
+            const uint32_t targetBatches = workerCount * (std::max)(policy.batchesPerWorker, 1u);
+            const uint32_t perBatch = std::clamp(
+                (smallCount + targetBatches - 1) / targetBatches,
+                1u, (std::max)(policy.maxFilesPerBatch, 1u));
+
+            for (uint32_t first = index; first < fileCount; first += perBatch) {
+                const uint32_t count = (std::min)(perBatch, fileCount - first);
+                uint64_t cost = 0;
+                for (uint32_t i = first; i < first + count; ++i)
+                    cost += sizesDescending[i] + policy.perFileCostBytes;
+                schedule.items.push_back({ first, count, 0, 0, 0, cost });
+            }
+        }
+
+        std::stable_sort(schedule.items.begin(), schedule.items.end(),
+            [](const CopyWorkItem& a, const CopyWorkItem& b) { return a.cost > b.cost; });
+
+        return schedule;
+    }
+
+}
@@ -0,0 +1,55 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace winsetup::adapters::platform {
+
+    struct CopySchedulePolicy {
+        uint64_t smallFileMaxBytes = 256 * 1024;
+        uint32_t maxFilesPerBatch = 64;
+        uint32_t batchesPerWorker = 4;
+        uint64_t splitMinFileSize = 512ull * 1024 * 1024;
+        uint64_t splitChunkSize = 128ull * 1024 * 1024;
+        uint64_t perFileCostBytes = 64 * 1024;
+    };
+
+    // One unit handed to a copy worker: a run of whole files, or one byte
+    // range of a file that is being copied by several workers at once.
+    struct CopyWorkItem {
+        uint32_t firstFile = 0;
+        uint32_t fileCount = 0;
+        uint64_t rangeOffset = 0;
+        uint64_t rangeLength = 0;
+        uint32_t splitIndex = 0;
+        uint64_t cost = 0;
+
+        [[nodiscard]] bool IsRange() const noexcept { return rangeLength != 0; }
+    };
+
+    struct CopySchedule {
+        std::vector<CopyWorkItem> items;
+        std::vector<uint32_t>     rangesPerSplit;
+    };
+
+    // Orders copy work longest-first so the biggest files start before the
+    // small ones instead of trailing at the end of the run. Files must be
+    // sorted by size, largest first. Small files are grouped into batches
+    // sized to leave several per worker for balancing, and files of at least
+    // splitMinFileSize are cut into chunk-aligned byte ranges unless flagged
+    // in keepWhole, which is either empty or parallel to the sizes. Nothing
+    // here depends on the Windows headers.
+    class CopyScheduler {
+    public:
+        CopyScheduler() = delete;
+
+        [[nodiscard]] static CopySchedule Build(
+            std::span<const uint64_t> sizesDescending,
+            uint32_t workerCount,
+            const CopySchedulePolicy& policy = {},
+            std::span<const uint8_t> keepWhole = {}
+        );
+    };
+
+}
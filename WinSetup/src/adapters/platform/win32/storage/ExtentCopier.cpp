@@ -0,0 +1,150 @@
+﻿#include "ExtentCopier.h"
+#include <algorithm>
+
+namespace winsetup::adapters::platform {
+
+    namespace {
+        // Win32 codes, spelled out so this file builds without <Windows.h>.
+        constexpr uint32_t CODE_HANDLE_EOF = 38;
+        constexpr uint32_t CODE_INVALID_PARAMETER = 87;
+        constexpr uint32_t CODE_OPERATION_ABORTED = 995;
+
+        constexpr uint64_t AlignUp(uint64_t value, uint32_t alignment) noexcept {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        constexpr uint64_t AlignDown(uint64_t value, uint32_t alignment) noexcept {
+            return value / alignment * alignment;
+        }
+
+        domain::Error Cancelled() {
+            return domain::Error{
+                L"Copy operation was cancelled",
+                CODE_OPERATION_ABORTED,
+                domain::ErrorCategory::IO
+            };
+        }
+    }
+
+    ExtentCopier::ExtentCopier(uint32_t bufferSize)
+        : mBufferSize(bufferSize)
+    {
+    }
+
+    domain::Expected<ExtentCopyStats> ExtentCopier::Run(
+        IExtentFileChannel& channel,
+        uint64_t fileSize,
+        bool keepSparse,
+        const std::atomic<bool>& cancelled
+    ) {
+        if (mBufferSize == 0) {
+            return domain::Error{
+                L"Extent copy needs a non-zero buffer size",
+                CODE_INVALID_PARAMETER,
+                domain::ErrorCategory::Validation
+            };
+        }
+
+        mStats = ExtentCopyStats{};
+        mFileSize = fileSize;
+        mCloneAlignment = channel.GetCloneAlignment();
+        if (mBuffer.size() != mBufferSize)
+            mBuffer.assign(mBufferSize, std::byte{ 0 });
+
+        auto ranges = channel.QueryAllocatedRanges(0, fileSize);
+        if (!ranges.HasValue()) return ranges.GetError();
+
+        auto prepared = channel.PrepareDestination(fileSize, keepSparse);
+        if (!prepared.HasValue()) return prepared.GetError();
+
+        uint64_t covered = 0;
+        for (const FileExtent& extent : ranges.Value()) {
+            const uint64_t begin = (std::max)(extent.offset, covered);
+            const uint64_t end = (std::min)(extent.offset + extent.length, fileSize);
+            if (begin >= end) continue;
+
+            if (cancelled.load(std::memory_order_relaxed))
+                return Cancelled();
+
+            auto moved = CloneOrCopy(channel, begin, end - begin, cancelled);
+            if (!moved.HasValue()) return moved.GetError();
+            covered = end;
+        }
+
+        mStats.bytesSkipped = fileSize - mStats.bytesCloned - mStats.bytesCopied;
+        return mStats;
+    }
+
+    domain::Expected<void> ExtentCopier::CloneOrCopy(
+        IExtentFileChannel& channel,
+        uint64_t offset,
+        uint64_t length,
+        const std::atomic<bool>& cancelled
+    ) {
+        const uint64_t end = offset + length;
+        uint64_t cloneBegin = end;
+        uint64_t cloneEnd = end;
+        if (mCloneAlignment != 0) {
+            cloneBegin = (std::min)(AlignUp(offset, mCloneAlignment), end);
+            cloneEnd = end == mFileSize ? end : (std::max)(AlignDown(end, mCloneAlignment), cloneBegin);
+        }
+
+        // Everything before the first aligned boundary, the aligned middle
+        // in chunks, then the unaligned tail. A clone may run to end of
+        // file unaligned.
+        auto head = CopyData(channel, offset, cloneBegin - offset, cancelled);
+        if (!head.HasValue()) return head;
+
+        for (uint64_t position = cloneBegin; position < cloneEnd;) {
+            if (cancelled.load(std::memory_order_relaxed))
+                return Cancelled();
+
+            if (mCloneAlignment == 0)
+                return CopyData(channel, position, end - position, cancelled);
+
+            const uint64_t step = (std::min)(CLONE_CHUNK_SIZE, cloneEnd - position);
+            auto cloned = channel.CloneRange(position, step);
+            if (!cloned.HasValue()) {
+                mCloneAlignment = 0;
+                continue;
+            }
+            mStats.bytesCloned += step;
+            position += step;
+        }
+
+        return CopyData(channel, cloneEnd, end - cloneEnd, cancelled);
+    }
+
+    domain::Expected<void> ExtentCopier::CopyData(
+        IExtentFileChannel& channel,
+        uint64_t offset,
+        uint64_t length,
+        const std::atomic<bool>& cancelled
+    ) {
+        const uint64_t end = offset + length;
+        while (offset < end) {
+            if (cancelled.load(std::memory_order_relaxed))
+                return Cancelled();
+
+            const uint32_t wanted = static_cast<uint32_t>(
+                (std::min)(static_cast<uint64_t>(mBufferSize), end - offset));
+            auto read = channel.ReadSource(offset, mBuffer.data(), wanted);
+            if (!read.HasValue()) return read.GetError();
+            if (read.Value() < wanted) {
+                return domain::Error{
+                    L"Source file shrank during copy",
+                    CODE_HANDLE_EOF,
+                    domain::ErrorCategory::IO
+                };
+            }
+
+            auto written = channel.WriteDestination(offset, mBuffer.data(), wanted);
+            if (!written.HasValue()) return written;
+
+            mStats.bytesCopied += wanted;
+            offset += wanted;
+        }
+        return domain::Expected<void>();
+    }
+
+}
@@ -0,0 +1,64 @@
+﻿#pragma once
+
+#include <domain/primitives/Expected.h>
+#include <adapters/platform/win32/storage/ExtentFileChannel.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace winsetup::adapters::platform {
+
+    struct ExtentCopyStats {
+        uint64_t bytesCloned = 0;
+        uint64_t bytesCopied = 0;
+        uint64_t bytesSkipped = 0;
+    };
+
+    // Copies only the allocated extents of a file. Each extent is cloned
+    // where the channel can share blocks, in CLONE_CHUNK_SIZE steps between
+    // aligned boundaries, and read and written around those boundaries and
+    // everywhere else. Holes are never read; the destination is sized up
+    // front so they stay holes or read back as zeros. A refused clone turns
+    // cloning off for the rest of the file and copies that range instead.
+    // Nothing here depends on the Windows headers.
+    class ExtentCopier {
+    public:
+        explicit ExtentCopier(uint32_t bufferSize);
+        ~ExtentCopier() = default;
+
+        ExtentCopier(const ExtentCopier&) = delete;
+        ExtentCopier& operator=(const ExtentCopier&) = delete;
+
+        [[nodiscard]] domain::Expected<ExtentCopyStats> Run(
+            IExtentFileChannel& channel,
+            uint64_t fileSize,
+            bool keepSparse,
+            const std::atomic<bool>& cancelled
+        );
+
+        static constexpr uint64_t CLONE_CHUNK_SIZE = 1ull << 30;
+
+    private:
+        [[nodiscard]] domain::Expected<void> CopyData(
+            IExtentFileChannel& channel,
+            uint64_t offset,
+            uint64_t length,
+            const std::atomic<bool>& cancelled
+        );
+
+        [[nodiscard]] domain::Expected<void> CloneOrCopy(
+            IExtentFileChannel& channel,
+            uint64_t offset,
+            uint64_t length,
+            const std::atomic<bool>& cancelled
+        );
+
+        uint32_t               mBufferSize;
+        uint32_t               mCloneAlignment = 0;
+        uint64_t               mFileSize = 0;
+        ExtentCopyStats        mStats;
+        std::vector<std::byte> mBuffer;
+    };
+
+}
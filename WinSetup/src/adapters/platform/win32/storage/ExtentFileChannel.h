@@ -0,0 +1,55 @@
+﻿#pragma once
+
+#include <domain/primitives/Expected.h>
+#include <cstdint>
+#include <vector>
+
+namespace winsetup::adapters::platform {
+
+    struct FileExtent {
+        uint64_t offset = 0;
+        uint64_t length = 0;
+    };
+
+    // A source/destination file pair that can say which parts of the source
+    // hold data and move those parts to the same offsets in the destination,
+    // by reading and writing or, where the file system shares blocks between
+    // files, by cloning. The same contract maps onto SEEK_DATA/SEEK_HOLE,
+    // FICLONERANGE and pread/pwrite elsewhere.
+    class IExtentFileChannel {
+    public:
+        virtual ~IExtentFileChannel() = default;
+
+        // Ascending, non-overlapping ranges of [begin, end) that hold data.
+        // A file system without holes reports the whole range.
+        [[nodiscard]] virtual domain::Expected<std::vector<FileExtent>> QueryAllocatedRanges(
+            uint64_t begin,
+            uint64_t end
+        ) = 0;
+
+        // Granularity clones must be aligned to, or 0 when the pair cannot
+        // share blocks. A clone may end unaligned only at end of file.
+        [[nodiscard]] virtual uint32_t GetCloneAlignment() const noexcept = 0;
+
+        [[nodiscard]] virtual domain::Expected<void> CloneRange(uint64_t offset, uint64_t length) = 0;
+
+        // Sizes the destination to its final length, marking it sparse first
+        // when holes are to be kept, so unwritten ranges read back as zeros.
+        [[nodiscard]] virtual domain::Expected<void> PrepareDestination(uint64_t length, bool sparse) = 0;
+
+        // Positional, synchronous transfers. A read may return fewer bytes
+        // than asked for only at end of file.
+        [[nodiscard]] virtual domain::Expected<uint32_t> ReadSource(
+            uint64_t offset,
+            void* buffer,
+            uint32_t length
+        ) = 0;
+
+        [[nodiscard]] virtual domain::Expected<void> WriteDestination(
+            uint64_t offset,
+            const void* buffer,
+            uint32_t length
+        ) = 0;
+    };
+
+}
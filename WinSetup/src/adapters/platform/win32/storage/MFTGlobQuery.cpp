@@ -0,0 +1,282 @@
+﻿#include "MFTGlobQuery.h"
+#include "CaseFold.h"
+#include <algorithm>
+
+namespace winsetup::adapters::platform {
+
+    namespace {
+        bool IsSeparator(wchar_t c) noexcept {
+            return c == L'\\' || c == L'/';
+        }
+
+        wchar_t FoldCase(wchar_t c) noexcept {
+            return CaseFold::FoldChar(c);
+        }
+
+        domain::Error InvalidPattern(std::wstring_view pattern, const wchar_t* reason) {
+            return domain::Error{
+                L"Invalid path pattern '" + std::wstring(pattern) + L"': " + reason,
+                ERROR_INVALID_PARAMETER,
+                domain::ErrorCategory::Validation
+            };
+        }
+    }
+
+    domain::Expected<MFTGlobPattern> MFTGlobPattern::Compile(std::wstring_view pattern) {
+        std::wstring_view body = pattern;
+        if (body.size() >= 2 && body[1] == L':')
+            body.remove_prefix(2);
+        while (!body.empty() && IsSeparator(body.front()))
+            body.remove_prefix(1);
+
+        MFTGlobPattern compiled;
+        while (!body.empty() && IsSeparator(body.back())) {
+            compiled.mDirectoriesOnly = true;
+            body.remove_suffix(1);
+        }
+
+        if (body.empty())
+            return InvalidPattern(pattern, L"pattern is empty");
+
+        size_t position = 0;
+        while (position <= body.size()) {
+            size_t end = position;
+            while (end < body.size() && !IsSeparator(body[end])) ++end;
+            const std::wstring_view text = body.substr(position, end - position);
+            position = end + 1;
+
+            if (text.empty() || text == L".")
+                continue;
+
+            if (text == L"**") {
+                if (compiled.mSegments.empty() ||
+                    compiled.mSegments.back().kind != SegmentKind::Recursive)
+                    compiled.mSegments.push_back({ SegmentKind::Recursive, {}, {} });
+                continue;
+            }
+
+            Segment segment{ SegmentKind::Literal, {}, {} };
+            for (size_t i = 0; i < text.size(); ++i) {
+                const wchar_t c = text[i];
+                if (c == L'*') {
+                    segment.kind = SegmentKind::Wildcard;
+                    if (segment.tokens.empty() || segment.tokens.back().kind != TokenKind::AnyRun)
+                        segment.tokens.push_back({ TokenKind::AnyRun, 0, 0 });
+                }
+                else if (c == L'?') {
+                    segment.kind = SegmentKind::Wildcard;
+                    segment.tokens.push_back({ TokenKind::AnyChar, 0, 0 });
+                }
+                else if (c == L'[') {
+                    size_t close = i + 1;
+                    if (close < text.size() && (text[close] == L'!' || text[close] == L'^')) ++close;
+                    if (close < text.size() && text[close] == L']') ++close;
+                    while (close < text.size() && text[close] != L']') ++close;
+                    if (close >= text.size())
+                        return InvalidPattern(pattern, L"unterminated character class");
+
+                    CharClass charClass;
+                    size_t k = i + 1;
+                    if (text[k] == L'!' || text[k] == L'^') {
+                        charClass.negated = true;
+                        ++k;
+                    }
+                    for (; k < close; ++k) {
+                        wchar_t low = FoldCase(text[k]);
+                        wchar_t high = low;
+                        if (k + 2 < close && text[k + 1] == L'-') {
+                            high = FoldCase(text[k + 2]);
+                            k += 2;
+                        }
+                        if (low > high) std::swap(low, high);
+                        charClass.ranges.emplace_back(low, high);
+                    }
+
+                    segment.kind = SegmentKind::Wildcard;
+                    segment.tokens.push_back({
+                        TokenKind::Class, 0, static_cast<uint32_t>(compiled.mClasses.size()) });
+                    compiled.mClasses.push_back(std::move(charClass));
+                    i = close;
+                }
+                else {
+                    segment.tokens.push_back({ TokenKind::Char, FoldCase(c), 0 });
+                }
+            }
+
+            if (segment.kind == SegmentKind::Literal) {
+                segment.literal.reserve(segment.tokens.size());
+                for (const Token& token : segment.tokens)
+                    segment.literal.push_back(token.ch);
+                segment.tokens.clear();
+            }
+
+            compiled.mSegments.push_back(std::move(segment));
+            if (compiled.mSegments.size() > MAX_SEGMENTS)
+                return InvalidPattern(pattern, L"too many path segments");
+        }
+
+        if (compiled.mSegments.empty())
+            return InvalidPattern(pattern, L"pattern is empty");
+
+        return compiled;
+    }
+
+    bool MFTGlobPattern::IsRecursive(size_t segment) const noexcept {
+        return mSegments[segment].kind == SegmentKind::Recursive;
+    }
+
+    bool MFTGlobPattern::MatchSegment(size_t segment, std::wstring_view name) const {
+        const Segment& current = mSegments[segment];
+        switch (current.kind) {
+        case SegmentKind::Recursive:
+            return true;
+        case SegmentKind::Literal:
+            return CaseFold::Equals(name, current.literal);
+        default:
+            return MatchTokens(current.tokens, name);
+        }
+    }
+
+    bool MFTGlobPattern::MatchToken(const Token& token, wchar_t lowered) const noexcept {
+        switch (token.kind) {
+        case TokenKind::Char:
+            return token.ch == lowered;
+        case TokenKind::AnyChar:
+            return true;
+        case TokenKind::Class: {
+            const CharClass& charClass = mClasses[token.classIndex];
+            const bool inClass = std::any_of(charClass.ranges.begin(), charClass.ranges.end(),
+                [lowered](const auto& range) {
+                    return lowered >= range.first && lowered <= range.second;
+                });
+            return inClass != charClass.negated;
+        }
+        default:
+            return false;
+        }
+    }
+
+    bool MFTGlobPattern::MatchTokens(const std::vector<Token>& tokens, std::wstring_view name) const {
+        constexpr size_t NO_STAR = static_cast<size_t>(-1);
+
+        size_t t = 0;
+        size_t n = 0;
+        size_t resumeToken = NO_STAR;
+        size_t resumeName = 0;
+
+        while (n < name.size()) {
+            if (t < tokens.size() && tokens[t].kind == TokenKind::AnyRun) {
+                resumeToken = ++t;
+                resumeName = n;
+                continue;
+            }
+            if (t < tokens.size() && MatchToken(tokens[t], FoldCase(name[n]))) {
+                ++t;
+                ++n;
+                continue;
+            }
+            if (resumeToken == NO_STAR)
+                return false;
+            t = resumeToken;
+            n = ++resumeName;
+        }
+
+        while (t < tokens.size() && tokens[t].kind == TokenKind::AnyRun) ++t;
+        return t == tokens.size();
+    }
+
+    MFTGlobCursor::MFTGlobCursor(
+        const MFTRecordStore& records,
+        std::span<const uint32_t> childOffsets,
+        std::span<const uint32_t> childIndices,
+        std::span<const uint32_t> rootIndices,
+        MFTGlobPattern pattern
+    )
+        : mRecords(&records)
+        , mChildOffsets(childOffsets)
+        , mChildIndices(childIndices)
+        , mPattern(std::move(pattern))
+        , mAcceptState(uint64_t{ 1 } << mPattern.SegmentCount())
+    {
+        mStack.push_back({
+            rootIndices.data(),
+            rootIndices.data() + rootIndices.size(),
+            Closure(1)
+        });
+    }
+
+    uint64_t MFTGlobCursor::Closure(uint64_t states) const noexcept {
+        const size_t count = mPattern.SegmentCount();
+        for (size_t i = 0; i < count; ++i) {
+            if ((states & (uint64_t{ 1 } << i)) && mPattern.IsRecursive(i))
+                states |= uint64_t{ 1 } << (i + 1);
+        }
+        return states;
+    }
+
+    uint64_t MFTGlobCursor::Advance(uint64_t states, std::wstring_view name) const {
+        uint64_t next = 0;
+        const size_t count = mPattern.SegmentCount();
+        for (size_t i = 0; i < count; ++i) {
+            if (!(states & (uint64_t{ 1 } << i))) continue;
+
+            if (mPattern.IsRecursive(i))
+                next |= uint64_t{ 1 } << i;
+            else if (mPattern.MatchSegment(i, name))
+                next |= uint64_t{ 1 } << (i + 1);
+        }
+        return Closure(next);
+    }
+
+    bool MFTGlobCursor::NextIndex(uint32_t& outIndex) {
+        while (!mStack.empty()) {
+            Frame& frame = mStack.back();
+            if (frame.next == frame.end) {
+                mStack.pop_back();
+                continue;
+            }
+
+            const uint32_t index = *frame.next++;
+            if (!mRecords->IsLive(index)) continue;
+
+            const uint64_t states = Advance(frame.states, mRecords->Name(index));
+            if (states == 0) continue;
+
+            const bool isDirectory = mRecords->IsDirectory(index);
+            const bool descend = isDirectory &&
+                (states & ~mAcceptState) != 0 &&
+                static_cast<size_t>(index) + 1 < mChildOffsets.size() &&
+                mChildOffsets[index] != mChildOffsets[index + 1];
+
+            if (descend) {
+                mStack.push_back({
+                    mChildIndices.data() + mChildOffsets[index],
+                    mChildIndices.data() + mChildOffsets[index + 1],
+                    states & ~mAcceptState
+                });
+            }
+
+            if ((states & mAcceptState) && (isDirectory || !mPattern.DirectoriesOnly())) {
+                mCurrent = index;
+                outIndex = index;
+                return true;
+            }
+        }
+
+        mCurrent = MFTRecordStore::INVALID_INDEX;
+        return false;
+    }
+
+    bool MFTGlobCursor::Next(MFTFileRecord& outRecord) {
+        uint32_t index = MFTRecordStore::INVALID_INDEX;
+        if (!NextIndex(index)) return false;
+        outRecord = mRecords->ToRecord(index);
+        return true;
+    }
+
+    std::wstring MFTGlobCursor::CurrentPath() const {
+        if (mCurrent == MFTRecordStore::INVALID_INDEX) return L"";
+        return mRecords->BuildPath(mCurrent);
+    }
+
+}
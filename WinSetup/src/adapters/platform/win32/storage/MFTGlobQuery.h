@@ -0,0 +1,96 @@
+﻿#pragma once
+
+#include <domain/primitives/Expected.h>
+#include <adapters/platform/win32/storage/MFTRecordStore.h>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+namespace winsetup::adapters::platform {
+
+    // Case-insensitive, volume-relative path pattern. Segments are separated
+    // by '\' or '/'; each may use '*', '?' and [a-z] / [!a-z] classes, and a
+    // whole segment of "**" spans any number of directories. A trailing
+    // separator restricts matches to directories.
+    class MFTGlobPattern {
+    public:
+        static constexpr size_t MAX_SEGMENTS = 63;
+
+        [[nodiscard]] static domain::Expected<MFTGlobPattern> Compile(std::wstring_view pattern);
+
+        [[nodiscard]] size_t SegmentCount() const noexcept { return mSegments.size(); }
+        [[nodiscard]] bool IsRecursive(size_t segment) const noexcept;
+        [[nodiscard]] bool MatchSegment(size_t segment, std::wstring_view name) const;
+        [[nodiscard]] bool DirectoriesOnly() const noexcept { return mDirectoriesOnly; }
+
+    private:
+        enum class TokenKind : uint8_t { Char, AnyChar, AnyRun, Class };
+
+        struct Token {
+            TokenKind kind;
+            wchar_t   ch;
+            uint32_t  classIndex;
+        };
+
+        struct CharClass {
+            bool negated = false;
+            std::vector<std::pair<wchar_t, wchar_t>> ranges;
+        };
+
+        enum class SegmentKind : uint8_t { Literal, Wildcard, Recursive };
+
+        struct Segment {
+            SegmentKind        kind;
+            std::wstring       literal;
+            std::vector<Token> tokens;
+        };
+
+        [[nodiscard]] bool MatchTokens(const std::vector<Token>& tokens, std::wstring_view name) const;
+        [[nodiscard]] bool MatchToken(const Token& token, wchar_t lowered) const noexcept;
+
+        std::vector<Segment>   mSegments;
+        std::vector<CharClass> mClasses;
+        bool                   mDirectoriesOnly = false;
+    };
+
+    // Streams the records matching a pattern by walking the scanner's child
+    // index depth-first. It borrows the index, so it is only valid until the
+    // next scan or USN update.
+    class MFTGlobCursor {
+    public:
+        MFTGlobCursor(
+            const MFTRecordStore& records,
+            std::span<const uint32_t> childOffsets,
+            std::span<const uint32_t> childIndices,
+            std::span<const uint32_t> rootIndices,
+            MFTGlobPattern pattern
+        );
+
+        [[nodiscard]] bool NextIndex(uint32_t& outIndex);
+        [[nodiscard]] bool Next(MFTFileRecord& outRecord);
+
+        // Volume-relative path of the record most recently returned.
+        [[nodiscard]] std::wstring CurrentPath() const;
+
+    private:
+        struct Frame {
+            const uint32_t* next;
+            const uint32_t* end;
+            uint64_t        states;
+        };
+
+        [[nodiscard]] uint64_t Closure(uint64_t states) const noexcept;
+        [[nodiscard]] uint64_t Advance(uint64_t states, std::wstring_view name) const;
+
+        const MFTRecordStore*     mRecords;
+        std::span<const uint32_t> mChildOffsets;
+        std::span<const uint32_t> mChildIndices;
+        MFTGlobPattern            mPattern;
+        uint64_t                  mAcceptState;
+        std::vector<Frame>        mStack;
+        uint32_t                  mCurrent = MFTRecordStore::INVALID_INDEX;
+    };
+
+}
@@ -0,0 +1,216 @@
+﻿#include "MFTIndexSnapshot.h"
+#include "CopyDigest.h"
+#include <fstream>
+#include <type_traits>
+
+namespace winsetup::adapters::platform {
+
+    namespace {
+        // Fixed part of one record: refs, size, attributes, three times and
+        // the name length. Bounds the record count a file of a given size
+        // can hold before anything is reserved for it.
+        constexpr uint64_t kMinRecordBytes = 3 * sizeof(uint64_t) + sizeof(uint32_t)
+            + 3 * sizeof(uint64_t) + sizeof(uint16_t);
+
+        template<typename T>
+        void WritePod(std::ofstream& out, const T& value) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        template<typename T>
+        void WritePod(std::ofstream& out, Xxh64& hash, const T& value) {
+            WritePod(out, value);
+            hash.Update(&value, sizeof(T));
+        }
+
+        template<typename T>
+        bool ReadPod(std::ifstream& in, T& value) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+        }
+
+        template<typename T>
+        bool ReadPod(std::ifstream& in, Xxh64& hash, T& value) {
+            if (!ReadPod(in, value)) return false;
+            hash.Update(&value, sizeof(T));
+            return true;
+        }
+
+        domain::Error CorruptSnapshot(const std::wstring& snapshotPath) {
+            return domain::Error{
+                L"MFT index snapshot is corrupt: " + snapshotPath,
+                ERROR_FILE_CORRUPT,
+                domain::ErrorCategory::Parsing
+            };
+        }
+    }
+
+    domain::Expected<void> MFTIndexSnapshotSerializer::Save(
+        const std::wstring& snapshotPath,
+        uint64_t journalId,
+        int64_t nextUsn,
+        bool sizesComplete,
+        const MFTRecordStore& store
+    ) {
+        const std::wstring tempPath = snapshotPath + L".tmp";
+
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) {
+                return domain::Error{
+                    L"Failed to create MFT index snapshot: " + tempPath,
+                    ERROR_CANNOT_MAKE,
+                    domain::ErrorCategory::IO
+                };
+            }
+
+            WritePod(out, kMagic);
+            WritePod(out, kVersion);
+            WritePod(out, journalId);
+            WritePod(out, nextUsn);
+            WritePod(out, static_cast<uint8_t>(sizesComplete ? 1 : 0));
+            WritePod(out, static_cast<uint64_t>(store.Size()));
+
+            // Patched with the real digest once the body is written.
+            const std::streampos bodyHashPos = out.tellp();
+            WritePod(out, uint64_t{ 0 });
+
+            Xxh64 body;
+
+            const uint32_t slotCount = static_cast<uint32_t>(store.SlotCount());
+            for (uint32_t i = 0; i < slotCount; ++i) {
+                if (!store.IsLive(i)) continue;
+
+                const std::wstring_view name = store.Name(i);
+                const uint16_t nameLength = static_cast<uint16_t>(name.size());
+
+                WritePod(out, body, store.FileRef(i));
+                WritePod(out, body, store.ParentRef(i));
+                WritePod(out, body, store.FileSize(i));
+                WritePod(out, body, store.Attributes(i));
+                WritePod(out, body, store.CreationTime(i));
+                WritePod(out, body, store.Timestamp(i));
+                WritePod(out, body, store.LastAccessTime(i));
+                WritePod(out, body, nameLength);
+                out.write(reinterpret_cast<const char*>(name.data()),
+                    static_cast<std::streamsize>(nameLength) * sizeof(wchar_t));
+                body.Update(name.data(), nameLength * sizeof(wchar_t));
+            }
+
+            out.seekp(bodyHashPos);
+            WritePod(out, body.Digest());
+
+            if (!out.good()) {
+                return domain::Error{
+                    L"Failed to write MFT index snapshot: " + tempPath,
+                    ERROR_WRITE_FAULT,
+                    domain::ErrorCategory::IO
+                };
+            }
+        }
+
+        if (!MoveFileExW(tempPath.c_str(), snapshotPath.c_str(),
+            MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+            DWORD error = GetLastError();
+            DeleteFileW(tempPath.c_str());
+            return domain::Error{
+                L"Failed to commit MFT index snapshot: " + snapshotPath,
+                error,
+                domain::ErrorCategory::IO
+            };
+        }
+
+        return domain::Expected<void>();
+    }
+
+    domain::Expected<MFTIndexSnapshot> MFTIndexSnapshotSerializer::Load(
+        const std::wstring& snapshotPath
+    ) {
+        std::ifstream in(snapshotPath, std::ios::binary | std::ios::ate);
+        if (!in.is_open()) {
+            return domain::Error{
+                L"MFT index snapshot not found: " + snapshotPath,
+                ERROR_FILE_NOT_FOUND,
+                domain::ErrorCategory::IO
+            };
+        }
+
+        const std::streamoff snapshotBytes = in.tellg();
+        in.seekg(0);
+
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        uint64_t recordCount = 0;
+        uint64_t bodyHash = 0;
+        uint8_t  sizesComplete = 0;
+        MFTIndexSnapshot snapshot;
+
+        if (!ReadPod(in, magic) || !ReadPod(in, version) ||
+            magic != kMagic || version != kVersion) {
+            return CorruptSnapshot(snapshotPath);
+        }
+
+        if (!ReadPod(in, snapshot.journalId) ||
+            !ReadPod(in, snapshot.nextUsn) ||
+            !ReadPod(in, sizesComplete) ||
+            !ReadPod(in, recordCount) ||
+            !ReadPod(in, bodyHash) ||
+            sizesComplete > 1) {
+            return CorruptSnapshot(snapshotPath);
+        }
+        snapshot.sizesComplete = sizesComplete != 0;
+
+        const std::streamoff bodySize = snapshotBytes - in.tellg();
+        if (snapshotBytes < 0 || bodySize < 0 ||
+            recordCount > static_cast<uint64_t>(bodySize) / kMinRecordBytes) {
+            return CorruptSnapshot(snapshotPath);
+        }
+
+        snapshot.store.Reserve(static_cast<size_t>(recordCount), 0);
+        Xxh64 body;
+        std::wstring name;
+
+        for (uint64_t i = 0; i < recordCount; ++i) {
+            uint64_t fileRef = 0;
+            uint64_t parentRef = 0;
+            uint64_t fileSize = 0;
+            uint32_t attributes = 0;
+            uint64_t creationTime = 0;
+            uint64_t timestamp = 0;
+            uint64_t lastAccessTime = 0;
+            uint16_t nameLength = 0;
+
+            if (!ReadPod(in, body, fileRef) ||
+                !ReadPod(in, body, parentRef) ||
+                !ReadPod(in, body, fileSize) ||
+                !ReadPod(in, body, attributes) ||
+                !ReadPod(in, body, creationTime) ||
+                !ReadPod(in, body, timestamp) ||
+                !ReadPod(in, body, lastAccessTime) ||
+                !ReadPod(in, body, nameLength)) {
+                return CorruptSnapshot(snapshotPath);
+            }
+
+            name.resize(nameLength);
+            if (!in.read(reinterpret_cast<char*>(name.data()),
+                static_cast<std::streamsize>(nameLength) * sizeof(wchar_t))) {
+                return CorruptSnapshot(snapshotPath);
+            }
+            body.Update(name.data(), nameLength * sizeof(wchar_t));
+
+            const uint32_t index = snapshot.store.Upsert(fileRef, parentRef, attributes, timestamp, name);
+            if (index == MFTRecordStore::INVALID_INDEX)
+                return CorruptSnapshot(snapshotPath);
+            snapshot.store.SetFileSize(index, fileSize);
+            snapshot.store.SetTimes(index, creationTime, timestamp, lastAccessTime);
+        }
+
+        if (in.tellg() != snapshotBytes || body.Digest() != bodyHash)
+            return CorruptSnapshot(snapshotPath);
+
+        snapshot.store.LinkParents();
+        return snapshot;
+    }
+
+}
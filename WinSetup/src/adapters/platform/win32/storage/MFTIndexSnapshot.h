@@ -0,0 +1,39 @@
+﻿#pragma once
+
+#include <domain/primitives/Expected.h>
+#include <adapters/platform/win32/storage/MFTRecordStore.h>
+#include <string>
+#include <cstdint>
+
+namespace winsetup::adapters::platform {
+
+    struct MFTIndexSnapshot {
+        uint64_t journalId = 0;
+        int64_t  nextUsn = 0;
+        // Set when a full raw $MFT pass filled in every size and time.
+        bool     sizesComplete = false;
+        MFTRecordStore store;
+    };
+
+    class MFTIndexSnapshotSerializer {
+    public:
+        MFTIndexSnapshotSerializer() = delete;
+
+        [[nodiscard]] static domain::Expected<void> Save(
+            const std::wstring& snapshotPath,
+            uint64_t journalId,
+            int64_t nextUsn,
+            bool sizesComplete,
+            const MFTRecordStore& store
+        );
+
+        [[nodiscard]] static domain::Expected<MFTIndexSnapshot> Load(
+            const std::wstring& snapshotPath
+        );
+
+    private:
+        static constexpr uint32_t kMagic = 0x4954464D;
+        static constexpr uint32_t kVersion = 5;
+    };
+
+}
@@ -0,0 +1,85 @@
+﻿#include "MFTKeyTable.h"
+#include <bit>
+
+namespace winsetup::adapters::platform {
+
+    namespace {
+        constexpr size_t MIN_CAPACITY = 64;
+
+        // Keeps the load factor at or below 0.7 so probe runs stay short.
+        size_t CapacityFor(size_t entryCount) noexcept {
+            const size_t required = entryCount + entryCount * 3 / 7 + 1;
+            size_t capacity = MIN_CAPACITY;
+            while (capacity < required) capacity <<= 1;
+            return capacity;
+        }
+    }
+
+    void MFTKeyTable::Clear() noexcept {
+        mSlots.clear();
+        mMask = 0;
+        mSize = 0;
+        mShift = 64;
+    }
+
+    void MFTKeyTable::Reserve(size_t entryCount) {
+        const size_t capacity = CapacityFor(entryCount);
+        if (capacity > mSlots.size())
+            Rehash(capacity);
+    }
+
+    void MFTKeyTable::Insert(uint64_t key, uint32_t value) {
+        const size_t capacity = CapacityFor(mSize + 1);
+        if (capacity > mSlots.size())
+            Rehash(capacity);
+
+        size_t slot = HomeSlot(key);
+        while (mSlots[slot].value != EMPTY_VALUE)
+            slot = (slot + 1) & mMask;
+
+        mSlots[slot] = Slot{ key, value };
+        mSize++;
+    }
+
+    bool MFTKeyTable::Erase(uint64_t key, uint32_t value) noexcept {
+        if (mSize == 0) return false;
+
+        size_t hole = HomeSlot(key);
+        while (mSlots[hole].key != key || mSlots[hole].value != value) {
+            if (mSlots[hole].value == EMPTY_VALUE) return false;
+            hole = (hole + 1) & mMask;
+        }
+
+        // Pulls back every later entry of the run whose home slot does not
+        // lie strictly between the hole and its current slot.
+        for (size_t next = (hole + 1) & mMask; mSlots[next].value != EMPTY_VALUE; next = (next + 1) & mMask) {
+            const size_t home = HomeSlot(mSlots[next].key);
+            if (((next - home) & mMask) >= ((next - hole) & mMask)) {
+                mSlots[hole] = mSlots[next];
+                hole = next;
+            }
+        }
+
+        mSlots[hole].value = EMPTY_VALUE;
+        mSize--;
+        return true;
+    }
+
+    void MFTKeyTable::Rehash(size_t capacity) {
+        std::vector<Slot> previous = std::move(mSlots);
+        mSlots.assign(capacity, Slot{ 0, EMPTY_VALUE });
+        mMask = capacity - 1;
+        mShift = 64 - static_cast<uint32_t>(std::countr_zero(capacity));
+        mSize = 0;
+
+        for (const Slot& entry : previous) {
+            if (entry.value == EMPTY_VALUE) continue;
+            size_t slot = HomeSlot(entry.key);
+            while (mSlots[slot].value != EMPTY_VALUE)
+                slot = (slot + 1) & mMask;
+            mSlots[slot] = entry;
+            mSize++;
+        }
+    }
+
+}
@@ -0,0 +1,60 @@
+﻿#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace winsetup::adapters::platform {
+
+    // Growing open-addressing table from a 64-bit key to a record index or
+    // arena offset. Each slot keeps the full key, so keys are rehashed on
+    // growth without the caller, and probing is linear from a Fibonacci-
+    // hashed home slot. Erase shifts the rest of the probe run back instead
+    // of leaving tombstones. The same key may be inserted more than once;
+    // Find with a predicate walks every value stored under it.
+    class MFTKeyTable {
+    public:
+        static constexpr uint32_t EMPTY_VALUE = 0xFFFFFFFF;
+
+        void Clear() noexcept;
+        void Reserve(size_t entryCount);
+        void Insert(uint64_t key, uint32_t value);
+        bool Erase(uint64_t key, uint32_t value) noexcept;
+
+        [[nodiscard]] uint32_t Find(uint64_t key) const noexcept {
+            return Find(key, [](uint32_t) { return true; });
+        }
+
+        template<typename Matches>
+        [[nodiscard]] uint32_t Find(uint64_t key, Matches&& matches) const {
+            if (mSize == 0) return EMPTY_VALUE;
+
+            for (size_t slot = HomeSlot(key);; slot = (slot + 1) & mMask) {
+                const Slot& entry = mSlots[slot];
+                if (entry.value == EMPTY_VALUE) return EMPTY_VALUE;
+                if (entry.key == key && matches(entry.value)) return entry.value;
+            }
+        }
+
+        [[nodiscard]] size_t Size() const noexcept { return mSize; }
+        [[nodiscard]] size_t MemoryUsage() const noexcept { return mSlots.capacity() * sizeof(Slot); }
+
+    private:
+        struct Slot {
+            uint64_t key;
+            uint32_t value;
+        };
+
+        [[nodiscard]] size_t HomeSlot(uint64_t key) const noexcept {
+            return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> mShift);
+        }
+
+        void Rehash(size_t capacity);
+
+        std::vector<Slot> mSlots;
+        size_t            mMask = 0;
+        size_t            mSize = 0;
+        uint32_t          mShift = 64;
+    };
+
+}
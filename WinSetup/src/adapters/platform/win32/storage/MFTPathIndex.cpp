@@ -0,0 +1,205 @@
+﻿#include "MFTPathIndex.h"
+#include "CaseFold.h"
+#include <algorithm>
+#include <thread>
+
+namespace winsetup::adapters::platform {
+
+    namespace {
+        constexpr uint64_t PATH_HASH_SEED = CaseFold::HASH_SEED;
+        constexpr uint16_t DEPTH_UNRESOLVED = 0xFFFF;
+        constexpr uint16_t DEPTH_IN_PROGRESS = 0xFFFE;
+
+        bool IsPathSeparator(wchar_t c) noexcept {
+            return c == L'\\' || c == L'/';
+        }
+
+        template<typename Fn>
+        void ParallelFor(uint32_t count, uint32_t threadCount, Fn&& fn) {
+            if (count == 0) return;
+            threadCount = (std::max)(1u, (std::min)(threadCount, count));
+
+            const uint32_t chunk = (count + threadCount - 1) / threadCount;
+            std::vector<std::thread> workers;
+            workers.reserve(threadCount - 1);
+
+            for (uint32_t shard = 1; shard < threadCount; ++shard) {
+                const uint32_t begin = shard * chunk;
+                const uint32_t end = (std::min)(count, begin + chunk);
+                if (begin >= end) break;
+                workers.emplace_back([&fn, shard, begin, end]() { fn(shard, begin, end); });
+            }
+
+            fn(0u, 0u, (std::min)(count, chunk));
+
+            for (auto& worker : workers)
+                worker.join();
+        }
+    }
+
+    uint32_t MFTPathIndex::ResolveThreadCount(uint32_t requested, size_t slotCount) noexcept {
+        uint32_t threadCount = requested;
+        if (threadCount == 0) {
+            threadCount = static_cast<uint32_t>(std::thread::hardware_concurrency());
+            if (threadCount == 0) threadCount = 1;
+        }
+
+        const uint32_t bySize = static_cast<uint32_t>(slotCount / MIN_RECORDS_PER_THREAD) + 1;
+
+        return (std::min)({ threadCount, bySize, MAX_THREADS });
+    }
+
+    uint64_t MFTPathIndex::HashPath(std::wstring_view relativePath) noexcept {
+        uint64_t hash = PATH_HASH_SEED;
+        size_t position = 0;
+        while (position < relativePath.size()) {
+            size_t end = position;
+            while (end < relativePath.size() && !IsPathSeparator(relativePath[end])) ++end;
+            if (end > position)
+                hash = CaseFold::CombinePath(hash, CaseFold::Hash(relativePath.substr(position, end - position)));
+            position = end + 1;
+        }
+        return hash;
+    }
+
+    std::wstring_view MFTPathIndex::Extension(std::wstring_view fileName) noexcept {
+        size_t pos = fileName.find_last_of(L'.');
+        if (pos == std::wstring_view::npos || pos == 0) return {};
+        return fileName.substr(pos);
+    }
+
+    void MFTPathIndex::Clear() noexcept {
+        mPathHashes.clear();
+        mPathTable.Clear();
+        mExtensions.clear();
+    }
+
+    void MFTPathIndex::Build(MFTRecordStore& records, uint32_t threadCount) {
+        Clear();
+        threadCount = (std::max)(1u, threadCount);
+
+        const uint32_t slotCount = static_cast<uint32_t>(records.SlotCount());
+
+        ParallelFor(slotCount, threadCount,
+            [&records](uint32_t, uint32_t begin, uint32_t end) {
+                records.LinkParents(begin, end);
+            });
+
+        ComputePathHashes(records, threadCount);
+
+        std::vector<ExtensionIndex> extensionShards(threadCount);
+
+        ParallelFor(slotCount, threadCount,
+            [&records, &extensionShards](uint32_t shard, uint32_t begin, uint32_t end) {
+                auto& extensions = extensionShards[shard];
+                for (uint32_t i = begin; i < end; ++i) {
+                    if (!records.IsLive(i) || records.IsDirectory(i)) continue;
+
+                    const std::wstring_view ext = Extension(records.Name(i));
+                    if (!ext.empty()) {
+                        extensions[CaseFold::Hash(ext)].push_back(i);
+                    }
+                }
+            });
+
+        mPathTable.Reset(records.Size());
+        for (uint32_t i = 0; i < slotCount; ++i) {
+            if (records.IsLive(i))
+                mPathTable.Insert(mPathHashes[i], i);
+        }
+
+        for (auto& shard : extensionShards) {
+            for (auto& [ext, indices] : shard) {
+                auto& merged = mExtensions[ext];
+                merged.insert(merged.end(), indices.begin(), indices.end());
+            }
+        }
+    }
+
+    const std::vector<uint32_t>* MFTPathIndex::FindExtension(std::wstring_view extension) const {
+        auto it = mExtensions.find(CaseFold::Hash(extension));
+        return it != mExtensions.end() ? &it->second : nullptr;
+    }
+
+    void MFTPathIndex::ComputePathHashes(const MFTRecordStore& records, uint32_t threadCount) {
+        const uint32_t slotCount = static_cast<uint32_t>(records.SlotCount());
+        mPathHashes.assign(slotCount, 0);
+
+        std::vector<uint16_t> depths(slotCount, DEPTH_UNRESOLVED);
+        std::vector<uint32_t> chain;
+        chain.reserve(MAX_PATH_DEPTH);
+        uint16_t maxDepth = 0;
+
+        for (uint32_t i = 0; i < slotCount; ++i) {
+            if (depths[i] != DEPTH_UNRESOLVED || !records.IsLive(i) || !records.IsDirectory(i))
+                continue;
+
+            chain.clear();
+            uint32_t current = i;
+            while (current != MFTRecordStore::INVALID_INDEX &&
+                depths[current] == DEPTH_UNRESOLVED &&
+                records.IsDirectory(current) &&
+                chain.size() < MAX_PATH_DEPTH) {
+                depths[current] = DEPTH_IN_PROGRESS;
+                chain.push_back(current);
+                current = records.ParentIndex(current);
+            }
+
+            uint16_t depth = 0;
+            if (current != MFTRecordStore::INVALID_INDEX && depths[current] < DEPTH_IN_PROGRESS)
+                depth = static_cast<uint16_t>(depths[current] + 1);
+
+            for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+                depths[*it] = depth;
+                maxDepth = (std::max)(maxDepth, depth);
+                depth++;
+            }
+        }
+
+        std::vector<uint32_t> levelStarts(static_cast<size_t>(maxDepth) + 2, 0);
+        for (uint32_t i = 0; i < slotCount; ++i) {
+            if (depths[i] < DEPTH_IN_PROGRESS)
+                levelStarts[depths[i] + 1]++;
+        }
+        for (size_t level = 1; level < levelStarts.size(); ++level)
+            levelStarts[level] += levelStarts[level - 1];
+
+        std::vector<uint32_t> directoriesByDepth(levelStarts.back());
+        std::vector<uint32_t> cursor(levelStarts.begin(), levelStarts.end() - 1);
+        for (uint32_t i = 0; i < slotCount; ++i) {
+            if (depths[i] < DEPTH_IN_PROGRESS)
+                directoriesByDepth[cursor[depths[i]]++] = i;
+        }
+
+        auto hashUnderParent = [this, &records, &depths](uint32_t index) {
+            const uint32_t parent = records.ParentIndex(index);
+            const bool hasParent = parent != MFTRecordStore::INVALID_INDEX &&
+                depths[parent] < DEPTH_IN_PROGRESS &&
+                (!records.IsDirectory(index) || depths[parent] < depths[index]);
+
+            const uint64_t parentHash = hasParent ? mPathHashes[parent] : PATH_HASH_SEED;
+            mPathHashes[index] = CaseFold::CombinePath(parentHash, CaseFold::Hash(records.Name(index)));
+        };
+
+        for (size_t level = 0; level + 1 < levelStarts.size(); ++level) {
+            const uint32_t levelBegin = levelStarts[level];
+            const uint32_t levelSize = levelStarts[level + 1] - levelBegin;
+            const uint32_t levelThreads = levelSize >= MIN_RECORDS_PER_THREAD ? threadCount : 1;
+
+            ParallelFor(levelSize, levelThreads,
+                [&](uint32_t, uint32_t begin, uint32_t end) {
+                    for (uint32_t k = begin; k < end; ++k)
+                        hashUnderParent(directoriesByDepth[levelBegin + k]);
+                });
+        }
+
+        ParallelFor(slotCount, threadCount,
+            [&](uint32_t, uint32_t begin, uint32_t end) {
+                for (uint32_t i = begin; i < end; ++i) {
+                    if (records.IsLive(i) && !records.IsDirectory(i))
+                        hashUnderParent(i);
+                }
+            });
+    }
+
+}
@@ -0,0 +1,58 @@
+﻿#pragma once
+
+#include <adapters/platform/win32/storage/MFTPathTable.h>
+#include <adapters/platform/win32/storage/MFTRecordStore.h>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace winsetup::adapters::platform {
+
+    // Path and extension lookups over an MFTRecordStore. Build() hashes each
+    // record's full path one directory depth at a time, so a level can be
+    // split across threads, and merges per-thread extension shards in slot
+    // order. The result is the same for any thread count.
+    class MFTPathIndex {
+    public:
+        using ExtensionIndex = std::unordered_map<uint64_t, std::vector<uint32_t>>;
+
+        static constexpr int      MAX_PATH_DEPTH = 256;
+        static constexpr uint32_t MAX_THREADS = 64;
+        static constexpr uint32_t MIN_RECORDS_PER_THREAD = 65536;
+
+        // 0 asks for one thread per core; small stores get fewer.
+        [[nodiscard]] static uint32_t ResolveThreadCount(uint32_t requested, size_t slotCount) noexcept;
+
+        [[nodiscard]] static uint64_t HashPath(std::wstring_view relativePath) noexcept;
+
+        // The extension including its dot, or empty for none and dotfiles.
+        [[nodiscard]] static std::wstring_view Extension(std::wstring_view fileName) noexcept;
+
+        void Clear() noexcept;
+
+        // Links parents in the store, then rebuilds every index from it.
+        void Build(MFTRecordStore& records, uint32_t threadCount);
+
+        // Hash hits are candidates; matches confirms them against the store.
+        template<typename Matches>
+        [[nodiscard]] uint32_t Find(std::wstring_view relativePath, Matches&& matches) const {
+            return mPathTable.Find(HashPath(relativePath), std::forward<Matches>(matches));
+        }
+
+        [[nodiscard]] const std::vector<uint32_t>* FindExtension(std::wstring_view extension) const;
+
+        [[nodiscard]] const std::vector<uint64_t>& PathHashes() const noexcept { return mPathHashes; }
+        [[nodiscard]] const ExtensionIndex& Extensions() const noexcept { return mExtensions; }
+
+    private:
+        void ComputePathHashes(const MFTRecordStore& records, uint32_t threadCount);
+
+        std::vector<uint64_t> mPathHashes;
+        MFTPathTable          mPathTable;
+        ExtensionIndex        mExtensions;
+    };
+
+}
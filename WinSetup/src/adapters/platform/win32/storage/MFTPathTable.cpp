@@ -0,0 +1,44 @@
+﻿#include "MFTPathTable.h"
+
+namespace winsetup::adapters::platform {
+
+    namespace {
+        constexpr size_t MIN_CAPACITY = 64;
+
+        // Keeps the load factor at or below 0.7 so probe runs stay short.
+        size_t CapacityFor(size_t entryCount) noexcept {
+            const size_t required = entryCount + entryCount * 3 / 7 + 1;
+            size_t capacity = MIN_CAPACITY;
+            while (capacity < required) capacity <<= 1;
+            return capacity;
+        }
+    }
+
+    void MFTPathTable::Clear() noexcept {
+        mSlots.clear();
+        mMask = 0;
+        mSize = 0;
+        mMaxEntries = 0;
+    }
+
+    void MFTPathTable::Reset(size_t maxEntries) {
+        const size_t capacity = CapacityFor(maxEntries);
+        mSlots.assign(capacity, Slot{ 0, EMPTY_INDEX });
+        mMask = capacity - 1;
+        mSize = 0;
+        mMaxEntries = maxEntries;
+    }
+
+    bool MFTPathTable::Insert(uint64_t hash, uint32_t index) noexcept {
+        if (mSize >= mMaxEntries) return false;
+
+        size_t slot = static_cast<size_t>(hash) & mMask;
+        while (mSlots[slot].index != EMPTY_INDEX)
+            slot = (slot + 1) & mMask;
+
+        mSlots[slot] = Slot{ static_cast<uint32_t>(hash >> 32), index };
+        mSize++;
+        return true;
+    }
+
+}
@@ -0,0 +1,49 @@
+﻿#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace winsetup::adapters::platform {
+
+    // Open-addressing table from path hash to record index. Slots hold the
+    // upper 32 bits of the hash as a tag next to the index, and the lower
+    // bits pick the home slot; probing is linear. Tag hits are candidates
+    // only, so callers confirm each one against the record itself. The table
+    // is sized up front by Reset() and does not grow.
+    class MFTPathTable {
+    public:
+        static constexpr uint32_t EMPTY_INDEX = 0xFFFFFFFF;
+
+        void Clear() noexcept;
+        void Reset(size_t maxEntries);
+        bool Insert(uint64_t hash, uint32_t index) noexcept;
+
+        template<typename Matches>
+        [[nodiscard]] uint32_t Find(uint64_t hash, Matches&& matches) const {
+            if (mSlots.empty()) return EMPTY_INDEX;
+
+            const uint32_t tag = static_cast<uint32_t>(hash >> 32);
+            for (size_t slot = static_cast<size_t>(hash) & mMask;; slot = (slot + 1) & mMask) {
+                const Slot& entry = mSlots[slot];
+                if (entry.index == EMPTY_INDEX) return EMPTY_INDEX;
+                if (entry.tag == tag && matches(entry.index)) return entry.index;
+            }
+        }
+
+        [[nodiscard]] size_t Size() const noexcept { return mSize; }
+        [[nodiscard]] size_t MemoryUsage() const noexcept { return mSlots.capacity() * sizeof(Slot); }
+
+    private:
+        struct Slot {
+            uint32_t tag;
+            uint32_t index;
+        };
+
+        std::vector<Slot> mSlots;
+        size_t            mMask = 0;
+        size_t            mSize = 0;
+        size_t            mMaxEntries = 0;
+    };
+
+}
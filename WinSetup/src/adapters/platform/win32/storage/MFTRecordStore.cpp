@@ -0,0 +1,215 @@
+﻿#include "MFTRecordStore.h"
+#include <algorithm>
+#include <cstring>
+
+namespace winsetup::adapters::platform {
+
+    namespace {
+        constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+        constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+        constexpr int      MAX_PATH_DEPTH = 256;
+        constexpr size_t   MAX_NAME_CHARS = 0xFFFF;
+
+        uint64_t HashName(std::wstring_view name) noexcept {
+            uint64_t hash = FNV_OFFSET_BASIS;
+            for (wchar_t c : name) {
+                hash ^= static_cast<uint16_t>(c);
+                hash *= FNV_PRIME;
+            }
+            return hash;
+        }
+
+        FILETIME UInt64ToFileTime(uint64_t value) noexcept {
+            FILETIME ft;
+            ft.dwLowDateTime = static_cast<DWORD>(value & 0xFFFFFFFF);
+            ft.dwHighDateTime = static_cast<DWORD>(value >> 32);
+            return ft;
+        }
+    }
+
+    void MFTRecordStore::Clear() {
+        mFileRefs.clear();
+        mParentRefs.clear();
+        mParentIndices.clear();
+        mFileSizes.clear();
+        mAttributes.clear();
+        mTimestamps.clear();
+        mCreationTimes.clear();
+        mLastAccessTimes.clear();
+        mNameOffsets.clear();
+        mNameLengths.clear();
+        mNameArena.clear();
+        mIndexByRef.Clear();
+        mInternTable.Clear();
+        mLiveCount = 0;
+    }
+
+    void MFTRecordStore::Reserve(size_t recordCount, size_t nameChars) {
+        mFileRefs.reserve(recordCount);
+        mParentRefs.reserve(recordCount);
+        mParentIndices.reserve(recordCount);
+        mFileSizes.reserve(recordCount);
+        mAttributes.reserve(recordCount);
+        mTimestamps.reserve(recordCount);
+        mCreationTimes.reserve(recordCount);
+        mLastAccessTimes.reserve(recordCount);
+        mNameOffsets.reserve(recordCount);
+        mNameLengths.reserve(recordCount);
+        mNameArena.reserve(nameChars);
+        mIndexByRef.Reserve(recordCount);
+    }
+
+    uint32_t MFTRecordStore::InternName(std::wstring_view name) {
+        const uint64_t hash = HashName(name);
+
+        const uint32_t found = mInternTable.Find(hash, [this, name](uint32_t offset) {
+            return offset + name.size() <= mNameArena.size() &&
+                std::wmemcmp(mNameArena.data() + offset, name.data(), name.size()) == 0;
+        });
+        if (found != MFTKeyTable::EMPTY_VALUE) return found;
+
+        const uint32_t offset = static_cast<uint32_t>(mNameArena.size());
+        mNameArena.insert(mNameArena.end(), name.begin(), name.end());
+        mInternTable.Insert(hash, offset);
+        return offset;
+    }
+
+    uint32_t MFTRecordStore::Upsert(
+        uint64_t fileRef,
+        uint64_t parentRef,
+        uint32_t attributes,
+        uint64_t timestamp,
+        std::wstring_view name
+    ) {
+        if (name.empty()) return INVALID_INDEX;
+        if (name.size() > MAX_NAME_CHARS) name = name.substr(0, MAX_NAME_CHARS);
+
+        const uint32_t existing = mIndexByRef.Find(fileRef);
+        if (existing != MFTKeyTable::EMPTY_VALUE) {
+            const uint32_t index = existing;
+            mParentRefs[index] = parentRef;
+            mParentIndices[index] = INVALID_INDEX;
+            mAttributes[index] = attributes;
+            mTimestamps[index] = timestamp;
+            if (Name(index) != name) {
+                mNameOffsets[index] = InternName(name);
+                mNameLengths[index] = static_cast<uint16_t>(name.size());
+            }
+            return index;
+        }
+
+        const uint32_t index = static_cast<uint32_t>(mFileRefs.size());
+        const uint32_t nameOffset = InternName(name);
+
+        mFileRefs.push_back(fileRef);
+        mParentRefs.push_back(parentRef);
+        mParentIndices.push_back(INVALID_INDEX);
+        mFileSizes.push_back(0);
+        mAttributes.push_back(attributes);
+        mTimestamps.push_back(timestamp);
+        mCreationTimes.push_back(timestamp);
+        mLastAccessTimes.push_back(timestamp);
+        mNameOffsets.push_back(nameOffset);
+        mNameLengths.push_back(static_cast<uint16_t>(name.size()));
+
+        mIndexByRef.Insert(fileRef, index);
+        mLiveCount++;
+        return index;
+    }
+
+    bool MFTRecordStore::Erase(uint64_t fileRef) {
+        const uint32_t index = mIndexByRef.Find(fileRef);
+        if (index == MFTKeyTable::EMPTY_VALUE) return false;
+
+        mNameLengths[index] = 0;
+        mParentIndices[index] = INVALID_INDEX;
+        mIndexByRef.Erase(fileRef, index);
+        mLiveCount--;
+        return true;
+    }
+
+    uint32_t MFTRecordStore::Find(uint64_t fileRef) const noexcept {
+        static_assert(MFTKeyTable::EMPTY_VALUE == INVALID_INDEX);
+        return mIndexByRef.Find(fileRef);
+    }
+
+    void MFTRecordStore::LinkParents() {
+        LinkParents(0, static_cast<uint32_t>(mFileRefs.size()));
+    }
+
+    void MFTRecordStore::LinkParents(uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+            if (!IsLive(i) || mParentRefs[i] == mFileRefs[i]) {
+                mParentIndices[i] = INVALID_INDEX;
+                continue;
+            }
+            mParentIndices[i] = Find(mParentRefs[i]);
+        }
+    }
+
+    void MFTRecordStore::Compact() {
+        if (mLiveCount == mFileRefs.size()) return;
+
+        MFTRecordStore compacted;
+        compacted.Reserve(mLiveCount, mNameArena.size());
+
+        const uint32_t count = static_cast<uint32_t>(mFileRefs.size());
+        for (uint32_t i = 0; i < count; ++i) {
+            if (!IsLive(i)) continue;
+            const uint32_t index = compacted.Upsert(
+                mFileRefs[i], mParentRefs[i], mAttributes[i], mTimestamps[i], Name(i));
+            compacted.SetFileSize(index, mFileSizes[i]);
+            compacted.SetTimes(index, mCreationTimes[i], mTimestamps[i], mLastAccessTimes[i]);
+        }
+
+        compacted.LinkParents();
+        *this = std::move(compacted);
+    }
+
+    std::wstring MFTRecordStore::BuildPath(uint32_t index) const {
+        if (index >= mFileRefs.size() || !IsLive(index)) return L"";
+
+        uint32_t chain[MAX_PATH_DEPTH];
+        int      depth = 0;
+        size_t   length = 0;
+
+        for (uint32_t current = index;
+            current != INVALID_INDEX && depth < MAX_PATH_DEPTH;
+            current = mParentIndices[current]) {
+            chain[depth++] = current;
+            length += mNameLengths[current] + 1;
+        }
+
+        std::wstring path;
+        path.reserve(length);
+        for (int i = depth - 1; i >= 0; --i) {
+            path.append(Name(chain[i]));
+            if (i > 0) path.push_back(L'\\');
+        }
+
+        return path;
+    }
+
+    MFTFileRecord MFTRecordStore::ToRecord(uint32_t index) const {
+        MFTFileRecord record{};
+        record.fileReferenceNumber = mFileRefs[index];
+        record.parentFileReferenceNumber = mParentRefs[index];
+        record.fileName.assign(Name(index));
+        record.fileSize = mFileSizes[index];
+        record.fileAttributes = mAttributes[index];
+        record.creationTime = UInt64ToFileTime(mCreationTimes[index]);
+        record.lastAccessTime = UInt64ToFileTime(mLastAccessTimes[index]);
+        record.lastWriteTime = UInt64ToFileTime(mTimestamps[index]);
+        record.isDirectory = IsDirectory(index);
+        return record;
+    }
+
+    size_t MFTRecordStore::MemoryUsage() const noexcept {
+        const size_t slots = mFileRefs.capacity();
+        return slots * (sizeof(uint64_t) * 6 + sizeof(uint32_t) * 3 + sizeof(uint16_t)) +
+            mNameArena.capacity() * sizeof(wchar_t) +
+            mIndexByRef.MemoryUsage() +
+            mInternTable.MemoryUsage();
+    }
+
+}
@@ -0,0 +1,132 @@
+﻿#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <Windows.h>
+#include <adapters/platform/win32/storage/MFTKeyTable.h>
+
+namespace winsetup::adapters::platform {
+
+    struct MFTFileRecord {
+        uint64_t fileReferenceNumber;
+        uint64_t parentFileReferenceNumber;
+        std::wstring fileName;
+        uint64_t fileSize;
+        uint32_t fileAttributes;
+        FILETIME creationTime;
+        FILETIME lastAccessTime;
+        FILETIME lastWriteTime;
+        bool isDirectory;
+
+        [[nodiscard]] bool IsSystemFile() const noexcept {
+            return (fileAttributes & FILE_ATTRIBUTE_SYSTEM) != 0;
+        }
+
+        [[nodiscard]] bool IsHidden() const noexcept {
+            return (fileAttributes & FILE_ATTRIBUTE_HIDDEN) != 0;
+        }
+
+        [[nodiscard]] bool IsReadOnly() const noexcept {
+            return (fileAttributes & FILE_ATTRIBUTE_READONLY) != 0;
+        }
+    };
+
+    // Columnar storage for MFT records. Each record occupies one slot across
+    // parallel arrays; names live in a single UTF-16 arena and identical names
+    // share one copy. File references and name hashes are looked up through
+    // flat MFTKeyTables rather than node-based maps, which on a few million
+    // records is most of the difference in memory and insert time. Erased
+    // slots become tombstones until Compact().
+    class MFTRecordStore {
+    public:
+        static constexpr uint32_t INVALID_INDEX = 0xFFFFFFFF;
+
+        MFTRecordStore() = default;
+        ~MFTRecordStore() = default;
+
+        MFTRecordStore(const MFTRecordStore&) = delete;
+        MFTRecordStore& operator=(const MFTRecordStore&) = delete;
+        MFTRecordStore(MFTRecordStore&&) noexcept = default;
+        MFTRecordStore& operator=(MFTRecordStore&&) noexcept = default;
+
+        void Clear();
+        void Reserve(size_t recordCount, size_t nameChars);
+
+        uint32_t Upsert(
+            uint64_t fileRef,
+            uint64_t parentRef,
+            uint32_t attributes,
+            uint64_t timestamp,
+            std::wstring_view name
+        );
+
+        bool Erase(uint64_t fileRef);
+
+        void SetFileSize(uint32_t index, uint64_t fileSize) noexcept {
+            mFileSizes[index] = fileSize;
+        }
+
+        void SetTimes(uint32_t index, uint64_t creationTime, uint64_t lastWriteTime, uint64_t lastAccessTime) noexcept {
+            mCreationTimes[index] = creationTime;
+            mTimestamps[index] = lastWriteTime;
+            mLastAccessTimes[index] = lastAccessTime;
+        }
+
+        void LinkParents();
+        void LinkParents(uint32_t begin, uint32_t end);
+        void Compact();
+
+        [[nodiscard]] uint32_t Find(uint64_t fileRef) const noexcept;
+
+        [[nodiscard]] size_t SlotCount() const noexcept { return mFileRefs.size(); }
+        [[nodiscard]] size_t Size() const noexcept { return mLiveCount; }
+        [[nodiscard]] bool Empty() const noexcept { return mLiveCount == 0; }
+
+        [[nodiscard]] bool IsLive(uint32_t index) const noexcept {
+            return mNameLengths[index] != 0;
+        }
+
+        [[nodiscard]] uint64_t FileRef(uint32_t index) const noexcept { return mFileRefs[index]; }
+        [[nodiscard]] uint64_t ParentRef(uint32_t index) const noexcept { return mParentRefs[index]; }
+        [[nodiscard]] uint32_t ParentIndex(uint32_t index) const noexcept { return mParentIndices[index]; }
+        [[nodiscard]] uint64_t FileSize(uint32_t index) const noexcept { return mFileSizes[index]; }
+        [[nodiscard]] uint32_t Attributes(uint32_t index) const noexcept { return mAttributes[index]; }
+        [[nodiscard]] uint64_t Timestamp(uint32_t index) const noexcept { return mTimestamps[index]; }
+        [[nodiscard]] uint64_t CreationTime(uint32_t index) const noexcept { return mCreationTimes[index]; }
+        [[nodiscard]] uint64_t LastAccessTime(uint32_t index) const noexcept { return mLastAccessTimes[index]; }
+
+        [[nodiscard]] bool IsDirectory(uint32_t index) const noexcept {
+            return (mAttributes[index] & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        }
+
+        [[nodiscard]] std::wstring_view Name(uint32_t index) const noexcept {
+            return std::wstring_view(mNameArena.data() + mNameOffsets[index], mNameLengths[index]);
+        }
+
+        [[nodiscard]] std::wstring BuildPath(uint32_t index) const;
+        [[nodiscard]] MFTFileRecord ToRecord(uint32_t index) const;
+        [[nodiscard]] size_t MemoryUsage() const noexcept;
+
+    private:
+        [[nodiscard]] uint32_t InternName(std::wstring_view name);
+
+        std::vector<uint64_t> mFileRefs;
+        std::vector<uint64_t> mParentRefs;
+        std::vector<uint32_t> mParentIndices;
+        std::vector<uint64_t> mFileSizes;
+        std::vector<uint32_t> mAttributes;
+        std::vector<uint64_t> mTimestamps;
+        std::vector<uint64_t> mCreationTimes;
+        std::vector<uint64_t> mLastAccessTimes;
+        std::vector<uint32_t> mNameOffsets;
+        std::vector<uint16_t> mNameLengths;
+        std::vector<wchar_t>  mNameArena;
+
+        MFTKeyTable mIndexByRef;
+        MFTKeyTable mInternTable;
+        size_t mLiveCount = 0;
+    };
+
+}
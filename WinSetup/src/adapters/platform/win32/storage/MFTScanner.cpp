@@ -1,7 +1,15 @@
 ﻿#include "MFTScanner.h"
+#include "MFTIndexSnapshot.h"
+#include "USNRecordParser.h"
+#include "AsyncIOCTL.h"
+#include "CaseFold.h"
 #include <adapters/platform/win32/core/Win32ErrorHandler.h>
 #include <adapters/platform/win32/core/Win32HandleFactory.h>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
 #include <algorithm>
 #include <cwctype>
 #include <cstring>
@@ -10,12 +18,25 @@ namespace winsetup::adapters::platform {
 
     namespace {
         constexpr size_t BUFFER_SIZE = 64 * 1024;
-
-        std::wstring ToLower(std::wstring str) {
-            std::transform(str.begin(), str.end(), str.begin(),
-                [](wchar_t c) { return static_cast<wchar_t>(std::towlower(c)); });
-            return str;
-        }
+        constexpr size_t BOOT_SECTOR_READ_SIZE = 4096;
+        constexpr uint64_t RECORD_NUMBER_MASK = 0x0000FFFFFFFFFFFFull;
+        constexpr uint64_t ROOT_DIRECTORY_RECORD = 5;
+        constexpr uint32_t RAW_RECORDS_PER_STOP_CHECK = 4096;
+
+        static_assert(sizeof(wchar_t) == sizeof(char16_t), "USN names are UTF-16");
+
+        struct EnumPipeline {
+            std::mutex                     mutex;
+            std::condition_variable        cv;
+            std::vector<std::vector<BYTE>> buffers;
+            std::vector<uint32_t>          freeSlots;
+            std::deque<std::pair<uint32_t, DWORD>> filled;
+            MFT_ENUM_DATA                  med{};
+            bool                           inFlight = false;
+            bool                           finished = false;
+            bool                           stopRequested = false;
+            DWORD                          error = ERROR_SUCCESS;
+        };
 
         bool EndsWith(const std::wstring& str, const std::wstring& suffix) {
             if (suffix.size() > str.size()) return false;
@@ -35,21 +56,26 @@ namespace winsetup::adapters::platform {
             return pos != std::wstring::npos ? path.substr(0, pos) : L"";
         }
 
-        std::wstring ExtractExtension(const std::wstring& fileName) {
-            size_t pos = fileName.find_last_of(L'.');
-            if (pos == std::wstring::npos || pos == 0) return L"";
-            return ToLower(fileName.substr(pos));
+        bool IsPathSeparator(wchar_t c) noexcept {
+            return c == L'\\' || c == L'/';
         }
 
-        FILETIME LargeIntegerToFileTime(const LARGE_INTEGER& li) noexcept {
-            FILETIME ft;
-            ft.dwLowDateTime = static_cast<DWORD>(li.QuadPart & 0xFFFFFFFF);
-            ft.dwHighDateTime = static_cast<DWORD>(li.QuadPart >> 32);
-            return ft;
+        // Drops a drive prefix and leading separators; the index holds
+        // volume-relative paths.
+        std::wstring_view StripVolumePrefix(std::wstring_view path) noexcept {
+            if (path.size() >= 2 && path[1] == L':')
+                path.remove_prefix(2);
+            while (!path.empty() && IsPathSeparator(path.front()))
+                path.remove_prefix(1);
+            while (!path.empty() && IsPathSeparator(path.back()))
+                path.remove_suffix(1);
+            return path;
         }
+
+        constexpr int MAX_PATH_DEPTH = MFTPathIndex::MAX_PATH_DEPTH;
     }
 
-    std::wstring MFTScanner::NormalizeVolumePath(const std::wstring& volumePath) {
+    std::wstring MFTScanner::NormalizeVolumePath(const std::wstring& volumePath) const {
         std::wstring normalized = volumePath;
 
         if (normalized.length() == 2 && normalized[1] == L':') {
@@ -67,24 +93,29 @@ namespace winsetup::adapters::platform {
         return normalized;
     }
 
-    std::wstring MFTScanner::NormalizeFilePath(const std::wstring& filePath) {
-        std::wstring normalized = filePath;
+    bool MFTScanner::MatchesPath(uint32_t index, std::wstring_view relativePath) const noexcept {
+        uint32_t current = index;
+        size_t   end = relativePath.size();
 
-        if (!normalized.empty() && (normalized[0] == L'\\' || normalized[0] == L'/')) {
-            normalized = normalized.substr(1);
-        }
+        for (int depth = 0; depth < MAX_PATH_DEPTH; ++depth) {
+            while (end > 0 && IsPathSeparator(relativePath[end - 1])) --end;
+            if (end == 0) return current == MFTRecordStore::INVALID_INDEX;
+            if (current == MFTRecordStore::INVALID_INDEX) return false;
+
+            size_t start = end;
+            while (start > 0 && !IsPathSeparator(relativePath[start - 1])) --start;
 
-        std::replace(normalized.begin(), normalized.end(), L'/', L'\\');
+            if (!CaseFold::Equals(mRecords.Name(current), relativePath.substr(start, end - start)))
+                return false;
 
-        while (normalized.find(L"\\\\") != std::wstring::npos) {
-            size_t pos = normalized.find(L"\\\\");
-            normalized.erase(pos, 1);
+            current = mRecords.ParentIndex(current);
+            end = start;
         }
 
-        return ToLower(normalized);
+        return false;
     }
 
-    adapters::platform::UniqueHandle MFTScanner::OpenVolumeHandle(const std::wstring& volumePath) {
+    adapters::platform::UniqueHandle MFTScanner::OpenVolumeHandle(const std::wstring& volumePath, DWORD flags) {
         std::wstring normalizedPath = NormalizeVolumePath(volumePath);
 
         HANDLE hVolume = CreateFileW(
@@ -93,7 +124,7 @@ namespace winsetup::adapters::platform {
             FILE_SHARE_READ | FILE_SHARE_WRITE,
             nullptr,
             OPEN_EXISTING,
-            0,
+            flags,
             nullptr
         );
 
@@ -138,44 +169,57 @@ namespace winsetup::adapters::platform {
         return journalData;
     }
 
-    bool MFTScanner::ParseUSNRecord(const USN_RECORD* record, MFTFileRecord& outFileRecord) {
-        if (!record) return false;
+    bool MFTScanner::StoreUSNRecord(const USNRecordView& record) {
+        if (record.fileName.empty()) return false;
 
-        outFileRecord.fileReferenceNumber = record->FileReferenceNumber;
-        outFileRecord.parentFileReferenceNumber = record->ParentFileReferenceNumber;
-        outFileRecord.fileSize = 0;
-        outFileRecord.fileAttributes = record->FileAttributes;
+        const std::wstring_view name(
+            reinterpret_cast<const wchar_t*>(record.fileName.data()),
+            record.fileName.size()
+        );
 
-        outFileRecord.creationTime = LargeIntegerToFileTime(record->TimeStamp);
-        outFileRecord.lastAccessTime = LargeIntegerToFileTime(record->TimeStamp);
-        outFileRecord.lastWriteTime = LargeIntegerToFileTime(record->TimeStamp);
+        return mRecords.Upsert(
+            record.fileReferenceNumber,
+            record.parentFileReferenceNumber,
+            record.fileAttributes,
+            static_cast<uint64_t>(record.timestamp),
+            name
+        ) != MFTRecordStore::INVALID_INDEX;
+    }
 
-        outFileRecord.isDirectory = (record->FileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+    size_t MFTScanner::AppendUSNRecords(const BYTE* buffer, size_t bufferSize, size_t maxRecords) {
+        size_t stored = 0;
+        USNRecordParser parser(buffer, bufferSize);
+        USNRecordView record;
 
-        if (record->FileNameLength > 0 && record->FileNameLength < 32768) {
-            size_t charCount = record->FileNameLength / sizeof(WCHAR);
-            outFileRecord.fileName.assign(record->FileName, charCount);
+        while (stored < maxRecords && parser.Next(record)) {
+            if (StoreUSNRecord(record))
+                stored++;
         }
 
-        return !outFileRecord.fileName.empty();
+        return stored;
     }
 
     domain::Expected<void> MFTScanner::ReadUSNJournal(
         HANDLE hVolume,
-        const USN_JOURNAL_DATA& journalData,
-        std::vector<MFTFileRecord>& outRecords
+        const USN_JOURNAL_DATA& journalData
     ) {
-        std::vector<BYTE> buffer(BUFFER_SIZE);
+        std::vector<BYTE> buffer(mEnumBufferSize);
 
         MFT_ENUM_DATA med{};
         med.StartFileReferenceNumber = 0;
         med.LowUsn = 0;
         med.HighUsn = journalData.NextUsn;
 
-        DWORD    bytesReturned = 0;
-        uint32_t filesScanned = 0;
+        DWORD  bytesReturned = 0;
+        size_t filesScanned = 0;
 
         while (true) {
+            if (filesScanned >= mMaxFilesToScan) {
+                mCompletion = MFTScanCompletion::RecordLimit;
+                break;
+            }
+            if (ShouldStopScan()) break;
+
             BOOL result = DeviceIoControl(
                 hVolume,
                 FSCTL_ENUM_USN_DATA,
@@ -197,103 +241,487 @@ namespace winsetup::adapters::platform {
                 };
             }
 
-            if (bytesReturned < sizeof(USN)) break;
+            int64_t resumePoint = 0;
+            if (!USNRecordParser::ReadResumePoint(buffer.data(), bytesReturned, resumePoint)) break;
+            med.StartFileReferenceNumber = static_cast<DWORDLONG>(resumePoint);
 
-            DWORD dwRetBytes = bytesReturned - sizeof(USN);
-            USN* pUsn = reinterpret_cast<USN*>(buffer.data());
-            med.StartFileReferenceNumber = *pUsn;
+            filesScanned += AppendUSNRecords(
+                buffer.data() + USNRecordParser::RESUME_POINT_SIZE,
+                bytesReturned - USNRecordParser::RESUME_POINT_SIZE,
+                mMaxFilesToScan - filesScanned
+            );
+            ReportScanProgress(filesScanned, resumePoint);
+        }
+
+        return domain::Expected<void>();
+    }
 
-            BYTE* pRecord = buffer.data() + sizeof(USN);
+    domain::Expected<void> MFTScanner::ReadUSNJournalPipelined(
+        HANDLE hVolume,
+        const USN_JOURNAL_DATA& journalData
+    ) {
+        EnumPipeline              pipeline;
+        std::optional<AsyncIOCTL> asyncIO;
+        asyncIO.emplace();
+
+        pipeline.buffers.resize(mEnumBufferCount);
+        for (uint32_t slot = 0; slot < mEnumBufferCount; ++slot) {
+            pipeline.buffers[slot].resize(mEnumBufferSize);
+            pipeline.freeSlots.push_back(mEnumBufferCount - 1 - slot);
+        }
 
-            while (dwRetBytes > 0) {
-                USN_RECORD* record = reinterpret_cast<USN_RECORD*>(pRecord);
+        pipeline.med.StartFileReferenceNumber = 0;
+        pipeline.med.LowUsn = 0;
+        pipeline.med.HighUsn = journalData.NextUsn;
 
-                if (record->RecordLength == 0 || record->RecordLength > dwRetBytes) break;
+        std::function<void(uint32_t)> issueRead;
 
-                MFTFileRecord fileRecord;
-                if (ParseUSNRecord(record, fileRecord)) {
-                    outRecords.push_back(std::move(fileRecord));
-                    filesScanned++;
+        auto onComplete = [&pipeline, &issueRead](uint32_t slot, const AsyncIOCTLResult& result) {
+            int64_t  resumePoint = 0;
+            uint32_t nextSlot = MFTRecordStore::INVALID_INDEX;
+            {
+                std::lock_guard<std::mutex> lock(pipeline.mutex);
+                pipeline.inFlight = false;
 
-                    if (filesScanned >= mMaxFilesToScan)
-                        return domain::Expected<void>();
+                if (!result.IsCompleted()) {
+                    pipeline.finished = true;
+                    if (result.errorCode != ERROR_HANDLE_EOF)
+                        pipeline.error = result.errorCode ? result.errorCode : ERROR_OPERATION_ABORTED;
+                    pipeline.freeSlots.push_back(slot);
+                }
+                else if (!USNRecordParser::ReadResumePoint(
+                    pipeline.buffers[slot].data(), result.bytesTransferred, resumePoint)) {
+                    pipeline.finished = true;
+                    pipeline.freeSlots.push_back(slot);
                 }
+                else {
+                    pipeline.med.StartFileReferenceNumber = static_cast<DWORDLONG>(resumePoint);
+                    pipeline.filled.emplace_back(slot, result.bytesTransferred);
+
+                    if (!pipeline.stopRequested && !pipeline.freeSlots.empty()) {
+                        nextSlot = pipeline.freeSlots.back();
+                        pipeline.freeSlots.pop_back();
+                        pipeline.inFlight = true;
+                    }
+                }
+            }
+            pipeline.cv.notify_all();
 
-                pRecord += record->RecordLength;
-                dwRetBytes -= record->RecordLength;
+            if (nextSlot != MFTRecordStore::INVALID_INDEX)
+                issueRead(nextSlot);
+        };
+
+        issueRead = [&pipeline, &asyncIO, &onComplete, hVolume](uint32_t slot) {
+            MFT_ENUM_DATA med;
+            {
+                std::lock_guard<std::mutex> lock(pipeline.mutex);
+                med = pipeline.med;
+            }
+
+            auto sendResult = asyncIO->SendAsync(
+                hVolume,
+                FSCTL_ENUM_USN_DATA,
+                &med,
+                sizeof(med),
+                std::span<BYTE>(pipeline.buffers[slot]),
+                [&onComplete, slot](const AsyncIOCTLResult& result) { onComplete(slot, result); }
+            );
+
+            if (!sendResult.HasValue()) {
+                std::lock_guard<std::mutex> lock(pipeline.mutex);
+                if (pipeline.inFlight) {
+                    pipeline.inFlight = false;
+                    pipeline.finished = true;
+                    pipeline.error = sendResult.GetError().GetCode();
+                    pipeline.freeSlots.push_back(slot);
+                }
+                pipeline.cv.notify_all();
             }
+        };
+
+        {
+            std::lock_guard<std::mutex> lock(pipeline.mutex);
+            pipeline.inFlight = true;
+            pipeline.freeSlots.pop_back();
+        }
+        issueRead(0);
+
+        size_t filesScanned = 0;
+
+        while (true) {
+            std::pair<uint32_t, DWORD> ready;
+            int64_t                    resumePoint = 0;
+            {
+                std::unique_lock<std::mutex> lock(pipeline.mutex);
+                pipeline.cv.wait(lock, [&pipeline]() {
+                    return !pipeline.filled.empty() || (pipeline.finished && !pipeline.inFlight);
+                });
+                if (pipeline.filled.empty()) break;
+                ready = pipeline.filled.front();
+                pipeline.filled.pop_front();
+                resumePoint = static_cast<int64_t>(pipeline.med.StartFileReferenceNumber);
+            }
+
+            const auto& buffer = pipeline.buffers[ready.first];
+            filesScanned += AppendUSNRecords(
+                buffer.data() + USNRecordParser::RESUME_POINT_SIZE,
+                ready.second - USNRecordParser::RESUME_POINT_SIZE,
+                mMaxFilesToScan - filesScanned
+            );
+            ReportScanProgress(filesScanned, resumePoint);
+
+            bool stop = ShouldStopScan();
+            if (!stop && filesScanned >= mMaxFilesToScan) {
+                mCompletion = MFTScanCompletion::RecordLimit;
+                stop = true;
+            }
+
+            uint32_t nextSlot = MFTRecordStore::INVALID_INDEX;
+            {
+                std::lock_guard<std::mutex> lock(pipeline.mutex);
+                pipeline.freeSlots.push_back(ready.first);
+
+                if (stop) {
+                    pipeline.stopRequested = true;
+                    pipeline.finished = true;
+                }
+                else if (!pipeline.inFlight && !pipeline.finished) {
+                    nextSlot = pipeline.freeSlots.back();
+                    pipeline.freeSlots.pop_back();
+                    pipeline.inFlight = true;
+                }
+            }
+
+            if (nextSlot != MFTRecordStore::INVALID_INDEX)
+                issueRead(nextSlot);
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(pipeline.mutex);
+            pipeline.cv.wait(lock, [&pipeline]() { return !pipeline.inFlight; });
+        }
+        asyncIO.reset();
+
+        if (pipeline.error != ERROR_SUCCESS && mCompletion == MFTScanCompletion::Complete) {
+            return domain::Error{
+                L"Failed to enumerate USN data",
+                pipeline.error,
+                domain::ErrorCategory::Volume
+            };
         }
 
         return domain::Expected<void>();
     }
 
-    std::wstring MFTScanner::GetFullPath(uint64_t fileRefNumber) {
-        auto cacheIt = mPathCache.find(fileRefNumber);
-        if (cacheIt != mPathCache.end())
-            return cacheIt->second;
+    size_t MFTScanner::ApplyUSNRecords(const BYTE* buffer, size_t bufferSize) {
+        size_t applied = 0;
+        USNRecordParser parser(buffer, bufferSize);
+        USNRecordView record;
 
-        std::wstring path;
-        uint64_t     currentRef = fileRefNumber;
-        int          depth = 0;
-        const int    maxDepth = 256;
+        while (parser.Next(record)) {
+            if (record.reason & USN_REASON_FILE_DELETE) {
+                mRecords.Erase(record.fileReferenceNumber);
+                applied++;
+            }
+            else if (StoreUSNRecord(record)) {
+                mReplayedRecords.push_back(record.fileReferenceNumber & RECORD_NUMBER_MASK);
+                applied++;
+            }
 
-        while (currentRef != 0 && depth < maxDepth) {
-            auto it = mFileRecordMap.find(currentRef);
-            if (it == mFileRecordMap.end()) break;
+            const uint32_t current = mRecords.Find(record.fileReferenceNumber);
+            if (current != MFTRecordStore::INVALID_INDEX)
+                mRecords.LinkParents(current, current + 1);
+            mChildIndexValid = false;
+        }
 
-            const auto& record = it->second;
-            if (record.fileName == L"." || record.fileName == L"..") break;
+        return applied;
+    }
 
-            auto parentCacheIt = mPathCache.find(currentRef);
-            if (parentCacheIt != mPathCache.end()) {
-                path = parentCacheIt->second + L"\\" + path;
-                break;
+    domain::Expected<void> MFTScanner::ReadUSNJournalDelta(
+        HANDLE hVolume,
+        const USN_JOURNAL_DATA& journalData,
+        USN startUsn
+    ) {
+        std::vector<BYTE> buffer(BUFFER_SIZE);
+
+        READ_USN_JOURNAL_DATA_V0 rujd{};
+        rujd.StartUsn = startUsn;
+        rujd.ReasonMask = 0xFFFFFFFF;
+        rujd.ReturnOnlyOnClose = TRUE;
+        rujd.Timeout = 0;
+        rujd.BytesToWaitFor = 0;
+        rujd.UsnJournalID = journalData.UsnJournalID;
+
+        DWORD bytesReturned = 0;
+
+        while (rujd.StartUsn < journalData.NextUsn) {
+            BOOL result = DeviceIoControl(
+                hVolume,
+                FSCTL_READ_USN_JOURNAL,
+                &rujd,
+                sizeof(rujd),
+                buffer.data(),
+                static_cast<DWORD>(buffer.size()),
+                &bytesReturned,
+                nullptr
+            );
+
+            if (!result) {
+                DWORD error = GetLastError();
+                if (error == ERROR_HANDLE_EOF) break;
+                return domain::Error{
+                    L"Failed to read USN journal",
+                    error,
+                    domain::ErrorCategory::Volume
+                };
             }
 
-            path = path.empty() ? record.fileName : record.fileName + L"\\" + path;
+            int64_t nextUsn = 0;
+            if (!USNRecordParser::ReadResumePoint(buffer.data(), bytesReturned, nextUsn)) break;
 
-            if (currentRef == record.parentFileReferenceNumber) break;
+            ApplyUSNRecords(
+                buffer.data() + USNRecordParser::RESUME_POINT_SIZE,
+                bytesReturned - USNRecordParser::RESUME_POINT_SIZE
+            );
 
-            currentRef = record.parentFileReferenceNumber;
-            depth++;
+            if (nextUsn <= rujd.StartUsn) break;
+            rujd.StartUsn = nextUsn;
         }
 
-        mPathCache[fileRefNumber] = path;
-        return path;
+        return domain::Expected<void>();
     }
 
-    void MFTScanner::BuildFilePathMap(const std::vector<MFTFileRecord>& records) {
-        mFileRecordMap.clear();
-        mPathToRefNumberMap.clear();
-        mPathCache.clear();
-        mExtensionIndex.clear();
+    bool MFTScanner::RestoreFromSnapshot(HANDLE hVolume, const USN_JOURNAL_DATA& journalData) {
+        auto snapshotResult = MFTIndexSnapshotSerializer::Load(mSnapshotPath);
+        if (!snapshotResult.HasValue()) return false;
 
-        mFileRecordMap.reserve(records.size());
-        mPathToRefNumberMap.reserve(records.size());
-        mPathCache.reserve(records.size());
+        auto& snapshot = snapshotResult.Value();
+        if (snapshot.journalId != journalData.UsnJournalID ||
+            snapshot.nextUsn < journalData.LowestValidUsn ||
+            snapshot.nextUsn > journalData.NextUsn) {
+            return false;
+        }
+
+        mRecords = std::move(snapshot.store);
+        mRestoredSizesComplete = snapshot.sizesComplete;
+        mReplayedRecords.clear();
 
-        for (const auto& record : records) {
-            mFileRecordMap[record.fileReferenceNumber] = record;
+        auto deltaResult = ReadUSNJournalDelta(hVolume, journalData, snapshot.nextUsn);
+        if (!deltaResult.HasValue()) {
+            mRecords.Clear();
+            return false;
         }
 
-        for (const auto& record : records) {
-            std::wstring fullPath = GetFullPath(record.fileReferenceNumber);
-            if (fullPath.empty()) continue;
+        std::sort(mReplayedRecords.begin(), mReplayedRecords.end());
+        mReplayedRecords.erase(
+            std::unique(mReplayedRecords.begin(), mReplayedRecords.end()),
+            mReplayedRecords.end());
+        return true;
+    }
+
+    void MFTScanner::SaveSnapshot(const USN_JOURNAL_DATA& journalData) const {
+        (void)MFTIndexSnapshotSerializer::Save(
+            mSnapshotPath,
+            journalData.UsnJournalID,
+            journalData.NextUsn,
+            mSizesComplete,
+            mRecords
+        );
+    }
 
-            std::wstring lowerPath = ToLower(fullPath);
-            mPathToRefNumberMap[lowerPath] = record.fileReferenceNumber;
+    void MFTScanner::BuildFilePathMap() {
+        mPathIndex.Clear();
 
-            if (!record.isDirectory) {
-                std::wstring ext = ExtractExtension(record.fileName);
-                if (!ext.empty()) {
-                    mExtensionIndex[ext].push_back(record.fileReferenceNumber);
-                }
+        mRecords.Compact();
+
+        mPathIndex.Build(mRecords,
+            MFTPathIndex::ResolveThreadCount(mIndexThreadCount, mRecords.SlotCount()));
+        BuildChildIndex();
+        BuildSubtreeAggregates();
+    }
+
+    void MFTScanner::BuildChildIndex() {
+        const uint32_t slotCount = static_cast<uint32_t>(mRecords.SlotCount());
+        mChildOffsets.assign(static_cast<size_t>(slotCount) + 1, 0);
+        mRootIndices.clear();
+
+        for (uint32_t i = 0; i < slotCount; ++i) {
+            if (!mRecords.IsLive(i)) continue;
+
+            const uint32_t parent = mRecords.ParentIndex(i);
+            if (parent != MFTRecordStore::INVALID_INDEX)
+                mChildOffsets[parent + 1]++;
+            else
+                mRootIndices.push_back(i);
+        }
+
+        for (uint32_t i = 0; i < slotCount; ++i)
+            mChildOffsets[i + 1] += mChildOffsets[i];
+
+        mChildIndices.resize(mChildOffsets.back());
+        std::vector<uint32_t> cursor(mChildOffsets.begin(), mChildOffsets.end() - 1);
+
+        for (uint32_t i = 0; i < slotCount; ++i) {
+            const uint32_t parent = mRecords.ParentIndex(i);
+            if (mRecords.IsLive(i) && parent != MFTRecordStore::INVALID_INDEX)
+                mChildIndices[cursor[parent]++] = i;
+        }
+
+        mChildIndexValid = true;
+    }
+
+    void MFTScanner::BuildSubtreeAggregates() {
+        const uint32_t slotCount = static_cast<uint32_t>(mRecords.SlotCount());
+        mSubtreeSizes.assign(slotCount, 0);
+        mSubtreeFileCounts.assign(slotCount, 0);
+        mVolumeStats = MFTDirectoryStats{};
+
+        std::vector<uint32_t> topDown;
+        for (uint32_t i = 0; i < slotCount; ++i) {
+            if (!mRecords.IsLive(i)) continue;
+
+            if (mRecords.IsDirectory(i)) {
+                if (mRecords.ParentIndex(i) == MFTRecordStore::INVALID_INDEX)
+                    topDown.push_back(i);
+                continue;
+            }
+
+            mVolumeStats.totalSize += mRecords.FileSize(i);
+            mVolumeStats.fileCount++;
+
+            const uint32_t parent = mRecords.ParentIndex(i);
+            if (parent != MFTRecordStore::INVALID_INDEX) {
+                mSubtreeSizes[parent] += mRecords.FileSize(i);
+                mSubtreeFileCounts[parent]++;
             }
         }
+
+        for (size_t k = 0; k < topDown.size(); ++k) {
+            const uint32_t dir = topDown[k];
+            for (uint32_t c = mChildOffsets[dir]; c < mChildOffsets[dir + 1]; ++c) {
+                if (mRecords.IsDirectory(mChildIndices[c]))
+                    topDown.push_back(mChildIndices[c]);
+            }
+        }
+
+        for (auto it = topDown.rbegin(); it != topDown.rend(); ++it) {
+            const uint32_t parent = mRecords.ParentIndex(*it);
+            if (parent != MFTRecordStore::INVALID_INDEX) {
+                mSubtreeSizes[parent] += mSubtreeSizes[*it];
+                mSubtreeFileCounts[parent] += mSubtreeFileCounts[*it];
+            }
+        }
+
+        mAggregatesValid = true;
     }
 
-    domain::Expected<MFTScanResult> MFTScanner::ScanVolume(const std::wstring& volumePath) {
-        auto startTime = std::chrono::high_resolution_clock::now();
+    uint32_t MFTScanner::FindIndexByPath(std::wstring_view path) const {
+        const std::wstring_view relativePath = StripVolumePrefix(path);
+        if (relativePath.empty()) return MFTRecordStore::INVALID_INDEX;
+
+        return mPathIndex.Find(relativePath,
+            [this, relativePath](uint32_t index) {
+                return mRecords.IsLive(index) && MatchesPath(index, relativePath);
+            });
+    }
+
+    domain::Expected<void> MFTScanner::ReadVolumeRecords(
+        const std::wstring& volumePath,
+        const UniqueHandle& hVolume,
+        const USN_JOURNAL_DATA& journalData
+    ) {
+        if (mEnumBufferCount >= 2) {
+            auto hOverlapped = OpenVolumeHandle(volumePath, FILE_FLAG_OVERLAPPED);
+            if (hOverlapped) {
+                return ReadUSNJournalPipelined(
+                    Win32HandleFactory::ToWin32Handle(hOverlapped),
+                    journalData
+                );
+            }
+        }
+
+        return ReadUSNJournal(Win32HandleFactory::ToWin32Handle(hVolume), journalData);
+    }
+
+    domain::Expected<void> MFTScanner::ReadRawMFT(HANDLE hVolume, bool replayedOnly) {
+        auto readAt = [hVolume](uint64_t byteOffset, uint8_t* buffer, size_t length) -> bool {
+            LARGE_INTEGER position{};
+            position.QuadPart = static_cast<LONGLONG>(byteOffset);
+            if (!SetFilePointerEx(hVolume, position, nullptr, FILE_BEGIN))
+                return false;
+
+            while (length > 0) {
+                const DWORD request = static_cast<DWORD>((std::min)(length, size_t{ 0x40000000 }));
+                DWORD bytesRead = 0;
+                if (!ReadFile(hVolume, buffer, request, &bytesRead, nullptr) || bytesRead == 0)
+                    return false;
+                buffer += bytesRead;
+                length -= bytesRead;
+            }
+            return true;
+        };
+
+        std::vector<uint8_t> bootSector(BOOT_SECTOR_READ_SIZE);
+        NTFSVolumeGeometry geometry{};
+        if (!readAt(0, bootSector.data(), bootSector.size()) ||
+            !NTFSRecordParser::ParseBootSector(bootSector.data(), bootSector.size(), geometry)) {
+            return domain::Error{
+                L"Volume is not NTFS or its boot sector could not be read",
+                GetLastError(),
+                domain::ErrorCategory::Volume
+            };
+        }
+
+        NTFSMFTReader reader(geometry, readAt);
+        uint32_t untilStopCheck = RAW_RECORDS_PER_STOP_CHECK;
+        const auto onRecord = [this, &untilStopCheck](const NTFSFileRecordInfo& record) {
+            ApplyRawRecord(record);
+            if (--untilStopCheck == 0) {
+                untilStopCheck = RAW_RECORDS_PER_STOP_CHECK;
+                return !ShouldStopScan();
+            }
+            return true;
+        };
+        const NTFSReadStatus status = replayedOnly
+            ? reader.ReadRecords(mReplayedRecords, onRecord)
+            : reader.ReadAll(onRecord);
+
+        if (status == NTFSReadStatus::Stopped)
+            return domain::Expected<void>();
+
+        if (status != NTFSReadStatus::Completed) {
+            return domain::Error{
+                status == NTFSReadStatus::Corrupt
+                    ? L"$MFT layout is corrupt"
+                    : L"Failed to read $MFT",
+                GetLastError(),
+                domain::ErrorCategory::Volume
+            };
+        }
+
+        return domain::Expected<void>();
+    }
+
+    void MFTScanner::ApplyRawRecord(const NTFSFileRecordInfo& record) {
+        const uint64_t targetRef = record.IsBaseRecord() ? record.fileReference : record.baseFileReference;
+        const uint32_t index = mRecords.Find(targetRef);
+        if (index == MFTRecordStore::INVALID_INDEX) return;
+
+        if (record.hasData && !mRecords.IsDirectory(index))
+            mRecords.SetFileSize(index, record.fileSize);
+
+        if (record.hasStandardInformation) {
+            mRecords.SetTimes(
+                index,
+                static_cast<uint64_t>(record.creationTime),
+                static_cast<uint64_t>(record.lastWriteTime),
+                static_cast<uint64_t>(record.lastAccessTime)
+            );
+        }
+    }
+
+    domain::Expected<void> MFTScanner::IndexVolume(const std::wstring& volumePath) {
+        mIndexedVolume.clear();
 
         auto hVolume = OpenVolumeHandle(volumePath);
         if (!hVolume) {
@@ -309,31 +737,214 @@ namespace winsetup::adapters::platform {
             return journalResult.GetError();
         }
 
-        MFTScanResult result{};
+        const auto& journalData = journalResult.Value();
 
-        auto readResult = ReadUSNJournal(
-            Win32HandleFactory::ToWin32Handle(hVolume),
-            journalResult.Value(),
-            result.files
-        );
+        mAggregatesValid = false;
+        mChildIndexValid = false;
+        BeginScan(Win32HandleFactory::ToWin32Handle(hVolume));
+
+        bool restored = !mSnapshotPath.empty() &&
+            RestoreFromSnapshot(Win32HandleFactory::ToWin32Handle(hVolume), journalData);
 
-        if (!readResult.HasValue()) {
-            return readResult.GetError();
+        if (!restored) {
+            mRecords.Clear();
+            auto readResult = ReadVolumeRecords(volumePath, hVolume, journalData);
+
+            if (!readResult.HasValue()) {
+                mRecords.Clear();
+                return readResult.GetError();
+            }
         }
 
-        BuildFilePathMap(result.files);
+        if (mCompletion != MFTScanCompletion::Complete)
+            DropDetachedRecords();
+
+        // Completion is decided by the journal enumeration alone. The raw
+        // pass only adds sizes and times, so a deadline or a read error
+        // there marks the sizes incomplete but keeps the index savable.
+        mSizesComplete = false;
+        mRawPassError.reset();
+        const MFTScanCompletion indexCompletion = mCompletion;
+        if (mReadRawMFT && indexCompletion == MFTScanCompletion::Complete) {
+            auto rawResult = ReadRawMFT(Win32HandleFactory::ToWin32Handle(hVolume),
+                restored && mRestoredSizesComplete);
+            if (!rawResult.HasValue()) {
+                mRawPassError = rawResult.GetError();
+            }
+            else if (mCompletion != MFTScanCompletion::Complete) {
+                mRawPassError = domain::Error{
+                    L"Raw $MFT pass stopped before reading every record",
+                    ERROR_TIMEOUT,
+                    domain::ErrorCategory::Volume
+                };
+            }
+            mSizesComplete = !mRawPassError;
+            mCompletion = indexCompletion;
+        }
+
+        BuildFilePathMap();
+        ReportScanProgress(mRecords.Size(), 0, true);
+
+        // A truncated index would be restored as if it were complete.
+        if (!mSnapshotPath.empty() && mCompletion == MFTScanCompletion::Complete)
+            SaveSnapshot(journalData);
+
+        mIndexedVolume = NormalizeVolumePath(volumePath);
+        return domain::Expected<void>();
+    }
+
+    void MFTScanner::BeginScan(HANDLE hVolume) {
+        mCompletion = MFTScanCompletion::Complete;
+        mScanStart = std::chrono::steady_clock::now();
+        mLastProgressReport = mScanStart;
+        mScanDeadline = mScanTimeoutMs != 0
+            ? mScanStart + std::chrono::milliseconds(mScanTimeoutMs)
+            : std::chrono::steady_clock::time_point::max();
+
+        NTFS_VOLUME_DATA_BUFFER volumeData{};
+        DWORD bytesReturned = 0;
+        mMftRecordSlots = 0;
+        if (DeviceIoControl(hVolume, FSCTL_GET_NTFS_VOLUME_DATA, nullptr, 0,
+            &volumeData, sizeof(volumeData), &bytesReturned, nullptr) &&
+            volumeData.BytesPerFileRecordSegment != 0) {
+            mMftRecordSlots = static_cast<uint64_t>(volumeData.MftValidDataLength.QuadPart) /
+                volumeData.BytesPerFileRecordSegment;
+        }
+    }
+
+    bool MFTScanner::ShouldStopScan() {
+        if (mCompletion == MFTScanCompletion::TimedOut || mCompletion == MFTScanCompletion::Cancelled)
+            return true;
+
+        if (mStopToken.stop_requested()) {
+            mCompletion = MFTScanCompletion::Cancelled;
+            return true;
+        }
+        if (std::chrono::steady_clock::now() >= mScanDeadline) {
+            mCompletion = MFTScanCompletion::TimedOut;
+            return true;
+        }
+        return false;
+    }
+
+    // Enumeration walks the MFT in record-number order, so the resume point
+    // over the MFT size gives the fraction done and, from the rate so far,
+    // both the likely record count and the time left.
+    void MFTScanner::ReportScanProgress(uint64_t recordsScanned, int64_t nextFileReference, bool final) {
+        if (!mProgressCallback) return;
+
+        const auto now = std::chrono::steady_clock::now();
+        if (!final && now - mLastProgressReport < kProgressInterval) return;
+        mLastProgressReport = now;
+
+        MFTScanProgress progress;
+        progress.recordsScanned = recordsScanned;
+        progress.elapsedMs = std::chrono::duration<double, std::milli>(now - mScanStart).count();
+        if (progress.elapsedMs > 0.0)
+            progress.recordsPerSecond = static_cast<double>(recordsScanned) / progress.elapsedMs * 1000.0;
+
+        if (final) {
+            progress.estimatedTotalRecords = recordsScanned;
+            progress.percentComplete = 100;
+        }
+        else if (mMftRecordSlots != 0) {
+            const uint64_t position = static_cast<uint64_t>(nextFileReference) & RECORD_NUMBER_MASK;
+            const double fraction = (std::min)(1.0,
+                static_cast<double>(position) / static_cast<double>(mMftRecordSlots));
+            if (fraction > 0.0) {
+                progress.estimatedTotalRecords = static_cast<uint64_t>(recordsScanned / fraction);
+                progress.estimatedRemainingMs = progress.elapsedMs * (1.0 - fraction) / fraction;
+            }
+            progress.percentComplete = static_cast<uint32_t>(fraction * 100.0);
+        }
+
+        mProgressCallback(progress);
+    }
+
+    // A truncated enumeration holds records whose ancestors were never read.
+    // Left in, they would index as top-level entries under the wrong path,
+    // so only records with an unbroken chain up to the root are kept.
+    void MFTScanner::DropDetachedRecords() {
+        constexpr uint8_t UNKNOWN = 0;
+        constexpr uint8_t ATTACHED = 1;
+        constexpr uint8_t DETACHED = 2;
+
+        mRecords.LinkParents();
+
+        const uint32_t slotCount = static_cast<uint32_t>(mRecords.SlotCount());
+        std::vector<uint8_t> state(slotCount, UNKNOWN);
+        std::vector<uint32_t> chain;
+
+        for (uint32_t i = 0; i < slotCount; ++i) {
+            if (!mRecords.IsLive(i) || state[i] != UNKNOWN) continue;
+
+            chain.clear();
+            uint32_t current = i;
+            uint8_t resolved = DETACHED;
+            while (true) {
+                if (state[current] != UNKNOWN) {
+                    resolved = state[current];
+                    break;
+                }
+                if (chain.size() >= static_cast<size_t>(MAX_PATH_DEPTH)) break;
+                chain.push_back(current);
+
+                const uint32_t parent = mRecords.ParentIndex(current);
+                if (parent == MFTRecordStore::INVALID_INDEX) {
+                    resolved = (mRecords.ParentRef(current) & RECORD_NUMBER_MASK) == ROOT_DIRECTORY_RECORD
+                        ? ATTACHED : DETACHED;
+                    break;
+                }
+                current = parent;
+            }
+
+            for (uint32_t index : chain)
+                state[index] = resolved;
+        }
+
+        for (uint32_t i = 0; i < slotCount; ++i) {
+            if (state[i] == DETACHED)
+                mRecords.Erase(mRecords.FileRef(i));
+        }
+    }
+
+    domain::Expected<void> MFTScanner::EnsureIndexed(const std::wstring& volumePath) {
+        if (!mRecords.Empty() && IsIndexedVolume(volumePath))
+            return domain::Expected<void>();
+        return IndexVolume(volumePath);
+    }
 
+    // An index populated without IndexVolume (USN replay) is not tied to a
+    // volume and is reused as-is.
+    bool MFTScanner::IsIndexedVolume(const std::wstring& volumePath) const {
+        return mIndexedVolume.empty() ||
+            CaseFold::Equals(mIndexedVolume, NormalizeVolumePath(volumePath));
+    }
+
+    domain::Expected<MFTScanResult> MFTScanner::ScanVolume(const std::wstring& volumePath) {
+        auto startTime = std::chrono::high_resolution_clock::now();
+
+        auto indexResult = IndexVolume(volumePath);
+        if (!indexResult.HasValue()) return indexResult.GetError();
+
+        MFTScanResult result{};
         result.totalFiles = 0;
         result.totalDirectories = 0;
         result.totalSize = 0;
+        result.completion = mCompletion;
 
-        for (const auto& file : result.files) {
-            if (file.isDirectory) {
+        result.files.reserve(mRecords.Size());
+        const uint32_t slotCount = static_cast<uint32_t>(mRecords.SlotCount());
+        for (uint32_t i = 0; i < slotCount; ++i) {
+            if (!mRecords.IsLive(i)) continue;
+
+            result.files.push_back(mRecords.ToRecord(i));
+            if (mRecords.IsDirectory(i)) {
                 result.totalDirectories++;
             }
             else {
                 result.totalFiles++;
-                result.totalSize += file.fileSize;
+                result.totalSize += mRecords.FileSize(i);
             }
         }
 
@@ -348,28 +959,22 @@ namespace winsetup::adapters::platform {
         const std::wstring& volumePath,
         const std::wstring& filePath
     ) {
-        if (mPathToRefNumberMap.empty()) {
-            auto scanResult = ScanVolume(volumePath);
-            if (!scanResult.HasValue()) return scanResult.GetError();
-        }
+        auto indexResult = EnsureIndexed(volumePath);
+        if (!indexResult.HasValue()) return indexResult.GetError();
 
-        std::wstring normalizedPath = NormalizeFilePath(filePath);
-        return mPathToRefNumberMap.find(normalizedPath) != mPathToRefNumberMap.end();
+        return FindIndexByPath(filePath) != MFTRecordStore::INVALID_INDEX;
     }
 
     domain::Expected<MFTFileRecord> MFTScanner::FindFile(
         const std::wstring& volumePath,
         const std::wstring& filePath
     ) {
-        if (mPathToRefNumberMap.empty()) {
-            auto scanResult = ScanVolume(volumePath);
-            if (!scanResult.HasValue()) return scanResult.GetError();
-        }
+        auto indexResult = EnsureIndexed(volumePath);
+        if (!indexResult.HasValue()) return indexResult.GetError();
 
-        std::wstring normalizedPath = NormalizeFilePath(filePath);
-        auto it = mPathToRefNumberMap.find(normalizedPath);
+        uint32_t index = FindIndexByPath(filePath);
 
-        if (it == mPathToRefNumberMap.end()) {
+        if (index == MFTRecordStore::INVALID_INDEX) {
             return domain::Error{
                 L"File not found: " + filePath,
                 ERROR_FILE_NOT_FOUND,
@@ -377,42 +982,34 @@ namespace winsetup::adapters::platform {
             };
         }
 
-        auto recordIt = mFileRecordMap.find(it->second);
-        if (recordIt == mFileRecordMap.end()) {
-            return domain::Error{
-                L"File record not found",
-                ERROR_FILE_NOT_FOUND,
-                domain::ErrorCategory::Volume
-            };
-        }
-
-        return recordIt->second;
+        return mRecords.ToRecord(index);
     }
 
     domain::Expected<std::vector<MFTFileRecord>> MFTScanner::FindFilesByExtension(
         const std::wstring& volumePath,
         const std::wstring& extension
     ) {
-        if (mFileRecordMap.empty()) {
-            auto scanResult = ScanVolume(volumePath);
-            if (!scanResult.HasValue()) return scanResult.GetError();
+        auto indexResult = EnsureIndexed(volumePath);
+        if (!indexResult.HasValue()) return indexResult.GetError();
+
+        std::wstring dottedExt;
+        std::wstring_view ext = extension;
+        if (!ext.empty() && ext[0] != L'.') {
+            dottedExt = L"." + extension;
+            ext = dottedExt;
         }
 
-        std::wstring lowerExt = ToLower(extension);
-        if (!lowerExt.empty() && lowerExt[0] != L'.')
-            lowerExt = L"." + lowerExt;
-
         std::vector<MFTFileRecord> matchingFiles;
 
-        auto idxIt = mExtensionIndex.find(lowerExt);
-        if (idxIt == mExtensionIndex.end())
+        const std::vector<uint32_t>* candidates = mPathIndex.FindExtension(ext);
+        if (!candidates)
             return matchingFiles;
 
-        matchingFiles.reserve(idxIt->second.size());
-        for (uint64_t refNumber : idxIt->second) {
-            auto recordIt = mFileRecordMap.find(refNumber);
-            if (recordIt != mFileRecordMap.end())
-                matchingFiles.push_back(recordIt->second);
+        matchingFiles.reserve(candidates->size());
+        for (uint32_t index : *candidates) {
+            if (mRecords.IsLive(index) &&
+                CaseFold::Equals(MFTPathIndex::Extension(mRecords.Name(index)), ext))
+                matchingFiles.push_back(mRecords.ToRecord(index));
         }
 
         return matchingFiles;
@@ -422,23 +1019,127 @@ namespace winsetup::adapters::platform {
         const std::wstring& volumePath,
         const std::wstring& directoryPath
     ) {
-        if (mPathToRefNumberMap.empty()) {
-            auto scanResult = ScanVolume(volumePath);
-            if (!scanResult.HasValue()) return scanResult.GetError();
+        auto statsResult = GetDirectoryStats(volumePath, directoryPath);
+        if (!statsResult.HasValue()) return statsResult.GetError();
+        return statsResult.Value().totalSize;
+    }
+
+    domain::Expected<MFTDirectoryStats> MFTScanner::GetDirectoryStats(
+        const std::wstring& volumePath,
+        const std::wstring& directoryPath
+    ) {
+        auto indexResult = EnsureIndexed(volumePath);
+        if (!indexResult.HasValue()) return indexResult.GetError();
+
+        if (!mAggregatesValid)
+            BuildFilePathMap();
+
+        if (StripVolumePrefix(directoryPath).empty())
+            return mVolumeStats;
+
+        uint32_t index = FindIndexByPath(directoryPath);
+        if (index == MFTRecordStore::INVALID_INDEX) {
+            return domain::Error{
+                L"Directory not found: " + directoryPath,
+                ERROR_PATH_NOT_FOUND,
+                domain::ErrorCategory::Volume
+            };
         }
 
-        std::wstring normalizedDir = NormalizeFilePath(directoryPath);
-        uint64_t totalSize = 0;
+        if (!mRecords.IsDirectory(index))
+            return MFTDirectoryStats{ mRecords.FileSize(index), 1 };
 
-        for (const auto& [path, refNumber] : mPathToRefNumberMap) {
-            if (path.find(normalizedDir) == 0) {
-                auto recordIt = mFileRecordMap.find(refNumber);
-                if (recordIt != mFileRecordMap.end() && !recordIt->second.isDirectory)
-                    totalSize += recordIt->second.fileSize;
-            }
+        return MFTDirectoryStats{ mSubtreeSizes[index], mSubtreeFileCounts[index] };
+    }
+
+    domain::Expected<std::vector<MFTFileRecord>> MFTScanner::ListDirectory(
+        const std::wstring& volumePath,
+        const std::wstring& directoryPath
+    ) {
+        auto indexResult = EnsureIndexed(volumePath);
+        if (!indexResult.HasValue()) return indexResult.GetError();
+
+        if (!mChildIndexValid)
+            BuildChildIndex();
+
+        uint32_t index = FindIndexByPath(directoryPath);
+
+        if (index == MFTRecordStore::INVALID_INDEX || !mRecords.IsDirectory(index)) {
+            return domain::Error{
+                L"Directory not found: " + directoryPath,
+                ERROR_PATH_NOT_FOUND,
+                domain::ErrorCategory::Volume
+            };
+        }
+
+        std::vector<MFTFileRecord> children;
+        children.reserve(mChildOffsets[index + 1] - mChildOffsets[index]);
+        for (uint32_t c = mChildOffsets[index]; c < mChildOffsets[index + 1]; ++c) {
+            if (mRecords.IsLive(mChildIndices[c]))
+                children.push_back(mRecords.ToRecord(mChildIndices[c]));
         }
 
-        return totalSize;
+        return children;
+    }
+
+    domain::Expected<MFTGlobCursor> MFTScanner::QueryPattern(
+        const std::wstring& volumePath,
+        const std::wstring& pattern
+    ) {
+        auto compiled = MFTGlobPattern::Compile(pattern);
+        if (!compiled.HasValue()) return compiled.GetError();
+
+        auto indexResult = EnsureIndexed(volumePath);
+        if (!indexResult.HasValue()) return indexResult.GetError();
+
+        if (!mChildIndexValid)
+            BuildChildIndex();
+
+        return OpenPatternCursor(std::move(compiled).Value());
+    }
+
+    domain::Expected<std::vector<MFTFileRecord>> MFTScanner::FindFilesByPattern(
+        const std::wstring& volumePath,
+        const std::wstring& pattern
+    ) {
+        auto cursorResult = QueryPattern(volumePath, pattern);
+        if (!cursorResult.HasValue()) return cursorResult.GetError();
+
+        auto& cursor = cursorResult.Value();
+        std::vector<MFTFileRecord> matchingFiles;
+        MFTFileRecord record{};
+        while (cursor.Next(record))
+            matchingFiles.push_back(std::move(record));
+
+        return matchingFiles;
+    }
+
+    std::optional<MFTFileRecord> MFTScanner::LookupRecord(std::wstring_view path) const {
+        const uint32_t index = FindIndexByPath(path);
+        if (index == MFTRecordStore::INVALID_INDEX) return std::nullopt;
+        return mRecords.ToRecord(index);
+    }
+
+    std::optional<MFTDirectoryStats> MFTScanner::LookupDirectoryStats(std::wstring_view path) const {
+        if (!mAggregatesValid) return std::nullopt;
+        if (StripVolumePrefix(path).empty()) return mVolumeStats;
+
+        const uint32_t index = FindIndexByPath(path);
+        if (index == MFTRecordStore::INVALID_INDEX) return std::nullopt;
+
+        if (!mRecords.IsDirectory(index))
+            return MFTDirectoryStats{ mRecords.FileSize(index), 1 };
+        return MFTDirectoryStats{ mSubtreeSizes[index], mSubtreeFileCounts[index] };
+    }
+
+    MFTGlobCursor MFTScanner::OpenPatternCursor(MFTGlobPattern pattern) const {
+        return MFTGlobCursor(
+            mRecords,
+            mChildOffsets,
+            mChildIndices,
+            mRootIndices,
+            std::move(pattern)
+        );
     }
 
 }
@@ -2,55 +2,70 @@
 
 #include <domain/primitives/Expected.h>
 #include <adapters/platform/win32/memory/UniqueHandle.h>
+#include <adapters/platform/win32/storage/MFTRecordStore.h>
+#include <adapters/platform/win32/storage/USNRecordParser.h>
+#include <adapters/platform/win32/storage/NTFSRecordParser.h>
+#include <adapters/platform/win32/storage/MFTGlobQuery.h>
+#include <adapters/platform/win32/storage/MFTPathIndex.h>
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <stop_token>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <unordered_map>
+#include <utility>
+#include <algorithm>
 #include <cstdint>
 #include <Windows.h>
 #include <winioctl.h>
 
 namespace winsetup::adapters::platform {
 
-    struct MFTFileRecord {
-        uint64_t fileReferenceNumber;
-        uint64_t parentFileReferenceNumber;
-        std::wstring fileName;
-        uint64_t fileSize;
-        uint32_t fileAttributes;
-        FILETIME creationTime;
-        FILETIME lastAccessTime;
-        FILETIME lastWriteTime;
-        bool isDirectory;
-
-        [[nodiscard]] bool IsSystemFile() const noexcept {
-            return (fileAttributes & FILE_ATTRIBUTE_SYSTEM) != 0;
-        }
-
-        [[nodiscard]] bool IsHidden() const noexcept {
-            return (fileAttributes & FILE_ATTRIBUTE_HIDDEN) != 0;
-        }
+    enum class MFTScanCompletion {
+        Complete,
+        RecordLimit,
+        TimedOut,
+        Cancelled
+    };
 
-        [[nodiscard]] bool IsReadOnly() const noexcept {
-            return (fileAttributes & FILE_ATTRIBUTE_READONLY) != 0;
-        }
+    struct MFTScanProgress {
+        uint64_t recordsScanned = 0;
+        uint64_t estimatedTotalRecords = 0;
+        double   recordsPerSecond = 0.0;
+        double   elapsedMs = 0.0;
+        double   estimatedRemainingMs = 0.0;
+        uint32_t percentComplete = 0;
     };
 
+    using MFTScanProgressCallback = std::function<void(const MFTScanProgress&)>;
+
     struct MFTScanResult {
         std::vector<MFTFileRecord> files;
         uint64_t totalFiles;
         uint64_t totalDirectories;
         uint64_t totalSize;
         double scanDurationMs;
+        MFTScanCompletion completion = MFTScanCompletion::Complete;
 
         [[nodiscard]] size_t GetFileCount() const noexcept {
             return files.size();
         }
 
+        [[nodiscard]] bool IsTruncated() const noexcept {
+            return completion != MFTScanCompletion::Complete;
+        }
+
         [[nodiscard]] double GetAverageScanSpeed() const noexcept {
             return scanDurationMs > 0.0 ? (static_cast<double>(totalFiles) / scanDurationMs * 1000.0) : 0.0;
         }
     };
 
+    struct MFTDirectoryStats {
+        uint64_t totalSize = 0;
+        uint64_t fileCount = 0;
+    };
+
     class MFTScanner {
     public:
         MFTScanner() = default;
@@ -63,6 +78,11 @@ namespace winsetup::adapters::platform {
             const std::wstring& volumePath
         );
 
+        // Builds the index without materializing every record.
+        [[nodiscard]] domain::Expected<void> IndexVolume(
+            const std::wstring& volumePath
+        );
+
         [[nodiscard]] domain::Expected<bool> FileExists(
             const std::wstring& volumePath,
             const std::wstring& filePath
@@ -83,45 +103,217 @@ namespace winsetup::adapters::platform {
             const std::wstring& directoryPath
         );
 
+        [[nodiscard]] domain::Expected<MFTDirectoryStats> GetDirectoryStats(
+            const std::wstring& volumePath,
+            const std::wstring& directoryPath
+        );
+
+        [[nodiscard]] domain::Expected<std::vector<MFTFileRecord>> ListDirectory(
+            const std::wstring& volumePath,
+            const std::wstring& directoryPath
+        );
+
+        // The cursor borrows the index; see MFTGlobCursor.
+        [[nodiscard]] domain::Expected<MFTGlobCursor> QueryPattern(
+            const std::wstring& volumePath,
+            const std::wstring& pattern
+        );
+
+        [[nodiscard]] domain::Expected<std::vector<MFTFileRecord>> FindFilesByPattern(
+            const std::wstring& volumePath,
+            const std::wstring& pattern
+        );
+
+        // Read-only queries against the current index. They never scan, so
+        // concurrent callers are safe once indexing has finished.
+        [[nodiscard]] bool HasIndex() const noexcept {
+            return !mRecords.Empty() && mChildIndexValid && mAggregatesValid;
+        }
+
+        [[nodiscard]] size_t GetRecordCount() const noexcept {
+            return mRecords.Size();
+        }
+
+        [[nodiscard]] std::optional<MFTFileRecord> LookupRecord(std::wstring_view path) const;
+
+        [[nodiscard]] std::optional<MFTDirectoryStats> LookupDirectoryStats(std::wstring_view path) const;
+
+        [[nodiscard]] MFTGlobCursor OpenPatternCursor(MFTGlobPattern pattern) const;
+
         void SetMaxFilesToScan(uint32_t maxFiles) noexcept {
             mMaxFilesToScan = maxFiles;
         }
 
+        // Bounds enumeration and the raw $MFT pass; 0 disables the deadline.
         void SetScanTimeout(uint32_t timeoutMs) noexcept {
             mScanTimeoutMs = timeoutMs;
         }
 
+        // Checked between enumeration buffers. A stopped scan keeps what it
+        // has read and reports it through GetLastCompletion().
+        void SetStopToken(std::stop_token stopToken) noexcept {
+            mStopToken = std::move(stopToken);
+        }
+
+        // Invoked on the scanning thread at most every kProgressInterval.
+        void SetProgressCallback(MFTScanProgressCallback callback) {
+            mProgressCallback = std::move(callback);
+        }
+
+        [[nodiscard]] MFTScanCompletion GetLastCompletion() const noexcept {
+            return mCompletion;
+        }
+
+        [[nodiscard]] bool IsTruncated() const noexcept {
+            return mCompletion != MFTScanCompletion::Complete;
+        }
+
+        // The raw $MFT pass was requested but did not read every record,
+        // so some sizes and times are missing. The index itself is still
+        // as complete as IsTruncated() says.
+        [[nodiscard]] bool AreSizesIncomplete() const noexcept {
+            return mReadRawMFT && !mSizesComplete;
+        }
+
+        // Why the last raw $MFT pass stopped short, if it ran and did.
+        [[nodiscard]] const std::optional<domain::Error>& GetRawPassError() const noexcept {
+            return mRawPassError;
+        }
+
+        void SetEnumBufferSize(uint32_t bufferSize) noexcept {
+            mEnumBufferSize = (std::clamp)(bufferSize, kMinEnumBufferSize, kMaxEnumBufferSize);
+        }
+
+        void SetEnumBufferCount(uint32_t bufferCount) noexcept {
+            mEnumBufferCount = (std::clamp)(bufferCount, 1u, kMaxEnumBufferCount);
+        }
+
+        void SetIndexThreadCount(uint32_t threadCount) noexcept {
+            mIndexThreadCount = threadCount;
+        }
+
+        void SetSnapshotPath(const std::wstring& snapshotPath) {
+            mSnapshotPath = snapshotPath;
+        }
+
+        // Reads $MFT directly after enumeration to fill in file sizes and
+        // timestamps, which FSCTL_ENUM_USN_DATA does not report. After a
+        // snapshot restore only the records the journal replay touched are
+        // read, unless the snapshot was saved with sizes incomplete.
+        void SetReadRawMFT(bool readRawMFT) noexcept {
+            mReadRawMFT = readRawMFT;
+        }
+
     private:
-        [[nodiscard]] adapters::platform::UniqueHandle OpenVolumeHandle(const std::wstring& volumePath);
+        static constexpr uint32_t kMinEnumBufferSize = 64 * 1024;
+        static constexpr uint32_t kMaxEnumBufferSize = 16 * 1024 * 1024;
+        static constexpr uint32_t kMaxEnumBufferCount = 3;
+        static constexpr std::chrono::milliseconds kProgressInterval{ 250 };
+
+        [[nodiscard]] adapters::platform::UniqueHandle OpenVolumeHandle(
+            const std::wstring& volumePath,
+            DWORD flags = 0
+        );
 
         [[nodiscard]] domain::Expected<USN_JOURNAL_DATA> QueryUSNJournal(HANDLE hVolume);
 
+        [[nodiscard]] domain::Expected<void> EnsureIndexed(const std::wstring& volumePath);
+
+        [[nodiscard]] bool IsIndexedVolume(const std::wstring& volumePath) const;
+
+        void BeginScan(HANDLE hVolume);
+
+        [[nodiscard]] bool ShouldStopScan();
+
+        void ReportScanProgress(uint64_t recordsScanned, int64_t nextFileReference, bool final = false);
+
+        void DropDetachedRecords();
+
+        [[nodiscard]] domain::Expected<void> ReadVolumeRecords(
+            const std::wstring& volumePath,
+            const UniqueHandle& hVolume,
+            const USN_JOURNAL_DATA& journalData
+        );
+
         [[nodiscard]] domain::Expected<void> ReadUSNJournal(
+            HANDLE hVolume,
+            const USN_JOURNAL_DATA& journalData
+        );
+
+        [[nodiscard]] domain::Expected<void> ReadUSNJournalPipelined(
+            HANDLE hOverlappedVolume,
+            const USN_JOURNAL_DATA& journalData
+        );
+
+        [[nodiscard]] domain::Expected<void> ReadUSNJournalDelta(
             HANDLE hVolume,
             const USN_JOURNAL_DATA& journalData,
-            std::vector<MFTFileRecord>& outRecords
+            USN startUsn
         );
 
-        [[nodiscard]] bool ParseUSNRecord(
-            const USN_RECORD* record,
-            MFTFileRecord& outFileRecord
+        [[nodiscard]] bool RestoreFromSnapshot(
+            HANDLE hVolume,
+            const USN_JOURNAL_DATA& journalData
         );
 
-        [[nodiscard]] std::wstring NormalizeVolumePath(const std::wstring& volumePath);
+        void SaveSnapshot(const USN_JOURNAL_DATA& journalData) const;
+
+        [[nodiscard]] domain::Expected<void> ReadRawMFT(HANDLE hVolume, bool replayedOnly);
+
+        void ApplyRawRecord(const NTFSFileRecordInfo& record);
+
+        [[nodiscard]] bool StoreUSNRecord(const USNRecordView& record);
+
+        size_t AppendUSNRecords(const BYTE* buffer, size_t bufferSize, size_t maxRecords);
 
-        [[nodiscard]] std::wstring NormalizeFilePath(const std::wstring& filePath);
+        // Replays journal records onto a restored store. Leaves the path
+        // index and subtree aggregates stale, so it only runs before
+        // BuildFilePathMap, which rebuilds both in full.
+        size_t ApplyUSNRecords(const BYTE* buffer, size_t bufferSize);
 
-        void BuildFilePathMap(const std::vector<MFTFileRecord>& records);
+        [[nodiscard]] std::wstring NormalizeVolumePath(const std::wstring& volumePath) const;
 
-        [[nodiscard]] std::wstring GetFullPath(uint64_t fileRefNumber);
+        void BuildFilePathMap();
+
+        void BuildChildIndex();
+
+        void BuildSubtreeAggregates();
+
+        [[nodiscard]] uint32_t FindIndexByPath(std::wstring_view path) const;
+
+        [[nodiscard]] bool MatchesPath(uint32_t index, std::wstring_view relativePath) const noexcept;
 
         uint32_t mMaxFilesToScan = 1000000;
         uint32_t mScanTimeoutMs = 30000;
+        uint32_t mIndexThreadCount = 0;
+        uint32_t mEnumBufferSize = 1024 * 1024;
+        uint32_t mEnumBufferCount = 2;
+        bool     mReadRawMFT = false;
+        bool     mSizesComplete = false;
+        bool     mRestoredSizesComplete = false;
+        std::wstring mSnapshotPath;
+        std::wstring mIndexedVolume;
+
+        std::stop_token                       mStopToken;
+        MFTScanProgressCallback               mProgressCallback;
+        MFTScanCompletion                     mCompletion = MFTScanCompletion::Complete;
+        std::optional<domain::Error>          mRawPassError;
+        std::chrono::steady_clock::time_point mScanStart;
+        std::chrono::steady_clock::time_point mScanDeadline;
+        std::chrono::steady_clock::time_point mLastProgressReport;
+        uint64_t                              mMftRecordSlots = 0;
 
-        std::unordered_map<uint64_t, MFTFileRecord>              mFileRecordMap;
-        std::unordered_map<std::wstring, uint64_t>               mPathToRefNumberMap;
-        std::unordered_map<uint64_t, std::wstring>               mPathCache;
-        std::unordered_map<std::wstring, std::vector<uint64_t>>  mExtensionIndex;
+        MFTRecordStore                                           mRecords;
+        std::vector<uint64_t>                                    mReplayedRecords;
+        MFTPathIndex                                             mPathIndex;
+        std::vector<uint32_t>                                    mChildOffsets;
+        std::vector<uint32_t>                                    mChildIndices;
+        std::vector<uint32_t>                                    mRootIndices;
+        std::vector<uint64_t>                                    mSubtreeSizes;
+        std::vector<uint64_t>                                    mSubtreeFileCounts;
+        MFTDirectoryStats                                        mVolumeStats;
+        bool                                                     mChildIndexValid = false;
+        bool                                                     mAggregatesValid = false;
     };
 
 }
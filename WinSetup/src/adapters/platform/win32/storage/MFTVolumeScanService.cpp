@@ -0,0 +1,368 @@
+﻿// src/adapters/platform/win32/storage/MFTVolumeScanService.cpp
+#include "adapters/platform/win32/storage/MFTVolumeScanService.h"
+#include "adapters/platform/win32/storage/MFTScanner.h"
+#include <Windows.h>
+#include <winioctl.h>
+#include <condition_variable>
+#include <cwctype>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <unordered_set>
+
+namespace winsetup::adapters::platform {
+
+    namespace {
+
+        constexpr wchar_t kSnapshotExtension[] = L".mftidx";
+
+        class MFTVolumeIndex final : public abstractions::IStorageIndexSnapshot {
+        public:
+            MFTVolumeIndex(std::wstring volumeGuid, std::unique_ptr<MFTScanner> scanner)
+                : mVolumeGuid(std::move(volumeGuid))
+                , mScanner(std::move(scanner))
+                , mComplete(!mScanner->IsTruncated())
+            {
+            }
+
+            [[nodiscard]] const std::wstring& GetVolumeGuid() const noexcept override {
+                return mVolumeGuid;
+            }
+
+            [[nodiscard]] size_t GetEntryCount() const noexcept override {
+                return mScanner->GetRecordCount();
+            }
+
+            [[nodiscard]] bool IsComplete() const noexcept override {
+                return mComplete;
+            }
+
+            [[nodiscard]] bool Exists(const std::wstring& relativePath) const noexcept override {
+                try {
+                    return mScanner->LookupRecord(relativePath).has_value();
+                }
+                catch (...) {
+                    return false;
+                }
+            }
+
+            [[nodiscard]] bool IsFile(const std::wstring& relativePath) const noexcept override {
+                try {
+                    const auto record = mScanner->LookupRecord(relativePath);
+                    return record.has_value() && !record->isDirectory;
+                }
+                catch (...) {
+                    return false;
+                }
+            }
+
+            [[nodiscard]] bool IsDirectory(const std::wstring& relativePath) const noexcept override {
+                try {
+                    const auto record = mScanner->LookupRecord(relativePath);
+                    return record.has_value() && record->isDirectory;
+                }
+                catch (...) {
+                    return false;
+                }
+            }
+
+            [[nodiscard]] std::optional<abstractions::StorageUsage> GetUsage(
+                const std::wstring& relativePath
+            ) const override {
+                const auto stats = mScanner->LookupDirectoryStats(relativePath);
+                if (!stats.has_value())
+                    return std::nullopt;
+                return abstractions::StorageUsage{ stats->totalSize, stats->fileCount };
+            }
+
+            [[nodiscard]] domain::Expected<std::vector<std::wstring>> FindPaths(
+                const std::wstring& pattern
+            ) const override {
+                auto compiled = MFTGlobPattern::Compile(pattern);
+                if (!compiled.HasValue())
+                    return compiled.GetError();
+
+                auto cursor = mScanner->OpenPatternCursor(std::move(compiled).Value());
+                std::vector<std::wstring> paths;
+                uint32_t index = 0;
+                while (cursor.NextIndex(index))
+                    paths.push_back(cursor.CurrentPath());
+                return paths;
+            }
+
+        private:
+            std::wstring                mVolumeGuid;
+            std::unique_ptr<MFTScanner> mScanner;
+            bool                        mComplete;
+        };
+
+        std::wstring VolumeKey(const std::wstring& volumeGuid) {
+            std::wstring key = volumeGuid;
+            while (!key.empty() && key.back() == L'\\')
+                key.pop_back();
+            for (auto& c : key)
+                c = static_cast<wchar_t>(std::towlower(c));
+            return key;
+        }
+
+        std::optional<uint32_t> QueryDiskNumber(const std::wstring& volumeGuid) {
+            std::wstring devicePath = volumeGuid;
+            while (!devicePath.empty() && devicePath.back() == L'\\')
+                devicePath.pop_back();
+
+            HANDLE hVolume = ::CreateFileW(
+                devicePath.c_str(), 0,
+                FILE_SHARE_READ | FILE_SHARE_WRITE,
+                nullptr, OPEN_EXISTING, 0, nullptr
+            );
+            if (hVolume == INVALID_HANDLE_VALUE)
+                return std::nullopt;
+
+            STORAGE_DEVICE_NUMBER sdn{};
+            DWORD bytesReturned = 0;
+            const BOOL ok = ::DeviceIoControl(
+                hVolume,
+                IOCTL_STORAGE_GET_DEVICE_NUMBER,
+                nullptr, 0,
+                &sdn, sizeof(sdn),
+                &bytesReturned, nullptr
+            );
+            ::CloseHandle(hVolume);
+
+            if (!ok)
+                return std::nullopt;
+            return static_cast<uint32_t>(sdn.DeviceNumber);
+        }
+
+        struct ScanBatch {
+            std::mutex              mutex;
+            std::condition_variable done;
+            size_t                  pending = 0;
+            size_t                  indexed = 0;
+        };
+
+        // Counts a disk group as finished however its task exits, so the
+        // batch wait cannot outlive a task that threw.
+        struct GroupCompletion {
+            ScanBatch& batch;
+            size_t     indexed = 0;
+
+            ~GroupCompletion() {
+                std::lock_guard lock(batch.mutex);
+                batch.indexed += indexed;
+                if (--batch.pending == 0)
+                    batch.done.notify_all();
+            }
+        };
+
+    }
+
+    MFTVolumeScanService::MFTVolumeScanService(
+        std::shared_ptr<abstractions::IExecutor> executor,
+        std::shared_ptr<abstractions::ILogger>   logger)
+        : mExecutor(std::move(executor))
+        , mLogger(std::move(logger))
+    {
+    }
+
+    domain::Expected<size_t> MFTVolumeScanService::ScanVolumes(
+        const std::vector<std::wstring>& volumeGuids)
+    {
+        std::vector<std::vector<std::wstring>> groups;
+        std::unordered_map<uint32_t, size_t>   groupByDisk;
+        std::unordered_set<std::wstring>       seen;
+
+        for (const auto& guid : volumeGuids) {
+            if (guid.empty() || !seen.insert(VolumeKey(guid)).second)
+                continue;
+
+            const auto disk = QueryDiskNumber(guid);
+            if (disk.has_value()) {
+                auto [it, inserted] = groupByDisk.emplace(disk.value(), groups.size());
+                if (inserted)
+                    groups.emplace_back();
+                groups[it->second].push_back(guid);
+            }
+            else {
+                groups.push_back({ guid });
+            }
+        }
+
+        if (groups.empty())
+            return size_t{ 0 };
+
+        {
+            std::lock_guard lock(mMutex);
+            if (mStopSource.stop_requested())
+                mStopSource = std::stop_source{};
+        }
+
+        auto batch = std::make_shared<ScanBatch>();
+        batch->pending = groups.size();
+
+        for (auto& group : groups) {
+            std::function<void()> task = [this, batch, volumes = std::move(group)]() {
+                GroupCompletion completion{ *batch };
+                for (const auto& guid : volumes) {
+                    try {
+                        if (ScanVolume(guid))
+                            ++completion.indexed;
+                    }
+                    catch (...) {
+                        if (mLogger)
+                            mLogger->Error(L"MFTVolumeScanService: Indexing threw for " + guid);
+                    }
+                }
+            };
+
+            // A task the executor refuses would never count down the batch.
+            if (!mExecutor || !mExecutor->Post(task))
+                task();
+        }
+
+        std::unique_lock lock(batch->mutex);
+        batch->done.wait(lock, [&batch] { return batch->pending == 0; });
+
+        if (mLogger)
+            mLogger->Info(L"MFTVolumeScanService: Indexed "
+                + std::to_wstring(batch->indexed) + L" of "
+                + std::to_wstring(seen.size()) + L" volume(s) across "
+                + std::to_wstring(groups.size()) + L" disk(s).");
+
+        return batch->indexed;
+    }
+
+    std::shared_ptr<const abstractions::IStorageIndexSnapshot> MFTVolumeScanService::GetSnapshot(
+        const std::wstring& volumeGuid) const
+    {
+        std::lock_guard lock(mMutex);
+        const auto it = mSnapshots.find(VolumeKey(volumeGuid));
+        return it != mSnapshots.end() ? it->second : nullptr;
+    }
+
+    void MFTVolumeScanService::Invalidate(const std::wstring& volumeGuid)
+    {
+        std::lock_guard lock(mMutex);
+        mSnapshots.erase(VolumeKey(volumeGuid));
+    }
+
+    void MFTVolumeScanService::CancelScans() noexcept
+    {
+        std::lock_guard lock(mMutex);
+        mStopSource.request_stop();
+    }
+
+    void MFTVolumeScanService::SetProgressCallback(abstractions::StorageScanProgressCallback callback)
+    {
+        std::lock_guard lock(mMutex);
+        mProgressCallback = std::move(callback);
+    }
+
+    void MFTVolumeScanService::SetScanTimeout(uint32_t timeoutMs) noexcept
+    {
+        std::lock_guard lock(mMutex);
+        mScanTimeoutMs = timeoutMs;
+    }
+
+    void MFTVolumeScanService::SetSnapshotDirectory(const std::wstring& directory)
+    {
+        std::lock_guard lock(mMutex);
+        mSnapshotDirectory = directory;
+    }
+
+    void MFTVolumeScanService::SetReadRawMFT(bool readRawMFT) noexcept
+    {
+        std::lock_guard lock(mMutex);
+        mReadRawMFT = readRawMFT;
+    }
+
+    std::wstring MFTVolumeScanService::SnapshotPathFor(const std::wstring& volumeKey) const
+    {
+        std::wstring directory;
+        {
+            std::lock_guard lock(mMutex);
+            directory = mSnapshotDirectory;
+        }
+        if (directory.empty())
+            return {};
+
+        if (!::CreateDirectoryW(directory.c_str(), nullptr) &&
+            ::GetLastError() != ERROR_ALREADY_EXISTS)
+            return {};
+
+        const size_t open = volumeKey.find(L'{');
+        const size_t close = volumeKey.find(L'}', open);
+        std::wstring name = (open != std::wstring::npos && close != std::wstring::npos)
+            ? volumeKey.substr(open + 1, close - open - 1)
+            : volumeKey;
+        for (auto& c : name) {
+            if (!std::iswalnum(c) && c != L'-')
+                c = L'_';
+        }
+
+        if (directory.back() != L'\\')
+            directory += L'\\';
+        return directory + name + kSnapshotExtension;
+    }
+
+    bool MFTVolumeScanService::ScanVolume(const std::wstring& volumeGuid)
+    {
+        const std::wstring key = VolumeKey(volumeGuid);
+
+        auto scanner = std::make_unique<MFTScanner>();
+        scanner->SetMaxFilesToScan((std::numeric_limits<uint32_t>::max)());
+        scanner->SetSnapshotPath(SnapshotPathFor(key));
+        {
+            std::lock_guard lock(mMutex);
+            scanner->SetReadRawMFT(mReadRawMFT);
+            scanner->SetStopToken(mStopSource.get_token());
+            scanner->SetScanTimeout(mScanTimeoutMs);
+            if (mProgressCallback) {
+                scanner->SetProgressCallback(
+                    [callback = mProgressCallback, volumeGuid](const MFTScanProgress& progress) {
+                        callback(abstractions::StorageScanProgress{
+                            volumeGuid,
+                            progress.recordsScanned,
+                            progress.estimatedTotalRecords,
+                            progress.estimatedRemainingMs,
+                            progress.percentComplete
+                        });
+                    });
+            }
+        }
+
+        auto result = scanner->IndexVolume(volumeGuid);
+        if (!result.HasValue()) {
+            if (mLogger)
+                mLogger->Warning(L"MFTVolumeScanService: Cannot index " + volumeGuid
+                    + L" - " + result.GetError().GetMessage());
+            return false;
+        }
+
+        if (scanner->AreSizesIncomplete() && mLogger) {
+            const auto& rawError = scanner->GetRawPassError();
+            mLogger->Warning(L"MFTVolumeScanService: Sizes incomplete for " + volumeGuid
+                + (rawError ? L" - " + rawError->GetMessage()
+                    + L" (" + std::to_wstring(rawError->GetCode()) + L")" : std::wstring()));
+        }
+
+        const size_t entryCount = scanner->GetRecordCount();
+        const bool   truncated = scanner->IsTruncated();
+        auto snapshot = std::make_shared<const MFTVolumeIndex>(volumeGuid, std::move(scanner));
+        {
+            std::lock_guard lock(mMutex);
+            mSnapshots[key] = std::move(snapshot);
+        }
+
+        if (mLogger) {
+            if (truncated)
+                mLogger->Warning(L"MFTVolumeScanService: Partially indexed " + volumeGuid
+                    + L" (" + std::to_wstring(entryCount) + L" entries before the scan was stopped)");
+            else
+                mLogger->Info(L"MFTVolumeScanService: Indexed " + volumeGuid
+                    + L" (" + std::to_wstring(entryCount) + L" entries)");
+        }
+        return true;
+    }
+
+} // namespace winsetup::adapters::platform
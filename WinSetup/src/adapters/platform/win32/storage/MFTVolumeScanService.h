@@ -0,0 +1,73 @@
+﻿// src/adapters/platform/win32/storage/MFTVolumeScanService.h
+#pragma once
+#include "abstractions/services/storage/IStorageScanner.h"
+#include "abstractions/infrastructure/async/IExecutor.h"
+#include "abstractions/infrastructure/logging/ILogger.h"
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace winsetup::adapters::platform {
+
+    // Indexes volumes with MFTScanner, one scanner per volume GUID. Volumes
+    // that share a physical disk are scanned one after another so a spinning
+    // disk is not made to seek between two MFTs; separate disks are scanned
+    // concurrently on the executor.
+    class MFTVolumeScanService final : public abstractions::IStorageScanner {
+    public:
+        MFTVolumeScanService(
+            std::shared_ptr<abstractions::IExecutor> executor,
+            std::shared_ptr<abstractions::ILogger>   logger);
+        ~MFTVolumeScanService() override = default;
+
+        MFTVolumeScanService(const MFTVolumeScanService&) = delete;
+        MFTVolumeScanService& operator=(const MFTVolumeScanService&) = delete;
+
+        [[nodiscard]] domain::Expected<size_t> ScanVolumes(
+            const std::vector<std::wstring>& volumeGuids
+        ) override;
+
+        [[nodiscard]] std::shared_ptr<const abstractions::IStorageIndexSnapshot> GetSnapshot(
+            const std::wstring& volumeGuid
+        ) const override;
+
+        void Invalidate(const std::wstring& volumeGuid) override;
+
+        void CancelScans() noexcept override;
+
+        void SetProgressCallback(abstractions::StorageScanProgressCallback callback) override;
+
+        // Directory for per-volume index snapshots; empty (the default)
+        // disables them. Never point this at a volume being set up.
+        void SetSnapshotDirectory(const std::wstring& directory);
+
+        // Follows the USN enumeration with a raw $MFT pass for file sizes
+        // and times. Off by default: only size-based planning needs it.
+        void SetReadRawMFT(bool readRawMFT) noexcept;
+
+        // Per-volume scan deadline; 0 lets a scan run to completion.
+        void SetScanTimeout(uint32_t timeoutMs) noexcept;
+
+    private:
+        static constexpr uint32_t kDefaultScanTimeoutMs = 60000;
+
+        [[nodiscard]] bool ScanVolume(const std::wstring& volumeGuid);
+        // Creates the snapshot directory; returns empty when it cannot.
+        [[nodiscard]] std::wstring SnapshotPathFor(const std::wstring& volumeKey) const;
+
+        std::shared_ptr<abstractions::IExecutor> mExecutor;
+        std::shared_ptr<abstractions::ILogger>   mLogger;
+
+        mutable std::mutex mMutex;
+        std::unordered_map<std::wstring, std::shared_ptr<const abstractions::IStorageIndexSnapshot>> mSnapshots;
+        std::wstring       mSnapshotDirectory;
+        std::stop_source   mStopSource;
+        abstractions::StorageScanProgressCallback mProgressCallback;
+        uint32_t           mScanTimeoutMs = kDefaultScanTimeoutMs;
+        bool               mReadRawMFT = false;
+    };
+
+} // namespace winsetup::adapters::platform
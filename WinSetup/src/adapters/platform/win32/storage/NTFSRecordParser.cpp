@@ -0,0 +1,390 @@
+﻿#include "NTFSRecordParser.h"
+#include <algorithm>
+#include <cstring>
+
+namespace winsetup::adapters::platform {
+
+    namespace {
+        constexpr uint32_t FILE_RECORD_MAGIC = 0x454C4946;
+        constexpr uint16_t RECORD_FLAG_IN_USE = 0x0001;
+        constexpr uint16_t RECORD_FLAG_DIRECTORY = 0x0002;
+
+        constexpr uint32_t ATTRIBUTE_STANDARD_INFORMATION = 0x10;
+        constexpr uint32_t ATTRIBUTE_FILE_NAME = 0x30;
+        constexpr uint32_t ATTRIBUTE_DATA = 0x80;
+        constexpr uint32_t ATTRIBUTE_END = 0xFFFFFFFF;
+        constexpr uint32_t RESIDENT_HEADER_SIZE = 0x18;
+
+        constexpr uint8_t  NAMESPACE_DOS = 2;
+        constexpr uint32_t FILE_ATTRIBUTE_DIRECTORY_FLAG = 0x10;
+        constexpr uint64_t FILE_REFERENCE_MASK = 0x0000FFFFFFFFFFFFULL;
+        constexpr uint32_t MAX_FILE_RECORD_SIZE = 64 * 1024;
+
+        template<typename T>
+        T ReadField(const uint8_t* base, size_t offset) noexcept {
+            T value;
+            std::memcpy(&value, base + offset, sizeof(T));
+            return value;
+        }
+
+        int NamespaceRank(uint8_t nameSpace) noexcept {
+            return nameSpace == NAMESPACE_DOS ? 0 : (nameSpace == 0 ? 1 : 2);
+        }
+    }
+
+    bool NTFSRecordParser::ParseBootSector(
+        const uint8_t* sector,
+        size_t sectorSize,
+        NTFSVolumeGeometry& outGeometry
+    ) noexcept {
+        if (!sector || sectorSize < 512) return false;
+        if (std::memcmp(sector + 3, "NTFS    ", 8) != 0) return false;
+
+        const uint16_t bytesPerSector = ReadField<uint16_t>(sector, 0x0B);
+        const uint8_t  sectorsPerCluster = ReadField<uint8_t>(sector, 0x0D);
+        const int8_t   clustersPerRecord = ReadField<int8_t>(sector, 0x40);
+
+        if (bytesPerSector < 256 || (bytesPerSector & (bytesPerSector - 1)) != 0) return false;
+        if (sectorsPerCluster == 0) return false;
+
+        uint32_t bytesPerCluster = sectorsPerCluster <= 0x80
+            ? static_cast<uint32_t>(bytesPerSector) * sectorsPerCluster
+            : static_cast<uint32_t>(bytesPerSector) << (256 - sectorsPerCluster);
+
+        uint32_t bytesPerRecord = clustersPerRecord > 0
+            ? static_cast<uint32_t>(clustersPerRecord) * bytesPerCluster
+            : (clustersPerRecord > -31 ? 1u << (-clustersPerRecord) : 0u);
+
+        if (bytesPerRecord < bytesPerSector || bytesPerRecord > MAX_FILE_RECORD_SIZE) return false;
+
+        outGeometry.bytesPerSector = bytesPerSector;
+        outGeometry.bytesPerCluster = bytesPerCluster;
+        outGeometry.bytesPerFileRecord = bytesPerRecord;
+        outGeometry.mftStartLcn = ReadField<uint64_t>(sector, 0x30);
+        return true;
+    }
+
+    bool NTFSRecordParser::ApplyFixups(uint8_t* record, size_t recordSize) noexcept {
+        if (recordSize < 0x30) return false;
+
+        const uint16_t usaOffset = ReadField<uint16_t>(record, 0x04);
+        const uint16_t usaCount = ReadField<uint16_t>(record, 0x06);
+        if (usaCount < 2 || usaOffset + static_cast<size_t>(usaCount) * 2 > recordSize) return false;
+
+        const size_t stride = recordSize / (usaCount - 1);
+        if (stride < 2 || stride * (usaCount - 1) != recordSize) return false;
+
+        const uint16_t sequence = ReadField<uint16_t>(record, usaOffset);
+        for (uint16_t i = 1; i < usaCount; ++i) {
+            uint8_t* tail = record + i * stride - 2;
+            if (ReadField<uint16_t>(tail, 0) != sequence) return false;
+            std::memcpy(tail, record + usaOffset + i * 2, 2);
+        }
+
+        return true;
+    }
+
+    bool NTFSRecordParser::DecodeDataRuns(
+        const uint8_t* runList,
+        size_t runListSize,
+        std::vector<NTFSDataRun>& outRuns
+    ) {
+        size_t  pos = 0;
+        int64_t lcn = 0;
+
+        while (pos < runListSize && runList[pos] != 0) {
+            const uint8_t lengthBytes = runList[pos] & 0x0F;
+            const uint8_t offsetBytes = runList[pos] >> 4;
+            pos++;
+
+            if (lengthBytes == 0 || lengthBytes > 8 || offsetBytes > 8) return false;
+            if (pos + lengthBytes + offsetBytes > runListSize) return false;
+
+            uint64_t length = 0;
+            for (uint8_t i = 0; i < lengthBytes; ++i)
+                length |= static_cast<uint64_t>(runList[pos + i]) << (8 * i);
+            pos += lengthBytes;
+
+            NTFSDataRun run;
+            run.vcnLength = length;
+
+            if (offsetBytes > 0) {
+                uint64_t delta = 0;
+                for (uint8_t i = 0; i < offsetBytes; ++i)
+                    delta |= static_cast<uint64_t>(runList[pos + i]) << (8 * i);
+                if (offsetBytes < 8 && (runList[pos + offsetBytes - 1] & 0x80) != 0)
+                    delta |= ~0ULL << (8 * offsetBytes);
+                pos += offsetBytes;
+
+                lcn += static_cast<int64_t>(delta);
+                if (lcn < 0) return false;
+                run.lcn = lcn;
+            }
+
+            outRuns.push_back(run);
+        }
+
+        return true;
+    }
+
+    bool NTFSRecordParser::ParseFileRecord(
+        uint8_t* record,
+        size_t recordSize,
+        uint64_t recordNumber,
+        NTFSFileRecordInfo& outInfo
+    ) {
+        outInfo = NTFSFileRecordInfo{};
+
+        if (recordSize < 0x30 || ReadField<uint32_t>(record, 0x00) != FILE_RECORD_MAGIC) return false;
+
+        const uint16_t flags = ReadField<uint16_t>(record, 0x16);
+        if ((flags & RECORD_FLAG_IN_USE) == 0) return false;
+        if (!ApplyFixups(record, recordSize)) return false;
+
+        const uint16_t sequence = ReadField<uint16_t>(record, 0x10);
+        const uint16_t firstAttribute = ReadField<uint16_t>(record, 0x14);
+        const uint32_t usedSize = (std::min)(ReadField<uint32_t>(record, 0x18), static_cast<uint32_t>(recordSize));
+
+        outInfo.fileReference = (static_cast<uint64_t>(sequence) << 48) | (recordNumber & FILE_REFERENCE_MASK);
+        outInfo.baseFileReference = ReadField<uint64_t>(record, 0x20);
+        outInfo.isDirectory = (flags & RECORD_FLAG_DIRECTORY) != 0;
+
+        int    bestNameRank = -1;
+        size_t offset = firstAttribute;
+
+        while (offset + 16 <= usedSize) {
+            const uint32_t type = ReadField<uint32_t>(record, offset);
+            if (type == ATTRIBUTE_END) break;
+
+            const uint32_t length = ReadField<uint32_t>(record, offset + 0x04);
+            if (length < 16 || offset + length > usedSize) return false;
+
+            const uint8_t* attribute = record + offset;
+            const bool     nonResident = attribute[0x08] != 0;
+            const uint8_t  nameLength = attribute[0x09];
+
+            if (!nonResident) {
+                if (length < RESIDENT_HEADER_SIZE) return false;
+                const uint32_t valueLength = ReadField<uint32_t>(attribute, 0x10);
+                const uint16_t valueOffset = ReadField<uint16_t>(attribute, 0x14);
+                if (static_cast<size_t>(valueOffset) + valueLength > length) return false;
+                const uint8_t* value = attribute + valueOffset;
+
+                if (type == ATTRIBUTE_STANDARD_INFORMATION && valueLength >= 0x24) {
+                    outInfo.creationTime = ReadField<int64_t>(value, 0x00);
+                    outInfo.lastWriteTime = ReadField<int64_t>(value, 0x08);
+                    outInfo.lastAccessTime = ReadField<int64_t>(value, 0x18);
+                    outInfo.fileAttributes = ReadField<uint32_t>(value, 0x20);
+                    outInfo.hasStandardInformation = true;
+                }
+                else if (type == ATTRIBUTE_FILE_NAME && valueLength >= 0x42) {
+                    const uint8_t nameChars = value[0x40];
+                    const int     rank = NamespaceRank(value[0x41]);
+                    if (0x42 + static_cast<size_t>(nameChars) * 2 <= valueLength && rank > bestNameRank) {
+                        bestNameRank = rank;
+                        outInfo.parentFileReference = ReadField<uint64_t>(value, 0x00);
+                        outInfo.fileName = std::u16string_view(
+                            reinterpret_cast<const char16_t*>(value + 0x42), nameChars);
+                    }
+                }
+                else if (type == ATTRIBUTE_DATA && nameLength == 0) {
+                    outInfo.fileSize = valueLength;
+                    outInfo.allocatedSize = valueLength;
+                    outInfo.hasData = true;
+                }
+            }
+            else if (type == ATTRIBUTE_DATA && nameLength == 0 && length >= 0x40) {
+                const uint64_t startVcn = ReadField<uint64_t>(attribute, 0x10);
+                const uint16_t runOffset = ReadField<uint16_t>(attribute, 0x20);
+                if (runOffset >= length) return false;
+
+                if (startVcn == 0) {
+                    outInfo.allocatedSize = ReadField<uint64_t>(attribute, 0x28);
+                    outInfo.fileSize = ReadField<uint64_t>(attribute, 0x30);
+                    outInfo.hasData = true;
+                }
+
+                if (!DecodeDataRuns(attribute + runOffset, length - runOffset, outInfo.dataRuns))
+                    return false;
+            }
+
+            offset += length;
+        }
+
+        if (outInfo.isDirectory)
+            outInfo.fileAttributes |= FILE_ATTRIBUTE_DIRECTORY_FLAG;
+
+        return true;
+    }
+
+    NTFSMFTReader::NTFSMFTReader(
+        const NTFSVolumeGeometry& geometry,
+        ReadCallback reader,
+        size_t readChunkSize
+    )
+        : mGeometry(geometry)
+        , mReader(std::move(reader))
+        , mReadChunkSize(readChunkSize)
+    {
+    }
+
+    NTFSReadStatus NTFSMFTReader::ReadLayout(
+        uint64_t& outTotalRecords,
+        std::vector<NTFSDataRun>& outRuns
+    ) {
+        const uint32_t recordSize = mGeometry.bytesPerFileRecord;
+        const uint64_t clusterSize = mGeometry.bytesPerCluster;
+        if (recordSize == 0 || clusterSize == 0) return NTFSReadStatus::Corrupt;
+
+        std::vector<uint8_t> mftRecord(recordSize);
+        if (!mReader(mGeometry.mftStartLcn * clusterSize, mftRecord.data(), recordSize))
+            return NTFSReadStatus::ReadFailed;
+
+        NTFSFileRecordInfo mftInfo;
+        if (!NTFSRecordParser::ParseFileRecord(mftRecord.data(), recordSize, 0, mftInfo) || !mftInfo.hasData || mftInfo.dataRuns.empty())
+            return NTFSReadStatus::Corrupt;
+
+        outTotalRecords = mftInfo.fileSize / recordSize;
+        outRuns = std::move(mftInfo.dataRuns);
+        return NTFSReadStatus::Completed;
+    }
+
+    NTFSReadStatus NTFSMFTReader::ReadAll(const RecordCallback& onRecord) {
+        mRecordsRead = 0;
+
+        const uint32_t recordSize = mGeometry.bytesPerFileRecord;
+        const uint64_t clusterSize = mGeometry.bytesPerCluster;
+
+        uint64_t totalRecords = 0;
+        std::vector<NTFSDataRun> runs;
+        const NTFSReadStatus layoutStatus = ReadLayout(totalRecords, runs);
+        if (layoutStatus != NTFSReadStatus::Completed) return layoutStatus;
+
+        const size_t chunkSize = (std::max)(
+            static_cast<size_t>(clusterSize),
+            mReadChunkSize / clusterSize * clusterSize
+        );
+
+        std::vector<uint8_t> chunk(chunkSize);
+        std::vector<uint8_t> pending;
+        pending.reserve(recordSize);
+
+        uint64_t           recordNumber = 0;
+        NTFSFileRecordInfo info;
+
+        auto consume = [&](uint8_t* data, size_t size) -> bool {
+            size_t pos = 0;
+
+            if (!pending.empty()) {
+                const size_t take = (std::min)(size, recordSize - pending.size());
+                pending.insert(pending.end(), data, data + take);
+                pos = take;
+                if (pending.size() < recordSize) return true;
+
+                if (NTFSRecordParser::ParseFileRecord(pending.data(), recordSize, recordNumber, info) && !onRecord(info))
+                    return false;
+                pending.clear();
+                recordNumber++;
+                mRecordsRead++;
+            }
+
+            while (pos + recordSize <= size && recordNumber < totalRecords) {
+                if (NTFSRecordParser::ParseFileRecord(data + pos, recordSize, recordNumber, info) && !onRecord(info))
+                    return false;
+                pos += recordSize;
+                recordNumber++;
+                mRecordsRead++;
+            }
+
+            if (pos < size && recordNumber < totalRecords)
+                pending.assign(data + pos, data + size);
+
+            return true;
+        };
+
+        for (const auto& run : runs) {
+            if (recordNumber >= totalRecords) break;
+
+            uint64_t runBytes = run.vcnLength * clusterSize;
+            uint64_t runOffset = 0;
+
+            while (runBytes > 0 && recordNumber < totalRecords) {
+                const size_t readSize = static_cast<size_t>((std::min)(runBytes, static_cast<uint64_t>(chunkSize)));
+
+                if (run.IsSparse()) {
+                    std::fill(chunk.begin(), chunk.begin() + readSize, uint8_t{ 0 });
+                }
+                else if (!mReader(static_cast<uint64_t>(run.lcn) * clusterSize + runOffset, chunk.data(), readSize)) {
+                    return NTFSReadStatus::ReadFailed;
+                }
+
+                if (!consume(chunk.data(), readSize))
+                    return NTFSReadStatus::Stopped;
+
+                runOffset += readSize;
+                runBytes -= readSize;
+            }
+        }
+
+        return NTFSReadStatus::Completed;
+    }
+
+    NTFSReadStatus NTFSMFTReader::ReadRecords(
+        const std::vector<uint64_t>& recordNumbers,
+        const RecordCallback& onRecord
+    ) {
+        mRecordsRead = 0;
+        if (recordNumbers.empty()) return NTFSReadStatus::Completed;
+
+        const uint32_t recordSize = mGeometry.bytesPerFileRecord;
+        const uint64_t clusterSize = mGeometry.bytesPerCluster;
+
+        uint64_t totalRecords = 0;
+        std::vector<NTFSDataRun> runs;
+        const NTFSReadStatus layoutStatus = ReadLayout(totalRecords, runs);
+        if (layoutStatus != NTFSReadStatus::Completed) return layoutStatus;
+
+        std::vector<uint8_t> record(recordSize);
+        NTFSFileRecordInfo info;
+
+        for (const uint64_t recordNumber : recordNumbers) {
+            if (recordNumber >= totalRecords) continue;
+
+            // A record can straddle two runs when it is larger than a cluster.
+            uint64_t mftOffset = recordNumber * recordSize;
+            size_t   filled = 0;
+            bool     sparse = false;
+
+            for (const auto& run : runs) {
+                if (filled == recordSize) break;
+
+                const uint64_t runBytes = run.vcnLength * clusterSize;
+                if (mftOffset >= runBytes) {
+                    mftOffset -= runBytes;
+                    continue;
+                }
+
+                const size_t take = static_cast<size_t>((std::min)(
+                    runBytes - mftOffset, static_cast<uint64_t>(recordSize - filled)));
+                if (run.IsSparse()) {
+                    sparse = true;
+                    break;
+                }
+                if (!mReader(static_cast<uint64_t>(run.lcn) * clusterSize + mftOffset, record.data() + filled, take))
+                    return NTFSReadStatus::ReadFailed;
+
+                filled += take;
+                mftOffset = 0;
+            }
+
+            if (sparse || filled != recordSize) continue;
+
+            mRecordsRead++;
+            if (NTFSRecordParser::ParseFileRecord(record.data(), recordSize, recordNumber, info) && !onRecord(info))
+                return NTFSReadStatus::Stopped;
+        }
+
+        return NTFSReadStatus::Completed;
+    }
+
+}
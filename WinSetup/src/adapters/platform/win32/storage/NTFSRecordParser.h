@@ -0,0 +1,121 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+namespace winsetup::adapters::platform {
+
+    struct NTFSVolumeGeometry {
+        uint32_t bytesPerSector = 0;
+        uint32_t bytesPerCluster = 0;
+        uint32_t bytesPerFileRecord = 0;
+        uint64_t mftStartLcn = 0;
+    };
+
+    struct NTFSDataRun {
+        uint64_t vcnLength = 0;
+        int64_t  lcn = -1;
+
+        [[nodiscard]] bool IsSparse() const noexcept { return lcn < 0; }
+    };
+
+    struct NTFSFileRecordInfo {
+        uint64_t fileReference = 0;
+        uint64_t baseFileReference = 0;
+        uint64_t parentFileReference = 0;
+        uint64_t fileSize = 0;
+        uint64_t allocatedSize = 0;
+        int64_t  creationTime = 0;
+        int64_t  lastWriteTime = 0;
+        int64_t  lastAccessTime = 0;
+        uint32_t fileAttributes = 0;
+        bool     isDirectory = false;
+        bool     hasStandardInformation = false;
+        bool     hasData = false;
+        std::u16string_view fileName;
+        std::vector<NTFSDataRun> dataRuns;
+
+        [[nodiscard]] bool IsBaseRecord() const noexcept { return baseFileReference == 0; }
+    };
+
+    enum class NTFSReadStatus {
+        Completed,
+        Stopped,
+        ReadFailed,
+        Corrupt
+    };
+
+    // Decodes NTFS boot sectors and FILE records from raw bytes. Nothing here
+    // depends on the Windows headers, so NTFS images can drive it off-box.
+    class NTFSRecordParser {
+    public:
+        NTFSRecordParser() = delete;
+
+        [[nodiscard]] static bool ParseBootSector(
+            const uint8_t* sector,
+            size_t sectorSize,
+            NTFSVolumeGeometry& outGeometry
+        ) noexcept;
+
+        [[nodiscard]] static bool ApplyFixups(
+            uint8_t* record,
+            size_t recordSize
+        ) noexcept;
+
+        // Applies fixups in place. Returns false for free or damaged records.
+        [[nodiscard]] static bool ParseFileRecord(
+            uint8_t* record,
+            size_t recordSize,
+            uint64_t recordNumber,
+            NTFSFileRecordInfo& outInfo
+        );
+
+        [[nodiscard]] static bool DecodeDataRuns(
+            const uint8_t* runList,
+            size_t runListSize,
+            std::vector<NTFSDataRun>& outRuns
+        );
+    };
+
+    // Streams every FILE record of $MFT through a caller-supplied reader that
+    // returns raw volume bytes, issuing large reads along the $MFT data runs.
+    class NTFSMFTReader {
+    public:
+        using ReadCallback = std::function<bool(uint64_t byteOffset, uint8_t* buffer, size_t length)>;
+        using RecordCallback = std::function<bool(const NTFSFileRecordInfo& record)>;
+
+        NTFSMFTReader(
+            const NTFSVolumeGeometry& geometry,
+            ReadCallback reader,
+            size_t readChunkSize = DEFAULT_READ_CHUNK_SIZE
+        );
+
+        [[nodiscard]] NTFSReadStatus ReadAll(const RecordCallback& onRecord);
+
+        // Reads only the listed FILE records, one record-sized read each.
+        // Numbers past the end of $MFT or in sparse runs are skipped.
+        [[nodiscard]] NTFSReadStatus ReadRecords(
+            const std::vector<uint64_t>& recordNumbers,
+            const RecordCallback& onRecord
+        );
+
+        [[nodiscard]] uint64_t GetRecordsRead() const noexcept { return mRecordsRead; }
+
+        static constexpr size_t DEFAULT_READ_CHUNK_SIZE = 4 * 1024 * 1024;
+
+    private:
+        [[nodiscard]] NTFSReadStatus ReadLayout(
+            uint64_t& outTotalRecords,
+            std::vector<NTFSDataRun>& outRuns
+        );
+
+        NTFSVolumeGeometry mGeometry;
+        ReadCallback       mReader;
+        size_t             mReadChunkSize;
+        uint64_t           mRecordsRead = 0;
+    };
+
+}
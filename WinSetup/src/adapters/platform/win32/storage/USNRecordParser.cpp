@@ -0,0 +1,75 @@
+﻿#include "USNRecordParser.h"
+#include <cstring>
+
+namespace winsetup::adapters::platform {
+
+    namespace {
+        constexpr size_t OFFSET_RECORD_LENGTH = 0;
+        constexpr size_t OFFSET_MAJOR_VERSION = 4;
+        constexpr size_t OFFSET_FILE_REFERENCE = 8;
+        constexpr size_t OFFSET_PARENT_REFERENCE = 16;
+        constexpr size_t OFFSET_USN = 24;
+        constexpr size_t OFFSET_TIMESTAMP = 32;
+        constexpr size_t OFFSET_REASON = 40;
+        constexpr size_t OFFSET_FILE_ATTRIBUTES = 52;
+        constexpr size_t OFFSET_FILE_NAME_LENGTH = 56;
+        constexpr size_t OFFSET_FILE_NAME_OFFSET = 58;
+        constexpr size_t RECORD_V2_HEADER_SIZE = 60;
+        constexpr uint16_t RECORD_MAJOR_VERSION_2 = 2;
+
+        template<typename T>
+        T ReadField(const uint8_t* record, size_t offset) noexcept {
+            T value;
+            std::memcpy(&value, record + offset, sizeof(T));
+            return value;
+        }
+    }
+
+    bool USNRecordParser::Next(USNRecordView& outRecord) noexcept {
+        while (mRemaining >= RECORD_V2_HEADER_SIZE) {
+            const uint8_t* record = mCursor;
+            const uint32_t recordLength = ReadField<uint32_t>(record, OFFSET_RECORD_LENGTH);
+
+            if (recordLength < RECORD_V2_HEADER_SIZE || recordLength > mRemaining) {
+                mRemaining = 0;
+                return false;
+            }
+
+            mCursor += recordLength;
+            mRemaining -= recordLength;
+
+            if (ReadField<uint16_t>(record, OFFSET_MAJOR_VERSION) != RECORD_MAJOR_VERSION_2)
+                continue;
+
+            const uint16_t nameLength = ReadField<uint16_t>(record, OFFSET_FILE_NAME_LENGTH);
+            const uint16_t nameOffset = ReadField<uint16_t>(record, OFFSET_FILE_NAME_OFFSET);
+            if (static_cast<size_t>(nameOffset) + nameLength > recordLength || (nameOffset & 1) != 0)
+                continue;
+
+            outRecord.fileReferenceNumber = ReadField<uint64_t>(record, OFFSET_FILE_REFERENCE);
+            outRecord.parentFileReferenceNumber = ReadField<uint64_t>(record, OFFSET_PARENT_REFERENCE);
+            outRecord.usn = ReadField<int64_t>(record, OFFSET_USN);
+            outRecord.timestamp = ReadField<int64_t>(record, OFFSET_TIMESTAMP);
+            outRecord.reason = ReadField<uint32_t>(record, OFFSET_REASON);
+            outRecord.fileAttributes = ReadField<uint32_t>(record, OFFSET_FILE_ATTRIBUTES);
+            outRecord.fileName = std::u16string_view(
+                reinterpret_cast<const char16_t*>(record + nameOffset),
+                nameLength / sizeof(char16_t)
+            );
+            return true;
+        }
+
+        return false;
+    }
+
+    bool USNRecordParser::ReadResumePoint(
+        const uint8_t* buffer,
+        size_t bufferSize,
+        int64_t& outResumePoint
+    ) noexcept {
+        if (!buffer || bufferSize < RESUME_POINT_SIZE) return false;
+        std::memcpy(&outResumePoint, buffer, RESUME_POINT_SIZE);
+        return true;
+    }
+
+}
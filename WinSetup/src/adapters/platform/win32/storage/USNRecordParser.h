@@ -0,0 +1,46 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace winsetup::adapters::platform {
+
+    struct USNRecordView {
+        uint64_t fileReferenceNumber = 0;
+        uint64_t parentFileReferenceNumber = 0;
+        int64_t  usn = 0;
+        int64_t  timestamp = 0;
+        uint32_t reason = 0;
+        uint32_t fileAttributes = 0;
+        std::u16string_view fileName;
+    };
+
+    // Walks USN_RECORD_V2 entries by their on-disk layout, without touching
+    // the Windows headers, so captured FSCTL output can be replayed anywhere.
+    class USNRecordParser {
+    public:
+        USNRecordParser(const uint8_t* buffer, size_t bufferSize) noexcept
+            : mCursor(buffer)
+            , mRemaining(buffer ? bufferSize : 0)
+        {
+        }
+
+        [[nodiscard]] bool Next(USNRecordView& outRecord) noexcept;
+
+        // FSCTL_ENUM_USN_DATA and FSCTL_READ_USN_JOURNAL prefix their output
+        // with the 64-bit value to resume from.
+        [[nodiscard]] static bool ReadResumePoint(
+            const uint8_t* buffer,
+            size_t bufferSize,
+            int64_t& outResumePoint
+        ) noexcept;
+
+        static constexpr size_t RESUME_POINT_SIZE = sizeof(int64_t);
+
+    private:
+        const uint8_t* mCursor;
+        size_t         mRemaining;
+    };
+
+}
@@ -0,0 +1,222 @@
+﻿#include "UnbufferedCopyRing.h"
+#include <algorithm>
+#include <cstring>
+#include <optional>
+
+namespace winsetup::adapters::platform {
+
+    namespace {
+        // Win32 codes, spelled out so this file builds without <Windows.h>.
+        constexpr uint32_t CODE_WRITE_FAULT = 29;
+        constexpr uint32_t CODE_HANDLE_EOF = 38;
+        constexpr uint32_t CODE_INVALID_PARAMETER = 87;
+        constexpr uint32_t CODE_OPERATION_ABORTED = 995;
+
+        constexpr uint64_t AlignUp(uint64_t value, uint32_t alignment) noexcept {
+            return (value + alignment - 1) & ~static_cast<uint64_t>(alignment - 1);
+        }
+
+        constexpr bool IsPowerOfTwo(uint32_t value) noexcept {
+            return value != 0 && (value & (value - 1)) == 0;
+        }
+    }
+
+    UnbufferedCopyRing::UnbufferedCopyRing(uint32_t blockSize, uint32_t queueDepth)
+        : mBlockSize(blockSize)
+        , mQueueDepth((std::clamp)(queueDepth, 1u, MAX_QUEUE_DEPTH))
+    {
+    }
+
+    domain::Expected<void> UnbufferedCopyRing::Run(
+        IAsyncFileChannel& channel,
+        uint64_t rangeBegin,
+        uint64_t rangeEnd,
+        uint64_t fileSize,
+        const std::atomic<bool>& cancelled
+    ) {
+        mAlignment = channel.GetAlignment();
+        if (!IsPowerOfTwo(mAlignment) || mBlockSize == 0 ||
+            rangeBegin % mAlignment != 0 || rangeBegin > rangeEnd || rangeEnd > fileSize ||
+            (rangeEnd != fileSize && rangeEnd % mAlignment != 0)) {
+            return domain::Error{
+                L"Unbuffered copy needs a power-of-two alignment, a non-zero block size and an aligned range",
+                CODE_INVALID_PARAMETER,
+                domain::ErrorCategory::Validation
+            };
+        }
+
+        mFileSize = fileSize;
+        mRangeEnd = rangeEnd;
+        mNextReadOffset = rangeBegin;
+        mNextWriteOffset = rangeBegin;
+        mOrderedWrites = channel.RequiresOrderedWrites();
+        mBytesCopied = 0;
+        mInFlight = 0;
+        mStopIssuing = false;
+        if (rangeBegin == rangeEnd) return domain::Expected<void>();
+
+        if (cancelled.load(std::memory_order_relaxed)) {
+            return domain::Error{
+                L"Copy operation was cancelled",
+                CODE_OPERATION_ABORTED,
+                domain::ErrorCategory::IO
+            };
+        }
+
+        const uint32_t alignedBlock = static_cast<uint32_t>(AlignUp(mBlockSize, mAlignment));
+        const size_t   bufferAlignment = (std::max)(static_cast<size_t>(mAlignment), alignof(std::max_align_t));
+        if (!mBuffers || alignedBlock != mBlockSize || mBuffers.get_deleter().alignment < bufferAlignment) {
+            mBlockSize = alignedBlock;
+            mBuffers = std::unique_ptr<std::byte[], AlignedDelete>(
+                static_cast<std::byte*>(::operator new(
+                    static_cast<size_t>(mBlockSize) * mQueueDepth, std::align_val_t{ bufferAlignment })),
+                AlignedDelete{ bufferAlignment });
+        }
+        mSlots.assign(mQueueDepth, Slot{});
+
+        std::optional<domain::Error> failure;
+        auto fail = [this, &channel, &failure](domain::Error error) {
+            if (!failure) failure = std::move(error);
+            if (!mStopIssuing) {
+                mStopIssuing = true;
+                channel.CancelPending();
+            }
+        };
+
+        for (uint32_t slot = 0; slot < mQueueDepth && mNextReadOffset < mRangeEnd; ++slot) {
+            auto issued = IssueRead(channel, slot);
+            if (!issued.HasValue()) {
+                fail(issued.GetError());
+                break;
+            }
+        }
+
+        while (mInFlight > 0) {
+            if (!mStopIssuing && cancelled.load(std::memory_order_relaxed)) {
+                fail(domain::Error{
+                    L"Copy operation was cancelled",
+                    CODE_OPERATION_ABORTED,
+                    domain::ErrorCategory::IO
+                });
+            }
+
+            auto completion = channel.WaitForCompletion();
+            if (!completion.HasValue())
+                return completion.GetError();
+
+            const AsyncFileCompletion& done = completion.Value();
+            --mInFlight;
+
+            if (mStopIssuing) continue;
+
+            auto handled = done.operation == AsyncFileOperation::Read
+                ? OnReadComplete(channel, done)
+                : OnWriteComplete(channel, done);
+            if (!handled.HasValue())
+                fail(handled.GetError());
+        }
+
+        if (failure) return *failure;
+
+        if (mRangeEnd == mFileSize && mFileSize % mAlignment != 0)
+            return channel.SetDestinationLength(mFileSize);
+
+        return domain::Expected<void>();
+    }
+
+    domain::Expected<void> UnbufferedCopyRing::IssueRead(IAsyncFileChannel& channel, uint32_t slot) {
+        Slot& current = mSlots[slot];
+        current.offset = mNextReadOffset;
+        current.expected = static_cast<uint32_t>((std::min)(
+            static_cast<uint64_t>(mBlockSize), mRangeEnd - mNextReadOffset));
+        current.submitted = static_cast<uint32_t>(AlignUp(current.expected, mAlignment));
+
+        auto submitted = channel.SubmitRead(slot, current.offset, SlotBuffer(slot), current.submitted);
+        if (!submitted.HasValue()) return submitted;
+
+        mNextReadOffset += current.expected;
+        ++mInFlight;
+        return domain::Expected<void>();
+    }
+
+    domain::Expected<void> UnbufferedCopyRing::OnReadComplete(
+        IAsyncFileChannel& channel,
+        const AsyncFileCompletion& completion
+    ) {
+        Slot& current = mSlots[completion.slot];
+        if (completion.errorCode != 0) {
+            return domain::Error{
+                L"Read failed at offset " + std::to_wstring(current.offset),
+                completion.errorCode,
+                domain::ErrorCategory::IO
+            };
+        }
+        if (completion.bytesTransferred < current.expected) {
+            return domain::Error{
+                L"Source file shrank during copy",
+                CODE_HANDLE_EOF,
+                domain::ErrorCategory::IO
+            };
+        }
+
+        std::byte* buffer = SlotBuffer(completion.slot);
+        if (mBlockObserver)
+            mBlockObserver(current.offset, buffer, current.expected);
+        if (current.submitted > current.expected)
+            std::memset(buffer + current.expected, 0, current.submitted - current.expected);
+
+        if (mOrderedWrites) {
+            current.readyToWrite = true;
+            return SubmitOrderedWrites(channel);
+        }
+
+        auto submitted = channel.SubmitWrite(completion.slot, current.offset, buffer, current.submitted);
+        if (!submitted.HasValue()) return submitted;
+
+        ++mInFlight;
+        return domain::Expected<void>();
+    }
+
+    // Slots are few (MAX_QUEUE_DEPTH), so a scan per submitted block is
+    // cheaper than keeping them sorted.
+    domain::Expected<void> UnbufferedCopyRing::SubmitOrderedWrites(IAsyncFileChannel& channel) {
+        for (bool found = true; found;) {
+            found = false;
+            for (uint32_t slot = 0; slot < mQueueDepth; ++slot) {
+                Slot& current = mSlots[slot];
+                if (!current.readyToWrite || current.offset != mNextWriteOffset) continue;
+
+                auto submitted = channel.SubmitWrite(slot, current.offset, SlotBuffer(slot), current.submitted);
+                if (!submitted.HasValue()) return submitted;
+
+                current.readyToWrite = false;
+                mNextWriteOffset += current.expected;
+                ++mInFlight;
+                found = true;
+                break;
+            }
+        }
+        return domain::Expected<void>();
+    }
+
+    domain::Expected<void> UnbufferedCopyRing::OnWriteComplete(
+        IAsyncFileChannel& channel,
+        const AsyncFileCompletion& completion
+    ) {
+        Slot& current = mSlots[completion.slot];
+        if (completion.errorCode != 0 || completion.bytesTransferred != current.submitted) {
+            return domain::Error{
+                L"Write failed at offset " + std::to_wstring(current.offset),
+                completion.errorCode != 0 ? completion.errorCode : CODE_WRITE_FAULT,
+                domain::ErrorCategory::IO
+            };
+        }
+
+        mBytesCopied += current.expected;
+
+        if (mNextReadOffset < mRangeEnd)
+            return IssueRead(channel, completion.slot);
+        return domain::Expected<void>();
+    }
+
+}
@@ -0,0 +1,113 @@
+﻿#pragma once
+
+#include <domain/primitives/Expected.h>
+#include <adapters/platform/win32/storage/AsyncFileChannel.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace winsetup::adapters::platform {
+
+    // Copies one file through a ring of aligned buffers, keeping up to
+    // queueDepth reads and writes in flight at once. Every slot cycles
+    // read -> write -> read at its own offset, so a slow write never stalls
+    // the reads queued behind it. When the channel requires ordered writes,
+    // a block whose read finished early waits in its slot until every
+    // block before it has been submitted. The last block is zero-padded to
+    // the channel alignment and the destination trimmed back afterwards.
+    // Nothing here depends on the Windows headers.
+    class UnbufferedCopyRing {
+    public:
+        UnbufferedCopyRing(uint32_t blockSize, uint32_t queueDepth);
+        ~UnbufferedCopyRing() = default;
+
+        UnbufferedCopyRing(const UnbufferedCopyRing&) = delete;
+        UnbufferedCopyRing& operator=(const UnbufferedCopyRing&) = delete;
+
+        [[nodiscard]] domain::Expected<void> Run(
+            IAsyncFileChannel& channel,
+            uint64_t fileSize,
+            const std::atomic<bool>& cancelled
+        ) {
+            return Run(channel, 0, fileSize, fileSize, cancelled);
+        }
+
+        // Copies [rangeBegin, rangeEnd) only, so several rings can share one
+        // file. Both ends must be aligned unless rangeEnd is fileSize; the
+        // destination is trimmed only by the ring that owns the tail.
+        [[nodiscard]] domain::Expected<void> Run(
+            IAsyncFileChannel& channel,
+            uint64_t rangeBegin,
+            uint64_t rangeEnd,
+            uint64_t fileSize,
+            const std::atomic<bool>& cancelled
+        );
+
+        // Sees each block's source bytes between its read and its write, for
+        // hashing the copy inline. Called on the thread running Run().
+        using BlockObserver = std::function<void(uint64_t offset, const std::byte* data, uint32_t length)>;
+
+        void SetBlockObserver(BlockObserver observer) { mBlockObserver = std::move(observer); }
+
+        [[nodiscard]] uint64_t GetBytesCopied() const noexcept { return mBytesCopied; }
+
+        static constexpr uint32_t MAX_QUEUE_DEPTH = 64;
+
+    private:
+        struct Slot {
+            uint64_t  offset = 0;
+            uint32_t  expected = 0;
+            uint32_t  submitted = 0;
+            bool      readyToWrite = false;
+        };
+
+        struct AlignedDelete {
+            AlignedDelete() noexcept : alignment(0) {}
+            explicit AlignedDelete(size_t blockAlignment) noexcept : alignment(blockAlignment) {}
+
+            size_t alignment;
+            void operator()(std::byte* block) const noexcept {
+                ::operator delete(block, std::align_val_t{ alignment });
+            }
+        };
+
+        [[nodiscard]] std::byte* SlotBuffer(uint32_t slot) noexcept {
+            return mBuffers.get() + static_cast<size_t>(slot) * mBlockSize;
+        }
+
+        [[nodiscard]] domain::Expected<void> IssueRead(IAsyncFileChannel& channel, uint32_t slot);
+
+        [[nodiscard]] domain::Expected<void> OnReadComplete(
+            IAsyncFileChannel& channel,
+            const AsyncFileCompletion& completion
+        );
+
+        [[nodiscard]] domain::Expected<void> SubmitOrderedWrites(IAsyncFileChannel& channel);
+
+        [[nodiscard]] domain::Expected<void> OnWriteComplete(
+            IAsyncFileChannel& channel,
+            const AsyncFileCompletion& completion
+        );
+
+        uint32_t mBlockSize;
+        uint32_t mQueueDepth;
+        uint32_t mAlignment = 0;
+        uint64_t mFileSize = 0;
+        uint64_t mRangeEnd = 0;
+        uint64_t mNextReadOffset = 0;
+        uint64_t mNextWriteOffset = 0;
+        bool     mOrderedWrites = false;
+        uint64_t mBytesCopied = 0;
+        uint32_t mInFlight = 0;
+        bool     mStopIssuing = false;
+
+        std::vector<Slot>                           mSlots;
+        std::unique_ptr<std::byte[], AlignedDelete> mBuffers;
+        BlockObserver                               mBlockObserver;
+    };
+
+}
@@ -0,0 +1,245 @@
+﻿#include "Win32AsyncFileChannel.h"
+#include <adapters/platform/win32/core/Win32HandleFactory.h>
+#include <adapters/platform/win32/core/Win32Privilege.h>
+#include <algorithm>
+#undef min
+#undef max
+
+namespace winsetup::adapters::platform {
+
+    namespace {
+        domain::Error ChannelError(const std::wstring& message, DWORD code) {
+            return domain::Error{ message, code, domain::ErrorCategory::IO };
+        }
+    }
+
+    domain::Expected<std::unique_ptr<Win32AsyncFileChannel>> Win32AsyncFileChannel::Open(
+        const std::wstring& srcPath,
+        const std::wstring& dstPath,
+        uint64_t fileSize,
+        uint32_t queueDepth,
+        bool createDestination,
+        bool validDataPreset
+    ) {
+        auto hSrc = Win32HandleFactory::MakeHandle(
+            CreateFileW(srcPath.c_str(),
+                GENERIC_READ,
+                FILE_SHARE_READ | FILE_SHARE_WRITE,
+                nullptr,
+                OPEN_EXISTING,
+                FILE_FLAG_NO_BUFFERING | FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN,
+                nullptr));
+        if (!hSrc)
+            return ChannelError(L"Failed to open source file: " + srcPath, GetLastError());
+
+        auto hDst = Win32HandleFactory::MakeHandle(
+            CreateFileW(dstPath.c_str(),
+                GENERIC_WRITE,
+                createDestination ? 0 : FILE_SHARE_READ | FILE_SHARE_WRITE,
+                nullptr,
+                createDestination ? CREATE_ALWAYS : OPEN_EXISTING,
+                FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING | FILE_FLAG_OVERLAPPED | FILE_FLAG_WRITE_THROUGH,
+                nullptr));
+        if (!hDst)
+            return ChannelError(L"Failed to create destination file: " + dstPath, GetLastError());
+
+        std::unique_ptr<Win32AsyncFileChannel> channel(
+            new Win32AsyncFileChannel(std::move(hSrc), std::move(hDst), queueDepth));
+
+        const HANDLE source = Win32HandleFactory::ToWin32Handle(channel->mSource);
+        const HANDLE destination = Win32HandleFactory::ToWin32Handle(channel->mDestination);
+
+        channel->mCompletionPort = CreateIoCompletionPort(source, nullptr, 0, 1);
+        if (!channel->mCompletionPort ||
+            !CreateIoCompletionPort(destination, channel->mCompletionPort, 0, 1))
+            return ChannelError(L"Failed to create completion port for: " + srcPath, GetLastError());
+
+        channel->mAlignment = (std::max)(QuerySectorAlignment(source), QuerySectorAlignment(destination));
+
+        if (createDestination) {
+            const uint64_t alignedSize =
+                (fileSize + channel->mAlignment - 1) & ~static_cast<uint64_t>(channel->mAlignment - 1);
+            channel->mOrderedWrites = !(CanPresetValidData() && PresetValidData(destination, alignedSize));
+        }
+        else {
+            channel->mOrderedWrites = !validDataPreset;
+        }
+
+        return channel;
+    }
+
+    bool Win32AsyncFileChannel::CanPresetValidData() noexcept {
+        static const bool enabled = Win32Privilege::Enable(SE_MANAGE_VOLUME_NAME);
+        return enabled;
+    }
+
+    // Extending only the end of file leaves the valid data length at zero,
+    // and a write past it makes NTFS zero the gap synchronously first.
+    // On failure (FAT, compressed or sparse files) the file is cut back to
+    // empty so the caller can fall back to ordered writes.
+    bool Win32AsyncFileChannel::PresetValidData(HANDLE hFile, uint64_t length) noexcept {
+        if (length == 0) return true;
+
+        FILE_END_OF_FILE_INFO endOfFile{};
+        endOfFile.EndOfFile.QuadPart = static_cast<LONGLONG>(length);
+        if (!SetFileInformationByHandle(hFile, FileEndOfFileInfo, &endOfFile, sizeof(endOfFile)))
+            return false;
+        if (SetFileValidData(hFile, static_cast<LONGLONG>(length)))
+            return true;
+
+        endOfFile.EndOfFile.QuadPart = 0;
+        (void)SetFileInformationByHandle(hFile, FileEndOfFileInfo, &endOfFile, sizeof(endOfFile));
+        return false;
+    }
+
+    Win32AsyncFileChannel::Win32AsyncFileChannel(
+        UniqueHandle source,
+        UniqueHandle destination,
+        uint32_t queueDepth
+    )
+        : mSource(std::move(source))
+        , mDestination(std::move(destination))
+        , mRequests((std::max)(queueDepth, 1u))
+    {
+    }
+
+    Win32AsyncFileChannel::~Win32AsyncFileChannel() {
+        if (mPending > 0) {
+            CancelPending();
+
+            DWORD       bytes = 0;
+            ULONG_PTR   key = 0;
+            OVERLAPPED* overlapped = nullptr;
+            while (mPending > 0) {
+                if (!GetQueuedCompletionStatus(mCompletionPort, &bytes, &key, &overlapped, INFINITE) &&
+                    overlapped == nullptr)
+                    break;
+                --mPending;
+            }
+        }
+
+        if (mCompletionPort)
+            CloseHandle(mCompletionPort);
+    }
+
+    bool Win32AsyncFileChannel::IsUnsupported(uint32_t errorCode) noexcept {
+        return errorCode == ERROR_INVALID_PARAMETER ||
+            errorCode == ERROR_NOT_SUPPORTED ||
+            errorCode == ERROR_INVALID_FUNCTION;
+    }
+
+    uint32_t Win32AsyncFileChannel::QuerySectorAlignment(HANDLE hFile) noexcept {
+        FILE_STORAGE_INFO storage{};
+        if (!GetFileInformationByHandleEx(hFile, FileStorageInfo, &storage, sizeof(storage)))
+            return kDefaultAlignment;
+
+        const uint32_t sector = (std::max)(
+            static_cast<uint32_t>(storage.LogicalBytesPerSector),
+            static_cast<uint32_t>(storage.PhysicalBytesPerSectorForPerformance));
+        return sector != 0 && (sector & (sector - 1)) == 0 ? sector : kDefaultAlignment;
+    }
+
+    domain::Expected<void> Win32AsyncFileChannel::SubmitRead(
+        uint32_t slot,
+        uint64_t offset,
+        void* buffer,
+        uint32_t length
+    ) {
+        return Submit(slot, AsyncFileOperation::Read, offset, buffer, length);
+    }
+
+    domain::Expected<void> Win32AsyncFileChannel::SubmitWrite(
+        uint32_t slot,
+        uint64_t offset,
+        const void* buffer,
+        uint32_t length
+    ) {
+        return Submit(slot, AsyncFileOperation::Write, offset, const_cast<void*>(buffer), length);
+    }
+
+    domain::Expected<void> Win32AsyncFileChannel::Submit(
+        uint32_t slot,
+        AsyncFileOperation operation,
+        uint64_t offset,
+        void* buffer,
+        uint32_t length
+    ) {
+        if (slot >= mRequests.size())
+            return ChannelError(L"Asynchronous file slot out of range", ERROR_INVALID_PARAMETER);
+
+        Request& request = mRequests[slot];
+        request = Request{};
+        request.slot = slot;
+        request.operation = operation;
+        request.overlapped.Offset = static_cast<DWORD>(offset);
+        request.overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+        const BOOL issued = operation == AsyncFileOperation::Read
+            ? ReadFile(Win32HandleFactory::ToWin32Handle(mSource), buffer, length, nullptr, &request.overlapped)
+            : WriteFile(Win32HandleFactory::ToWin32Handle(mDestination), buffer, length, nullptr, &request.overlapped);
+
+        if (!issued) {
+            const DWORD error = GetLastError();
+            if (error == ERROR_HANDLE_EOF) {
+                mImmediate.push_back({ slot, operation, 0, 0 });
+                return domain::Expected<void>();
+            }
+            if (error != ERROR_IO_PENDING) {
+                return ChannelError(operation == AsyncFileOperation::Read
+                    ? L"Failed to queue read" : L"Failed to queue write", error);
+            }
+        }
+
+        ++mPending;
+        return domain::Expected<void>();
+    }
+
+    domain::Expected<AsyncFileCompletion> Win32AsyncFileChannel::WaitForCompletion() {
+        if (!mImmediate.empty()) {
+            AsyncFileCompletion completion = mImmediate.front();
+            mImmediate.pop_front();
+            return completion;
+        }
+
+        DWORD       bytes = 0;
+        ULONG_PTR   key = 0;
+        OVERLAPPED* overlapped = nullptr;
+        const BOOL ok = GetQueuedCompletionStatus(mCompletionPort, &bytes, &key, &overlapped, INFINITE);
+        if (overlapped == nullptr)
+            return ChannelError(L"Completion port wait failed", GetLastError());
+
+        --mPending;
+        const Request& request = *reinterpret_cast<const Request*>(overlapped);
+
+        AsyncFileCompletion completion;
+        completion.slot = request.slot;
+        completion.operation = request.operation;
+        completion.bytesTransferred = bytes;
+        if (!ok) {
+            const DWORD error = GetLastError();
+            completion.errorCode = error == ERROR_HANDLE_EOF ? 0 : error;
+        }
+        return completion;
+    }
+
+    domain::Expected<void> Win32AsyncFileChannel::SetDestinationLength(uint64_t length) {
+        FILE_END_OF_FILE_INFO endOfFile{};
+        endOfFile.EndOfFile.QuadPart = static_cast<LONGLONG>(length);
+        if (!SetFileInformationByHandle(Win32HandleFactory::ToWin32Handle(mDestination),
+            FileEndOfFileInfo, &endOfFile, sizeof(endOfFile)))
+            return ChannelError(L"Failed to set destination length", GetLastError());
+        return domain::Expected<void>();
+    }
+
+    void Win32AsyncFileChannel::CancelPending() noexcept {
+        CancelIoEx(Win32HandleFactory::ToWin32Handle(mSource), nullptr);
+        CancelIoEx(Win32HandleFactory::ToWin32Handle(mDestination), nullptr);
+    }
+
+    void Win32AsyncFileChannel::CopyFileTimes() noexcept {
+        FILETIME creation{}, access{}, write{};
+        if (GetFileTime(Win32HandleFactory::ToWin32Handle(mSource), &creation, &access, &write))
+            SetFileTime(Win32HandleFactory::ToWin32Handle(mDestination), &creation, &access, &write);
+    }
+
+}
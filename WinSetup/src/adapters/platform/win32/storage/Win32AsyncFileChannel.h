@@ -0,0 +1,108 @@
+﻿#pragma once
+
+#include <domain/primitives/Expected.h>
+#include <adapters/platform/win32/memory/UniqueHandle.h>
+#include <adapters/platform/win32/storage/AsyncFileChannel.h>
+#include <Windows.h>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace winsetup::adapters::platform {
+
+    // IAsyncFileChannel over a FILE_FLAG_NO_BUFFERING | FILE_FLAG_OVERLAPPED
+    // file pair sharing one I/O completion port. The destination is created
+    // write-through. When the process holds SeManageVolumePrivilege it is
+    // pre-sized and its valid data length set to match, so queued writes
+    // land anywhere without NTFS zero-filling the gap first. Otherwise the
+    // file is not pre-extended and RequiresOrderedWrites() asks the ring to
+    // write in offset order from the valid data length. With
+    // createDestination off it opens an existing destination shared with
+    // other channels; validDataPreset says whose valid data length already
+    // covers the whole file, which only holds for PrepareSplitDestination.
+    class Win32AsyncFileChannel final : public IAsyncFileChannel {
+    public:
+        [[nodiscard]] static domain::Expected<std::unique_ptr<Win32AsyncFileChannel>> Open(
+            const std::wstring& srcPath,
+            const std::wstring& dstPath,
+            uint64_t fileSize,
+            uint32_t queueDepth,
+            bool createDestination = true,
+            bool validDataPreset = false
+        );
+
+        ~Win32AsyncFileChannel() override;
+
+        Win32AsyncFileChannel(const Win32AsyncFileChannel&) = delete;
+        Win32AsyncFileChannel& operator=(const Win32AsyncFileChannel&) = delete;
+
+        [[nodiscard]] uint32_t GetAlignment() const noexcept override { return mAlignment; }
+
+        [[nodiscard]] domain::Expected<void> SubmitRead(
+            uint32_t slot,
+            uint64_t offset,
+            void* buffer,
+            uint32_t length
+        ) override;
+
+        [[nodiscard]] domain::Expected<void> SubmitWrite(
+            uint32_t slot,
+            uint64_t offset,
+            const void* buffer,
+            uint32_t length
+        ) override;
+
+        [[nodiscard]] domain::Expected<AsyncFileCompletion> WaitForCompletion() override;
+
+        [[nodiscard]] bool RequiresOrderedWrites() const noexcept override { return mOrderedWrites; }
+
+        [[nodiscard]] domain::Expected<void> SetDestinationLength(uint64_t length) override;
+
+        void CancelPending() noexcept override;
+
+        void CopyFileTimes() noexcept;
+
+        // Errors from Open() that mean the volume or redirector refuses
+        // unbuffered I/O, so a buffered copy should be tried instead.
+        [[nodiscard]] static bool IsUnsupported(uint32_t errorCode) noexcept;
+
+        // Enables SeManageVolumePrivilege on first use. False means new
+        // destinations are written in order instead of having their valid
+        // data length set up front.
+        [[nodiscard]] static bool CanPresetValidData() noexcept;
+
+    private:
+        struct Request {
+            OVERLAPPED         overlapped{};
+            uint32_t           slot = 0;
+            AsyncFileOperation operation = AsyncFileOperation::Read;
+        };
+
+        Win32AsyncFileChannel(UniqueHandle source, UniqueHandle destination, uint32_t queueDepth);
+
+        [[nodiscard]] domain::Expected<void> Submit(
+            uint32_t slot,
+            AsyncFileOperation operation,
+            uint64_t offset,
+            void* buffer,
+            uint32_t length
+        );
+
+        [[nodiscard]] static uint32_t QuerySectorAlignment(HANDLE hFile) noexcept;
+
+        [[nodiscard]] static bool PresetValidData(HANDLE hFile, uint64_t length) noexcept;
+
+        static constexpr uint32_t kDefaultAlignment = 4096;
+
+        UniqueHandle                    mSource;
+        UniqueHandle                    mDestination;
+        HANDLE                          mCompletionPort = nullptr;
+        uint32_t                        mAlignment = kDefaultAlignment;
+        uint32_t                        mPending = 0;
+        bool                            mOrderedWrites = true;
+        std::vector<Request>            mRequests;
+        std::deque<AsyncFileCompletion> mImmediate;
+    };
+
+}
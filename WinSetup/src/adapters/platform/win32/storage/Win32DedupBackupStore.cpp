@@ -0,0 +1,942 @@
+#include "Win32DedupBackupStore.h"
+#include "adapters/platform/win32/core/Win32HandleFactory.h"
+#include "adapters/platform/win32/core/Win32Privilege.h"
+#include "adapters/platform/win32/storage/CopyDigest.h"
+#include "domain/primitives/Error.h"
+#include <Windows.h>
+#include <bcrypt.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <cwchar>
+
+#pragma comment(lib, "bcrypt.lib")
+
+namespace winsetup::adapters::platform {
+
+    namespace {
+        namespace abs = winsetup::abstractions;
+        namespace dom = winsetup::domain;
+
+        constexpr uint32_t k_indexMagic = 0x49584442;   // "BDXI"
+        constexpr uint32_t k_treeMagic = 0x45525442;    // "BTRE"
+        constexpr uint32_t k_indexVersion = 2;
+        constexpr uint32_t k_treeVersion = 3;
+        constexpr DWORD    k_settableAttributes = FILE_ATTRIBUTE_READONLY | FILE_ATTRIBUTE_HIDDEN
+            | FILE_ATTRIBUTE_SYSTEM | FILE_ATTRIBUTE_ARCHIVE | FILE_ATTRIBUTE_NOT_CONTENT_INDEXED;
+
+        struct IndexHeader {
+            uint32_t magic;
+            uint32_t version;
+        };
+
+        struct IndexRecord {
+            uint8_t  id[32];
+            uint64_t offset;
+            uint32_t length;
+            uint32_t checksum;
+        };
+        static_assert(sizeof(IndexRecord) == 48, "chunks.idx record layout changed");
+
+        struct TreeHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t entryCount;
+            uint32_t reserved;
+            uint64_t chunkRefCount;
+            uint64_t nameLength;
+            uint64_t bodyHash;
+        };
+        static_assert(sizeof(TreeHeader) == 40, "tree header layout changed");
+
+        uint32_t RecordChecksum(const IndexRecord& record) noexcept {
+            return static_cast<uint32_t>(Xxh64::Hash(&record, offsetof(IndexRecord, checksum)));
+        }
+
+        uint64_t FromFileTime(const FILETIME& time) noexcept {
+            return (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+        }
+
+        FILETIME ToFileTime(uint64_t time) noexcept {
+            FILETIME result{};
+            result.dwLowDateTime = static_cast<DWORD>(time);
+            result.dwHighDateTime = static_cast<DWORD>(time >> 32);
+            return result;
+        }
+
+        bool WriteAll(HANDLE handle, const void* data, size_t length) noexcept {
+            const auto* cursor = static_cast<const uint8_t*>(data);
+            while (length > 0) {
+                const DWORD request = static_cast<DWORD>((std::min)(length, static_cast<size_t>(1u << 30)));
+                DWORD written = 0;
+                if (!WriteFile(handle, cursor, request, &written, nullptr) || written == 0)
+                    return false;
+                cursor += written;
+                length -= written;
+            }
+            return true;
+        }
+
+        bool ReadAt(HANDLE handle, uint64_t offset, void* data, uint32_t length) noexcept {
+            OVERLAPPED position{};
+            position.Offset = static_cast<DWORD>(offset);
+            position.OffsetHigh = static_cast<DWORD>(offset >> 32);
+            DWORD read = 0;
+            return ReadFile(handle, data, length, &read, &position) && read == length;
+        }
+
+        bool ReadWholeFile(HANDLE handle, std::vector<uint8_t>& contents) {
+            LARGE_INTEGER size{};
+            if (!GetFileSizeEx(handle, &size) || size.QuadPart > 0x7FFFFFFF)
+                return false;
+            contents.resize(static_cast<size_t>(size.QuadPart));
+            return contents.empty() || ReadAt(handle, 0, contents.data(), static_cast<uint32_t>(contents.size()));
+        }
+
+        bool SeekTo(HANDLE handle, uint64_t offset, bool truncate) noexcept {
+            LARGE_INTEGER position{};
+            position.QuadPart = static_cast<LONGLONG>(offset);
+            if (!SetFilePointerEx(handle, position, nullptr, FILE_BEGIN)) return false;
+            return !truncate || SetEndOfFile(handle);
+        }
+
+        void ApplyAttributes(const std::wstring& path, uint32_t attributes) noexcept {
+            const DWORD settable = attributes & k_settableAttributes;
+            if (settable != 0 && settable != FILE_ATTRIBUTE_ARCHIVE)
+                SetFileAttributesW(path.c_str(), settable);
+        }
+    }
+
+    Win32DedupBackupStore::Win32DedupBackupStore(
+        std::shared_ptr<abs::ILogger> logger,
+        const ContentChunkerPolicy& policy
+    )
+        : m_logger(std::move(logger))
+        , m_chunker(policy)
+    {
+    }
+
+    dom::Expected<abs::BackupStoreStats> Win32DedupBackupStore::Backup(
+        const std::wstring& storeDir,
+        const std::wstring& name,
+        const std::wstring& sourceDir
+    ) {
+        std::lock_guard lock(m_storeMutex);
+        m_cancelled.store(false);
+
+        if (storeDir.empty() || name.empty() || sourceDir.empty())
+            return dom::Error(L"Backup store, name and source must not be empty",
+                ERROR_INVALID_PARAMETER, dom::ErrorCategory::Validation);
+
+        abs::BackupStoreStats stats;
+        const std::wstring treePath = TreePath(storeDir, name);
+
+        // A target that is gone has nothing to restore either; dropping the
+        // old tree keeps a stale copy from coming back.
+        const DWORD sourceAttributes = GetFileAttributesW(sourceDir.c_str());
+        if (sourceAttributes == INVALID_FILE_ATTRIBUTES || !(sourceAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+            DeleteFileW(treePath.c_str());
+            if (m_logger)
+                m_logger->Info(L"Backup source not found, nothing to back up: " + sourceDir);
+            return stats;
+        }
+
+        // Lets FILE_FLAG_BACKUP_SEMANTICS and the directory listing get
+        // past ACLs that deny the administrator, as on other profiles.
+        if (!Win32Privilege::Enable(SE_BACKUP_NAME) && m_logger)
+            m_logger->Warning(L"Backup runs without SeBackupPrivilege; protected files will be reported as skipped");
+
+        auto created = EnsureDirectory(storeDir);
+        if (!created.HasValue()) return created.GetError();
+
+        ChunkStore store;
+        auto opened = OpenChunkStore(storeDir, true, store);
+        if (!opened.HasValue()) return opened.GetError();
+
+        struct PendingDirectory {
+            std::wstring path;
+            uint32_t     entry;
+        };
+
+        BackupTree tree;
+        TreeEntry root;
+        root.parent = k_noParent;
+        root.attributes = sourceAttributes;
+        tree.entries.push_back(root);
+
+        std::vector<PendingDirectory> walk;
+        walk.push_back({ sourceDir, 0 });
+
+        while (!walk.empty()) {
+            PendingDirectory dir = std::move(walk.back());
+            walk.pop_back();
+
+            WIN32_FIND_DATAW findData{};
+            auto hFind = Win32HandleFactory::MakeFindHandle(
+                FindFirstFileExW((dir.path + L"\\*").c_str(),
+                    FindExInfoBasic,
+                    &findData,
+                    FindExSearchNameMatch,
+                    nullptr,
+                    FIND_FIRST_EX_LARGE_FETCH));
+            if (!hFind) {
+                if (m_logger)
+                    m_logger->Error(L"Backup skipped unreadable directory (error "
+                        + std::to_wstring(GetLastError()) + L"): " + dir.path);
+                ++stats.skippedFiles;
+                continue;
+            }
+
+            do {
+                auto cancelled = CheckCancelled();
+                if (!cancelled.HasValue()) return cancelled.GetError();
+
+                const std::wstring childName = findData.cFileName;
+                if (childName == L"." || childName == L"..") continue;
+
+                TreeEntry entry;
+                entry.parent = dir.entry;
+                entry.attributes = findData.dwFileAttributes;
+                entry.creationTime = FromFileTime(findData.ftCreationTime);
+                entry.lastAccessTime = FromFileTime(findData.ftLastAccessTime);
+                entry.lastWriteTime = FromFileTime(findData.ftLastWriteTime);
+                entry.nameLength = static_cast<uint32_t>(childName.size());
+
+                std::wstring childPath = dir.path + L"\\" + childName;
+
+                if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+                    // Profile junctions point back into the profile itself.
+                    if (findData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) continue;
+
+                    walk.push_back({ std::move(childPath), static_cast<uint32_t>(tree.entries.size()) });
+                    tree.entries.push_back(entry);
+                    tree.names += childName;
+                    ++stats.directories;
+                    continue;
+                }
+
+                const size_t refsBefore = tree.chunkRefs.size();
+                auto backedUp = BackupFile(childPath, store, entry, tree.chunkRefs, stats);
+                if (!backedUp.HasValue()) return backedUp.GetError();
+                if (!backedUp.Value()) {
+                    tree.chunkRefs.resize(refsBefore);
+                    ++stats.skippedFiles;
+                    continue;
+                }
+
+                tree.entries.push_back(entry);
+                tree.names += childName;
+                ++stats.files;
+            } while (FindNextFileW(
+                Win32HandleFactory::ToWin32FindHandle(hFind), &findData));
+        }
+
+        auto committed = CommitChunkStore(store);
+        if (!committed.HasValue()) return committed.GetError();
+
+        auto written = WriteTree(treePath, tree);
+        if (!written.HasValue()) return written.GetError();
+
+        if (m_logger) {
+            m_logger->Info(L"Backup '" + name + L"': " + std::to_wstring(stats.files) + L" files, "
+                + std::to_wstring(stats.bytesRead) + L" bytes read, "
+                + std::to_wstring(stats.bytesWritten) + L" bytes stored, "
+                + std::to_wstring(stats.duplicateChunks) + L" of "
+                + std::to_wstring(stats.chunks + stats.duplicateChunks) + L" chunks already in store");
+        }
+
+        return stats;
+    }
+
+    dom::Expected<abs::BackupStoreStats> Win32DedupBackupStore::Restore(
+        const std::wstring& storeDir,
+        const std::wstring& name,
+        const std::wstring& targetDir
+    ) {
+        std::lock_guard lock(m_storeMutex);
+        m_cancelled.store(false);
+
+        if (storeDir.empty() || name.empty() || targetDir.empty())
+            return dom::Error(L"Backup store, name and target must not be empty",
+                ERROR_INVALID_PARAMETER, dom::ErrorCategory::Validation);
+
+        ChunkStore store;
+        auto opened = OpenChunkStore(storeDir, false, store);
+        if (!opened.HasValue()) return opened.GetError();
+
+        auto treeResult = ReadTree(TreePath(storeDir, name), store.chunks.size());
+        if (!treeResult.HasValue()) return treeResult.GetError();
+        const BackupTree& tree = treeResult.Value();
+
+        auto created = EnsureDirectory(targetDir);
+        if (!created.HasValue()) return created.GetError();
+
+        abs::BackupStoreStats stats;
+        std::vector<std::wstring> directoryPaths(tree.entries.size());
+        directoryPaths[0] = targetDir;
+
+        uint64_t refCursor = 0;
+        size_t nameCursor = 0;
+        uint64_t failedFiles = 0;
+        DWORD lastFailure = ERROR_SUCCESS;
+
+        for (size_t i = 1; i < tree.entries.size(); ++i) {
+            const TreeEntry& entry = tree.entries[i];
+            std::wstring path = directoryPaths[entry.parent] + L"\\"
+                + tree.names.substr(nameCursor, entry.nameLength);
+            nameCursor += entry.nameLength;
+
+            if (entry.attributes & FILE_ATTRIBUTE_DIRECTORY) {
+                if (!CreateDirectoryW(path.c_str(), nullptr)) {
+                    const DWORD err = GetLastError();
+                    if (err != ERROR_ALREADY_EXISTS)
+                        return dom::Error(L"Failed to create directory: " + path, err, dom::ErrorCategory::IO);
+                }
+                directoryPaths[i] = std::move(path);
+                ++stats.directories;
+                continue;
+            }
+
+            auto restored = RestoreFile(path, entry, tree.chunkRefs.data() + refCursor, store, stats);
+            refCursor += entry.chunkCount;
+            if (!restored.HasValue()) {
+                if (m_cancelled.load()) return restored.GetError();
+                if (m_logger)
+                    m_logger->Error(L"Restore failed for " + path + L": " + restored.GetError().GetMessage());
+                lastFailure = restored.GetError().GetCode();
+                ++failedFiles;
+                continue;
+            }
+            ++stats.files;
+        }
+
+        // Directory times last: creating their children changed them.
+        for (size_t i = tree.entries.size(); i-- > 1;) {
+            const TreeEntry& entry = tree.entries[i];
+            if (!(entry.attributes & FILE_ATTRIBUTE_DIRECTORY)) continue;
+
+            auto hDir = Win32HandleFactory::MakeHandle(
+                CreateFileW(directoryPaths[i].c_str(),
+                    FILE_WRITE_ATTRIBUTES,
+                    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                    nullptr,
+                    OPEN_EXISTING,
+                    FILE_FLAG_BACKUP_SEMANTICS,
+                    nullptr));
+            if (hDir) {
+                const FILETIME ctime = ToFileTime(entry.creationTime);
+                const FILETIME atime = ToFileTime(entry.lastAccessTime);
+                const FILETIME wtime = ToFileTime(entry.lastWriteTime);
+                SetFileTime(Win32HandleFactory::ToWin32Handle(hDir), &ctime, &atime, &wtime);
+            }
+            ApplyAttributes(directoryPaths[i], entry.attributes);
+        }
+
+        if (m_logger) {
+            m_logger->Info(L"Restore '" + name + L"': " + std::to_wstring(stats.files) + L" files, "
+                + std::to_wstring(stats.bytesWritten) + L" bytes written");
+        }
+
+        if (failedFiles > 0)
+            return dom::Error(std::to_wstring(failedFiles) + L" files could not be restored from backup '" + name + L"'",
+                lastFailure, dom::ErrorCategory::IO);
+
+        return stats;
+    }
+
+    dom::Expected<abs::BackupStoreStats> Win32DedupBackupStore::Verify(
+        const std::wstring& storeDir,
+        const std::wstring& name,
+        const std::wstring& targetDir
+    ) {
+        std::lock_guard lock(m_storeMutex);
+        m_cancelled.store(false);
+
+        if (storeDir.empty() || name.empty() || targetDir.empty())
+            return dom::Error(L"Backup store, name and target must not be empty",
+                ERROR_INVALID_PARAMETER, dom::ErrorCategory::Validation);
+
+        ChunkStore store;
+        auto opened = OpenChunkStore(storeDir, false, store);
+        if (!opened.HasValue()) return opened.GetError();
+
+        auto treeResult = ReadTree(TreePath(storeDir, name), store.chunks.size());
+        if (!treeResult.HasValue()) return treeResult.GetError();
+        const BackupTree& tree = treeResult.Value();
+
+        abs::BackupStoreStats stats;
+        std::vector<std::wstring> directoryPaths(tree.entries.size());
+        directoryPaths[0] = targetDir;
+        size_t nameCursor = 0;
+
+        for (size_t i = 1; i < tree.entries.size(); ++i) {
+            auto cancelled = CheckCancelled();
+            if (!cancelled.HasValue()) return cancelled.GetError();
+
+            const TreeEntry& entry = tree.entries[i];
+            std::wstring path = directoryPaths[entry.parent] + L"\\"
+                + tree.names.substr(nameCursor, entry.nameLength);
+            nameCursor += entry.nameLength;
+
+            if (entry.attributes & FILE_ATTRIBUTE_DIRECTORY) {
+                directoryPaths[i] = std::move(path);
+                ++stats.directories;
+                continue;
+            }
+
+            uint64_t size = 0;
+            uint64_t hash = 0;
+            if (!HashRestoredFile(path, size, hash)) {
+                if (m_logger)
+                    m_logger->Error(L"Verify cannot read restored file (error "
+                        + std::to_wstring(GetLastError()) + L"): " + path);
+                ++stats.mismatchedFiles;
+                continue;
+            }
+            stats.bytesRead += size;
+            if (size != entry.size || hash != entry.contentHash) {
+                if (m_logger)
+                    m_logger->Error(L"Restored file differs from its backup: " + path);
+                ++stats.mismatchedFiles;
+                continue;
+            }
+            ++stats.files;
+        }
+
+        if (m_logger) {
+            m_logger->Info(L"Verify '" + name + L"': " + std::to_wstring(stats.files) + L" files match, "
+                + std::to_wstring(stats.mismatchedFiles) + L" differ");
+        }
+
+        return stats;
+    }
+
+    bool Win32DedupBackupStore::HasBackup(
+        const std::wstring& storeDir,
+        const std::wstring& name
+    ) const {
+        const DWORD attributes = GetFileAttributesW(TreePath(storeDir, name).c_str());
+        return attributes != INVALID_FILE_ATTRIBUTES && !(attributes & FILE_ATTRIBUTE_DIRECTORY);
+    }
+
+    void Win32DedupBackupStore::Cancel() noexcept {
+        m_cancelled.store(true);
+    }
+
+    dom::Expected<void> Win32DedupBackupStore::OpenChunkStore(
+        const std::wstring& storeDir,
+        bool writable,
+        ChunkStore& store
+    ) {
+        const std::wstring indexPath = storeDir + L"\\chunks.idx";
+        const std::wstring packPath = storeDir + L"\\chunks.pack";
+        const DWORD access = writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ;
+        const DWORD disposition = writable ? OPEN_ALWAYS : OPEN_EXISTING;
+
+        store.index = Win32HandleFactory::MakeHandle(
+            CreateFileW(indexPath.c_str(), access, FILE_SHARE_READ, nullptr, disposition,
+                FILE_ATTRIBUTE_NORMAL, nullptr));
+        if (!store.index)
+            return dom::Error(L"Failed to open backup chunk index: " + indexPath,
+                GetLastError(), dom::ErrorCategory::IO);
+
+        store.pack = Win32HandleFactory::MakeHandle(
+            CreateFileW(packPath.c_str(), access, FILE_SHARE_READ, nullptr, disposition,
+                FILE_ATTRIBUTE_NORMAL, nullptr));
+        if (!store.pack)
+            return dom::Error(L"Failed to open backup chunk pack: " + packPath,
+                GetLastError(), dom::ErrorCategory::IO);
+
+        const HANDLE hIndex = Win32HandleFactory::ToWin32Handle(store.index);
+        const HANDLE hPack = Win32HandleFactory::ToWin32Handle(store.pack);
+
+        std::vector<uint8_t> contents;
+        LARGE_INTEGER packSize{};
+        if (!ReadWholeFile(hIndex, contents) || !GetFileSizeEx(hPack, &packSize))
+            return dom::Error(L"Failed to read backup chunk index: " + indexPath,
+                GetLastError(), dom::ErrorCategory::IO);
+
+        if (contents.empty()) {
+            if (!writable)
+                return dom::Error(L"Backup chunk index is empty: " + indexPath,
+                    ERROR_FILE_CORRUPT, dom::ErrorCategory::Validation);
+
+            const IndexHeader header{ k_indexMagic, k_indexVersion };
+            if (!WriteAll(hIndex, &header, sizeof(header)))
+                return dom::Error(L"Failed to write backup chunk index: " + indexPath,
+                    GetLastError(), dom::ErrorCategory::IO);
+            contents.resize(sizeof(header));
+            std::memcpy(contents.data(), &header, sizeof(header));
+        }
+
+        IndexHeader header{};
+        if (contents.size() < sizeof(header))
+            return dom::Error(L"Backup chunk index is truncated: " + indexPath,
+                ERROR_FILE_CORRUPT, dom::ErrorCategory::Validation);
+        std::memcpy(&header, contents.data(), sizeof(header));
+        if (header.magic != k_indexMagic || header.version != k_indexVersion)
+            return dom::Error(L"Not a backup chunk index: " + indexPath,
+                ERROR_FILE_CORRUPT, dom::ErrorCategory::Validation);
+
+        // Records are appended in pack order, so each must start where the
+        // last ended; the first one that does not, or whose bytes never
+        // reached the pack, ends the valid index.
+        const size_t recordCount = (contents.size() - sizeof(header)) / sizeof(IndexRecord);
+        store.chunks.reserve(recordCount);
+        for (size_t i = 0; i < recordCount; ++i) {
+            IndexRecord record{};
+            std::memcpy(&record, contents.data() + sizeof(header) + i * sizeof(IndexRecord), sizeof(record));
+            if (record.checksum != RecordChecksum(record) ||
+                record.offset != store.packEnd ||
+                record.length == 0 || record.length > m_chunker.GetMaxSize() ||
+                record.offset + record.length > static_cast<uint64_t>(packSize.QuadPart))
+                break;
+
+            ChunkLocation location{ {}, record.offset, record.length };
+            std::memcpy(location.id.digest.data(), record.id, sizeof(record.id));
+            store.chunks.push_back(location);
+            store.packEnd = record.offset + record.length;
+        }
+
+        if (!writable) return dom::Expected<void>();
+
+        const uint64_t indexEnd = sizeof(header) + store.chunks.size() * sizeof(IndexRecord);
+        const bool tornIndex = indexEnd != contents.size();
+        const bool tornPack = store.packEnd != static_cast<uint64_t>(packSize.QuadPart);
+        if ((tornIndex || tornPack) && m_logger)
+            m_logger->Warning(L"Backup store had an interrupted write; trimmed to "
+                + std::to_wstring(store.chunks.size()) + L" chunks: " + storeDir);
+
+        if (!SeekTo(hIndex, indexEnd, tornIndex) || !SeekTo(hPack, store.packEnd, tornPack))
+            return dom::Error(L"Failed to trim backup store: " + storeDir,
+                GetLastError(), dom::ErrorCategory::IO);
+
+        store.lookup.reserve(store.chunks.size());
+        for (uint32_t i = 0; i < store.chunks.size(); ++i)
+            store.lookup.emplace(store.chunks[i].id, i);
+
+        return dom::Expected<void>();
+    }
+
+    dom::Expected<void> Win32DedupBackupStore::CommitChunkStore(ChunkStore& store) {
+        if (store.pendingRecords.empty()) return dom::Expected<void>();
+
+        if (!FlushFileBuffers(Win32HandleFactory::ToWin32Handle(store.pack)))
+            return dom::Error(L"Failed to flush backup chunk pack",
+                GetLastError(), dom::ErrorCategory::IO);
+
+        std::vector<IndexRecord> records;
+        records.reserve(store.pendingRecords.size());
+        for (const ChunkLocation& chunk : store.pendingRecords) {
+            IndexRecord record{ {}, chunk.offset, chunk.length, 0 };
+            std::memcpy(record.id, chunk.id.digest.data(), sizeof(record.id));
+            record.checksum = RecordChecksum(record);
+            records.push_back(record);
+        }
+
+        const HANDLE hIndex = Win32HandleFactory::ToWin32Handle(store.index);
+        if (!WriteAll(hIndex, records.data(), records.size() * sizeof(IndexRecord)) ||
+            !FlushFileBuffers(hIndex))
+            return dom::Error(L"Failed to write backup chunk index",
+                GetLastError(), dom::ErrorCategory::IO);
+
+        store.pendingRecords.clear();
+        return dom::Expected<void>();
+    }
+
+    dom::Expected<bool> Win32DedupBackupStore::BackupFile(
+        const std::wstring& path,
+        ChunkStore& store,
+        TreeEntry& entry,
+        std::vector<uint32_t>& chunkRefs,
+        abs::BackupStoreStats& stats
+    ) {
+        auto hFile = Win32HandleFactory::MakeHandle(
+            CreateFileW(path.c_str(),
+                GENERIC_READ,
+                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                nullptr,
+                OPEN_EXISTING,
+                FILE_FLAG_SEQUENTIAL_SCAN | FILE_FLAG_BACKUP_SEMANTICS,
+                nullptr));
+        if (!hFile) {
+            if (m_logger)
+                m_logger->Error(L"Backup skipped file that cannot be opened (error "
+                    + std::to_wstring(GetLastError()) + L"): " + path);
+            return false;
+        }
+
+        if (m_buffer.size() < k_readSize)
+            m_buffer.resize(k_readSize);
+
+        // Chunks are cut from the front of the buffer; the tail is topped up
+        // whenever less than a maximum chunk is left, so every cut sees the
+        // same bytes it would in a single pass over the file.
+        const size_t maxChunk = m_chunker.GetMaxSize();
+        const size_t refsBefore = chunkRefs.size();
+        size_t begin = 0;
+        size_t end = 0;
+        bool eof = false;
+        uint64_t total = 0;
+        Xxh64 content;
+
+        while (true) {
+            if (!eof && end - begin < maxChunk) {
+                std::memmove(m_buffer.data(), m_buffer.data() + begin, end - begin);
+                end -= begin;
+                begin = 0;
+
+                DWORD bytesRead = 0;
+                if (!ReadFile(Win32HandleFactory::ToWin32Handle(hFile),
+                    m_buffer.data() + end, static_cast<DWORD>(m_buffer.size() - end), &bytesRead, nullptr)) {
+                    if (m_logger)
+                        m_logger->Error(L"Backup skipped file that failed to read (error "
+                            + std::to_wstring(GetLastError()) + L"): " + path);
+                    return false;
+                }
+                if (bytesRead == 0) eof = true;
+                content.Update(m_buffer.data() + end, bytesRead);
+                end += bytesRead;
+                total += bytesRead;
+                stats.bytesRead += bytesRead;
+                continue;
+            }
+
+            if (begin == end) break;
+
+            const size_t cut = m_chunker.FindCut(m_buffer.data() + begin, end - begin, eof);
+            auto added = AddChunk(m_buffer.data() + begin, static_cast<uint32_t>(cut), store, chunkRefs, stats);
+            if (!added.HasValue()) return added.GetError();
+            begin += cut;
+        }
+
+        entry.size = total;
+        entry.contentHash = content.Digest();
+        entry.chunkCount = static_cast<uint32_t>(chunkRefs.size() - refsBefore);
+        return true;
+    }
+
+    dom::Expected<void> Win32DedupBackupStore::AddChunk(
+        const uint8_t* data,
+        uint32_t length,
+        ChunkStore& store,
+        std::vector<uint32_t>& chunkRefs,
+        abs::BackupStoreStats& stats
+    ) {
+        auto cancelled = CheckCancelled();
+        if (!cancelled.HasValue()) return cancelled;
+
+        ChunkId id;
+        if (!HashChunk(data, length, id))
+            return dom::Error(L"Failed to hash backup chunk", ERROR_INVALID_FUNCTION, dom::ErrorCategory::System);
+
+        const auto found = store.lookup.find(id);
+        if (found != store.lookup.end()) {
+            chunkRefs.push_back(found->second);
+            ++stats.duplicateChunks;
+            return dom::Expected<void>();
+        }
+
+        if (!WriteAll(Win32HandleFactory::ToWin32Handle(store.pack), data, length))
+            return dom::Error(L"Failed to write backup chunk pack",
+                GetLastError(), dom::ErrorCategory::IO);
+
+        const uint32_t ordinal = static_cast<uint32_t>(store.chunks.size());
+        const ChunkLocation location{ id, store.packEnd, length };
+        store.chunks.push_back(location);
+        store.pendingRecords.push_back(location);
+        store.lookup.emplace(id, ordinal);
+        store.packEnd += length;
+
+        chunkRefs.push_back(ordinal);
+        ++stats.chunks;
+        stats.bytesWritten += length;
+        return dom::Expected<void>();
+    }
+
+    dom::Expected<void> Win32DedupBackupStore::RestoreFile(
+        const std::wstring& path,
+        const TreeEntry& entry,
+        const uint32_t* chunkRefs,
+        ChunkStore& store,
+        abs::BackupStoreStats& stats
+    ) {
+        // A read-only file left from an earlier restore would refuse
+        // CREATE_ALWAYS.
+        SetFileAttributesW(path.c_str(), FILE_ATTRIBUTE_NORMAL);
+
+        auto hFile = Win32HandleFactory::MakeHandle(
+            CreateFileW(path.c_str(),
+                GENERIC_WRITE,
+                0,
+                nullptr,
+                CREATE_ALWAYS,
+                FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+                nullptr));
+        if (!hFile)
+            return dom::Error(L"Failed to create file: " + path, GetLastError(), dom::ErrorCategory::IO);
+
+        const HANDLE hDst = Win32HandleFactory::ToWin32Handle(hFile);
+        if (entry.size > 0 && (!SeekTo(hDst, entry.size, true) || !SeekTo(hDst, 0, false)))
+            return dom::Error(L"Failed to allocate file: " + path, GetLastError(), dom::ErrorCategory::IO);
+
+        if (m_buffer.size() < k_readSize)
+            m_buffer.resize(k_readSize);
+
+        uint64_t written = 0;
+        for (uint32_t i = 0; i < entry.chunkCount; ++i) {
+            auto cancelled = CheckCancelled();
+            if (!cancelled.HasValue()) return cancelled;
+
+            const ChunkLocation& chunk = store.chunks[chunkRefs[i]];
+            if (!ReadAt(Win32HandleFactory::ToWin32Handle(store.pack), chunk.offset, m_buffer.data(), chunk.length))
+                return dom::Error(L"Failed to read backup chunk " + std::to_wstring(chunkRefs[i]),
+                    GetLastError(), dom::ErrorCategory::IO);
+            stats.bytesRead += chunk.length;
+
+            ChunkId id;
+            if (!HashChunk(m_buffer.data(), chunk.length, id) || id != chunk.id)
+                return dom::Error(L"Backup chunk " + std::to_wstring(chunkRefs[i]) + L" failed verification",
+                    ERROR_CRC, dom::ErrorCategory::IO);
+
+            if (!WriteAll(hDst, m_buffer.data(), chunk.length))
+                return dom::Error(L"Write failed: " + path, GetLastError(), dom::ErrorCategory::IO);
+            written += chunk.length;
+            stats.bytesWritten += chunk.length;
+        }
+
+        if (written != entry.size)
+            return dom::Error(L"Backup chunks do not add up to the file size: " + path,
+                ERROR_FILE_CORRUPT, dom::ErrorCategory::Validation);
+
+        const FILETIME ctime = ToFileTime(entry.creationTime);
+        const FILETIME atime = ToFileTime(entry.lastAccessTime);
+        const FILETIME wtime = ToFileTime(entry.lastWriteTime);
+        SetFileTime(hDst, &ctime, &atime, &wtime);
+        hFile.Reset();
+
+        ApplyAttributes(path, entry.attributes);
+        return dom::Expected<void>();
+    }
+
+    bool Win32DedupBackupStore::HashRestoredFile(
+        const std::wstring& path,
+        uint64_t& outSize,
+        uint64_t& outHash
+    ) {
+        auto hFile = Win32HandleFactory::MakeHandle(
+            CreateFileW(path.c_str(),
+                GENERIC_READ,
+                FILE_SHARE_READ,
+                nullptr,
+                OPEN_EXISTING,
+                FILE_FLAG_SEQUENTIAL_SCAN | FILE_FLAG_BACKUP_SEMANTICS,
+                nullptr));
+        if (!hFile) return false;
+
+        if (m_buffer.size() < k_readSize)
+            m_buffer.resize(k_readSize);
+
+        Xxh64 content;
+        uint64_t total = 0;
+        while (true) {
+            if (m_cancelled.load()) return false;
+
+            DWORD bytesRead = 0;
+            if (!ReadFile(Win32HandleFactory::ToWin32Handle(hFile),
+                m_buffer.data(), static_cast<DWORD>(m_buffer.size()), &bytesRead, nullptr))
+                return false;
+            if (bytesRead == 0) break;
+            content.Update(m_buffer.data(), bytesRead);
+            total += bytesRead;
+        }
+
+        outSize = total;
+        outHash = content.Digest();
+        return true;
+    }
+
+    dom::Expected<void> Win32DedupBackupStore::WriteTree(
+        const std::wstring& treePath,
+        const BackupTree& tree
+    ) {
+        const size_t entryBytes = tree.entries.size() * sizeof(TreeEntry);
+        const size_t refBytes = tree.chunkRefs.size() * sizeof(uint32_t);
+        const size_t nameBytes = tree.names.size() * sizeof(wchar_t);
+
+        Xxh64 body;
+        body.Update(tree.entries.data(), entryBytes);
+        body.Update(tree.chunkRefs.data(), refBytes);
+        body.Update(tree.names.data(), nameBytes);
+
+        TreeHeader header{};
+        header.magic = k_treeMagic;
+        header.version = k_treeVersion;
+        header.entryCount = static_cast<uint32_t>(tree.entries.size());
+        header.chunkRefCount = tree.chunkRefs.size();
+        header.nameLength = tree.names.size();
+        header.bodyHash = body.Digest();
+
+        const std::wstring tempPath = treePath + L".tmp";
+        {
+            auto hFile = Win32HandleFactory::MakeHandle(
+                CreateFileW(tempPath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                    FILE_ATTRIBUTE_NORMAL, nullptr));
+            if (!hFile)
+                return dom::Error(L"Failed to create backup tree: " + tempPath,
+                    GetLastError(), dom::ErrorCategory::IO);
+
+            const HANDLE hTree = Win32HandleFactory::ToWin32Handle(hFile);
+            if (!WriteAll(hTree, &header, sizeof(header)) ||
+                !WriteAll(hTree, tree.entries.data(), entryBytes) ||
+                !WriteAll(hTree, tree.chunkRefs.data(), refBytes) ||
+                !WriteAll(hTree, tree.names.data(), nameBytes) ||
+                !FlushFileBuffers(hTree)) {
+                const DWORD err = GetLastError();
+                hFile.Reset();
+                DeleteFileW(tempPath.c_str());
+                return dom::Error(L"Failed to write backup tree: " + tempPath, err, dom::ErrorCategory::IO);
+            }
+        }
+
+        if (!MoveFileExW(tempPath.c_str(), treePath.c_str(),
+            MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+            const DWORD err = GetLastError();
+            DeleteFileW(tempPath.c_str());
+            return dom::Error(L"Failed to commit backup tree: " + treePath, err, dom::ErrorCategory::IO);
+        }
+
+        return dom::Expected<void>();
+    }
+
+    dom::Expected<Win32DedupBackupStore::BackupTree> Win32DedupBackupStore::ReadTree(
+        const std::wstring& treePath,
+        size_t chunkCount
+    ) {
+        auto hFile = Win32HandleFactory::MakeHandle(
+            CreateFileW(treePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                FILE_FLAG_SEQUENTIAL_SCAN, nullptr));
+        if (!hFile)
+            return dom::Error(L"Failed to open backup tree: " + treePath,
+                GetLastError(), dom::ErrorCategory::IO);
+
+        std::vector<uint8_t> contents;
+        if (!ReadWholeFile(Win32HandleFactory::ToWin32Handle(hFile), contents))
+            return dom::Error(L"Failed to read backup tree: " + treePath,
+                GetLastError(), dom::ErrorCategory::IO);
+
+        const dom::Error corrupt(L"Backup tree is damaged: " + treePath,
+            ERROR_FILE_CORRUPT, dom::ErrorCategory::Validation);
+
+        TreeHeader header{};
+        if (contents.size() < sizeof(header)) return corrupt;
+        std::memcpy(&header, contents.data(), sizeof(header));
+
+        const uint64_t bodySize = static_cast<uint64_t>(header.entryCount) * sizeof(TreeEntry)
+            + header.chunkRefCount * sizeof(uint32_t)
+            + header.nameLength * sizeof(wchar_t);
+        if (header.magic != k_treeMagic || header.version != k_treeVersion ||
+            header.entryCount == 0 || header.chunkRefCount > contents.size() ||
+            header.nameLength > contents.size() || bodySize != contents.size() - sizeof(header) ||
+            Xxh64::Hash(contents.data() + sizeof(header), static_cast<size_t>(bodySize)) != header.bodyHash)
+            return corrupt;
+
+        BackupTree tree;
+        tree.entries.resize(header.entryCount);
+        tree.chunkRefs.resize(static_cast<size_t>(header.chunkRefCount));
+        tree.names.resize(static_cast<size_t>(header.nameLength));
+
+        const uint8_t* cursor = contents.data() + sizeof(header);
+        std::memcpy(tree.entries.data(), cursor, tree.entries.size() * sizeof(TreeEntry));
+        cursor += tree.entries.size() * sizeof(TreeEntry);
+        std::memcpy(tree.chunkRefs.data(), cursor, tree.chunkRefs.size() * sizeof(uint32_t));
+        cursor += tree.chunkRefs.size() * sizeof(uint32_t);
+        std::memcpy(tree.names.data(), cursor, tree.names.size() * sizeof(wchar_t));
+
+        // Parents come before their children, and the chunk and name
+        // sequences must be used up exactly.
+        if (tree.entries[0].parent != k_noParent || !(tree.entries[0].attributes & FILE_ATTRIBUTE_DIRECTORY))
+            return corrupt;
+
+        uint64_t refTotal = 0;
+        uint64_t nameTotal = 0;
+        for (size_t i = 1; i < tree.entries.size(); ++i) {
+            const TreeEntry& entry = tree.entries[i];
+            if (entry.parent >= i || !(tree.entries[entry.parent].attributes & FILE_ATTRIBUTE_DIRECTORY) ||
+                entry.nameLength == 0)
+                return corrupt;
+            if (entry.attributes & FILE_ATTRIBUTE_DIRECTORY) {
+                if (entry.chunkCount != 0) return corrupt;
+            }
+            refTotal += entry.chunkCount;
+            nameTotal += entry.nameLength;
+        }
+        if (refTotal != tree.chunkRefs.size() || nameTotal != tree.names.size())
+            return corrupt;
+
+        for (const uint32_t ref : tree.chunkRefs) {
+            if (ref >= chunkCount)
+                return dom::Error(L"Backup tree references chunks missing from the store: " + treePath,
+                    ERROR_FILE_CORRUPT, dom::ErrorCategory::Validation);
+        }
+
+        return tree;
+    }
+
+    dom::Expected<void> Win32DedupBackupStore::EnsureDirectory(
+        const std::wstring& dirPath
+    ) {
+        if (dirPath.empty()) return dom::Expected<void>();
+
+        DWORD attrib = GetFileAttributesW(dirPath.c_str());
+        if (attrib != INVALID_FILE_ATTRIBUTES) {
+            if (attrib & FILE_ATTRIBUTE_DIRECTORY) return dom::Expected<void>();
+            return dom::Error(L"Path exists but is not a directory: " + dirPath,
+                ERROR_DIRECTORY, dom::ErrorCategory::IO);
+        }
+
+        const size_t pos = dirPath.find_last_of(L"\\/");
+        if (pos != std::wstring::npos && pos > 0) {
+            auto parent = EnsureDirectory(dirPath.substr(0, pos));
+            if (!parent.HasValue()) return parent;
+        }
+
+        if (!CreateDirectoryW(dirPath.c_str(), nullptr)) {
+            DWORD err = GetLastError();
+            if (err != ERROR_ALREADY_EXISTS)
+                return dom::Error(L"Failed to create directory: " + dirPath,
+                    err, dom::ErrorCategory::IO);
+        }
+
+        return dom::Expected<void>();
+    }
+
+    dom::Expected<void> Win32DedupBackupStore::CheckCancelled() const {
+        if (m_cancelled.load())
+            return dom::Error(L"Backup operation was cancelled",
+                ERROR_OPERATION_ABORTED, dom::ErrorCategory::IO);
+        return dom::Expected<void>();
+    }
+
+    bool Win32DedupBackupStore::HashChunk(
+        const uint8_t* data,
+        uint32_t length,
+        ChunkId& outId
+    ) noexcept {
+        // The pseudo-handle needs no provider to open or close and is safe
+        // to share between threads.
+        return BCRYPT_SUCCESS(BCryptHash(BCRYPT_SHA256_ALG_HANDLE, nullptr, 0,
+            const_cast<PUCHAR>(data), length,
+            outId.digest.data(), static_cast<ULONG>(outId.digest.size())));
+    }
+
+    std::wstring Win32DedupBackupStore::TreePath(const std::wstring& storeDir, const std::wstring& name) {
+        std::wstring fileName = name;
+        for (wchar_t& c : fileName) {
+            if (c < L' ' || std::wcschr(L"\\/:*?\"<>|", c) != nullptr)
+                c = L'_';
+        }
+        return storeDir + L"\\" + fileName + L".tree";
+    }
+
+}
@@ -0,0 +1,190 @@
+// src/adapters/platform/win32/storage/Win32DedupBackupStore.h
+#pragma once
+#include "abstractions/services/storage/IBackupStore.h"
+#include "abstractions/infrastructure/logging/ILogger.h"
+#include "adapters/platform/win32/memory/UniqueHandle.h"
+#include "adapters/platform/win32/storage/ContentChunker.h"
+#include "domain/primitives/Expected.h"
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+namespace winsetup::adapters::platform {
+
+    // Backs directories up into a content-addressed chunk store. Files are
+    // cut into content-defined chunks keyed by their SHA-256, each distinct
+    // chunk is appended to chunks.pack once and listed in chunks.idx, and
+    // every backup is a <name>.tree file holding the directory tree, the
+    // chunk list of each file and the XXH64 of its contents for Verify. Commits go pack, then index, then tree, so a
+    // tree never points past what reached the disk; whatever a torn run
+    // left behind the index is trimmed off on the next open.
+    class Win32DedupBackupStore final : public winsetup::abstractions::IBackupStore {
+    public:
+        explicit Win32DedupBackupStore(
+            std::shared_ptr<winsetup::abstractions::ILogger> logger,
+            const ContentChunkerPolicy& policy = {}
+        );
+        ~Win32DedupBackupStore() override = default;
+
+        Win32DedupBackupStore(const Win32DedupBackupStore&) = delete;
+        Win32DedupBackupStore& operator=(const Win32DedupBackupStore&) = delete;
+
+        [[nodiscard]] winsetup::domain::Expected<winsetup::abstractions::BackupStoreStats> Backup(
+            const std::wstring& storeDir,
+            const std::wstring& name,
+            const std::wstring& sourceDir
+        ) override;
+
+        [[nodiscard]] winsetup::domain::Expected<winsetup::abstractions::BackupStoreStats> Restore(
+            const std::wstring& storeDir,
+            const std::wstring& name,
+            const std::wstring& targetDir
+        ) override;
+
+        [[nodiscard]] winsetup::domain::Expected<winsetup::abstractions::BackupStoreStats> Verify(
+            const std::wstring& storeDir,
+            const std::wstring& name,
+            const std::wstring& targetDir
+        ) override;
+
+        [[nodiscard]] bool HasBackup(
+            const std::wstring& storeDir,
+            const std::wstring& name
+        ) const override;
+
+        void Cancel() noexcept override;
+
+    private:
+        // SHA-256 of the chunk bytes. A weaker key would let a collision
+        // silently restore one chunk's data in place of another's.
+        struct ChunkId {
+            std::array<uint8_t, 32> digest{};
+
+            [[nodiscard]] bool operator==(const ChunkId&) const noexcept = default;
+        };
+
+        struct ChunkIdHash {
+            [[nodiscard]] size_t operator()(const ChunkId& id) const noexcept {
+                size_t value = 0;
+                std::memcpy(&value, id.digest.data(), sizeof(value));
+                return value;
+            }
+        };
+
+        struct ChunkLocation {
+            ChunkId  id;
+            uint64_t offset = 0;
+            uint32_t length = 0;
+        };
+
+        // One file or directory of a backup. Entries are stored parents
+        // first; a file's chunk references follow those of the file before
+        // it and its name follows the previous name, so neither needs an
+        // offset.
+        struct TreeEntry {
+            uint64_t size = 0;
+            uint64_t creationTime = 0;
+            uint64_t lastAccessTime = 0;
+            uint64_t lastWriteTime = 0;
+            uint64_t contentHash = 0;
+            uint32_t chunkCount = 0;
+            uint32_t parent = 0;
+            uint32_t attributes = 0;
+            uint32_t nameLength = 0;
+        };
+
+        struct BackupTree {
+            std::vector<TreeEntry> entries;
+            std::vector<uint32_t>  chunkRefs;
+            std::wstring           names;
+        };
+
+        // The open pack and index of one store directory.
+        struct ChunkStore {
+            UniqueHandle                                   pack;
+            UniqueHandle                                   index;
+            std::vector<ChunkLocation>                     chunks;
+            std::unordered_map<ChunkId, uint32_t, ChunkIdHash> lookup;
+            std::vector<ChunkLocation>                     pendingRecords;
+            uint64_t                                       packEnd = 0;
+        };
+
+        [[nodiscard]] winsetup::domain::Expected<void> OpenChunkStore(
+            const std::wstring& storeDir,
+            bool writable,
+            ChunkStore& store
+        );
+
+        [[nodiscard]] winsetup::domain::Expected<void> CommitChunkStore(ChunkStore& store);
+
+        // Chunks one file into the store. Returns false, after logging, when
+        // the source cannot be read and the file is left out; errors are
+        // store failures or cancellation and end the backup.
+        [[nodiscard]] winsetup::domain::Expected<bool> BackupFile(
+            const std::wstring& path,
+            ChunkStore& store,
+            TreeEntry& entry,
+            std::vector<uint32_t>& chunkRefs,
+            winsetup::abstractions::BackupStoreStats& stats
+        );
+
+        [[nodiscard]] winsetup::domain::Expected<void> AddChunk(
+            const uint8_t* data,
+            uint32_t length,
+            ChunkStore& store,
+            std::vector<uint32_t>& chunkRefs,
+            winsetup::abstractions::BackupStoreStats& stats
+        );
+
+        [[nodiscard]] winsetup::domain::Expected<void> RestoreFile(
+            const std::wstring& path,
+            const TreeEntry& entry,
+            const uint32_t* chunkRefs,
+            ChunkStore& store,
+            winsetup::abstractions::BackupStoreStats& stats
+        );
+
+        // Hashes a restored file the way BackupFile did. Returns false when
+        // it cannot be read back.
+        [[nodiscard]] bool HashRestoredFile(
+            const std::wstring& path,
+            uint64_t& outSize,
+            uint64_t& outHash
+        );
+
+        [[nodiscard]] winsetup::domain::Expected<void> WriteTree(
+            const std::wstring& treePath,
+            const BackupTree& tree
+        );
+
+        [[nodiscard]] winsetup::domain::Expected<BackupTree> ReadTree(
+            const std::wstring& treePath,
+            size_t chunkCount
+        );
+
+        [[nodiscard]] winsetup::domain::Expected<void> EnsureDirectory(
+            const std::wstring& dirPath
+        );
+
+        [[nodiscard]] winsetup::domain::Expected<void> CheckCancelled() const;
+
+        [[nodiscard]] static bool HashChunk(const uint8_t* data, uint32_t length, ChunkId& outId) noexcept;
+        [[nodiscard]] static std::wstring TreePath(const std::wstring& storeDir, const std::wstring& name);
+
+        std::shared_ptr<winsetup::abstractions::ILogger> m_logger;
+        ContentChunker                                   m_chunker;
+        std::atomic<bool>                                m_cancelled{ false };
+        std::mutex                                       m_storeMutex;
+        std::vector<uint8_t>                             m_buffer;
+
+        static constexpr uint32_t k_readSize = 4 * 1024 * 1024;
+        static constexpr uint32_t k_noParent = 0xFFFFFFFFu;
+    };
+
+}
@@ -0,0 +1,219 @@
+﻿#include "Win32ExtentFileChannel.h"
+#include <adapters/platform/win32/core/Win32HandleFactory.h>
+#include <winioctl.h>
+#include <algorithm>
+#include <cwchar>
+#undef min
+#undef max
+
+namespace winsetup::adapters::platform {
+
+    namespace {
+        domain::Error ChannelError(const std::wstring& message, DWORD code) {
+            return domain::Error{ message, code, domain::ErrorCategory::IO };
+        }
+
+        OVERLAPPED AtOffset(uint64_t offset) noexcept {
+            OVERLAPPED overlapped{};
+            overlapped.Offset = static_cast<DWORD>(offset);
+            overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+            return overlapped;
+        }
+
+        bool RefcountingVolume(const std::wstring& path, wchar_t (&mountPoint)[MAX_PATH]) noexcept {
+            if (!GetVolumePathNameW(path.c_str(), mountPoint, MAX_PATH))
+                return false;
+            DWORD flags = 0;
+            return GetVolumeInformationW(mountPoint, nullptr, 0, nullptr, nullptr, &flags, nullptr, 0) &&
+                (flags & FILE_SUPPORTS_BLOCK_REFCOUNTING) != 0;
+        }
+    }
+
+    domain::Expected<std::unique_ptr<Win32ExtentFileChannel>> Win32ExtentFileChannel::Open(
+        const std::wstring& srcPath,
+        const std::wstring& dstPath
+    ) {
+        auto hSrc = Win32HandleFactory::MakeHandle(
+            CreateFileW(srcPath.c_str(),
+                GENERIC_READ,
+                FILE_SHARE_READ | FILE_SHARE_WRITE,
+                nullptr,
+                OPEN_EXISTING,
+                FILE_FLAG_SEQUENTIAL_SCAN,
+                nullptr));
+        if (!hSrc)
+            return ChannelError(L"Failed to open source file: " + srcPath, GetLastError());
+
+        // Read access as well, since FSCTL_DUPLICATE_EXTENTS_TO_FILE needs it
+        // on the target.
+        auto hDst = Win32HandleFactory::MakeHandle(
+            CreateFileW(dstPath.c_str(),
+                GENERIC_READ | GENERIC_WRITE,
+                0,
+                nullptr,
+                CREATE_ALWAYS,
+                FILE_ATTRIBUTE_NORMAL,
+                nullptr));
+        if (!hDst)
+            return ChannelError(L"Failed to create destination file: " + dstPath, GetLastError());
+
+        std::unique_ptr<Win32ExtentFileChannel> channel(
+            new Win32ExtentFileChannel(std::move(hSrc), std::move(hDst)));
+        channel->mCloneAlignment = QueryCloneAlignment(
+            Win32HandleFactory::ToWin32Handle(channel->mSource),
+            Win32HandleFactory::ToWin32Handle(channel->mDestination),
+            dstPath);
+        return channel;
+    }
+
+    Win32ExtentFileChannel::Win32ExtentFileChannel(UniqueHandle source, UniqueHandle destination)
+        : mSource(std::move(source))
+        , mDestination(std::move(destination))
+    {
+    }
+
+    bool Win32ExtentFileChannel::SupportsBlockCloning(
+        const std::wstring& srcPath,
+        const std::wstring& dstPath
+    ) noexcept {
+        wchar_t srcMount[MAX_PATH] = {};
+        wchar_t dstMount[MAX_PATH] = {};
+        if (!RefcountingVolume(srcPath, srcMount) || !GetVolumePathNameW(dstPath.c_str(), dstMount, MAX_PATH))
+            return false;
+
+        wchar_t srcVolume[64] = {};
+        wchar_t dstVolume[64] = {};
+        if (!GetVolumeNameForVolumeMountPointW(srcMount, srcVolume, 64) ||
+            !GetVolumeNameForVolumeMountPointW(dstMount, dstVolume, 64))
+            return false;
+        return wcscmp(srcVolume, dstVolume) == 0;
+    }
+
+    uint32_t Win32ExtentFileChannel::QueryCloneAlignment(
+        HANDLE source,
+        HANDLE destination,
+        const std::wstring& dstPath
+    ) noexcept {
+        BY_HANDLE_FILE_INFORMATION srcInfo{};
+        BY_HANDLE_FILE_INFORMATION dstInfo{};
+        if (!GetFileInformationByHandle(source, &srcInfo) ||
+            !GetFileInformationByHandle(destination, &dstInfo) ||
+            srcInfo.dwVolumeSerialNumber != dstInfo.dwVolumeSerialNumber)
+            return 0;
+
+        wchar_t mountPoint[MAX_PATH] = {};
+        if (!RefcountingVolume(dstPath, mountPoint))
+            return 0;
+
+        DWORD sectorsPerCluster = 0, bytesPerSector = 0, freeClusters = 0, totalClusters = 0;
+        if (!GetDiskFreeSpaceW(mountPoint, &sectorsPerCluster, &bytesPerSector, &freeClusters, &totalClusters))
+            return 0;
+
+        const uint32_t cluster = sectorsPerCluster * bytesPerSector;
+        return cluster != 0 && (cluster & (cluster - 1)) == 0 ? cluster : 0;
+    }
+
+    domain::Expected<std::vector<FileExtent>> Win32ExtentFileChannel::QueryAllocatedRanges(
+        uint64_t begin,
+        uint64_t end
+    ) {
+        std::vector<FileExtent> extents;
+        FILE_ALLOCATED_RANGE_BUFFER query{};
+        FILE_ALLOCATED_RANGE_BUFFER ranges[kRangeBatch]{};
+
+        uint64_t position = begin;
+        while (position < end) {
+            query.FileOffset.QuadPart = static_cast<LONGLONG>(position);
+            query.Length.QuadPart = static_cast<LONGLONG>(end - position);
+
+            DWORD bytes = 0;
+            const BOOL ok = DeviceIoControl(Win32HandleFactory::ToWin32Handle(mSource),
+                FSCTL_QUERY_ALLOCATED_RANGES, &query, sizeof(query), ranges, sizeof(ranges), &bytes, nullptr);
+            const DWORD error = ok ? ERROR_SUCCESS : GetLastError();
+
+            // File systems without sparse files have no holes to report.
+            if (error == ERROR_INVALID_FUNCTION || error == ERROR_NOT_SUPPORTED) {
+                extents.assign(1, FileExtent{ begin, end - begin });
+                return extents;
+            }
+            if (error != ERROR_SUCCESS && error != ERROR_MORE_DATA)
+                return ChannelError(L"Failed to query allocated ranges", error);
+
+            const DWORD count = bytes / sizeof(FILE_ALLOCATED_RANGE_BUFFER);
+            for (DWORD i = 0; i < count; ++i) {
+                const uint64_t offset = static_cast<uint64_t>(ranges[i].FileOffset.QuadPart);
+                const uint64_t length = static_cast<uint64_t>(ranges[i].Length.QuadPart);
+                extents.push_back({ offset, length });
+                position = std::max(position, offset + length);
+            }
+            if (error == ERROR_SUCCESS || count == 0) break;
+        }
+        return extents;
+    }
+
+    domain::Expected<void> Win32ExtentFileChannel::CloneRange(uint64_t offset, uint64_t length) {
+        DUPLICATE_EXTENTS_DATA duplicate{};
+        duplicate.FileHandle = Win32HandleFactory::ToWin32Handle(mSource);
+        duplicate.SourceFileOffset.QuadPart = static_cast<LONGLONG>(offset);
+        duplicate.TargetFileOffset.QuadPart = static_cast<LONGLONG>(offset);
+        duplicate.ByteCount.QuadPart = static_cast<LONGLONG>(length);
+
+        DWORD bytes = 0;
+        if (!DeviceIoControl(Win32HandleFactory::ToWin32Handle(mDestination),
+            FSCTL_DUPLICATE_EXTENTS_TO_FILE, &duplicate, sizeof(duplicate), nullptr, 0, &bytes, nullptr))
+            return ChannelError(L"Failed to clone range at offset " + std::to_wstring(offset), GetLastError());
+        return domain::Expected<void>();
+    }
+
+    // A clone target has to match a sparse source, so a failed
+    // FSCTL_SET_SPARSE also turns cloning off.
+    domain::Expected<void> Win32ExtentFileChannel::PrepareDestination(uint64_t length, bool sparse) {
+        const HANDLE destination = Win32HandleFactory::ToWin32Handle(mDestination);
+        if (sparse) {
+            DWORD bytes = 0;
+            if (!DeviceIoControl(destination, FSCTL_SET_SPARSE, nullptr, 0, nullptr, 0, &bytes, nullptr))
+                mCloneAlignment = 0;
+        }
+
+        FILE_END_OF_FILE_INFO endOfFile{};
+        endOfFile.EndOfFile.QuadPart = static_cast<LONGLONG>(length);
+        if (!SetFileInformationByHandle(destination, FileEndOfFileInfo, &endOfFile, sizeof(endOfFile)))
+            return ChannelError(L"Failed to set destination length", GetLastError());
+        return domain::Expected<void>();
+    }
+
+    domain::Expected<uint32_t> Win32ExtentFileChannel::ReadSource(
+        uint64_t offset,
+        void* buffer,
+        uint32_t length
+    ) {
+        OVERLAPPED overlapped = AtOffset(offset);
+        DWORD bytes = 0;
+        if (!ReadFile(Win32HandleFactory::ToWin32Handle(mSource), buffer, length, &bytes, &overlapped)) {
+            const DWORD error = GetLastError();
+            if (error != ERROR_HANDLE_EOF)
+                return ChannelError(L"Read failed at offset " + std::to_wstring(offset), error);
+        }
+        return static_cast<uint32_t>(bytes);
+    }
+
+    domain::Expected<void> Win32ExtentFileChannel::WriteDestination(
+        uint64_t offset,
+        const void* buffer,
+        uint32_t length
+    ) {
+        OVERLAPPED overlapped = AtOffset(offset);
+        DWORD bytes = 0;
+        if (!WriteFile(Win32HandleFactory::ToWin32Handle(mDestination), buffer, length, &bytes, &overlapped) ||
+            bytes != length)
+            return ChannelError(L"Write failed at offset " + std::to_wstring(offset), GetLastError());
+        return domain::Expected<void>();
+    }
+
+    void Win32ExtentFileChannel::CopyFileTimes() noexcept {
+        FILETIME creation{}, access{}, write{};
+        if (GetFileTime(Win32HandleFactory::ToWin32Handle(mSource), &creation, &access, &write))
+            SetFileTime(Win32HandleFactory::ToWin32Handle(mDestination), &creation, &access, &write);
+    }
+
+}
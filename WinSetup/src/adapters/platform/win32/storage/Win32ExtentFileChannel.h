@@ -0,0 +1,74 @@
+﻿#pragma once
+
+#include <domain/primitives/Expected.h>
+#include <adapters/platform/win32/memory/UniqueHandle.h>
+#include <adapters/platform/win32/storage/ExtentFileChannel.h>
+#include <Windows.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace winsetup::adapters::platform {
+
+    // IExtentFileChannel over a synchronous file pair. Allocated ranges come
+    // from FSCTL_QUERY_ALLOCATED_RANGES and clones from
+    // FSCTL_DUPLICATE_EXTENTS_TO_FILE, offered only when both files live on
+    // the same volume and it reports FILE_SUPPORTS_BLOCK_REFCOUNTING (ReFS,
+    // Dev Drive); the clone alignment is the volume cluster size.
+    class Win32ExtentFileChannel final : public IExtentFileChannel {
+    public:
+        [[nodiscard]] static domain::Expected<std::unique_ptr<Win32ExtentFileChannel>> Open(
+            const std::wstring& srcPath,
+            const std::wstring& dstPath
+        );
+
+        ~Win32ExtentFileChannel() override = default;
+
+        Win32ExtentFileChannel(const Win32ExtentFileChannel&) = delete;
+        Win32ExtentFileChannel& operator=(const Win32ExtentFileChannel&) = delete;
+
+        [[nodiscard]] domain::Expected<std::vector<FileExtent>> QueryAllocatedRanges(
+            uint64_t begin,
+            uint64_t end
+        ) override;
+
+        [[nodiscard]] uint32_t GetCloneAlignment() const noexcept override { return mCloneAlignment; }
+
+        [[nodiscard]] domain::Expected<void> CloneRange(uint64_t offset, uint64_t length) override;
+
+        [[nodiscard]] domain::Expected<void> PrepareDestination(uint64_t length, bool sparse) override;
+
+        [[nodiscard]] domain::Expected<uint32_t> ReadSource(
+            uint64_t offset,
+            void* buffer,
+            uint32_t length
+        ) override;
+
+        [[nodiscard]] domain::Expected<void> WriteDestination(
+            uint64_t offset,
+            const void* buffer,
+            uint32_t length
+        ) override;
+
+        void CopyFileTimes() noexcept;
+
+        // Whether two paths share a volume that can clone blocks between
+        // files, for deciding up front if a copy is worth routing here.
+        [[nodiscard]] static bool SupportsBlockCloning(
+            const std::wstring& srcPath,
+            const std::wstring& dstPath
+        ) noexcept;
+
+    private:
+        Win32ExtentFileChannel(UniqueHandle source, UniqueHandle destination);
+
+        [[nodiscard]] static uint32_t QueryCloneAlignment(HANDLE source, HANDLE destination, const std::wstring& dstPath) noexcept;
+
+        static constexpr DWORD kRangeBatch = 64;
+
+        UniqueHandle mSource;
+        UniqueHandle mDestination;
+        uint32_t     mCloneAlignment = 0;
+    };
+
+}
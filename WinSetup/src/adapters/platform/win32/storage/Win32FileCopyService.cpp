@@ -1,8 +1,15 @@
 #include "Win32FileCopyService.h"
 #include "adapters/platform/win32/core/Win32HandleFactory.h"
+#include "adapters/platform/win32/storage/CopyDigest.h"
+#include "adapters/platform/win32/storage/CopySchedule.h"
+#include "adapters/platform/win32/storage/ExtentCopier.h"
+#include "adapters/platform/win32/storage/UnbufferedCopyRing.h"
+#include "adapters/platform/win32/storage/Win32AsyncFileChannel.h"
+#include "adapters/platform/win32/storage/Win32ExtentFileChannel.h"
 #include "domain/primitives/Error.h"
 #include <Windows.h>
 #include <algorithm>
+#include <optional>
 #include <thread>
 #undef CopyFile
 #undef CopyFileW
@@ -15,6 +22,47 @@ namespace winsetup::adapters::platform {
     namespace {
         namespace abs = winsetup::abstractions;
         namespace dom = winsetup::domain;
+
+        uint64_t FromFileTime(const FILETIME& time) noexcept {
+            return (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+        }
+
+        FILETIME ToFileTime(uint64_t time) noexcept {
+            FILETIME result{};
+            result.dwLowDateTime = static_cast<DWORD>(time);
+            result.dwHighDateTime = static_cast<DWORD>(time >> 32);
+            return result;
+        }
+
+        std::optional<uint64_t> QueryFileSize(const std::wstring& path) noexcept {
+            WIN32_FILE_ATTRIBUTE_DATA info{};
+            if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &info))
+                return std::nullopt;
+            return (static_cast<uint64_t>(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+        }
+
+        std::wstring VolumeKey(const std::wstring& path) {
+            wchar_t mountPoint[MAX_PATH] = {};
+            if (!GetVolumePathNameW(path.c_str(), mountPoint, MAX_PATH))
+                return path;
+            wchar_t volumeName[64] = {};
+            if (GetVolumeNameForVolumeMountPointW(mountPoint, volumeName, 64))
+                return volumeName;
+            return mountPoint;
+        }
+
+        // Tuned settings belong to the pair of volumes, since the slower of
+        // the two decides what pays off.
+        std::wstring DevicePairKey(const std::wstring& srcPath, const std::wstring& dstPath) {
+            return VolumeKey(srcPath) + L"|" + VolumeKey(dstPath);
+        }
+
+        // Ring blocks hold whole digest blocks, so inline hashing never has
+        // to stitch a digest block together from two ring blocks.
+        uint32_t RingBlockSize(uint32_t bufSize, uint32_t minBlockSize) noexcept {
+            const uint32_t size = std::max(bufSize, minBlockSize);
+            return (size + CopyDigest::BLOCK_SIZE - 1) / CopyDigest::BLOCK_SIZE * CopyDigest::BLOCK_SIZE;
+        }
     }
 
     Win32FileCopyService::Win32FileCopyService(
@@ -24,9 +72,13 @@ namespace winsetup::adapters::platform {
         : m_logger(std::move(logger))
         , m_defaultThreadCount(ResolveThreadCount(threadCount))
     {
-        if (m_logger)
+        if (m_logger) {
             m_logger->Info(L"Win32FileCopyService initialized, threads: "
                 + std::to_wstring(m_defaultThreadCount));
+            m_logger->Info(Win32AsyncFileChannel::CanPresetValidData()
+                ? L"Unbuffered copies preset the destination valid data length"
+                : L"SeManageVolumePrivilege unavailable; unbuffered copies write in file order");
+        }
     }
 
     Win32FileCopyService::~Win32FileCopyService() = default;
@@ -44,6 +96,11 @@ namespace winsetup::adapters::platform {
         return m_lastProgress;
     }
 
+    abs::FileCopyReport Win32FileCopyService::GetLastReport() const {
+        std::lock_guard<std::mutex> lock(m_reportMutex);
+        return m_lastReport;
+    }
+
     dom::Expected<void> Win32FileCopyService::CopyFile(
         const std::wstring& srcPath,
         const std::wstring& dstPath,
@@ -51,16 +108,20 @@ namespace winsetup::adapters::platform {
         abs::FileCopyProgressCallback progressCallback
     ) {
         m_cancelled.store(false);
+        {
+            std::lock_guard<std::mutex> lock(m_reportMutex);
+            m_lastReport = abs::FileCopyReport{};
+        }
 
         if (m_logger)
             m_logger->Info(L"CopyFile: " + srcPath + L" -> " + dstPath);
 
-        DWORD srcAttrib = GetFileAttributesW(srcPath.c_str());
-        if (srcAttrib == INVALID_FILE_ATTRIBUTES)
+        WIN32_FILE_ATTRIBUTE_DATA srcInfo{};
+        if (!GetFileAttributesExW(srcPath.c_str(), GetFileExInfoStandard, &srcInfo))
             return dom::Error(L"Source file not found: " + srcPath,
                 GetLastError(), dom::ErrorCategory::IO);
 
-        if (srcAttrib & FILE_ATTRIBUTE_DIRECTORY)
+        if (srcInfo.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
             return dom::Error(L"Source is a directory, use CopyDirectory: " + srcPath,
                 ERROR_INVALID_PARAMETER, dom::ErrorCategory::IO);
 
@@ -68,9 +129,58 @@ namespace winsetup::adapters::platform {
         auto ensureResult = EnsureDirectory(dstParent);
         if (!ensureResult.HasValue()) return ensureResult;
 
-        auto copyResult = CopySingleFile(srcPath, dstPath,
-            options.bufferSizeKB, options.overwrite);
-        if (!copyResult.HasValue()) return copyResult;
+        CopyTask task;
+        task.srcPath = srcPath;
+        task.dstPath = dstPath;
+        task.fileSize = (static_cast<uint64_t>(srcInfo.nFileSizeHigh) << 32) | srcInfo.nFileSizeLow;
+        task.attributes = srcInfo.dwFileAttributes;
+        task.creationTime = FromFileTime(srcInfo.ftCreationTime);
+        task.lastAccessTime = FromFileTime(srcInfo.ftLastAccessTime);
+        task.lastWriteTime = FromFileTime(srcInfo.ftLastWriteTime);
+
+        auto manifest = OpenManifest(options);
+        if (!manifest.HasValue()) return manifest.GetError();
+
+        const bool blockClone = Win32ExtentFileChannel::SupportsBlockCloning(srcPath, dstParent);
+
+        // With a single file there is nothing else to get on with, so the
+        // backoff is simply slept off. Retries overwrite what the failed
+        // attempt left behind.
+        const abs::FileCopyErrorPolicy& policy = options.errorPolicy;
+        abs::FileCopyOptions retryOptions = options;
+        retryOptions.overwrite = true;
+
+        std::vector<uint8_t> buffer;
+        dom::Expected<void>  copyResult;
+        uint32_t             attempts = 0;
+        while (true) {
+            copyResult = CopySingleFile(task, attempts == 0 ? options : retryOptions,
+                manifest.Value().get(), blockClone, buffer);
+            ++attempts;
+            if (copyResult.HasValue() || m_cancelled.load() || attempts >= policy.maxAttempts ||
+                policy.ActionFor(copyResult.GetError().GetCode()) != abs::FileCopyErrorAction::Retry)
+                break;
+            Sleep(policy.BackoffMs(attempts));
+        }
+
+        if (attempts > 1) {
+            std::lock_guard<std::mutex> lock(m_reportMutex);
+            m_lastReport.retriedFiles = 1;
+            m_lastReport.recoveredFiles = copyResult.HasValue() ? 1 : 0;
+        }
+
+        if (!copyResult.HasValue()) {
+            const dom::Error& error = copyResult.GetError();
+            const abs::FileCopyErrorAction action = policy.FinalActionFor(error.GetCode());
+
+            {
+                std::lock_guard<std::mutex> lock(m_reportMutex);
+                RecordFailure(m_lastReport, task, error, attempts, action);
+            }
+            if (action != abs::FileCopyErrorAction::Skip || m_cancelled.load())
+                return copyResult;
+            return dom::Expected<void>();
+        }
 
         if (progressCallback) {
             abs::FileCopyProgress progress;
@@ -91,6 +201,10 @@ namespace winsetup::adapters::platform {
         abs::FileCopyProgressCallback progressCallback
     ) {
         m_cancelled.store(false);
+        {
+            std::lock_guard<std::mutex> lock(m_reportMutex);
+            m_lastReport = abs::FileCopyReport{};
+        }
 
         if (m_logger)
             m_logger->Info(L"CopyDirectory: " + srcDir + L" -> " + dstDir);
@@ -100,76 +214,366 @@ namespace winsetup::adapters::platform {
             return dom::Error(L"Source directory not found: " + srcDir,
                 ERROR_PATH_NOT_FOUND, dom::ErrorCategory::IO);
 
-        std::vector<CopyTask> tasks;
-        auto collectResult = CollectFiles(srcDir, dstDir, options.recursive, tasks);
-        if (!collectResult.HasValue()) return collectResult;
-        if (tasks.empty()) return dom::Expected<void>();
+        auto ensureResult = EnsureDirectory(dstDir);
+        if (!ensureResult.HasValue()) return ensureResult;
+
+        auto manifest = OpenManifest(options);
+        if (!manifest.HasValue()) return manifest.GetError();
 
-        uint64_t totalBytes = 0;
-        for (const auto& t : tasks) totalBytes += t.fileSize;
-        const uint32_t totalFiles = static_cast<uint32_t>(tasks.size());
-        const uint32_t threadCount = std::min(
-            ResolveThreadCount(options.threadCount), totalFiles);
+        EnumerationState state;
+        state.workerCount = ResolveThreadCount(options.threadCount);
+        state.windowLimit = k_enumFirstWindowFiles;
 
-        std::atomic<uint32_t>   taskIndex{ 0 };
-        std::atomic<uint64_t>   copiedBytes{ 0 };
-        std::atomic<uint32_t>   copiedFiles{ 0 };
-        std::vector<dom::Error> errors;
-        std::mutex              errorsMutex;
+        CopyBatchQueue<CopyBatch> queue(k_enumQueueDepth);
+        CopyProgressCounters      progress(state.workerCount);
 
         auto ctx = std::make_shared<WorkerContext>();
         ctx->service = this;
         ctx->callback = progressCallback;
         ctx->options = options;
-        ctx->tasks = &tasks;
-        ctx->taskIndex = &taskIndex;
-        ctx->copiedBytes = &copiedBytes;
-        ctx->copiedFiles = &copiedFiles;
-        ctx->errors = &errors;
-        ctx->errorsMutex = &errorsMutex;
-        ctx->totalBytes = totalBytes;
-        ctx->totalFiles = totalFiles;
-
-        std::vector<UniqueHandle> threads;
-        threads.reserve(threadCount);
-        for (uint32_t i = 0; i < threadCount; ++i) {
-            HANDLE hThread = CreateThread(nullptr, 0, WorkerThreadProc, ctx.get(), 0, nullptr);
-            if (hThread)
-                threads.push_back(Win32HandleFactory::MakeHandle(hThread));
-        }
-
-        for (auto& t : threads)
+        ctx->queue = &queue;
+        ctx->manifest = manifest.Value().get();
+        ctx->progress = &progress;
+        ctx->maxWorkers = state.workerCount;
+        ctx->blockClone = Win32ExtentFileChannel::SupportsBlockCloning(srcDir, dstDir);
+        if (ctx->blockClone && m_logger)
+            m_logger->Info(L"CopyDirectory: source and destination share a block-cloning volume");
+
+        std::wstring deviceKey;
+        std::unique_ptr<CopyConcurrencyController> controller;
+        if (options.adaptiveConcurrency && state.workerCount > 1) {
+            deviceKey = DevicePairKey(srcDir, dstDir);
+            controller = std::make_unique<CopyConcurrencyController>(
+                InitialConcurrency(deviceKey, options, state.workerCount),
+                CopyConcurrencyLimits{ state.workerCount, k_minBufferSizeKB, k_maxBufferSizeKB,
+                    CopySchedulePolicy{}.perFileCostBytes });
+            ctx->controller = controller.get();
+        }
+
+        UniqueHandle progressThread;
+        if (progressCallback || controller) {
+            ctx->progressStop = Win32HandleFactory::MakeHandle(CreateEventW(nullptr, TRUE, FALSE, nullptr));
+            if (ctx->progressStop)
+                progressThread = Win32HandleFactory::MakeHandle(
+                    CreateThread(nullptr, 0, ProgressThreadProc, ctx.get(), 0, nullptr));
+        }
+
+        auto walkResult = EnumerateSource(srcDir, dstDir, *ctx, state);
+        if (walkResult.HasValue() && !state.stopped)
+            walkResult = FlushWindow(*ctx, state);
+        ctx->totalsFinal.store(true);
+
+        if (walkResult.HasValue())
+            queue.Close();
+        else
+            queue.Abort();
+
+        for (auto& t : state.threads)
             WaitForSingleObject(Win32HandleFactory::ToWin32Handle(t), INFINITE);
 
+        if (progressThread) {
+            SetEvent(Win32HandleFactory::ToWin32Handle(ctx->progressStop));
+            WaitForSingleObject(Win32HandleFactory::ToWin32Handle(progressThread), INFINITE);
+        }
+        if (progressCallback && !m_cancelled.load()) {
+            CopyProgressCounters::Totals published;
+            PublishProgress(*ctx, published, true);
+        }
+
+        // An abort or cancel leaves parked files behind; they still count
+        // as failed.
+        for (const PendingRetry& retry : ctx->retries) {
+            RecordFailure(ctx->report, retry.task, retry.error, retry.attempts, abs::FileCopyErrorAction::Fail);
+            if (!ctx->firstError) ctx->firstError = retry.error;
+        }
+        ctx->retries.clear();
+
+        {
+            std::lock_guard<std::mutex> lock(m_reportMutex);
+            m_lastReport = ctx->report;
+        }
+        if (m_logger && (!ctx->report.failures.empty() || ctx->report.retriedFiles > 0))
+            m_logger->Warning(L"CopyDirectory: " + std::to_wstring(ctx->report.failures.size())
+                + L" file(s) failed, " + std::to_wstring(ctx->report.recoveredFiles) + L" of "
+                + std::to_wstring(ctx->report.retriedFiles) + L" retried file(s) recovered");
+
         if (m_cancelled.load())
             return dom::Error(L"Copy operation was cancelled",
                 ERROR_OPERATION_ABORTED, dom::ErrorCategory::IO);
 
-        if (!errors.empty()) return errors.front();
+        if (!walkResult.HasValue()) return walkResult;
+        if (ctx->firstError) return *ctx->firstError;
+
+        if (controller) {
+            const CopyConcurrencySettings best = controller->GetBestSettings();
+            {
+                std::lock_guard<std::mutex> lock(m_tuningMutex);
+                m_tunedSettings[deviceKey] = best;
+            }
+            if (m_logger)
+                m_logger->Info(L"CopyDirectory tuned to " + std::to_wstring(best.workers)
+                    + L" workers, " + std::to_wstring(best.bufferSizeKB) + L" KB buffer");
+        }
 
         if (m_logger)
             m_logger->Info(L"CopyDirectory completed: "
-                + std::to_wstring(copiedFiles.load()) + L" files copied");
+                + std::to_wstring(progress.Sum().files) + L" files copied");
 
         return dom::Expected<void>();
     }
 
     dom::Expected<void> Win32FileCopyService::CopySingleFile(
-        const std::wstring& srcPath,
-        const std::wstring& dstPath,
-        uint32_t bufferSizeKB,
-        bool overwrite
+        const CopyTask& task,
+        const abs::FileCopyOptions& options,
+        CopyManifest* manifest,
+        bool blockClone,
+        std::vector<uint8_t>& buffer
     ) {
-        if (!overwrite) {
-            if (GetFileAttributesW(dstPath.c_str()) != INVALID_FILE_ATTRIBUTES)
+        const uint64_t pathHash = manifest ? CopyManifest::HashPath(task.dstPath) : 0;
+        uint64_t resumeOffset = 0;
+
+        if (manifest) {
+            const auto entry = manifest->Find(pathHash, task.fileSize, task.lastWriteTime);
+            const auto dstSize = entry ? QueryFileSize(task.dstPath) : std::nullopt;
+            if (entry && dstSize) {
+                if (entry->complete && *dstSize == task.fileSize)
+                    return dom::Expected<void>();
+                if (!entry->complete && *dstSize >= entry->committedBytes)
+                    resumeOffset = entry->committedBytes;
+            }
+        }
+
+        // With a manifest, only a recorded completion counts as done: an
+        // interrupted copy may already be pre-sized or left truncated, and
+        // either way it still needs resuming or recopying.
+        if (!manifest && !options.overwrite) {
+            if (GetFileAttributesW(task.dstPath.c_str()) != INVALID_FILE_ATTRIBUTES)
                 return dom::Expected<void>();
         }
 
         const uint32_t bufSize =
-            std::clamp(bufferSizeKB, k_minBufferSizeKB, k_maxBufferSizeKB) * 1024;
+            std::clamp(options.bufferSizeKB, k_minBufferSizeKB, k_maxBufferSizeKB) * 1024;
+
+        std::unique_ptr<CopyDigest> digest;
+        if (options.verify)
+            digest = std::make_unique<CopyDigest>(task.fileSize);
+
+        // The extent path never reads holes or cloned data, so a digest for
+        // verification has to come from the source afterwards.
+        const bool sparse = (task.attributes & FILE_ATTRIBUTE_SPARSE_FILE) != 0;
+        dom::Expected<void> result;
+        if (resumeOffset == 0 && (sparse || (blockClone && task.fileSize >= k_cloneMinFileSize))) {
+            result = CopyExtents(task, bufSize, sparse);
+            if (result.HasValue() && digest)
+                result = HashFileRange(task.srcPath, 0, task.fileSize, *digest);
+        }
+        else if (task.fileSize < k_unbufferedMinFileSize ||
+            !TryCopyUnbuffered(task, bufSize, manifest, resumeOffset, digest.get(), result))
+            result = CopyBuffered(task, bufSize, digest.get(), buffer);
+        if (!result.HasValue()) return result;
+
+        std::optional<uint64_t> contentHash;
+        if (digest) {
+            auto verified = VerifyCopy(task, *digest);
+            if (!verified.HasValue()) return verified.GetError();
+            contentHash = verified.Value();
+        }
+
+        ApplyAttributes(task);
+        if (manifest)
+            LogManifestFailure(manifest->RecordComplete(
+                pathHash, task.fileSize, task.lastWriteTime, contentHash));
+        return result;
+    }
+
+    dom::Expected<void> Win32FileCopyService::CopyExtents(
+        const CopyTask& task,
+        uint32_t bufSize,
+        bool keepSparse
+    ) {
+        auto channel = Win32ExtentFileChannel::Open(task.srcPath, task.dstPath);
+        if (!channel.HasValue()) return channel.GetError();
+
+        ExtentCopier copier(bufSize);
+        auto copied = copier.Run(*channel.Value(), task.fileSize, keepSparse, m_cancelled);
+        if (!copied.HasValue()) return copied.GetError();
+
+        channel.Value()->CopyFileTimes();
+
+        const ExtentCopyStats& stats = copied.Value();
+        if (m_logger && (stats.bytesCloned > 0 || stats.bytesSkipped > 0))
+            m_logger->Info(L"Extent copy " + task.srcPath + L": "
+                + std::to_wstring(stats.bytesCloned) + L" bytes cloned, "
+                + std::to_wstring(stats.bytesCopied) + L" copied, "
+                + std::to_wstring(stats.bytesSkipped) + L" in holes");
+        return dom::Expected<void>();
+    }
+
+    dom::Expected<uint64_t> Win32FileCopyService::VerifyCopy(
+        const CopyTask& task,
+        const CopyDigest& sourceDigest
+    ) {
+        if (!sourceDigest.IsComplete())
+            return dom::Error(L"Source was not fully hashed: " + task.srcPath,
+                ERROR_INVALID_DATA, dom::ErrorCategory::IO);
+
+        CopyDigest destinationDigest(task.fileSize);
+        auto hashed = HashFileRange(task.dstPath, 0, task.fileSize, destinationDigest);
+        if (!hashed.HasValue()) return hashed.GetError();
+
+        const uint64_t expected = sourceDigest.Finish();
+        if (destinationDigest.Finish() != expected)
+            return dom::Error(L"Verification failed, destination differs from source: " + task.dstPath,
+                ERROR_CRC, dom::ErrorCategory::IO);
+
+        return expected;
+    }
+
+    // Reads through the cache would only prove the cache holds the right
+    // bytes, so the range is read unbuffered wherever the volume allows it.
+    dom::Expected<void> Win32FileCopyService::HashFileRange(
+        const std::wstring& path,
+        uint64_t begin,
+        uint64_t end,
+        CopyDigest& digest
+    ) {
+        HANDLE hRaw = CreateFileW(path.c_str(),
+            GENERIC_READ,
+            FILE_SHARE_READ | FILE_SHARE_WRITE,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_FLAG_NO_BUFFERING | FILE_FLAG_SEQUENTIAL_SCAN,
+            nullptr);
+        if (hRaw == INVALID_HANDLE_VALUE && Win32AsyncFileChannel::IsUnsupported(GetLastError()))
+            hRaw = CreateFileW(path.c_str(),
+                GENERIC_READ,
+                FILE_SHARE_READ | FILE_SHARE_WRITE,
+                nullptr,
+                OPEN_EXISTING,
+                FILE_FLAG_SEQUENTIAL_SCAN,
+                nullptr);
 
+        auto hFile = Win32HandleFactory::MakeHandle(hRaw);
+        if (!hFile)
+            return dom::Error(L"Failed to open file for verification: " + path,
+                GetLastError(), dom::ErrorCategory::IO);
+
+        LARGE_INTEGER position{};
+        position.QuadPart = static_cast<LONGLONG>(begin);
+        if (!SetFilePointerEx(Win32HandleFactory::ToWin32Handle(hFile), position, nullptr, FILE_BEGIN))
+            return dom::Error(L"Seek failed: " + path,
+                GetLastError(), dom::ErrorCategory::IO);
+
+        std::vector<uint8_t> storage(k_verifyReadSize + k_verifyAlignment);
+        uint8_t* const aligned = storage.data()
+            + (k_verifyAlignment - reinterpret_cast<uintptr_t>(storage.data()) % k_verifyAlignment)
+            % k_verifyAlignment;
+
+        uint64_t offset = begin;
+        while (offset < end) {
+            if (m_cancelled.load())
+                return dom::Error(L"Copy operation was cancelled",
+                    ERROR_OPERATION_ABORTED, dom::ErrorCategory::IO);
+
+            DWORD bytesRead = 0;
+            if (!ReadFile(Win32HandleFactory::ToWin32Handle(hFile),
+                aligned, k_verifyReadSize, &bytesRead, nullptr))
+                return dom::Error(L"Read failed: " + path,
+                    GetLastError(), dom::ErrorCategory::IO);
+            if (bytesRead == 0)
+                return dom::Error(L"File is shorter than expected: " + path,
+                    ERROR_HANDLE_EOF, dom::ErrorCategory::IO);
+
+            const uint64_t useful = std::min<uint64_t>(bytesRead, end - offset);
+            digest.Update(offset, aligned, static_cast<size_t>(useful));
+            offset += useful;
+        }
+
+        return dom::Expected<void>();
+    }
+
+    bool Win32FileCopyService::TryCopyUnbuffered(
+        const CopyTask& task,
+        uint32_t bufferSize,
+        CopyManifest* manifest,
+        uint64_t resumeOffset,
+        CopyDigest* digest,
+        dom::Expected<void>& outResult
+    ) {
+        auto channel = Win32AsyncFileChannel::Open(
+            task.srcPath, task.dstPath, task.fileSize, k_unbufferedQueueDepth,
+            resumeOffset == 0);
+        if (!channel.HasValue()) {
+            if (Win32AsyncFileChannel::IsUnsupported(channel.GetError().GetCode()))
+                return false;
+            outResult = channel.GetError();
+            return true;
+        }
+
+        if (digest && resumeOffset > 0) {
+            outResult = HashFileRange(task.srcPath, 0, resumeOffset, *digest);
+            if (!outResult.HasValue()) return true;
+        }
+
+        UnbufferedCopyRing ring(
+            RingBlockSize(bufferSize, k_unbufferedMinBlockKB * 1024), k_unbufferedQueueDepth);
+        if (digest)
+            ring.SetBlockObserver([digest](uint64_t offset, const std::byte* data, uint32_t length) {
+                digest->Update(offset, data, length);
+            });
+        if (!manifest) {
+            outResult = ring.Run(*channel.Value(), task.fileSize, m_cancelled);
+        }
+        else {
+            if (resumeOffset > 0 && m_logger)
+                m_logger->Info(L"Resuming " + task.srcPath + L" at byte "
+                    + std::to_wstring(resumeOffset));
+
+            const uint64_t pathHash = CopyManifest::HashPath(task.dstPath);
+            for (uint64_t offset = resumeOffset; offset < task.fileSize;) {
+                const uint64_t end = std::min(offset + k_resumeChunkSize, task.fileSize);
+                outResult = ring.Run(*channel.Value(), offset, end, task.fileSize, m_cancelled);
+                if (!outResult.HasValue()) break;
+
+                offset = end;
+                if (offset < task.fileSize)
+                    LogManifestFailure(manifest->RecordProgress(
+                        pathHash, task.fileSize, task.lastWriteTime, offset));
+            }
+        }
+        if (outResult.HasValue())
+            channel.Value()->CopyFileTimes();
+        return true;
+    }
+
+    dom::Expected<std::unique_ptr<CopyManifest>> Win32FileCopyService::OpenManifest(
+        const abs::FileCopyOptions& options
+    ) {
+        if (options.resumeManifestPath.empty())
+            return std::unique_ptr<CopyManifest>();
+
+        auto manifest = CopyManifest::Open(options.resumeManifestPath);
+        if (manifest.HasValue() && m_logger)
+            m_logger->Info(L"Copy manifest " + options.resumeManifestPath + L": "
+                + std::to_wstring(manifest.Value()->GetEntryCount()) + L" recorded file(s)");
+        return manifest;
+    }
+
+    // A lost manifest record only costs a redundant copy on the next run,
+    // so it is logged rather than failing the file.
+    void Win32FileCopyService::LogManifestFailure(const dom::Expected<void>& result) {
+        if (!result.HasValue() && m_logger)
+            m_logger->Warning(L"Copy manifest update failed: " + result.GetError().GetMessage());
+    }
+
+    dom::Expected<void> Win32FileCopyService::CopyBuffered(
+        const CopyTask& task,
+        uint32_t bufSize,
+        CopyDigest* digest,
+        std::vector<uint8_t>& buffer
+    ) {
         auto hSrc = Win32HandleFactory::MakeHandle(
-            CreateFileW(srcPath.c_str(),
+            CreateFileW(task.srcPath.c_str(),
                 GENERIC_READ,
                 FILE_SHARE_READ | FILE_SHARE_WRITE,
                 nullptr,
@@ -177,11 +581,11 @@ namespace winsetup::adapters::platform {
                 FILE_FLAG_SEQUENTIAL_SCAN,
                 nullptr));
         if (!hSrc)
-            return dom::Error(L"Failed to open source file: " + srcPath,
+            return dom::Error(L"Failed to open source file: " + task.srcPath,
                 GetLastError(), dom::ErrorCategory::IO);
 
         auto hDst = Win32HandleFactory::MakeHandle(
-            CreateFileW(dstPath.c_str(),
+            CreateFileW(task.dstPath.c_str(),
                 GENERIC_WRITE,
                 0,
                 nullptr,
@@ -189,82 +593,380 @@ namespace winsetup::adapters::platform {
                 FILE_ATTRIBUTE_NORMAL | FILE_FLAG_WRITE_THROUGH,
                 nullptr));
         if (!hDst)
-            return dom::Error(L"Failed to create destination file: " + dstPath,
+            return dom::Error(L"Failed to create destination file: " + task.dstPath,
                 GetLastError(), dom::ErrorCategory::IO);
 
-        std::vector<BYTE> buffer(bufSize);
+        if (buffer.size() < bufSize)
+            buffer.resize(bufSize);
         DWORD bytesRead = 0;
         DWORD bytesWritten = 0;
+        uint64_t offset = 0;
 
         while (!m_cancelled.load()) {
             if (!ReadFile(Win32HandleFactory::ToWin32Handle(hSrc),
                 buffer.data(), bufSize, &bytesRead, nullptr))
-                return dom::Error(L"Read failed: " + srcPath,
+                return dom::Error(L"Read failed: " + task.srcPath,
                     GetLastError(), dom::ErrorCategory::IO);
 
             if (bytesRead == 0) break;
 
+            if (digest)
+                digest->Update(offset, buffer.data(), bytesRead);
+            offset += bytesRead;
+
             if (!WriteFile(Win32HandleFactory::ToWin32Handle(hDst),
                 buffer.data(), bytesRead, &bytesWritten, nullptr)
                 || bytesWritten != bytesRead)
-                return dom::Error(L"Write failed: " + dstPath,
+                return dom::Error(L"Write failed: " + task.dstPath,
                     GetLastError(), dom::ErrorCategory::IO);
         }
 
-        DWORD srcAttrib = GetFileAttributesW(srcPath.c_str());
-        if (srcAttrib != INVALID_FILE_ATTRIBUTES)
-            SetFileAttributesW(dstPath.c_str(), srcAttrib);
+        // A cancelled copy is partial and must not be finished off or
+        // recorded complete by the caller.
+        if (m_cancelled.load())
+            return dom::Error(L"Copy operation was cancelled: " + task.dstPath,
+                ERROR_OPERATION_ABORTED, dom::ErrorCategory::IO);
 
-        FILETIME ctime{}, atime{}, wtime{};
-        if (GetFileTime(Win32HandleFactory::ToWin32Handle(hSrc), &ctime, &atime, &wtime))
-            SetFileTime(Win32HandleFactory::ToWin32Handle(hDst), &ctime, &atime, &wtime);
+        const FILETIME ctime = ToFileTime(task.creationTime);
+        const FILETIME atime = ToFileTime(task.lastAccessTime);
+        const FILETIME wtime = ToFileTime(task.lastWriteTime);
+        SetFileTime(Win32HandleFactory::ToWin32Handle(hDst), &ctime, &atime, &wtime);
 
         return dom::Expected<void>();
     }
 
-    dom::Expected<void> Win32FileCopyService::CollectFiles(
-        const std::wstring& srcDir,
-        const std::wstring& dstDir,
-        bool recursive,
-        std::vector<CopyTask>& outTasks
+    dom::Expected<bool> Win32FileCopyService::PrepareSplitDestination(const CopyTask& task) {
+        auto hDst = Win32HandleFactory::MakeHandle(
+            CreateFileW(task.dstPath.c_str(),
+                GENERIC_WRITE,
+                FILE_SHARE_READ | FILE_SHARE_WRITE,
+                nullptr,
+                CREATE_ALWAYS,
+                FILE_ATTRIBUTE_NORMAL,
+                nullptr));
+        if (!hDst)
+            return dom::Error(L"Failed to create destination file: " + task.dstPath,
+                GetLastError(), dom::ErrorCategory::IO);
+
+        FILE_END_OF_FILE_INFO endOfFile{};
+        endOfFile.EndOfFile.QuadPart = static_cast<LONGLONG>(task.fileSize);
+        if (!SetFileInformationByHandle(Win32HandleFactory::ToWin32Handle(hDst),
+            FileEndOfFileInfo, &endOfFile, sizeof(endOfFile)))
+            return dom::Error(L"Failed to size destination file: " + task.dstPath,
+                GetLastError(), dom::ErrorCategory::IO);
+
+        if (SetFileValidData(Win32HandleFactory::ToWin32Handle(hDst), endOfFile.EndOfFile.QuadPart))
+            return true;
+
+        if (m_logger)
+            m_logger->Warning(L"SetFileValidData failed for " + task.dstPath + L" (error "
+                + std::to_wstring(GetLastError()) + L"); its ranges will zero-fill ahead of writes");
+        return false;
+    }
+
+    dom::Expected<void> Win32FileCopyService::CopyRange(
+        const CopyTask& task,
+        uint64_t offset,
+        uint64_t length,
+        bool validDataPreset,
+        uint32_t bufSize,
+        CopyDigest* digest,
+        std::vector<uint8_t>& buffer
     ) {
-        auto ensureResult = EnsureDirectory(dstDir);
-        if (!ensureResult.HasValue()) return ensureResult;
+        auto channel = Win32AsyncFileChannel::Open(
+            task.srcPath, task.dstPath, task.fileSize, k_unbufferedQueueDepth, false, validDataPreset);
+        if (channel.HasValue()) {
+            UnbufferedCopyRing ring(
+                RingBlockSize(bufSize, k_unbufferedMinBlockKB * 1024), k_unbufferedQueueDepth);
+            if (digest)
+                ring.SetBlockObserver([digest](uint64_t blockOffset, const std::byte* data, uint32_t blockLength) {
+                    digest->Update(blockOffset, data, blockLength);
+                });
+            return ring.Run(*channel.Value(), offset, offset + length, task.fileSize, m_cancelled);
+        }
+        if (!Win32AsyncFileChannel::IsUnsupported(channel.GetError().GetCode()))
+            return channel.GetError();
 
-        WIN32_FIND_DATAW findData{};
-        auto hFind = Win32HandleFactory::MakeFindHandle(
-            FindFirstFileW((srcDir + L"\\*").c_str(), &findData));
-        if (!hFind)
-            return dom::Error(L"Failed to enumerate directory: " + srcDir,
+        auto hSrc = Win32HandleFactory::MakeHandle(
+            CreateFileW(task.srcPath.c_str(),
+                GENERIC_READ,
+                FILE_SHARE_READ | FILE_SHARE_WRITE,
+                nullptr,
+                OPEN_EXISTING,
+                FILE_FLAG_SEQUENTIAL_SCAN,
+                nullptr));
+        if (!hSrc)
+            return dom::Error(L"Failed to open source file: " + task.srcPath,
+                GetLastError(), dom::ErrorCategory::IO);
+
+        auto hDst = Win32HandleFactory::MakeHandle(
+            CreateFileW(task.dstPath.c_str(),
+                GENERIC_WRITE,
+                FILE_SHARE_READ | FILE_SHARE_WRITE,
+                nullptr,
+                OPEN_EXISTING,
+                FILE_FLAG_WRITE_THROUGH,
+                nullptr));
+        if (!hDst)
+            return dom::Error(L"Failed to open destination file: " + task.dstPath,
                 GetLastError(), dom::ErrorCategory::IO);
 
-        do {
+        LARGE_INTEGER position{};
+        position.QuadPart = static_cast<LONGLONG>(offset);
+        if (!SetFilePointerEx(Win32HandleFactory::ToWin32Handle(hSrc), position, nullptr, FILE_BEGIN) ||
+            !SetFilePointerEx(Win32HandleFactory::ToWin32Handle(hDst), position, nullptr, FILE_BEGIN))
+            return dom::Error(L"Seek failed: " + task.srcPath,
+                GetLastError(), dom::ErrorCategory::IO);
+
+        if (buffer.size() < bufSize)
+            buffer.resize(bufSize);
+
+        uint64_t remaining = length;
+        while (remaining > 0 && !m_cancelled.load()) {
+            const DWORD request = static_cast<DWORD>(std::min<uint64_t>(bufSize, remaining));
+            DWORD bytesRead = 0;
+            DWORD bytesWritten = 0;
+            if (!ReadFile(Win32HandleFactory::ToWin32Handle(hSrc),
+                buffer.data(), request, &bytesRead, nullptr) || bytesRead == 0)
+                return dom::Error(L"Read failed: " + task.srcPath,
+                    GetLastError(), dom::ErrorCategory::IO);
+
+            if (digest)
+                digest->Update(offset + (length - remaining), buffer.data(), bytesRead);
+
+            if (!WriteFile(Win32HandleFactory::ToWin32Handle(hDst),
+                buffer.data(), bytesRead, &bytesWritten, nullptr)
+                || bytesWritten != bytesRead)
+                return dom::Error(L"Write failed: " + task.dstPath,
+                    GetLastError(), dom::ErrorCategory::IO);
+
+            remaining -= bytesRead;
+        }
+
+        if (remaining > 0)
+            return dom::Error(L"Copy operation was cancelled: " + task.dstPath,
+                ERROR_OPERATION_ABORTED, dom::ErrorCategory::IO);
+
+        return dom::Expected<void>();
+    }
+
+    dom::Expected<void> Win32FileCopyService::FinishSplitFile(
+        const CopyTask& task,
+        const SplitFileState& split
+    ) {
+        if (split.digest) {
+            auto verified = VerifyCopy(task, *split.digest);
+            if (!verified.HasValue()) return verified.GetError();
+        }
+
+        auto hDst = Win32HandleFactory::MakeHandle(
+            CreateFileW(task.dstPath.c_str(),
+                FILE_WRITE_ATTRIBUTES,
+                FILE_SHARE_READ | FILE_SHARE_WRITE,
+                nullptr,
+                OPEN_EXISTING,
+                0,
+                nullptr));
+        if (hDst) {
+            const FILETIME ctime = ToFileTime(task.creationTime);
+            const FILETIME atime = ToFileTime(task.lastAccessTime);
+            const FILETIME wtime = ToFileTime(task.lastWriteTime);
+            SetFileTime(Win32HandleFactory::ToWin32Handle(hDst), &ctime, &atime, &wtime);
+        }
+        ApplyAttributes(task);
+        return dom::Expected<void>();
+    }
+
+    // New files already carry FILE_ATTRIBUTE_ARCHIVE, the common source
+    // state, so that case needs no extra call per file.
+    void Win32FileCopyService::ApplyAttributes(const CopyTask& task) {
+        if (task.attributes != FILE_ATTRIBUTE_ARCHIVE)
+            SetFileAttributesW(task.dstPath.c_str(), task.attributes);
+    }
+
+    dom::Expected<void> Win32FileCopyService::EnumerateSource(
+        const std::wstring& srcDir,
+        const std::wstring& dstDir,
+        WorkerContext& ctx,
+        EnumerationState& state
+    ) {
+        struct PendingWalk {
+            std::wstring src;
+            std::wstring dst;
+        };
+        std::vector<PendingWalk> walk{ { srcDir, dstDir } };
+
+        while (!walk.empty() && !state.stopped) {
             if (m_cancelled.load()) break;
-            const std::wstring name = findData.cFileName;
-            if (name == L"." || name == L"..") continue;
 
-            const std::wstring src = srcDir + L"\\" + name;
-            const std::wstring dst = dstDir + L"\\" + name;
+            const PendingWalk dir = std::move(walk.back());
+            walk.pop_back();
+
+            WIN32_FIND_DATAW findData{};
+            auto hFind = Win32HandleFactory::MakeFindHandle(
+                FindFirstFileExW((dir.src + L"\\*").c_str(),
+                    FindExInfoBasic,
+                    &findData,
+                    FindExSearchNameMatch,
+                    nullptr,
+                    FIND_FIRST_EX_LARGE_FETCH));
+            if (!hFind)
+                return dom::Error(L"Failed to enumerate directory: " + dir.src,
+                    GetLastError(), dom::ErrorCategory::IO);
+
+            do {
+                if (m_cancelled.load()) break;
+                const std::wstring name = findData.cFileName;
+                if (name == L"." || name == L"..") continue;
 
-            if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
-                if (recursive) {
-                    auto sub = CollectFiles(src, dst, recursive, outTasks);
-                    if (!sub.HasValue()) return sub;
+                std::wstring src = dir.src + L"\\" + name;
+                std::wstring dst = dir.dst + L"\\" + name;
+
+                if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+                    if (ctx.options.recursive) {
+                        state.pendingDirectories.push_back(dst);
+                        walk.push_back({ std::move(src), std::move(dst) });
+                    }
+                    continue;
                 }
-            }
-            else {
+
                 LARGE_INTEGER fileSize{};
                 fileSize.HighPart = static_cast<LONG>(findData.nFileSizeHigh);
                 fileSize.LowPart = findData.nFileSizeLow;
-                outTasks.push_back({ src, dst,
-                    static_cast<uint64_t>(fileSize.QuadPart) });
-            }
-        } while (FindNextFileW(
-            Win32HandleFactory::ToWin32FindHandle(hFind), &findData));
+                state.window.push_back({ std::move(src), std::move(dst),
+                    static_cast<uint64_t>(fileSize.QuadPart),
+                    findData.dwFileAttributes,
+                    FromFileTime(findData.ftCreationTime),
+                    FromFileTime(findData.ftLastAccessTime),
+                    FromFileTime(findData.ftLastWriteTime) });
+                state.windowBytes += static_cast<uint64_t>(fileSize.QuadPart);
+
+                if (state.window.size() >= state.windowLimit
+                    || state.windowBytes >= k_enumMaxWindowBytes) {
+                    auto flushed = FlushWindow(ctx, state);
+                    if (!flushed.HasValue()) return flushed;
+                    if (state.stopped) break;
+                }
+            } while (FindNextFileW(
+                Win32HandleFactory::ToWin32FindHandle(hFind), &findData));
+        }
 
         return dom::Expected<void>();
     }
 
+    dom::Expected<void> Win32FileCopyService::FlushWindow(
+        WorkerContext& ctx,
+        EnumerationState& state
+    ) {
+        auto created = CreatePendingDirectories(state);
+        if (!created.HasValue()) return created;
+        if (state.window.empty()) return dom::Expected<void>();
+
+        auto batch = std::make_shared<CopyBatch>();
+        batch->tasks = std::move(state.window);
+        state.window.clear();
+
+        std::stable_sort(batch->tasks.begin(), batch->tasks.end(),
+            [](const CopyTask& a, const CopyTask& b) { return a.fileSize > b.fileSize; });
+
+        std::vector<uint64_t> sizes;
+        std::vector<uint8_t>  keepWhole;
+        sizes.reserve(batch->tasks.size());
+        keepWhole.reserve(batch->tasks.size());
+        for (const auto& t : batch->tasks) {
+            sizes.push_back(t.fileSize);
+            keepWhole.push_back((t.attributes & FILE_ATTRIBUTE_SPARSE_FILE) != 0);
+        }
+
+        // Resumable copies commit large files front to back, which range
+        // splitting would break up. Clones and sparse copies take the whole
+        // file at once and finish long before split ranges would. Ranges
+        // written out of order need the valid data length set up front,
+        // so without SeManageVolumePrivilege files are copied whole.
+        CopySchedulePolicy policy;
+        if (ctx.manifest || ctx.blockClone || !Win32AsyncFileChannel::CanPresetValidData())
+            policy.splitChunkSize = 0;
+
+        CopySchedule schedule = CopyScheduler::Build(sizes, state.workerCount, policy, keepWhole);
+        PrepareSplits(ctx, *batch, schedule);
+        batch->items = std::move(schedule.items);
+
+        ctx.totalBytes.fetch_add(state.windowBytes);
+        ctx.totalFiles.fetch_add(static_cast<uint32_t>(batch->tasks.size()));
+        state.scheduledItems += batch->items.size();
+        state.windowBytes = 0;
+        state.windowLimit = std::min(state.windowLimit * 2, k_enumMaxWindowFiles);
+
+        if (!ctx.queue->Push(std::move(batch))) {
+            state.stopped = true;
+            return dom::Expected<void>();
+        }
+
+        const uint64_t wanted = std::min<uint64_t>(state.workerCount, state.scheduledItems);
+        while (state.threads.size() < wanted) {
+            HANDLE hThread = CreateThread(nullptr, 0, WorkerThreadProc, &ctx, 0, nullptr);
+            if (!hThread) break;
+            state.threads.push_back(Win32HandleFactory::MakeHandle(hThread));
+        }
+        if (state.threads.empty())
+            return dom::Error(L"Failed to start copy workers",
+                GetLastError(), dom::ErrorCategory::System);
+
+        return dom::Expected<void>();
+    }
+
+    // Parents are always discovered before their children, so one
+    // CreateDirectoryW per directory suffices, without probing or recursion.
+    dom::Expected<void> Win32FileCopyService::CreatePendingDirectories(
+        EnumerationState& state
+    ) {
+        for (const auto& dir : state.pendingDirectories) {
+            if (!CreateDirectoryW(dir.c_str(), nullptr)) {
+                DWORD err = GetLastError();
+                if (err != ERROR_ALREADY_EXISTS)
+                    return dom::Error(L"Failed to create directory: " + dir,
+                        err, dom::ErrorCategory::IO);
+            }
+        }
+        state.pendingDirectories.clear();
+        return dom::Expected<void>();
+    }
+
+    void Win32FileCopyService::PrepareSplits(
+        WorkerContext& ctx,
+        CopyBatch& batch,
+        const CopySchedule& schedule
+    ) {
+        if (schedule.rangesPerSplit.empty()) return;
+
+        batch.splits = std::make_unique<SplitFileState[]>(schedule.rangesPerSplit.size());
+        for (const auto& item : schedule.items) {
+            if (!item.IsRange() || item.rangeOffset != 0) continue;
+
+            SplitFileState& split = batch.splits[item.splitIndex];
+            split.remainingRanges.store(schedule.rangesPerSplit[item.splitIndex]);
+
+            const CopyTask& task = batch.tasks[item.firstFile];
+            if (ctx.options.verify)
+                split.digest = std::make_unique<CopyDigest>(task.fileSize);
+            if (!ctx.options.overwrite &&
+                GetFileAttributesW(task.dstPath.c_str()) != INVALID_FILE_ATTRIBUTES) {
+                split.skipped = true;
+                continue;
+            }
+
+            // The worker that finishes the last range reports the failure.
+            auto prepared = PrepareSplitDestination(task);
+            if (!prepared.HasValue()) {
+                split.failed.store(true);
+                split.error = prepared.GetError();
+            }
+            else {
+                split.validDataPreset = prepared.Value();
+            }
+        }
+    }
+
     dom::Expected<void> Win32FileCopyService::EnsureDirectory(
         const std::wstring& dirPath
     ) {
@@ -304,25 +1006,103 @@ namespace winsetup::adapters::platform {
 
     void Win32FileCopyService::NotifyProgress(
         abs::FileCopyProgressCallback& callback,
-        uint64_t copiedBytes,
-        uint64_t totalBytes,
-        uint32_t copiedFiles,
-        uint32_t totalFiles,
-        const std::wstring& currentFile
+        abs::FileCopyProgress progress
     ) {
-        abs::FileCopyProgress progress;
-        progress.copiedBytes = copiedBytes;
-        progress.totalBytes = totalBytes;
-        progress.copiedFiles = copiedFiles;
-        progress.totalFiles = totalFiles;
-        progress.percentComplete = totalBytes > 0
-            ? static_cast<uint32_t>((copiedBytes * 100) / totalBytes) : 0;
-        progress.currentFile = currentFile;
+        progress.percentComplete = progress.totalBytes > 0
+            ? static_cast<uint32_t>((progress.copiedBytes * 100) / progress.totalBytes) : 0;
+        if (!progress.totalsFinal)
+            progress.percentComplete = std::min(progress.percentComplete, 99u);
 
         { std::lock_guard<std::mutex> lock(m_progressMutex); m_lastProgress = progress; }
         if (callback) callback(progress);
     }
 
+    unsigned long __stdcall Win32FileCopyService::ProgressThreadProc(void* lpParam) {
+        auto* ctx = static_cast<WorkerContext*>(lpParam);
+        ctx->service->ProgressRun(ctx);
+        return 0;
+    }
+
+    void Win32FileCopyService::ProgressRun(WorkerContext* ctx) {
+        CopyProgressCounters::Totals published;
+        CopyProgressCounters::Totals observed;
+        uint64_t lastControl = GetTickCount64();
+
+        while (WaitForSingleObject(Win32HandleFactory::ToWin32Handle(ctx->progressStop),
+            k_progressIntervalMs) == WAIT_TIMEOUT) {
+            const uint64_t now = GetTickCount64();
+            if (ctx->controller && now - lastControl >= k_controlIntervalMs) {
+                ControlConcurrency(*ctx, observed, now - lastControl);
+                lastControl = now;
+            }
+            if (ctx->callback)
+                PublishProgress(*ctx, published, false);
+        }
+    }
+
+    void Win32FileCopyService::ControlConcurrency(
+        WorkerContext& ctx,
+        CopyProgressCounters::Totals& lastObserved,
+        uint64_t elapsedMs
+    ) {
+        const CopyProgressCounters::Totals totals = ctx.progress->Sum();
+        const uint64_t bytes = totals.bytes - lastObserved.bytes;
+        const uint32_t files = totals.files - lastObserved.files;
+        lastObserved = totals;
+
+        // With nothing queued, or only the last batch draining, workers sat
+        // idle for reasons the settings cannot fix.
+        const size_t pending = ctx.queue->GetPendingCount();
+        if (pending == 0 || (pending == 1 && ctx.totalsFinal.load()))
+            return;
+
+        if (ctx.controller->Observe(bytes, files, static_cast<double>(elapsedMs) / 1000.0) && m_logger)
+            m_logger->Info(L"Copy concurrency: " + std::to_wstring(ctx.controller->GetActiveWorkers())
+                + L" workers, " + std::to_wstring(ctx.controller->GetBufferSizeKB()) + L" KB buffer");
+    }
+
+    CopyConcurrencySettings Win32FileCopyService::InitialConcurrency(
+        const std::wstring& deviceKey,
+        const abs::FileCopyOptions& options,
+        uint32_t maxWorkers
+    ) {
+        {
+            std::lock_guard<std::mutex> lock(m_tuningMutex);
+            const auto it = m_tunedSettings.find(deviceKey);
+            if (it != m_tunedSettings.end())
+                return it->second;
+        }
+        return CopyConcurrencySettings{
+            std::min(k_adaptiveStartWorkers, maxWorkers),
+            std::clamp(options.bufferSizeKB, k_minBufferSizeKB, k_maxBufferSizeKB)
+        };
+    }
+
+    // Skips the callback when nothing moved since the last snapshot, so an
+    // idle or enumeration-bound copy does not keep waking the UI.
+    void Win32FileCopyService::PublishProgress(
+        WorkerContext& ctx,
+        CopyProgressCounters::Totals& lastPublished,
+        bool force
+    ) {
+        const CopyProgressCounters::Totals totals = ctx.progress->Sum();
+        if (!force && totals.bytes == lastPublished.bytes && totals.files == lastPublished.files)
+            return;
+        lastPublished = totals;
+
+        abs::FileCopyProgress progress;
+        progress.copiedBytes = totals.bytes;
+        progress.totalBytes = ctx.totalBytes.load();
+        progress.copiedFiles = totals.files;
+        progress.totalFiles = ctx.totalFiles.load();
+        progress.totalsFinal = ctx.totalsFinal.load();
+        progress.activeWorkers = ctx.controller ? ctx.controller->GetActiveWorkers() : ctx.maxWorkers;
+        progress.bufferSizeKB = ctx.controller ? ctx.controller->GetBufferSizeKB()
+            : std::clamp(ctx.options.bufferSizeKB, k_minBufferSizeKB, k_maxBufferSizeKB);
+        progress.currentFile = ctx.progress->TakeCurrentFile();
+        NotifyProgress(ctx.callback, std::move(progress));
+    }
+
     unsigned long __stdcall Win32FileCopyService::WorkerThreadProc(void* lpParam) {
         auto* ctx = static_cast<WorkerContext*>(lpParam);
         ctx->service->WorkerRun(ctx);
@@ -330,29 +1110,234 @@ namespace winsetup::adapters::platform {
     }
 
     void Win32FileCopyService::WorkerRun(WorkerContext* ctx) {
-        while (!m_cancelled.load()) {
-            const uint32_t idx = ctx->taskIndex->fetch_add(1);
-            if (idx >= static_cast<uint32_t>(ctx->tasks->size())) break;
+        std::vector<uint8_t> buffer;
+        const uint32_t slot = ctx->nextSlot.fetch_add(1);
+        abs::FileCopyOptions options = ctx->options;
+
+        while (true) {
+            if (m_cancelled.load()) {
+                ctx->queue->Abort();
+                break;
+            }
+
+            if (ctx->controller && !ctx->controller->WaitForTurn(slot)) break;
 
-            const auto& task = (*ctx->tasks)[idx];
-            auto result = CopySingleFile(
-                task.srcPath, task.dstPath,
-                ctx->options.bufferSizeKB, ctx->options.overwrite);
+            if (RunPendingRetry(ctx, slot, options, buffer, false)) continue;
+
+            // Once the queue is done, parked files are all that is left.
+            auto batch = ctx->queue->Acquire();
+            if (!batch) {
+                if (!ctx->aborted.load() && RunPendingRetry(ctx, slot, options, buffer, true)) continue;
+                break;
+            }
+
+            const uint32_t idx = batch->nextItem.fetch_add(1);
+            if (idx >= static_cast<uint32_t>(batch->items.size())) {
+                ctx->queue->Retire(batch.get());
+                continue;
+            }
+
+            if (ctx->controller)
+                options.bufferSizeKB = ctx->controller->GetBufferSizeKB();
+
+            const CopyWorkItem& item = batch->items[idx];
+            if (item.IsRange())
+                RunRangeItem(ctx, slot, options, *batch, item, buffer);
+            else
+                RunFilesItem(ctx, slot, options, *batch, item, buffer);
+        }
+
+        // The queue is drained or aborted, so parked workers can leave too.
+        if (ctx->controller)
+            ctx->controller->Release();
+    }
+
+    void Win32FileCopyService::RunFilesItem(
+        WorkerContext* ctx,
+        uint32_t slot,
+        const abs::FileCopyOptions& options,
+        const CopyBatch& batch,
+        const CopyWorkItem& item,
+        std::vector<uint8_t>& buffer
+    ) {
+        for (uint32_t i = item.firstFile; i < item.firstFile + item.fileCount; ++i) {
+            if (m_cancelled.load() || ctx->aborted.load()) break;
+
+            const auto& task = batch.tasks[i];
+            auto result = CopySingleFile(task, options, ctx->manifest, ctx->blockClone, buffer);
 
             if (!result.HasValue()) {
-                if (m_logger)
-                    m_logger->Warning(L"Copy failed: " + task.srcPath
-                        + L" - " + result.GetError().GetMessage());
-                std::lock_guard<std::mutex> lock(*ctx->errorsMutex);
-                ctx->errors->push_back(result.GetError());
+                HandleFailure(ctx, task, result.GetError(), 1, 0);
                 continue;
             }
 
-            const uint64_t cb = ctx->copiedBytes->fetch_add(task.fileSize) + task.fileSize;
-            const uint32_t cf = ctx->copiedFiles->fetch_add(1) + 1;
-            NotifyProgress(ctx->callback, cb, ctx->totalBytes,
-                cf, ctx->totalFiles, task.srcPath);
+            ctx->progress->Add(slot, task.fileSize, 1);
+            ctx->progress->OfferCurrentFile(task.srcPath);
+        }
+    }
+
+    void Win32FileCopyService::RunRangeItem(
+        WorkerContext* ctx,
+        uint32_t slot,
+        const abs::FileCopyOptions& options,
+        CopyBatch& batch,
+        const CopyWorkItem& item,
+        std::vector<uint8_t>& buffer
+    ) {
+        SplitFileState& split = batch.splits[item.splitIndex];
+        const auto& task = batch.tasks[item.firstFile];
+
+        bool copied = split.skipped;
+        if (!split.skipped && !split.failed.load()) {
+            const uint32_t bufSize = std::clamp(
+                options.bufferSizeKB, k_minBufferSizeKB, k_maxBufferSizeKB) * 1024;
+            auto result = CopyRange(task, item.rangeOffset, item.rangeLength,
+                split.validDataPreset, bufSize, split.digest.get(), buffer);
+            if (result.HasValue()) {
+                copied = true;
+                split.copiedBytes.fetch_add(item.rangeLength);
+            }
+            else if (!split.failed.exchange(true)) {
+                split.error = result.GetError();
+            }
+        }
+
+        // A failed split file goes through the error policy once, as a
+        // whole file, and a retry copies it without splitting.
+        uint32_t finishedFiles = 0;
+        if (split.remainingRanges.fetch_sub(1) == 1) {
+            if (split.failed.load()) {
+                if (split.error)
+                    HandleFailure(ctx, task, *split.error, 1, split.copiedBytes.load());
+            }
+            else {
+                auto finished = split.skipped ? dom::Expected<void>() : FinishSplitFile(task, split);
+                if (finished.HasValue())
+                    finishedFiles = 1;
+                else
+                    HandleFailure(ctx, task, finished.GetError(), 1, split.copiedBytes.load());
+            }
+        }
+
+        if (copied || finishedFiles != 0) {
+            ctx->progress->Add(slot, copied ? item.rangeLength : 0, finishedFiles);
+            ctx->progress->OfferCurrentFile(task.srcPath);
         }
     }
 
+    void Win32FileCopyService::HandleFailure(
+        WorkerContext* ctx,
+        const CopyTask& task,
+        const dom::Error& error,
+        uint32_t attempts,
+        uint64_t reportedBytes
+    ) {
+        const abs::FileCopyErrorPolicy& policy = ctx->options.errorPolicy;
+        if (policy.ActionFor(error.GetCode()) == abs::FileCopyErrorAction::Retry &&
+            attempts < policy.maxAttempts && !m_cancelled.load() && !ctx->aborted.load()) {
+            const uint32_t backoff = policy.BackoffMs(attempts);
+            if (m_logger)
+                m_logger->Info(L"Copy of " + task.srcPath + L" failed (" + error.GetMessage()
+                    + L"), retrying in " + std::to_wstring(backoff) + L" ms");
+
+            std::lock_guard<std::mutex> lock(ctx->retryMutex);
+            ctx->retries.push_back({ task, attempts, GetTickCount64() + backoff, reportedBytes, error });
+            return;
+        }
+
+        const abs::FileCopyErrorAction action = policy.FinalActionFor(error.GetCode());
+
+        {
+            std::lock_guard<std::mutex> lock(ctx->reportMutex);
+            RecordFailure(ctx->report, task, error, attempts, action);
+            if (action != abs::FileCopyErrorAction::Skip && !ctx->firstError)
+                ctx->firstError = error;
+        }
+
+        if (action == abs::FileCopyErrorAction::Abort && !ctx->aborted.exchange(true)) {
+            if (m_logger)
+                m_logger->Error(L"Copy aborted by error policy at " + task.srcPath);
+            ctx->queue->Abort();
+        }
+    }
+
+    bool Win32FileCopyService::RunPendingRetry(
+        WorkerContext* ctx,
+        uint32_t slot,
+        const abs::FileCopyOptions& options,
+        std::vector<uint8_t>& buffer,
+        bool wait
+    ) {
+        PendingRetry retry;
+        while (true) {
+            if (m_cancelled.load() || ctx->aborted.load()) return false;
+
+            uint64_t nextDue = 0;
+            {
+                std::lock_guard<std::mutex> lock(ctx->retryMutex);
+                if (ctx->retries.empty()) return false;
+
+                const uint64_t now = GetTickCount64();
+                auto due = std::min_element(ctx->retries.begin(), ctx->retries.end(),
+                    [](const PendingRetry& a, const PendingRetry& b) { return a.dueTick < b.dueTick; });
+                if (due->dueTick <= now) {
+                    retry = std::move(*due);
+                    *due = std::move(ctx->retries.back());
+                    ctx->retries.pop_back();
+                    break;
+                }
+                nextDue = due->dueTick - now;
+            }
+
+            if (!wait) return false;
+            Sleep(static_cast<DWORD>(std::min<uint64_t>(nextDue, k_retryPollMs)));
+        }
+
+        if (retry.attempts == 1) {
+            std::lock_guard<std::mutex> lock(ctx->reportMutex);
+            ++ctx->report.retriedFiles;
+        }
+
+        // Whatever is at the destination came from the failed attempt.
+        abs::FileCopyOptions retryOptions = options;
+        retryOptions.overwrite = true;
+
+        auto result = CopySingleFile(retry.task, retryOptions, ctx->manifest, ctx->blockClone, buffer);
+        if (!result.HasValue()) {
+            HandleFailure(ctx, retry.task, result.GetError(), retry.attempts + 1, retry.reportedBytes);
+            return true;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(ctx->reportMutex);
+            ++ctx->report.recoveredFiles;
+        }
+        ctx->progress->Add(slot, retry.task.fileSize - std::min(retry.reportedBytes, retry.task.fileSize), 1);
+        ctx->progress->OfferCurrentFile(retry.task.srcPath);
+        return true;
+    }
+
+    void Win32FileCopyService::RecordFailure(
+        abs::FileCopyReport& report,
+        const CopyTask& task,
+        const dom::Error& error,
+        uint32_t attempts,
+        abs::FileCopyErrorAction action
+    ) {
+        if (m_logger)
+            m_logger->Warning(L"Copy failed: " + task.srcPath
+                + L" - " + error.GetMessage()
+                + (attempts > 1 ? L" after " + std::to_wstring(attempts) + L" attempts" : L"")
+                + (action == abs::FileCopyErrorAction::Skip ? L", skipped" : L""));
+
+        abs::FileCopyFailure failure;
+        failure.srcPath = task.srcPath;
+        failure.dstPath = task.dstPath;
+        failure.errorCode = error.GetCode();
+        failure.message = error.GetMessage();
+        failure.attempts = attempts;
+        failure.action = action;
+        report.failures.push_back(std::move(failure));
+    }
+
 } // namespace winsetup::adapters::platform
@@ -4,12 +4,20 @@
 #include "abstractions/infrastructure/logging/ILogger.h"
 #include "adapters/platform/win32/memory/UniqueHandle.h"
 #include "adapters/platform/win32/memory/UniqueFindHandle.h"
+#include "adapters/platform/win32/storage/CopyBatchQueue.h"
+#include "adapters/platform/win32/storage/CopyConcurrencyController.h"
+#include "adapters/platform/win32/storage/CopyDigest.h"
+#include "adapters/platform/win32/storage/CopyManifest.h"
+#include "adapters/platform/win32/storage/CopyProgressCounters.h"
+#include "adapters/platform/win32/storage/CopySchedule.h"
 #include "domain/primitives/Expected.h"
 #include "domain/primitives/Error.h"
 #include <atomic>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <cstdint>
 
@@ -43,42 +51,191 @@ namespace winsetup::adapters::platform {
         void Cancel() noexcept override;
         [[nodiscard]] bool IsCancelled() const noexcept override;
         [[nodiscard]] winsetup::abstractions::FileCopyProgress GetLastProgress() const noexcept override;
+        [[nodiscard]] winsetup::abstractions::FileCopyReport GetLastReport() const override;
 
     private:
         struct CopyTask {
             std::wstring srcPath;
             std::wstring dstPath;
             uint64_t     fileSize = 0;
+            uint32_t     attributes = 0;
+            uint64_t     creationTime = 0;
+            uint64_t     lastAccessTime = 0;
+            uint64_t     lastWriteTime = 0;
+        };
+
+        // Shared by the range items of one split file. The worker that
+        // finishes the last range verifies it and applies times and
+        // attributes.
+        struct SplitFileState {
+            std::atomic<uint32_t>       remainingRanges{ 0 };
+            std::atomic<bool>           failed{ false };
+            std::atomic<uint64_t>       copiedBytes{ 0 };
+            bool                        skipped = false;
+            bool                        validDataPreset = false;
+            std::unique_ptr<CopyDigest> digest;
+            // Written once by whoever sets failed first.
+            std::optional<winsetup::domain::Error> error;
+        };
+
+        // A file whose copy failed with a retryable error, parked until its
+        // backoff expires so workers keep copying other files meanwhile.
+        struct PendingRetry {
+            CopyTask task;
+            uint32_t attempts = 0;
+            uint64_t dueTick = 0;
+            uint64_t reportedBytes = 0;
+            winsetup::domain::Error error;
+        };
+
+        // One enumeration window, scheduled on its own and shared by all
+        // workers until its items run out.
+        struct CopyBatch {
+            std::vector<CopyTask>             tasks;
+            std::vector<CopyWorkItem>         items;
+            std::unique_ptr<SplitFileState[]> splits;
+            std::atomic<uint32_t>             nextItem{ 0 };
         };
 
         struct WorkerContext {
             Win32FileCopyService* service = nullptr;
             winsetup::abstractions::FileCopyProgressCallback          callback;
             winsetup::abstractions::FileCopyOptions                   options;
-            std::vector<CopyTask>* tasks = nullptr;
-            std::atomic<uint32_t>* taskIndex = nullptr;
-            std::atomic<uint64_t>* copiedBytes = nullptr;
-            std::atomic<uint32_t>* copiedFiles = nullptr;
-            std::vector<winsetup::domain::Error>* errors = nullptr;
-            std::mutex* errorsMutex = nullptr;
-            uint64_t                                                  totalBytes = 0;
-            uint32_t                                                  totalFiles = 0;
+            CopyBatchQueue<CopyBatch>* queue = nullptr;
+            CopyManifest* manifest = nullptr;
+            CopyProgressCounters* progress = nullptr;
+            CopyConcurrencyController* controller = nullptr;
+            uint32_t                                                  maxWorkers = 0;
+            bool                                                      blockClone = false;
+            std::mutex                                                reportMutex;
+            winsetup::abstractions::FileCopyReport                    report;
+            std::mutex                                                retryMutex;
+            std::vector<PendingRetry>                                 retries;
+            std::atomic<bool>                                         aborted{ false };
+            std::optional<winsetup::domain::Error>                    firstError;
+            std::atomic<uint64_t>                                     totalBytes{ 0 };
+            std::atomic<uint32_t>                                     totalFiles{ 0 };
+            std::atomic<bool>                                         totalsFinal{ false };
+            std::atomic<uint32_t>                                     nextSlot{ 0 };
+            UniqueHandle                                              progressStop;
+        };
+
+        // Producer-side state of a streaming directory walk.
+        struct EnumerationState {
+            std::vector<CopyTask>     window;
+            uint64_t                  windowBytes = 0;
+            uint32_t                  windowLimit = 0;
+            std::vector<std::wstring> pendingDirectories;
+            uint32_t                  workerCount = 0;
+            uint64_t                  scheduledItems = 0;
+            std::vector<UniqueHandle> threads;
+            bool                      stopped = false;
         };
 
         [[nodiscard]] winsetup::domain::Expected<void> CopySingleFile(
-            const std::wstring& srcPath,
-            const std::wstring& dstPath,
-            uint32_t bufferSizeKB,
-            bool overwrite
+            const CopyTask& task,
+            const winsetup::abstractions::FileCopyOptions& options,
+            CopyManifest* manifest,
+            bool blockClone,
+            std::vector<uint8_t>& buffer
+        );
+
+        [[nodiscard]] winsetup::domain::Expected<void> CopyBuffered(
+            const CopyTask& task,
+            uint32_t bufSize,
+            CopyDigest* digest,
+            std::vector<uint8_t>& buffer
+        );
+
+        // Large files bypass the cache with a ring of overlapped unbuffered
+        // reads and writes. Returns false when the volume refuses unbuffered
+        // I/O and the caller should fall back to CopyBuffered. With a
+        // manifest the file is copied in k_resumeChunkSize steps from
+        // resumeOffset, committing each step.
+        [[nodiscard]] bool TryCopyUnbuffered(
+            const CopyTask& task,
+            uint32_t bufferSize,
+            CopyManifest* manifest,
+            uint64_t resumeOffset,
+            CopyDigest* digest,
+            winsetup::domain::Expected<void>& outResult
+        );
+
+        // Sparse files, and files on a volume that can clone blocks, move
+        // only their allocated extents: holes are skipped and data is cloned
+        // instead of read and written where the volume allows it.
+        [[nodiscard]] winsetup::domain::Expected<void> CopyExtents(
+            const CopyTask& task,
+            uint32_t bufSize,
+            bool keepSparse
+        );
+
+        // Re-reads the destination and compares it with the digest taken
+        // while copying; returns the content hash on a match.
+        [[nodiscard]] winsetup::domain::Expected<uint64_t> VerifyCopy(
+            const CopyTask& task,
+            const CopyDigest& sourceDigest
+        );
+
+        [[nodiscard]] winsetup::domain::Expected<void> HashFileRange(
+            const std::wstring& path,
+            uint64_t begin,
+            uint64_t end,
+            CopyDigest& digest
+        );
+
+        [[nodiscard]] winsetup::domain::Expected<std::unique_ptr<CopyManifest>> OpenManifest(
+            const winsetup::abstractions::FileCopyOptions& options
+        );
+
+        void LogManifestFailure(const winsetup::domain::Expected<void>& result);
+
+        // Creates the destination of a split file at its final length and
+        // valid data length so range workers can open it concurrently and
+        // write anywhere in it. Yields false when the file system refused
+        // SetFileValidData and the ranges have to write in order instead.
+        [[nodiscard]] winsetup::domain::Expected<bool> PrepareSplitDestination(
+            const CopyTask& task
+        );
+
+        [[nodiscard]] winsetup::domain::Expected<void> CopyRange(
+            const CopyTask& task,
+            uint64_t offset,
+            uint64_t length,
+            bool validDataPreset,
+            uint32_t bufSize,
+            CopyDigest* digest,
+            std::vector<uint8_t>& buffer
         );
 
-        [[nodiscard]] winsetup::domain::Expected<void> CollectFiles(
+        [[nodiscard]] winsetup::domain::Expected<void> FinishSplitFile(
+            const CopyTask& task,
+            const SplitFileState& split
+        );
+        void ApplyAttributes(const CopyTask& task);
+
+        // Walks the source tree and hands files to the workers in windows
+        // as it goes, so copying starts before enumeration has finished.
+        [[nodiscard]] winsetup::domain::Expected<void> EnumerateSource(
             const std::wstring& srcDir,
             const std::wstring& dstDir,
-            bool recursive,
-            std::vector<CopyTask>& outTasks
+            WorkerContext& ctx,
+            EnumerationState& state
+        );
+
+        // Creates the directories found since the last flush, schedules the
+        // window and queues it, starting workers as the work grows.
+        [[nodiscard]] winsetup::domain::Expected<void> FlushWindow(
+            WorkerContext& ctx,
+            EnumerationState& state
         );
 
+        [[nodiscard]] winsetup::domain::Expected<void> CreatePendingDirectories(
+            EnumerationState& state
+        );
+
+        void PrepareSplits(WorkerContext& ctx, CopyBatch& batch, const CopySchedule& schedule);
+
         [[nodiscard]] winsetup::domain::Expected<void> EnsureDirectory(
             const std::wstring& dirPath
         );
@@ -87,25 +244,102 @@ namespace winsetup::adapters::platform {
 
         void NotifyProgress(
             winsetup::abstractions::FileCopyProgressCallback& callback,
-            uint64_t copiedBytes,
-            uint64_t totalBytes,
-            uint32_t copiedFiles,
-            uint32_t totalFiles,
-            const std::wstring& currentFile
+            winsetup::abstractions::FileCopyProgress progress
+        );
+
+        // Workers only bump their own counters; this thread turns them into
+        // at most one callback per k_progressIntervalMs, and feeds the
+        // concurrency controller every k_controlIntervalMs.
+        static unsigned long __stdcall ProgressThreadProc(void* lpParam);
+        void ProgressRun(WorkerContext* ctx);
+        void PublishProgress(WorkerContext& ctx, CopyProgressCounters::Totals& lastPublished, bool force);
+        void ControlConcurrency(
+            WorkerContext& ctx,
+            CopyProgressCounters::Totals& lastObserved,
+            uint64_t elapsedMs
+        );
+
+        [[nodiscard]] CopyConcurrencySettings InitialConcurrency(
+            const std::wstring& deviceKey,
+            const winsetup::abstractions::FileCopyOptions& options,
+            uint32_t maxWorkers
         );
 
         static unsigned long __stdcall WorkerThreadProc(void* lpParam);
         void WorkerRun(WorkerContext* ctx);
+        void RunFilesItem(
+            WorkerContext* ctx,
+            uint32_t slot,
+            const winsetup::abstractions::FileCopyOptions& options,
+            const CopyBatch& batch,
+            const CopyWorkItem& item,
+            std::vector<uint8_t>& buffer
+        );
+        void RunRangeItem(
+            WorkerContext* ctx,
+            uint32_t slot,
+            const winsetup::abstractions::FileCopyOptions& options,
+            CopyBatch& batch,
+            const CopyWorkItem& item,
+            std::vector<uint8_t>& buffer
+        );
+        // Applies the error policy: parks the file for a retry, or records
+        // it in the report and aborts the run if the policy says so.
+        void HandleFailure(
+            WorkerContext* ctx,
+            const CopyTask& task,
+            const winsetup::domain::Error& error,
+            uint32_t attempts,
+            uint64_t reportedBytes
+        );
+
+        // Runs one parked file whose backoff has expired. With wait set it
+        // sleeps until the earliest one is due; returns false when none are
+        // left.
+        [[nodiscard]] bool RunPendingRetry(
+            WorkerContext* ctx,
+            uint32_t slot,
+            const winsetup::abstractions::FileCopyOptions& options,
+            std::vector<uint8_t>& buffer,
+            bool wait
+        );
+
+        void RecordFailure(
+            winsetup::abstractions::FileCopyReport& report,
+            const CopyTask& task,
+            const winsetup::domain::Error& error,
+            uint32_t attempts,
+            winsetup::abstractions::FileCopyErrorAction action
+        );
 
         std::shared_ptr<winsetup::abstractions::ILogger>  m_logger;
         uint32_t                                          m_defaultThreadCount;
         std::atomic<bool>                                 m_cancelled{ false };
         mutable std::mutex                                m_progressMutex;
         winsetup::abstractions::FileCopyProgress          m_lastProgress;
+        mutable std::mutex                                m_reportMutex;
+        winsetup::abstractions::FileCopyReport            m_lastReport;
+        std::mutex                                        m_tuningMutex;
+        std::unordered_map<std::wstring, CopyConcurrencySettings> m_tunedSettings;
 
         static constexpr uint32_t k_minBufferSizeKB = 64;
         static constexpr uint32_t k_maxBufferSizeKB = 4096;
         static constexpr uint32_t k_maxThreadCount = 16;
+        static constexpr uint64_t k_unbufferedMinFileSize = 16ull * 1024 * 1024;
+        static constexpr uint64_t k_cloneMinFileSize = 1ull * 1024 * 1024;
+        static constexpr uint32_t k_unbufferedMinBlockKB = 1024;
+        static constexpr uint32_t k_unbufferedQueueDepth = 4;
+        static constexpr uint32_t k_enumFirstWindowFiles = 64;
+        static constexpr uint32_t k_enumMaxWindowFiles = 2048;
+        static constexpr uint64_t k_enumMaxWindowBytes = 1ull * 1024 * 1024 * 1024;
+        static constexpr size_t   k_enumQueueDepth = 4;
+        static constexpr uint64_t k_resumeChunkSize = 64ull * 1024 * 1024;
+        static constexpr uint32_t k_verifyReadSize = 4 * 1024 * 1024;
+        static constexpr uint32_t k_verifyAlignment = 64 * 1024;
+        static constexpr uint32_t k_progressIntervalMs = 100;
+        static constexpr uint32_t k_controlIntervalMs = 500;
+        static constexpr uint32_t k_adaptiveStartWorkers = 2;
+        static constexpr uint32_t k_retryPollMs = 100;
     };
 
 }
@@ -8,10 +8,12 @@ namespace winsetup::application {
         std::shared_ptr<abstractions::IAnalysisRepository> analysisRepository,
         std::shared_ptr<abstractions::IConfigRepository>   configRepository,
         std::shared_ptr<abstractions::IPathChecker>        pathChecker,
+        std::shared_ptr<abstractions::IStorageScanner>     storageScanner,
         std::shared_ptr<abstractions::ILogger>             logger)
         : mAnalysisRepository(std::move(analysisRepository))
         , mConfigRepository(std::move(configRepository))
         , mPathChecker(std::move(pathChecker))
+        , mStorageScanner(std::move(storageScanner))
         , mLogger(std::move(logger))
     {
     }
@@ -47,6 +49,8 @@ namespace winsetup::application {
 
         FilterUsbDevices(disks, volumes);
 
+        mIndexAttempted.clear();
+
         const DiskIndexCache cache = BuildDiskIndexCache(volumes);
 
         if (auto result = AssignVolumeRoles(disks, volumes, userProfile, cache);
@@ -92,6 +96,43 @@ namespace winsetup::application {
             volumes.end());
     }
 
+    std::shared_ptr<const abstractions::IStorageIndexSnapshot> AnalyzeVolumesStep::IndexFor(
+        const domain::VolumeInfo& volume) const noexcept
+    {
+        const std::wstring& guid = volume.GetVolumePath();
+        if (!mStorageScanner || guid.empty() || volume.GetFileSystem() != domain::FileSystemType::NTFS)
+            return nullptr;
+
+        try {
+            if (auto snapshot = mStorageScanner->GetSnapshot(guid))
+                return snapshot;
+            if (!mIndexAttempted.insert(guid).second)
+                return nullptr;
+
+            auto result = mStorageScanner->ScanVolumes({ guid });
+            if (!result.HasValue() && mLogger)
+                mLogger->Warning(L"AnalyzeVolumesStep: Volume indexing failed - "
+                    + result.GetError().GetMessage());
+            return mStorageScanner->GetSnapshot(guid);
+        }
+        catch (...) {
+            return nullptr;
+        }
+    }
+
+    bool AnalyzeVolumesStep::IsDirectoryOnVolume(
+        const domain::VolumeInfo& volume,
+        const std::wstring& relativePath) const noexcept
+    {
+        if (const auto snapshot = IndexFor(volume)) {
+            if (snapshot->IsDirectory(relativePath))
+                return true;
+            if (snapshot->IsComplete())
+                return false;
+        }
+        return mPathChecker->IsDirectory(volume.GetVolumePath(), relativePath);
+    }
+
     AnalyzeVolumesStep::DiskIndexCache AnalyzeVolumesStep::BuildDiskIndexCache(
         const std::vector<domain::VolumeInfo>& volumes) const
     {
@@ -233,8 +274,8 @@ namespace winsetup::application {
         const std::wstring& guid = volume.GetVolumePath();
         if (guid.empty())
             return false;
-        return mPathChecker->IsDirectory(guid, L"Windows\\System32")
-            && mPathChecker->IsDirectory(guid, L"Users\\" + userProfile);
+        return IsDirectoryOnVolume(volume, L"Windows\\System32")
+            && IsDirectoryOnVolume(volume, L"Users\\" + userProfile);
     }
 
     bool AnalyzeVolumesStep::IsDataVolume(
@@ -244,8 +285,8 @@ namespace winsetup::application {
         const std::wstring& guid = volume.GetVolumePath();
         if (guid.empty())
             return false;
-        return mPathChecker->IsDirectory(guid, userProfile + L"\\desktop")
-            || mPathChecker->IsDirectory(guid, userProfile + L"\\Documents");
+        return IsDirectoryOnVolume(volume, userProfile + L"\\desktop")
+            || IsDirectoryOnVolume(volume, userProfile + L"\\Documents");
     }
 
     bool AnalyzeVolumesStep::IsBootVolume(
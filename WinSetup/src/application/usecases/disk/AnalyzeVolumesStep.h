@@ -1,9 +1,10 @@
-// src/application/usecases/disk/AnalyzeVolumesStep.h
+﻿// src/application/usecases/disk/AnalyzeVolumesStep.h
 #pragma once
 #include "abstractions/usecases/steps/IAnalyzeVolumesStep.h"
 #include "abstractions/repositories/IAnalysisRepository.h"
 #include "abstractions/repositories/IConfigRepository.h"
 #include "abstractions/services/storage/IPathChecker.h"
+#include "abstractions/services/storage/IStorageScanner.h"
 #include "abstractions/infrastructure/logging/ILogger.h"
 #include "domain/entities/DiskInfo.h"
 #include "domain/entities/VolumeInfo.h"
@@ -23,6 +24,7 @@ namespace winsetup::application {
             std::shared_ptr<abstractions::IAnalysisRepository> analysisRepository,
             std::shared_ptr<abstractions::IConfigRepository>   configRepository,
             std::shared_ptr<abstractions::IPathChecker>        pathChecker,
+            std::shared_ptr<abstractions::IStorageScanner>     storageScanner,
             std::shared_ptr<abstractions::ILogger>             logger);
 
         ~AnalyzeVolumesStep() override = default;
@@ -36,6 +38,15 @@ namespace winsetup::application {
             std::vector<domain::DiskInfo>& disks,
             std::vector<domain::VolumeInfo>& volumes) const;
 
+        // Indexes an NTFS volume the first time a probe asks about it, so
+        // volumes no probe reaches are never scanned.
+        [[nodiscard]] std::shared_ptr<const abstractions::IStorageIndexSnapshot> IndexFor(
+            const domain::VolumeInfo& volume) const noexcept;
+
+        [[nodiscard]] bool IsDirectoryOnVolume(
+            const domain::VolumeInfo& volume,
+            const std::wstring& relativePath) const noexcept;
+
         [[nodiscard]] DiskIndexCache BuildDiskIndexCache(
             const std::vector<domain::VolumeInfo>& volumes) const;
 
@@ -68,7 +79,10 @@ namespace winsetup::application {
         std::shared_ptr<abstractions::IAnalysisRepository> mAnalysisRepository;
         std::shared_ptr<abstractions::IConfigRepository>   mConfigRepository;
         std::shared_ptr<abstractions::IPathChecker>        mPathChecker;
+        std::shared_ptr<abstractions::IStorageScanner>     mStorageScanner;
         std::shared_ptr<abstractions::ILogger>             mLogger;
+
+        mutable std::unordered_set<std::wstring>           mIndexAttempted;
     };
 
 } // namespace winsetup::application
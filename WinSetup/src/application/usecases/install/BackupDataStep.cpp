@@ -3,13 +3,73 @@
 namespace winsetup {
     namespace application {
 
-        BackupDataStep::BackupDataStep(std::shared_ptr<abstractions::ILogger> logger)
-            : mLogger(std::move(logger))
+        BackupDataStep::BackupDataStep(
+            std::shared_ptr<abstractions::IConfigRepository>   configRepository,
+            std::shared_ptr<abstractions::IAnalysisRepository> analysisRepository,
+            std::shared_ptr<abstractions::IBackupStore>        backupStore,
+            std::shared_ptr<abstractions::ILogger>             logger)
+            : mConfigRepository(std::move(configRepository))
+            , mAnalysisRepository(std::move(analysisRepository))
+            , mBackupStore(std::move(backupStore))
+            , mLogger(std::move(logger))
         {
         }
 
         domain::Expected<void> BackupDataStep::Execute() {
-            if (mLogger) mLogger->Info(L"BackupDataStep: stub.");
+            if (!mConfigRepository)
+                return domain::Error(L"IConfigRepository not provided", 0, domain::ErrorCategory::System);
+            if (!mAnalysisRepository)
+                return domain::Error(L"IAnalysisRepository not provided", 0, domain::ErrorCategory::System);
+            if (!mBackupStore)
+                return domain::Error(L"IBackupStore not provided", 0, domain::ErrorCategory::System);
+
+            auto configResult = mConfigRepository->GetConfig();
+            if (!configResult.HasValue())
+                return configResult.GetError();
+            const auto& config = *configResult.Value();
+
+            // The system volume is about to be formatted, so without a data
+            // volume there is nowhere to keep the backup.
+            const auto dataVolume = mAnalysisRepository->GetDataVolume();
+            if (!dataVolume || dataVolume->GetLetter().empty()) {
+                if (mLogger)
+                    mLogger->Warning(L"BackupDataStep: No data volume, backup skipped.");
+                return domain::Expected<void>();
+            }
+
+            const std::wstring storeDir = dataVolume->GetLetter() + L"\\"
+                + abstractions::IBackupStore::kStoreDirectoryName;
+            if (mLogger)
+                mLogger->Info(L"BackupDataStep: Started. Store=" + storeDir);
+
+            uint64_t skippedFiles = 0;
+            for (const auto& target : config.GetBackupTargets()) {
+                const std::wstring source = config.ResolveBackupPath(target.path);
+                auto result = mBackupStore->Backup(storeDir, target.name, source);
+                if (!result.HasValue()) {
+                    if (mLogger)
+                        mLogger->Error(L"BackupDataStep: " + target.name + L" failed: "
+                            + result.GetError().GetMessage());
+                    return result.GetError();
+                }
+
+                if (result.Value().skippedFiles != 0 && mLogger)
+                    mLogger->Error(L"BackupDataStep: " + target.name + L" skipped "
+                        + std::to_wstring(result.Value().skippedFiles) + L" unreadable item(s).");
+                skippedFiles += result.Value().skippedFiles;
+            }
+
+            // Formatting follows this step, so anything left behind here
+            // would be lost; every target is still attempted first so the
+            // log lists all of the skipped items.
+            if (skippedFiles != 0)
+                return domain::Error(
+                    std::to_wstring(skippedFiles) + L" file(s) or folder(s) could not be backed up. "
+                    L"Setup stopped before formatting; see the log for the paths.",
+                    0,
+                    domain::ErrorCategory::IO);
+
+            if (mLogger) mLogger->Info(L"BackupDataStep: Completed.");
             return domain::Expected<void>();
         }
 
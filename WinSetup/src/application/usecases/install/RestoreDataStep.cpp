@@ -1,15 +1,90 @@
 #include "application/usecases/install/RestoreDataStep.h"
+#include <optional>
 
 namespace winsetup {
     namespace application {
 
-        RestoreDataStep::RestoreDataStep(std::shared_ptr<abstractions::ILogger> logger)
-            : mLogger(std::move(logger))
+        RestoreDataStep::RestoreDataStep(
+            std::shared_ptr<abstractions::IConfigRepository>   configRepository,
+            std::shared_ptr<abstractions::IAnalysisRepository> analysisRepository,
+            std::shared_ptr<abstractions::IBackupStore>        backupStore,
+            std::shared_ptr<abstractions::ILogger>             logger)
+            : mConfigRepository(std::move(configRepository))
+            , mAnalysisRepository(std::move(analysisRepository))
+            , mBackupStore(std::move(backupStore))
+            , mLogger(std::move(logger))
         {
         }
 
         domain::Expected<void> RestoreDataStep::Execute() {
-            if (mLogger) mLogger->Info(L"RestoreDataStep: stub.");
+            if (!mConfigRepository)
+                return domain::Error(L"IConfigRepository not provided", 0, domain::ErrorCategory::System);
+            if (!mAnalysisRepository)
+                return domain::Error(L"IAnalysisRepository not provided", 0, domain::ErrorCategory::System);
+            if (!mBackupStore)
+                return domain::Error(L"IBackupStore not provided", 0, domain::ErrorCategory::System);
+
+            auto configResult = mConfigRepository->GetConfig();
+            if (!configResult.HasValue())
+                return configResult.GetError();
+            const auto& config = *configResult.Value();
+
+            const auto dataVolume = mAnalysisRepository->GetDataVolume();
+            if (!dataVolume || dataVolume->GetLetter().empty()) {
+                if (mLogger)
+                    mLogger->Warning(L"RestoreDataStep: No data volume, nothing to restore.");
+                return domain::Expected<void>();
+            }
+
+            const std::wstring storeDir = dataVolume->GetLetter() + L"\\"
+                + abstractions::IBackupStore::kStoreDirectoryName;
+            if (mLogger)
+                mLogger->Info(L"RestoreDataStep: Started. Store=" + storeDir);
+
+            // Every target is attempted; the first failure is reported once
+            // the rest have been restored.
+            std::optional<domain::Error> firstFailure;
+            for (const auto& target : config.GetBackupTargets()) {
+                if (!mBackupStore->HasBackup(storeDir, target.name)) {
+                    if (mLogger)
+                        mLogger->Info(L"RestoreDataStep: No backup for " + target.name);
+                    continue;
+                }
+
+                const std::wstring destination = config.ResolveBackupPath(target.path);
+                auto result = mBackupStore->Restore(storeDir, target.name, destination);
+                if (!result.HasValue()) {
+                    if (mLogger)
+                        mLogger->Error(L"RestoreDataStep: " + target.name + L" failed: "
+                            + result.GetError().GetMessage());
+                    if (!firstFailure) firstFailure = result.GetError();
+                    continue;
+                }
+
+                // The restored files are read back and checked against the
+                // content hashes recorded when they were backed up.
+                auto verified = mBackupStore->Verify(storeDir, target.name, destination);
+                if (!verified.HasValue()) {
+                    if (mLogger)
+                        mLogger->Error(L"RestoreDataStep: " + target.name + L" could not be verified: "
+                            + verified.GetError().GetMessage());
+                    if (!firstFailure) firstFailure = verified.GetError();
+                    continue;
+                }
+                if (verified.Value().mismatchedFiles != 0) {
+                    const std::wstring message = std::to_wstring(verified.Value().mismatchedFiles)
+                        + L" restored file(s) in " + target.name
+                        + L" do not match the backup; see the log for the paths.";
+                    if (mLogger)
+                        mLogger->Error(L"RestoreDataStep: " + message);
+                    if (!firstFailure)
+                        firstFailure = domain::Error(message, 0, domain::ErrorCategory::IO);
+                }
+            }
+
+            if (firstFailure) return *firstFailure;
+
+            if (mLogger) mLogger->Info(L"RestoreDataStep: Completed.");
             return domain::Expected<void>();
         }
 
@@ -1,5 +1,8 @@
 #pragma once
 #include "abstractions/usecases/steps/IRestoreDataStep.h"
+#include "abstractions/repositories/IAnalysisRepository.h"
+#include "abstractions/repositories/IConfigRepository.h"
+#include "abstractions/services/storage/IBackupStore.h"
 #include "abstractions/infrastructure/logging/ILogger.h"
 #include "domain/primitives/Expected.h"
 #include <memory>
@@ -9,13 +12,20 @@ namespace winsetup {
 
         class RestoreDataStep final : public abstractions::IRestoreDataStep {
         public:
-            explicit RestoreDataStep(std::shared_ptr<abstractions::ILogger> logger);
+            RestoreDataStep(
+                std::shared_ptr<abstractions::IConfigRepository>   configRepository,
+                std::shared_ptr<abstractions::IAnalysisRepository> analysisRepository,
+                std::shared_ptr<abstractions::IBackupStore>        backupStore,
+                std::shared_ptr<abstractions::ILogger>             logger);
             ~RestoreDataStep() override = default;
 
             [[nodiscard]] domain::Expected<void> Execute() override;
 
         private:
-            std::shared_ptr<abstractions::ILogger> mLogger;
+            std::shared_ptr<abstractions::IConfigRepository>   mConfigRepository;
+            std::shared_ptr<abstractions::IAnalysisRepository> mAnalysisRepository;
+            std::shared_ptr<abstractions::IBackupStore>        mBackupStore;
+            std::shared_ptr<abstractions::ILogger>             mLogger;
         };
 
     } // namespace application
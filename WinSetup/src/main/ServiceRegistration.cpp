@@ -5,6 +5,9 @@
 #include "adapters/platform/win32/storage/Win32DiskService.h"
 #include "adapters/platform/win32/storage/Win32VolumeService.h"
 #include "adapters/platform/win32/storage/Win32FileCopyService.h"
+#include "adapters/platform/win32/storage/Win32DedupBackupStore.h"
+#include "adapters/platform/win32/storage/MFTVolumeScanService.h"
+#include "adapters/platform/win32/concurrency/Win32ThreadPoolExecutor.h"
 #include "adapters/persistence/config/IniConfigRepository.h"
 #include "application/repositories/AnalysisRepository.h"
 #include "adapters/persistence/filesystem/Win32PathChecker.h"
@@ -26,13 +29,16 @@
 #include "application/viewmodels/MainViewModel.h"
 #include "application/services/Dispatcher.h"
 #include "abstractions/infrastructure/logging/ILogger.h"
+#include "abstractions/infrastructure/async/IExecutor.h"
 #include "abstractions/repositories/IConfigRepository.h"
 #include "abstractions/repositories/IAnalysisRepository.h"
 #include "abstractions/services/platform/ISystemInfoService.h"
 #include "abstractions/services/storage/IDiskService.h"
 #include "abstractions/services/storage/IVolumeService.h"
 #include "abstractions/services/storage/IFileCopyService.h"
+#include "abstractions/services/storage/IBackupStore.h"
 #include "abstractions/services/storage/IPathChecker.h"
+#include "abstractions/services/storage/IStorageScanner.h"
 #include "abstractions/usecases/IAnalyzeSystemUseCase.h"
 #include "abstractions/usecases/ILoadConfigurationUseCase.h"
 #include "abstractions/usecases/ISetupSystemUseCase.h"
@@ -50,6 +56,7 @@
 #include "abstractions/ui/IUIDispatcher.h"
 #include "abstractions/ui/IMainViewModel.h"
 #include "abstractions/ui/IWindow.h"
+#include <filesystem>
 #include <stdexcept>
 #include <string>
 
@@ -87,6 +94,10 @@ namespace winsetup {
         container.RegisterInstance<abstractions::ILogger>(
             std::static_pointer_cast<abstractions::ILogger>(logger));
 
+        container.RegisterInstance<abstractions::IExecutor>(
+            std::static_pointer_cast<abstractions::IExecutor>(
+                std::make_shared<adapters::platform::Win32ThreadPoolExecutor>()));
+
         auto dispatcher = std::make_shared<application::Dispatcher>();
         container.RegisterInstance<abstractions::IUIDispatcher>(
             std::static_pointer_cast<abstractions::IUIDispatcher>(dispatcher));
@@ -125,9 +136,23 @@ namespace winsetup {
         container.RegisterInstance<abstractions::IFileCopyService>(
             std::static_pointer_cast<abstractions::IFileCopyService>(
                 std::make_shared<adapters::platform::Win32FileCopyService>(logger)));
+        container.RegisterInstance<abstractions::IBackupStore>(
+            std::static_pointer_cast<abstractions::IBackupStore>(
+                std::make_shared<adapters::platform::Win32DedupBackupStore>(logger)));
         container.RegisterInstance<abstractions::IPathChecker>(
             std::static_pointer_cast<abstractions::IPathChecker>(
                 std::make_shared<adapters::persistence::Win32PathChecker>()));
+
+        // Index snapshots stay beside config.ini in the working directory,
+        // never on the user's volumes.
+        auto executor = ResolveOrThrow<abstractions::IExecutor>(container, "IExecutor");
+        auto storageScanner = std::make_shared<adapters::platform::MFTVolumeScanService>(executor, logger);
+        std::error_code ec;
+        const auto snapshotDirectory = std::filesystem::absolute(L"MFTIndex", ec);
+        if (!ec)
+            storageScanner->SetSnapshotDirectory(snapshotDirectory.wstring());
+        container.RegisterInstance<abstractions::IStorageScanner>(
+            std::static_pointer_cast<abstractions::IStorageScanner>(storageScanner));
     }
 
     void ServiceRegistration::RegisterUseCaseServices(application::DIContainer& container)
@@ -139,6 +164,8 @@ namespace winsetup {
         auto diskService = ResolveOrThrow<abstractions::IDiskService>(container, "IDiskService");
         auto volService = ResolveOrThrow<abstractions::IVolumeService>(container, "IVolumeService");
         auto pathChecker = ResolveOrThrow<abstractions::IPathChecker>(container, "IPathChecker");
+        auto storageScanner = ResolveOrThrow<abstractions::IStorageScanner>(container, "IStorageScanner");
+        auto backupStore = ResolveOrThrow<abstractions::IBackupStore>(container, "IBackupStore");
 
         auto loadConfig = std::make_shared<application::LoadConfigurationUseCase>(configRepo, logger);
         container.RegisterInstance<abstractions::ILoadConfigurationUseCase>(
@@ -153,7 +180,7 @@ namespace winsetup {
             std::static_pointer_cast<abstractions::IEnumerateVolumesStep>(enumerateVolumes));
 
         auto analyzeVolumes = std::make_shared<application::AnalyzeVolumesStep>(
-            analysis, configRepo, pathChecker, logger);
+            analysis, configRepo, pathChecker, storageScanner, logger);
         container.RegisterInstance<abstractions::IAnalyzeVolumesStep>(
             std::static_pointer_cast<abstractions::IAnalyzeVolumesStep>(analyzeVolumes));
 
@@ -169,11 +196,13 @@ namespace winsetup {
                     analyzeVolumes, analyzeDisks,
                     analysis, configRepo, logger)));
 
-        auto backupData = std::make_shared<application::BackupDataStep>(logger);
+        auto backupData = std::make_shared<application::BackupDataStep>(
+            configRepo, analysis, backupStore, logger);
         auto formatPartition = std::make_shared<application::FormatPartitionStep>(logger);
         auto applyImage = std::make_shared<application::ApplyImageStep>(logger);
         auto installDrivers = std::make_shared<application::InstallDriversStep>(logger);
-        auto restoreData = std::make_shared<application::RestoreDataStep>(logger);
+        auto restoreData = std::make_shared<application::RestoreDataStep>(
+            configRepo, analysis, backupStore, logger);
         auto provisioning = std::make_shared<application::ProvisioningStep>(logger);
         auto reboot = std::make_shared<application::RebootStep>(logger);
 
@@ -0,0 +1,104 @@
+#include <adapters/platform/win32/storage/MFTKeyTable.h>
+#include <TestSupport.h>
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using winsetup::adapters::platform::MFTKeyTable;
+
+namespace {
+
+    void FindsWhatWasInserted() {
+        MFTKeyTable table;
+        CHECK(table.Find(42) == MFTKeyTable::EMPTY_VALUE);
+
+        for (uint32_t i = 0; i < 1000; ++i)
+            table.Insert(uint64_t{ i } * 7919, i);
+
+        CHECK(table.Size() == 1000);
+        for (uint32_t i = 0; i < 1000; ++i)
+            CHECK(table.Find(uint64_t{ i } * 7919) == i);
+        CHECK(table.Find(1) == MFTKeyTable::EMPTY_VALUE);
+    }
+
+    void KeepsDuplicateKeysApart() {
+        MFTKeyTable table;
+        table.Insert(5, 10);
+        table.Insert(5, 11);
+        table.Insert(5, 12);
+
+        CHECK(table.Find(5, [](uint32_t value) { return value == 11; }) == 11);
+        CHECK(table.Find(5, [](uint32_t value) { return value == 13; }) == MFTKeyTable::EMPTY_VALUE);
+
+        CHECK(table.Erase(5, 11));
+        CHECK(!table.Erase(5, 11));
+        CHECK(table.Find(5, [](uint32_t value) { return value == 11; }) == MFTKeyTable::EMPTY_VALUE);
+        CHECK(table.Find(5, [](uint32_t value) { return value == 12; }) == 12);
+        CHECK(table.Size() == 2);
+    }
+
+    // Erasing from the middle of a probe run must not cut off the entries
+    // behind it, which is what backward shifting has to get right.
+    void EraseKeepsProbeRunsReachable() {
+        MFTKeyTable table;
+        table.Reserve(16);
+        const uint64_t sameHome = 0;
+        for (uint32_t i = 0; i < 8; ++i)
+            table.Insert(sameHome, i);
+        table.Insert(1, 100);
+
+        CHECK(table.Erase(sameHome, 3));
+        CHECK(table.Erase(sameHome, 0));
+        for (uint32_t i : { 1u, 2u, 4u, 5u, 6u, 7u })
+            CHECK(table.Find(sameHome, [i](uint32_t value) { return value == i; }) == i);
+        CHECK(table.Find(1) == 100);
+    }
+
+    void MatchesAReferenceMapUnderChurn() {
+        MFTKeyTable table;
+        std::unordered_map<uint64_t, uint32_t> reference;
+        std::mt19937_64 random(12345);
+
+        for (uint32_t step = 0; step < 200000; ++step) {
+            const uint64_t key = random() % 50000;
+            const auto found = reference.find(key);
+            if (found == reference.end()) {
+                table.Insert(key, step);
+                reference.emplace(key, step);
+            }
+            else if (random() % 3 == 0) {
+                CHECK(table.Erase(key, found->second));
+                reference.erase(found);
+            }
+        }
+
+        CHECK(table.Size() == reference.size());
+        for (const auto& [key, value] : reference)
+            CHECK(table.Find(key) == value);
+        for (uint64_t key = 50000; key < 50100; ++key)
+            CHECK(table.Find(key) == MFTKeyTable::EMPTY_VALUE);
+    }
+
+    void ClearEmptiesTheTable() {
+        MFTKeyTable table;
+        table.Insert(1, 1);
+        table.Clear();
+        CHECK(table.Size() == 0);
+        CHECK(table.Find(1) == MFTKeyTable::EMPTY_VALUE);
+        CHECK(!table.Erase(1, 1));
+        table.Insert(1, 2);
+        CHECK(table.Find(1) == 2);
+    }
+
+}
+
+int main() {
+    FindsWhatWasInserted();
+    KeepsDuplicateKeysApart();
+    EraseKeepsProbeRunsReachable();
+    MatchesAReferenceMapUnderChurn();
+    ClearEmptiesTheTable();
+    return winsetup::tests::Finish("MFTKeyTableTests");
+}
@@ -0,0 +1,97 @@
+// Builds MFTPathIndex over a synthetic volume (5M records by default) with
+// 1, 2, ... up to maxThreads threads and reports the best of three builds
+// at each count, its speedup over one thread, and whether the indexes came
+// out identical to the single-threaded build.
+//
+//   MFTPathIndexBenchmark [recordCount] [maxThreads]
+#include <adapters/platform/win32/storage/MFTPathIndex.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using winsetup::adapters::platform::MFTPathIndex;
+using winsetup::adapters::platform::MFTRecordStore;
+
+namespace {
+
+    constexpr uint64_t ROOT = 5;
+    constexpr int      BUILDS_PER_COUNT = 3;
+
+    // The same shape as MFTRecordStoreBenchmark: one directory per ten
+    // files, parents before children, a third of the names repeating.
+    void FillVolume(MFTRecordStore& store, size_t recordCount) {
+        static const wchar_t* const commonNames[] = {
+            L"desktop.ini", L"thumbs.db", L"index.html", L"README.md", L"LICENSE",
+            L"en-US", L"x64", L"resources.pri", L"AppxManifest.xml", L"main.js",
+        };
+
+        std::mt19937_64 random(2024);
+        std::vector<uint64_t> directories{ ROOT };
+        store.Reserve(recordCount, recordCount * 16);
+
+        for (uint64_t number = 64; store.Size() < recordCount; ++number) {
+            const uint64_t fileRef = number | ((random() & 0xFF) << 48);
+            const uint64_t parent = directories[random() % directories.size()];
+            const bool isDirectory = random() % 10 == 0;
+
+            std::wstring name;
+            if (random() % 3 == 0)
+                name = commonNames[random() % std::size(commonNames)];
+            else
+                name = (isDirectory ? L"dir_" : L"file_") + std::to_wstring(number) + (isDirectory ? L"" : L".dat");
+
+            (void)store.Upsert(fileRef, parent, isDirectory ? FILE_ATTRIBUTE_DIRECTORY : 0u, 0, name);
+            if (isDirectory) directories.push_back(fileRef);
+        }
+    }
+
+    double BestBuildSeconds(MFTRecordStore& store, MFTPathIndex& index, uint32_t threadCount) {
+        double best = 0.0;
+        for (int run = 0; run < BUILDS_PER_COUNT; ++run) {
+            const auto start = std::chrono::steady_clock::now();
+            index.Build(store, threadCount);
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            best = run == 0 ? seconds : (std::min)(best, seconds);
+        }
+        return best;
+    }
+
+}
+
+int main(int argc, char** argv) {
+    const size_t recordCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 5000000;
+    uint32_t maxThreads = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10))
+        : static_cast<uint32_t>(std::thread::hardware_concurrency());
+    maxThreads = (std::clamp)(maxThreads, 1u, MFTPathIndex::MAX_THREADS);
+
+    std::printf("Synthetic volume of %zu records, 1..%u threads\n", recordCount, maxThreads);
+    MFTRecordStore store;
+    FillVolume(store, recordCount);
+
+    MFTPathIndex serial;
+    const double serialSeconds = BestBuildSeconds(store, serial, 1);
+
+    std::printf("  %-8s %10s %10s %8s  %s\n", "threads", "ms", "M rec/s", "speedup", "identical");
+    std::printf("  %-8u %10.1f %10.2f %8.2f  %s\n", 1u, serialSeconds * 1000.0,
+        recordCount / serialSeconds / 1e6, 1.0, "-");
+
+    bool allIdentical = true;
+    for (uint32_t threads = 2; threads <= maxThreads; ++threads) {
+        MFTPathIndex parallel;
+        const double seconds = BestBuildSeconds(store, parallel, threads);
+        const bool identical = parallel.PathHashes() == serial.PathHashes() &&
+            parallel.Extensions() == serial.Extensions();
+        allIdentical = allIdentical && identical;
+
+        std::printf("  %-8u %10.1f %10.2f %8.2f  %s\n", threads, seconds * 1000.0,
+            recordCount / seconds / 1e6, serialSeconds / seconds, identical ? "yes" : "NO");
+    }
+
+    return allIdentical ? 0 : 1;
+}
@@ -0,0 +1,126 @@
+#include <adapters/platform/win32/storage/MFTPathIndex.h>
+#include <TestSupport.h>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+using winsetup::adapters::platform::MFTPathIndex;
+using winsetup::adapters::platform::MFTPathTable;
+using winsetup::adapters::platform::MFTRecordStore;
+
+namespace {
+
+    constexpr uint64_t ROOT = 5;
+
+    // Wide enough that the first directory level and the file pass both
+    // clear MIN_RECORDS_PER_THREAD, so every phase of Build() really runs
+    // on several threads. Children are inserted before their parents now
+    // and then, and a few records are erased to leave tombstones.
+    void FillVolume(MFTRecordStore& store) {
+        static const wchar_t* const extensions[] = { L".txt", L".TXT", L".dll", L".Dll", L".json", L"" };
+
+        std::mt19937_64 random(7);
+        std::vector<uint64_t> directories;
+        uint64_t number = 64;
+
+        const uint32_t topLevel = MFTPathIndex::MIN_RECORDS_PER_THREAD + 4096;
+        for (uint32_t i = 0; i < topLevel; ++i, ++number) {
+            store.Upsert(number, ROOT, FILE_ATTRIBUTE_DIRECTORY, 0, L"top_" + std::to_wstring(number));
+            directories.push_back(number);
+        }
+
+        for (uint32_t i = 0; i < 20000; ++i, number += 2) {
+            // The child takes a slot before the parent it hangs under.
+            const uint64_t parent = directories[random() % directories.size()];
+            store.Upsert(number + 1, number, FILE_ATTRIBUTE_DIRECTORY, 0, L"Sub" + std::to_wstring(i));
+            store.Upsert(number, parent, FILE_ATTRIBUTE_DIRECTORY, 0, L"nested_" + std::to_wstring(i));
+            directories.push_back(number + 1);
+        }
+
+        for (uint32_t i = 0; i < 150000; ++i, ++number) {
+            const uint64_t parent = directories[random() % directories.size()];
+            const wchar_t* extension = extensions[random() % std::size(extensions)];
+            store.Upsert(number, parent, 0, 0, L"file_" + std::to_wstring(i) + extension);
+        }
+
+        for (uint64_t erased = 64 + topLevel + 40001; erased < number; erased += 97)
+            store.Erase(erased);
+    }
+
+    void ResolvesThreadCount() {
+        CHECK(MFTPathIndex::ResolveThreadCount(8, 1000) == 1);
+        CHECK(MFTPathIndex::ResolveThreadCount(8, 3 * MFTPathIndex::MIN_RECORDS_PER_THREAD) == 4);
+        CHECK(MFTPathIndex::ResolveThreadCount(2, 100 * MFTPathIndex::MIN_RECORDS_PER_THREAD) == 2);
+        CHECK(MFTPathIndex::ResolveThreadCount(1000, 1000 * MFTPathIndex::MIN_RECORDS_PER_THREAD) == MFTPathIndex::MAX_THREADS);
+        CHECK(MFTPathIndex::ResolveThreadCount(0, 1000) >= 1);
+    }
+
+    void FindsPathsAndExtensions() {
+        MFTRecordStore store;
+        const uint32_t windows = store.Upsert(100, ROOT, FILE_ATTRIBUTE_DIRECTORY, 0, L"Windows");
+        const uint32_t notepad = store.Upsert(102, 101, 0, 0, L"notepad.EXE");
+        const uint32_t system = store.Upsert(101, 100, FILE_ATTRIBUTE_DIRECTORY, 0, L"System32");
+        const uint32_t dotfile = store.Upsert(103, 100, 0, 0, L".gitignore");
+
+        MFTPathIndex index;
+        index.Build(store, 1);
+
+        auto isLive = [&store](uint32_t i) { return store.IsLive(i); };
+        CHECK(index.Find(L"Windows", isLive) == windows);
+        CHECK(index.Find(L"windows\\SYSTEM32", isLive) == system);
+        CHECK(index.Find(L"Windows/System32/notepad.exe", isLive) == notepad);
+        CHECK(index.Find(L"System32", isLive) == MFTPathTable::EMPTY_INDEX);
+
+        const auto* exe = index.FindExtension(L".exe");
+        CHECK(exe && exe->size() == 1 && exe->front() == notepad);
+        CHECK(MFTPathIndex::Extension(store.Name(dotfile)).empty());
+        CHECK(index.FindExtension(L".gitignore") == nullptr);
+    }
+
+    // The parallel build has to produce exactly what the serial one does:
+    // the same hash for every slot, the same extension lists in the same
+    // order, and path lookups landing on the same records.
+    void ParallelBuildMatchesSerial() {
+        MFTRecordStore store;
+        FillVolume(store);
+
+        MFTPathIndex serial;
+        serial.Build(store, 1);
+
+        std::vector<std::wstring> paths(store.SlotCount());
+        for (uint32_t i = 0; i < store.SlotCount(); ++i) {
+            if (!store.IsLive(i)) continue;
+            paths[i] = store.BuildPath(i);
+            if (serial.PathHashes()[i] != MFTPathIndex::HashPath(paths[i])) {
+                CHECK(serial.PathHashes()[i] == MFTPathIndex::HashPath(paths[i]));
+                break;
+            }
+        }
+
+        for (const uint32_t threads : { 2u, 3u, 4u, 7u, 16u }) {
+            MFTPathIndex parallel;
+            parallel.Build(store, threads);
+
+            CHECK(parallel.PathHashes() == serial.PathHashes());
+            CHECK(parallel.Extensions() == serial.Extensions());
+
+            uint32_t mismatches = 0;
+            for (uint32_t i = 0; i < store.SlotCount(); i += 13) {
+                if (!store.IsLive(i)) continue;
+                auto matches = [&](uint32_t candidate) { return store.BuildPath(candidate) == paths[i]; };
+                if (parallel.Find(paths[i], matches) != i || serial.Find(paths[i], matches) != i)
+                    mismatches++;
+            }
+            CHECK(mismatches == 0);
+        }
+    }
+
+}
+
+int main() {
+    ResolvesThreadCount();
+    FindsPathsAndExtensions();
+    ParallelBuildMatchesSerial();
+    return winsetup::tests::Finish("MFTPathIndexTests");
+}
@@ -0,0 +1,122 @@
+// Fills an MFTRecordStore with a synthetic volume (5M records by default)
+// and reports insert, lookup and parent-link throughput plus the store's
+// memory. The same file references also go through std::unordered_map as
+// a reference point for the flat FRN table.
+//
+//   MFTRecordStoreBenchmark [recordCount]
+#include <adapters/platform/win32/storage/MFTRecordStore.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using winsetup::adapters::platform::MFTRecordStore;
+
+namespace {
+
+    constexpr uint64_t ROOT = 5;
+
+    struct SyntheticRecord {
+        uint64_t     fileRef;
+        uint64_t     parentRef;
+        uint32_t     attributes;
+        std::wstring name;
+    };
+
+    // Roughly the shape of a system volume: one directory per ten files,
+    // parents created before their children, and about a third of the
+    // names drawn from a small set that repeats across directories.
+    std::vector<SyntheticRecord> MakeVolume(size_t recordCount) {
+        static const wchar_t* const commonNames[] = {
+            L"desktop.ini", L"thumbs.db", L"index.html", L"README.md", L"LICENSE",
+            L"en-US", L"x64", L"resources.pri", L"AppxManifest.xml", L"main.js",
+        };
+
+        std::mt19937_64 random(2024);
+        std::vector<SyntheticRecord> records;
+        std::vector<uint64_t> directories{ ROOT };
+        records.reserve(recordCount);
+        records.push_back({ ROOT | (uint64_t{ 5 } << 48), ROOT, FILE_ATTRIBUTE_DIRECTORY, L"." });
+
+        for (uint64_t number = 64; records.size() < recordCount; ++number) {
+            const uint64_t fileRef = number | ((random() & 0xFF) << 48);
+            const uint64_t parent = directories[random() % directories.size()];
+            const bool isDirectory = random() % 10 == 0;
+
+            std::wstring name;
+            if (random() % 3 == 0)
+                name = commonNames[random() % std::size(commonNames)];
+            else
+                name = (isDirectory ? L"dir_" : L"file_") + std::to_wstring(number) + (isDirectory ? L"" : L".dat");
+
+            records.push_back({ fileRef, parent, isDirectory ? FILE_ATTRIBUTE_DIRECTORY : 0u, std::move(name) });
+            if (isDirectory) directories.push_back(fileRef);
+        }
+        records[0].fileRef = ROOT;
+        return records;
+    }
+
+    double SecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void Report(const char* phase, size_t count, double seconds) {
+        std::printf("  %-22s %8.1f ms  %8.2f M/s\n", phase, seconds * 1000.0, count / seconds / 1e6);
+    }
+
+}
+
+int main(int argc, char** argv) {
+    const size_t recordCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 5000000;
+    std::printf("Synthetic volume of %zu records\n", recordCount);
+    const auto records = MakeVolume(recordCount);
+
+    std::vector<uint64_t> lookupOrder;
+    lookupOrder.reserve(records.size());
+    for (const auto& record : records) lookupOrder.push_back(record.fileRef);
+    std::shuffle(lookupOrder.begin(), lookupOrder.end(), std::mt19937_64(7));
+
+    std::printf("MFTRecordStore\n");
+    MFTRecordStore store;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& record : records)
+        (void)store.Upsert(record.fileRef, record.parentRef, record.attributes, 0, record.name);
+    Report("Upsert", records.size(), SecondsSince(start));
+
+    start = std::chrono::steady_clock::now();
+    uint64_t checksum = 0;
+    for (const uint64_t fileRef : lookupOrder)
+        checksum += store.Find(fileRef);
+    Report("Find (random order)", lookupOrder.size(), SecondsSince(start));
+
+    start = std::chrono::steady_clock::now();
+    store.LinkParents();
+    Report("LinkParents", records.size(), SecondsSince(start));
+
+    const size_t memory = store.MemoryUsage();
+    std::printf("  %-22s %8.1f MiB  %6.1f bytes/record\n", "MemoryUsage",
+        memory / 1048576.0, static_cast<double>(memory) / records.size());
+
+    std::printf("std::unordered_map<uint64_t, uint32_t> reference\n");
+    std::unordered_map<uint64_t, uint32_t> reference;
+    start = std::chrono::steady_clock::now();
+    reference.reserve(records.size());
+    for (uint32_t i = 0; i < records.size(); ++i)
+        reference.emplace(records[i].fileRef, i);
+    Report("emplace", records.size(), SecondsSince(start));
+
+    start = std::chrono::steady_clock::now();
+    for (const uint64_t fileRef : lookupOrder) {
+        const auto found = reference.find(fileRef);
+        checksum += found != reference.end() ? found->second : 0;
+    }
+    Report("find (random order)", lookupOrder.size(), SecondsSince(start));
+
+    std::printf("(checksum %llu)\n", static_cast<unsigned long long>(checksum));
+    return 0;
+}
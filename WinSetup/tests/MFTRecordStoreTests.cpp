@@ -0,0 +1,83 @@
+#include <adapters/platform/win32/storage/MFTRecordStore.h>
+#include <TestSupport.h>
+#include <cstdint>
+#include <string>
+
+using winsetup::adapters::platform::MFTRecordStore;
+
+namespace {
+
+    constexpr uint64_t ROOT = 5;
+
+    void UpsertFindAndErase() {
+        MFTRecordStore store;
+        const uint32_t windows = store.Upsert(100, ROOT, FILE_ATTRIBUTE_DIRECTORY, 1, L"Windows");
+        const uint32_t notepad = store.Upsert(101, 100, 0, 2, L"notepad.exe");
+
+        CHECK(store.Size() == 2);
+        CHECK(store.Find(100) == windows);
+        CHECK(store.Find(101) == notepad);
+        CHECK(store.Find(102) == MFTRecordStore::INVALID_INDEX);
+        CHECK(store.IsDirectory(windows));
+        CHECK(store.Name(notepad) == L"notepad.exe");
+
+        // A rename updates the slot in place.
+        CHECK(store.Upsert(101, 100, 0, 3, L"write.exe") == notepad);
+        CHECK(store.Name(notepad) == L"write.exe");
+        CHECK(store.Size() == 2);
+
+        CHECK(store.Erase(101));
+        CHECK(!store.Erase(101));
+        CHECK(store.Find(101) == MFTRecordStore::INVALID_INDEX);
+        CHECK(!store.IsLive(notepad));
+        CHECK(store.Size() == 1);
+    }
+
+    void InternsIdenticalNames() {
+        MFTRecordStore store;
+        const uint32_t first = store.Upsert(200, ROOT, 0, 0, L"desktop.ini");
+        const uint32_t second = store.Upsert(201, ROOT, 0, 0, L"desktop.ini");
+        const uint32_t other = store.Upsert(202, ROOT, 0, 0, L"desktop.in");
+
+        CHECK(store.Name(first).data() == store.Name(second).data());
+        CHECK(store.Name(other) == L"desktop.in");
+    }
+
+    void LinksParentsAndBuildsPaths() {
+        MFTRecordStore store;
+        store.Upsert(ROOT, ROOT, FILE_ATTRIBUTE_DIRECTORY, 0, L".");
+        store.Upsert(300, ROOT, FILE_ATTRIBUTE_DIRECTORY, 0, L"Users");
+        store.Upsert(301, 300, FILE_ATTRIBUTE_DIRECTORY, 0, L"Public");
+        const uint32_t file = store.Upsert(302, 301, 0, 0, L"notes.txt");
+        store.LinkParents();
+
+        CHECK(store.ParentIndex(file) == store.Find(301));
+        CHECK(store.BuildPath(file) == L".\\Users\\Public\\notes.txt");
+    }
+
+    void CompactKeepsLiveRecords() {
+        MFTRecordStore store;
+        for (uint64_t ref = 1000; ref < 1100; ++ref)
+            store.Upsert(ref, ROOT, 0, ref, L"file" + std::to_wstring(ref));
+        for (uint64_t ref = 1000; ref < 1100; ref += 2)
+            CHECK(store.Erase(ref));
+
+        store.Compact();
+        CHECK(store.SlotCount() == 50);
+        for (uint64_t ref = 1001; ref < 1100; ref += 2) {
+            const uint32_t index = store.Find(ref);
+            CHECK(index != MFTRecordStore::INVALID_INDEX);
+            CHECK(index != MFTRecordStore::INVALID_INDEX && store.Name(index) == L"file" + std::to_wstring(ref));
+        }
+        CHECK(store.Find(1000) == MFTRecordStore::INVALID_INDEX);
+    }
+
+}
+
+int main() {
+    UpsertFindAndErase();
+    InternsIdenticalNames();
+    LinksParentsAndBuildsPaths();
+    CompactKeepsLiveRecords();
+    return winsetup::tests::Finish("MFTRecordStoreTests");
+}
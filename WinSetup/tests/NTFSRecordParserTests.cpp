@@ -0,0 +1,370 @@
+#include <adapters/platform/win32/storage/NTFSRecordParser.h>
+#include <TestSupport.h>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace winsetup::adapters::platform;
+
+namespace {
+
+    constexpr size_t   RECORD_SIZE = 1024;
+    constexpr size_t   SECTOR_SIZE = 512;
+    constexpr uint16_t UPDATE_SEQUENCE = 0x0007;
+
+    template<typename T>
+    void Put(std::vector<uint8_t>& bytes, size_t offset, T value) {
+        std::memcpy(bytes.data() + offset, &value, sizeof(T));
+    }
+
+    // Lays out a FILE record the way NTFS writes it: header, update
+    // sequence array at 0x30, attributes from 0x38, end marker, and the
+    // update sequence number stamped over the last two bytes of every
+    // sector with the real bytes moved into the array.
+    class FileRecordBuilder {
+    public:
+        FileRecordBuilder(uint16_t sequence, uint16_t flags)
+            : mBytes(RECORD_SIZE, 0)
+        {
+            std::memcpy(mBytes.data(), "FILE", 4);
+            Put<uint16_t>(mBytes, 0x04, 0x30);
+            Put<uint16_t>(mBytes, 0x06, RECORD_SIZE / SECTOR_SIZE + 1);
+            Put<uint16_t>(mBytes, 0x10, sequence);
+            Put<uint16_t>(mBytes, 0x12, 1);
+            Put<uint16_t>(mBytes, 0x14, 0x38);
+            Put<uint16_t>(mBytes, 0x16, flags);
+            Put<uint32_t>(mBytes, 0x1C, RECORD_SIZE);
+        }
+
+        FileRecordBuilder& Resident(uint32_t type, const std::vector<uint8_t>& value, uint8_t nameLength = 0) {
+            const uint32_t length = Align8(0x18 + static_cast<uint32_t>(value.size()));
+            Put<uint32_t>(mBytes, mEnd + 0x00, type);
+            Put<uint32_t>(mBytes, mEnd + 0x04, length);
+            mBytes[mEnd + 0x08] = 0;
+            mBytes[mEnd + 0x09] = nameLength;
+            Put<uint32_t>(mBytes, mEnd + 0x10, static_cast<uint32_t>(value.size()));
+            Put<uint16_t>(mBytes, mEnd + 0x14, 0x18);
+            std::memcpy(mBytes.data() + mEnd + 0x18, value.data(), value.size());
+            mEnd += length;
+            return *this;
+        }
+
+        FileRecordBuilder& NonResidentData(
+            uint64_t allocatedSize,
+            uint64_t fileSize,
+            const std::vector<uint8_t>& runList,
+            uint64_t startVcn = 0
+        ) {
+            const uint32_t length = Align8(0x40 + static_cast<uint32_t>(runList.size()) + 1);
+            Put<uint32_t>(mBytes, mEnd + 0x00, 0x80);
+            Put<uint32_t>(mBytes, mEnd + 0x04, length);
+            mBytes[mEnd + 0x08] = 1;
+            Put<uint64_t>(mBytes, mEnd + 0x10, startVcn);
+            Put<uint16_t>(mBytes, mEnd + 0x20, 0x40);
+            Put<uint64_t>(mBytes, mEnd + 0x28, allocatedSize);
+            Put<uint64_t>(mBytes, mEnd + 0x30, fileSize);
+            Put<uint64_t>(mBytes, mEnd + 0x38, fileSize);
+            std::memcpy(mBytes.data() + mEnd + 0x40, runList.data(), runList.size());
+            mEnd += length;
+            return *this;
+        }
+
+        // Raw bytes for attributes the builder has no helper for, such as
+        // deliberately truncated ones.
+        FileRecordBuilder& Raw(const std::vector<uint8_t>& attribute) {
+            std::memcpy(mBytes.data() + mEnd, attribute.data(), attribute.size());
+            mEnd += static_cast<uint32_t>(attribute.size());
+            return *this;
+        }
+
+        std::vector<uint8_t> Build() const {
+            std::vector<uint8_t> record = mBytes;
+            Put<uint32_t>(record, mEnd, 0xFFFFFFFF);
+            Put<uint32_t>(record, 0x18, Align8(mEnd + 8));
+
+            Put<uint16_t>(record, 0x30, UPDATE_SEQUENCE);
+            for (size_t sector = 1; sector <= RECORD_SIZE / SECTOR_SIZE; ++sector) {
+                const size_t tail = sector * SECTOR_SIZE - 2;
+                std::memcpy(record.data() + 0x30 + sector * 2, record.data() + tail, 2);
+                Put<uint16_t>(record, tail, UPDATE_SEQUENCE);
+            }
+            return record;
+        }
+
+    private:
+        static uint32_t Align8(uint32_t value) { return (value + 7) & ~7u; }
+
+        std::vector<uint8_t> mBytes;
+        uint32_t             mEnd = 0x38;
+    };
+
+    std::vector<uint8_t> StandardInformation(int64_t created, int64_t written, int64_t accessed, uint32_t attributes) {
+        std::vector<uint8_t> value(0x48, 0);
+        Put<int64_t>(value, 0x00, created);
+        Put<int64_t>(value, 0x08, written);
+        Put<int64_t>(value, 0x10, written);
+        Put<int64_t>(value, 0x18, accessed);
+        Put<uint32_t>(value, 0x20, attributes);
+        return value;
+    }
+
+    std::vector<uint8_t> FileName(uint64_t parent, const std::u16string& name, uint8_t nameSpace) {
+        std::vector<uint8_t> value(0x42 + name.size() * 2, 0);
+        Put<uint64_t>(value, 0x00, parent);
+        value[0x40] = static_cast<uint8_t>(name.size());
+        value[0x41] = nameSpace;
+        std::memcpy(value.data() + 0x42, name.data(), name.size() * 2);
+        return value;
+    }
+
+    constexpr uint64_t ROOT_REFERENCE = (uint64_t{ 5 } << 48) | 5;
+
+    void ParsesResidentData() {
+        // Long enough that the value crosses the first sector boundary, so
+        // the fixup has to put the real bytes back inside it.
+        std::vector<uint8_t> contents(500);
+        for (size_t i = 0; i < contents.size(); ++i) contents[i] = static_cast<uint8_t>(i * 13 + 1);
+
+        auto record = FileRecordBuilder(3, 0x0001)
+            .Resident(0x10, StandardInformation(111, 222, 333, 0x20))
+            .Resident(0x30, FileName(ROOT_REFERENCE, u"REPORT~1.TXT", 2))
+            .Resident(0x30, FileName(ROOT_REFERENCE, u"report for 2024.txt", 1))
+            .Resident(0x80, contents)
+            .Build();
+
+        NTFSFileRecordInfo info;
+        CHECK(NTFSRecordParser::ParseFileRecord(record.data(), record.size(), 42, info));
+        CHECK(info.fileReference == ((uint64_t{ 3 } << 48) | 42));
+        CHECK(info.IsBaseRecord());
+        CHECK(info.parentFileReference == ROOT_REFERENCE);
+        CHECK(info.fileName == u"report for 2024.txt");
+        CHECK(info.hasStandardInformation);
+        CHECK(info.creationTime == 111 && info.lastWriteTime == 222 && info.lastAccessTime == 333);
+        CHECK(info.fileAttributes == 0x20);
+        CHECK(!info.isDirectory);
+        CHECK(info.hasData);
+        CHECK(info.fileSize == contents.size());
+        CHECK(info.dataRuns.empty());
+
+        // The $DATA value starts 0x18 into its attribute; find it and make
+        // sure the fixup restored the bytes under the sector tail.
+        const uint8_t* found = nullptr;
+        for (size_t offset = 0x38; offset + contents.size() <= record.size() && !found; ++offset) {
+            if (std::memcmp(record.data() + offset, contents.data(), contents.size()) == 0)
+                found = record.data() + offset;
+        }
+        CHECK(found != nullptr);
+    }
+
+    void ParsesNonResidentData() {
+        // Three runs: 16 clusters at LCN 0x1000, 8 sparse clusters, then 4
+        // clusters 0x10 before the first run (a negative delta).
+        const std::vector<uint8_t> runs = {
+            0x21, 0x10, 0x00, 0x10,
+            0x01, 0x08,
+            0x11, 0x04, 0xF0,
+            0x00,
+        };
+
+        auto record = FileRecordBuilder(9, 0x0001)
+            .Resident(0x10, StandardInformation(1, 2, 3, 0x80))
+            .Resident(0x30, FileName(ROOT_REFERENCE, u"movie.mkv", 1))
+            .NonResidentData(28 * 4096, 27 * 4096 + 100, runs)
+            .Build();
+
+        NTFSFileRecordInfo info;
+        CHECK(NTFSRecordParser::ParseFileRecord(record.data(), record.size(), 77, info));
+        CHECK(info.hasData);
+        CHECK(info.fileSize == 27 * 4096 + 100);
+        CHECK(info.allocatedSize == 28 * 4096);
+        CHECK(info.dataRuns.size() == 3);
+        if (info.dataRuns.size() == 3) {
+            CHECK(info.dataRuns[0].vcnLength == 16 && info.dataRuns[0].lcn == 0x1000);
+            CHECK(info.dataRuns[1].vcnLength == 8 && info.dataRuns[1].IsSparse());
+            CHECK(info.dataRuns[2].vcnLength == 4 && info.dataRuns[2].lcn == 0x1000 - 0x10);
+        }
+    }
+
+    void ParsesDirectoryRecord() {
+        auto record = FileRecordBuilder(1, 0x0003)
+            .Resident(0x10, StandardInformation(1, 2, 3, 0))
+            .Resident(0x30, FileName(ROOT_REFERENCE, u"Users", 3))
+            .Build();
+
+        NTFSFileRecordInfo info;
+        CHECK(NTFSRecordParser::ParseFileRecord(record.data(), record.size(), 100, info));
+        CHECK(info.isDirectory);
+        CHECK((info.fileAttributes & 0x10) != 0);
+        CHECK(!info.hasData);
+        CHECK(info.fileName == u"Users");
+    }
+
+    void RejectsTornAndFreeRecords() {
+        auto record = FileRecordBuilder(1, 0x0001)
+            .Resident(0x30, FileName(ROOT_REFERENCE, u"a.txt", 1))
+            .Build();
+
+        // A sector that did not reach the disk keeps a stale sequence number.
+        auto torn = record;
+        Put<uint16_t>(torn, 2 * SECTOR_SIZE - 2, UPDATE_SEQUENCE + 1);
+        NTFSFileRecordInfo info;
+        CHECK(!NTFSRecordParser::ParseFileRecord(torn.data(), torn.size(), 1, info));
+
+        auto badArray = record;
+        Put<uint16_t>(badArray, 0x06, 1);
+        CHECK(!NTFSRecordParser::ApplyFixups(badArray.data(), badArray.size()));
+
+        auto freeRecord = record;
+        Put<uint16_t>(freeRecord, 0x16, 0);
+        CHECK(!NTFSRecordParser::ParseFileRecord(freeRecord.data(), freeRecord.size(), 1, info));
+
+        auto badMagic = record;
+        std::memcpy(badMagic.data(), "BAAD", 4);
+        CHECK(!NTFSRecordParser::ParseFileRecord(badMagic.data(), badMagic.size(), 1, info));
+
+        CHECK(!NTFSRecordParser::ParseFileRecord(record.data(), 0x2F, 1, info));
+    }
+
+    void RejectsTruncatedAttributeHeaders() {
+        NTFSFileRecordInfo info;
+
+        // A resident attribute shorter than the 0x18-byte resident header.
+        std::vector<uint8_t> shortResident(0x10, 0);
+        Put<uint32_t>(shortResident, 0x00, 0x80);
+        Put<uint32_t>(shortResident, 0x04, 0x10);
+        auto record = FileRecordBuilder(1, 0x0001).Raw(shortResident).Build();
+        CHECK(!NTFSRecordParser::ParseFileRecord(record.data(), record.size(), 1, info));
+
+        // A value that claims to run past the end of its attribute.
+        std::vector<uint8_t> overlong(0x20, 0);
+        Put<uint32_t>(overlong, 0x00, 0x80);
+        Put<uint32_t>(overlong, 0x04, 0x20);
+        Put<uint32_t>(overlong, 0x10, 0x40);
+        Put<uint16_t>(overlong, 0x14, 0x18);
+        record = FileRecordBuilder(1, 0x0001).Raw(overlong).Build();
+        CHECK(!NTFSRecordParser::ParseFileRecord(record.data(), record.size(), 1, info));
+
+        // An attribute length running past the used size of the record.
+        std::vector<uint8_t> pastEnd(0x18, 0);
+        Put<uint32_t>(pastEnd, 0x00, 0x10);
+        Put<uint32_t>(pastEnd, 0x04, 0x300);
+        record = FileRecordBuilder(1, 0x0001).Raw(pastEnd).Build();
+        CHECK(!NTFSRecordParser::ParseFileRecord(record.data(), record.size(), 1, info));
+
+        // A non-resident $DATA whose run list offset is outside it.
+        std::vector<uint8_t> badRuns(0x48, 0);
+        Put<uint32_t>(badRuns, 0x00, 0x80);
+        Put<uint32_t>(badRuns, 0x04, 0x48);
+        badRuns[0x08] = 1;
+        Put<uint16_t>(badRuns, 0x20, 0x48);
+        record = FileRecordBuilder(1, 0x0001).Raw(badRuns).Build();
+        CHECK(!NTFSRecordParser::ParseFileRecord(record.data(), record.size(), 1, info));
+
+        // A run list cut off inside a run header.
+        std::vector<NTFSDataRun> runs;
+        const uint8_t cutRun[] = { 0x33, 0x10, 0x00 };
+        CHECK(!NTFSRecordParser::DecodeDataRuns(cutRun, sizeof(cutRun), runs));
+    }
+
+    void ParsesBootSector() {
+        std::vector<uint8_t> sector(512, 0);
+        std::memcpy(sector.data() + 3, "NTFS    ", 8);
+        Put<uint16_t>(sector, 0x0B, 512);
+        sector[0x0D] = 8;
+        Put<uint64_t>(sector, 0x30, 0xC0000);
+        sector[0x40] = static_cast<uint8_t>(-10);
+
+        NTFSVolumeGeometry geometry;
+        CHECK(NTFSRecordParser::ParseBootSector(sector.data(), sector.size(), geometry));
+        CHECK(geometry.bytesPerSector == 512);
+        CHECK(geometry.bytesPerCluster == 4096);
+        CHECK(geometry.bytesPerFileRecord == 1024);
+        CHECK(geometry.mftStartLcn == 0xC0000);
+
+        std::memcpy(sector.data() + 3, "FAT32   ", 8);
+        CHECK(!NTFSRecordParser::ParseBootSector(sector.data(), sector.size(), geometry));
+    }
+
+    // A tiny volume with 512-byte clusters, so every 1 KiB FILE record is
+    // split across two reads and the reader has to stitch it together.
+    void ReadsEveryRecordAcrossChunkBoundaries() {
+        constexpr uint32_t clusterSize = 512;
+        constexpr uint64_t mftLcn = 16;
+        constexpr uint64_t recordCount = 6;
+
+        std::map<uint64_t, std::vector<uint8_t>> volume;
+        const std::vector<uint8_t> mftRuns = { 0x11, static_cast<uint8_t>(recordCount * 2), static_cast<uint8_t>(mftLcn), 0x00 };
+
+        std::vector<uint8_t> mft;
+        for (uint64_t number = 0; number < recordCount; ++number) {
+            std::vector<uint8_t> record;
+            if (number == 0) {
+                record = FileRecordBuilder(1, 0x0001)
+                    .Resident(0x30, FileName(ROOT_REFERENCE, u"$MFT", 3))
+                    .NonResidentData(recordCount * RECORD_SIZE, recordCount * RECORD_SIZE, mftRuns)
+                    .Build();
+            }
+            else if (number == 3) {
+                record.assign(RECORD_SIZE, 0);
+            }
+            else {
+                record = FileRecordBuilder(static_cast<uint16_t>(number), 0x0001)
+                    .Resident(0x30, FileName(ROOT_REFERENCE, u"file" + std::u16string(1, u'0' + static_cast<char16_t>(number)), 1))
+                    .Resident(0x80, std::vector<uint8_t>(number * 10, 0xAB))
+                    .Build();
+            }
+            mft.insert(mft.end(), record.begin(), record.end());
+        }
+
+        NTFSVolumeGeometry geometry;
+        geometry.bytesPerSector = 512;
+        geometry.bytesPerCluster = clusterSize;
+        geometry.bytesPerFileRecord = RECORD_SIZE;
+        geometry.mftStartLcn = mftLcn;
+
+        const uint64_t mftStart = mftLcn * clusterSize;
+        NTFSMFTReader reader(geometry,
+            [&mft, mftStart](uint64_t offset, uint8_t* buffer, size_t length) {
+                if (offset < mftStart || offset + length > mftStart + mft.size()) return false;
+                std::memcpy(buffer, mft.data() + (offset - mftStart), length);
+                return true;
+            },
+            clusterSize);
+
+        std::vector<uint64_t> seen;
+        std::vector<uint64_t> sizes;
+        CHECK(reader.ReadAll([&](const NTFSFileRecordInfo& info) {
+            seen.push_back(info.fileReference & 0x0000FFFFFFFFFFFFull);
+            sizes.push_back(info.fileSize);
+            return true;
+        }) == NTFSReadStatus::Completed);
+
+        CHECK(reader.GetRecordsRead() == recordCount);
+        CHECK((seen == std::vector<uint64_t>{ 0, 1, 2, 4, 5 }));
+        CHECK((sizes == std::vector<uint64_t>{ recordCount * RECORD_SIZE, 10, 20, 40, 50 }));
+
+        std::vector<uint64_t> picked;
+        CHECK(reader.ReadRecords({ 2, 5, 99 }, [&](const NTFSFileRecordInfo& info) {
+            picked.push_back(info.fileReference & 0x0000FFFFFFFFFFFFull);
+            return true;
+        }) == NTFSReadStatus::Completed);
+        CHECK((picked == std::vector<uint64_t>{ 2, 5 }));
+
+        int calls = 0;
+        CHECK(reader.ReadAll([&](const NTFSFileRecordInfo&) { return ++calls < 2; }) == NTFSReadStatus::Stopped);
+    }
+
+}
+
+int main() {
+    ParsesResidentData();
+    ParsesNonResidentData();
+    ParsesDirectoryRecord();
+    RejectsTornAndFreeRecords();
+    RejectsTruncatedAttributeHeaders();
+    ParsesBootSector();
+    ReadsEveryRecordAcrossChunkBoundaries();
+    return winsetup::tests::Finish("NTFSRecordParserTests");
+}
@@ -0,0 +1,187 @@
+#include <adapters/platform/win32/storage/USNRecordParser.h>
+#include <TestSupport.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace winsetup::adapters::platform;
+
+namespace {
+
+    template<typename T>
+    void Put(std::vector<uint8_t>& bytes, size_t offset, T value) {
+        std::memcpy(bytes.data() + offset, &value, sizeof(T));
+    }
+
+    struct RecordSpec {
+        uint64_t       frn = 0;
+        uint64_t       parent = 0;
+        int64_t        usn = 0;
+        uint32_t       reason = 0;
+        std::u16string name;
+    };
+
+    // USN_RECORD_V2: 60-byte header, name at 0x3C, length padded to 8.
+    std::vector<uint8_t> RecordV2(const RecordSpec& spec) {
+        const size_t nameBytes = spec.name.size() * sizeof(char16_t);
+        const size_t length = (60 + nameBytes + 7) & ~size_t{ 7 };
+        std::vector<uint8_t> record(length, 0);
+        Put<uint32_t>(record, 0, static_cast<uint32_t>(length));
+        Put<uint16_t>(record, 4, 2);
+        Put<uint64_t>(record, 8, spec.frn);
+        Put<uint64_t>(record, 16, spec.parent);
+        Put<int64_t>(record, 24, spec.usn);
+        Put<int64_t>(record, 32, 0x01DA000000000000 + spec.usn);
+        Put<uint32_t>(record, 40, spec.reason);
+        Put<uint32_t>(record, 52, 0x20);
+        Put<uint16_t>(record, 56, static_cast<uint16_t>(nameBytes));
+        Put<uint16_t>(record, 58, 60);
+        std::memcpy(record.data() + 60, spec.name.data(), nameBytes);
+        return record;
+    }
+
+    // USN_RECORD_V3: 128-bit file IDs push the name out to 0x4C.
+    std::vector<uint8_t> RecordV3(const RecordSpec& spec) {
+        const size_t nameBytes = spec.name.size() * sizeof(char16_t);
+        const size_t length = (76 + nameBytes + 7) & ~size_t{ 7 };
+        std::vector<uint8_t> record(length, 0);
+        Put<uint32_t>(record, 0, static_cast<uint32_t>(length));
+        Put<uint16_t>(record, 4, 3);
+        Put<uint64_t>(record, 8, spec.frn);
+        Put<uint64_t>(record, 24, spec.parent);
+        Put<int64_t>(record, 40, spec.usn);
+        Put<uint32_t>(record, 56, spec.reason);
+        Put<uint16_t>(record, 72, static_cast<uint16_t>(nameBytes));
+        Put<uint16_t>(record, 74, 76);
+        std::memcpy(record.data() + 76, spec.name.data(), nameBytes);
+        return record;
+    }
+
+    // FSCTL output: the resume point followed by packed records.
+    std::vector<uint8_t> Buffer(int64_t resumePoint, const std::vector<std::vector<uint8_t>>& records) {
+        std::vector<uint8_t> buffer(USNRecordParser::RESUME_POINT_SIZE);
+        Put<int64_t>(buffer, 0, resumePoint);
+        for (const auto& record : records) buffer.insert(buffer.end(), record.begin(), record.end());
+        return buffer;
+    }
+
+    std::vector<std::u16string> Names(const uint8_t* data, size_t size) {
+        std::vector<std::u16string> names;
+        USNRecordParser parser(data, size);
+        USNRecordView view;
+        while (parser.Next(view)) names.emplace_back(view.fileName);
+        return names;
+    }
+
+    void ParsesV2Fields() {
+        const auto buffer = Buffer(4096, {
+            RecordV2({ 0x0001000000000123, 0x0005000000000005, 1000, 0x100, u"setup.log" }),
+            RecordV2({ 0x0002000000000456, 0x0001000000000123, 1088, 0x80000200, u"" }),
+        });
+
+        int64_t resume = 0;
+        CHECK(USNRecordParser::ReadResumePoint(buffer.data(), buffer.size(), resume));
+        CHECK(resume == 4096);
+
+        USNRecordParser parser(buffer.data() + USNRecordParser::RESUME_POINT_SIZE,
+            buffer.size() - USNRecordParser::RESUME_POINT_SIZE);
+        USNRecordView view;
+        CHECK(parser.Next(view));
+        CHECK(view.fileReferenceNumber == 0x0001000000000123);
+        CHECK(view.parentFileReferenceNumber == 0x0005000000000005);
+        CHECK(view.usn == 1000);
+        CHECK(view.timestamp == 0x01DA000000000000 + 1000);
+        CHECK(view.reason == 0x100);
+        CHECK(view.fileAttributes == 0x20);
+        CHECK(view.fileName == u"setup.log");
+
+        CHECK(parser.Next(view));
+        CHECK(view.usn == 1088);
+        CHECK(view.fileName.empty());
+        CHECK(!parser.Next(view));
+        CHECK(!parser.Next(view));
+    }
+
+    void SkipsV3RecordsWithoutLosingSync() {
+        const auto buffer = Buffer(0, {
+            RecordV2({ 1, 5, 10, 0, u"first" }),
+            RecordV3({ 2, 5, 20, 0, u"refs-volume-entry" }),
+            RecordV3({ 3, 5, 30, 0, u"x" }),
+            RecordV2({ 4, 5, 40, 0, u"after" }),
+        });
+
+        const auto names = Names(buffer.data() + 8, buffer.size() - 8);
+        CHECK((names == std::vector<std::u16string>{ u"first", u"after" }));
+    }
+
+    void StopsAtRecordStraddlingBufferEnd() {
+        const auto whole = Buffer(0, {
+            RecordV2({ 1, 5, 10, 0, u"one" }),
+            RecordV2({ 2, 5, 20, 0, u"two" }),
+            RecordV2({ 3, 5, 30, 0, u"three-with-a-longer-name" }),
+        });
+        const size_t firstTwo = RecordV2({ 1, 5, 10, 0, u"one" }).size()
+            + RecordV2({ 2, 5, 20, 0, u"two" }).size();
+
+        // Cut inside the third record's name, then inside its header.
+        for (const size_t cut : { firstTwo + 70, firstTwo + 20, firstTwo + 1 }) {
+            const auto names = Names(whole.data() + 8, cut);
+            CHECK((names == std::vector<std::u16string>{ u"one", u"two" }));
+        }
+
+        // Once a straddling record is seen the parser stays finished.
+        USNRecordParser parser(whole.data() + 8, firstTwo + 70);
+        USNRecordView view;
+        CHECK(parser.Next(view) && parser.Next(view));
+        CHECK(!parser.Next(view));
+        CHECK(!parser.Next(view));
+
+        // The next FSCTL call starts again at the cut record.
+        const auto names = Names(whole.data() + 8 + firstTwo, whole.size() - 8 - firstTwo);
+        CHECK((names == std::vector<std::u16string>{ u"three-with-a-longer-name" }));
+    }
+
+    void RejectsMalformedRecords() {
+        // A name that points past the record or at an odd offset is
+        // skipped; the records around it still parse.
+        auto pastEnd = RecordV2({ 2, 5, 20, 0, u"bad" });
+        Put<uint16_t>(pastEnd, 56, 200);
+        auto oddOffset = RecordV2({ 3, 5, 30, 0, u"odd" });
+        Put<uint16_t>(oddOffset, 58, 61);
+
+        auto buffer = Buffer(0, {
+            RecordV2({ 1, 5, 10, 0, u"a" }),
+            pastEnd,
+            oddOffset,
+            RecordV2({ 4, 5, 40, 0, u"b" }),
+        });
+        CHECK((Names(buffer.data() + 8, buffer.size() - 8) == std::vector<std::u16string>{ u"a", u"b" }));
+
+        // A length shorter than the header cannot be stepped over, so the
+        // rest of the buffer is abandoned.
+        auto shortLength = RecordV2({ 2, 5, 20, 0, u"short" });
+        Put<uint32_t>(shortLength, 0, 16);
+        buffer = Buffer(0, {
+            RecordV2({ 1, 5, 10, 0, u"a" }),
+            shortLength,
+            RecordV2({ 3, 5, 30, 0, u"unreached" }),
+        });
+        CHECK((Names(buffer.data() + 8, buffer.size() - 8) == std::vector<std::u16string>{ u"a" }));
+
+        CHECK(Names(nullptr, 4096).empty());
+
+        int64_t resume = 0;
+        CHECK(!USNRecordParser::ReadResumePoint(buffer.data(), 7, resume));
+        CHECK(!USNRecordParser::ReadResumePoint(nullptr, 8, resume));
+    }
+
+}
+
+int main() {
+    ParsesV2Fields();
+    SkipsV3RecordsWithoutLosingSync();
+    StopsAtRecordStraddlingBufferEnd();
+    RejectsMalformedRecords();
+    return winsetup::tests::Finish("USNRecordParserTests");
+}
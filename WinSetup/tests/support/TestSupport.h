@@ -0,0 +1,31 @@
+// Minimal checking for the portable tests: each test executable runs its
+// cases, CHECK records failures without stopping, and main returns the
+// failure count so ctest reports the executable as failed.
+#pragma once
+
+#include <cstdio>
+
+namespace winsetup::tests {
+
+    inline int& FailureCount() noexcept {
+        static int failures = 0;
+        return failures;
+    }
+
+    inline void ReportFailure(const char* file, int line, const char* expression) noexcept {
+        std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", file, line, expression);
+        ++FailureCount();
+    }
+
+    inline int Finish(const char* suite) noexcept {
+        if (FailureCount() == 0)
+            std::printf("%s: all checks passed\n", suite);
+        else
+            std::printf("%s: %d check(s) failed\n", suite, FailureCount());
+        return FailureCount() == 0 ? 0 : 1;
+    }
+
+}
+
+#define CHECK(expression) \
+    ((expression) ? (void)0 : ::winsetup::tests::ReportFailure(__FILE__, __LINE__, #expression))
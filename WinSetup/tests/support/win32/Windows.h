@@ -0,0 +1,19 @@
+// Stand-in for <Windows.h> when the portable sources are built off Windows.
+// Only the types and constants those sources use are declared, with the
+// values from the Windows SDK.
+#pragma once
+
+#include <cstdint>
+
+using DWORD = uint32_t;
+
+struct FILETIME {
+    DWORD dwLowDateTime;
+    DWORD dwHighDateTime;
+};
+
+constexpr DWORD FILE_ATTRIBUTE_READONLY = 0x00000001;
+constexpr DWORD FILE_ATTRIBUTE_HIDDEN = 0x00000002;
+constexpr DWORD FILE_ATTRIBUTE_SYSTEM = 0x00000004;
+constexpr DWORD FILE_ATTRIBUTE_DIRECTORY = 0x00000010;
+constexpr DWORD FILE_ATTRIBUTE_ARCHIVE = 0x00000020;